@@ -41,6 +41,19 @@ class AudioEngine:
     def set_output_ref(self, entity: Entity, width: int):
         self.engine.set_output_ref(entity, width)
 
+    def set_output_bus(self, name: str, entity: Entity, first_channel: int = 0):
+        self.engine.set_output_bus(name, entity, first_channel)
+
+    def remove_output_bus(self, name: str):
+        self.engine.remove_output_bus(name)
+
+    def add_aux_bus(self, name: str, width: int = 2, gain: float = 1.0) -> Entity:
+        return self.engine.add_aux_bus(name, width, gain)
+
+    def add_send(self, source: "AttachedParam", bus: str, gain: float = 1.0) -> Entity:
+        assert not source.param.is_input
+        return self.engine.add_send(source.block.entity, source.entity, bus, gain)
+
     def start(self):
         self.engine.startAudio()
         # To avoid race conditions with other pybind11 functions
@@ -66,75 +79,57 @@ class AudioEngine:
         target: "AttachedParam | MixerBlock",
         gain: float = 1.0,
         offset: float = 0.0,
-    ):
-        from block import Block, MixerBlock
+    ) -> Entity:
+        from block import MixerBlock
 
         assert not source.param.is_input
-        assert source.param.is_input
-        target_block = target if isinstance(target, Block) else target.block
-
-        if isinstance(target_block, MixerBlock):
-            self._add_wire_to_mixer(source, target)
+        if isinstance(target, MixerBlock):
+            return self._add_wire_to_mixer(source, target, gain, offset)
+        assert target.param.is_input
 
         match source.param.width, target.param.width:
             case (1, 1):
-                self.engine.add_wire(
-                    source.block.entity,
-                    target.block.entity,
-                    source.param.idx,
-                    target.param.idx,
-                    AAri_cpp.Wire.transmit_1d_to_1d,
-                    gain=gain,
-                    offset=offset,
-                )
+                transmit_func = AAri_cpp.Wire.transmit_1d_to_1d
             case (1, 2):
-                self.engine.add_wire(
-                    source.block.entity,
-                    target.block.entity,
-                    source.param.idx,
-                    target.param.idx,
-                    AAri_cpp.Wire.broadcast_1d_to_2d,
-                    gain=gain,
-                    offset=offset,
-                )
-            case other:
-                raise ValueError(
-                    f"Invalid wire width combination: {source.param.width}, {target.param.width}"
-                )
-
-    def _add_wire_to_mixer(self, source: "AttachedParam", target: "MixerBlock"):
-        """Match / case on the mixer size and whether the mixer is stereo
-        or mono and the input is 1d or 2d / stereo"""
-        free_input = target.find_free_slot()
-        match source.param.width, type(target):
-            case (1, MonoMixer):
-                self.engine.add_wire_to_mixer(
-                    source.block.entity,
-                    target.entity,
-                    source.param.idx,
-                    free_input,
-                    target.transmit_func,
-                )
-            case (1, StereoMixer):
-                self.engine.add_wire_to_mixer(
-                    source.block.entity,
-                    target.entity,
-                    source.param.idx,
-                    free_input,
-                    target.transmit_mono_func,
-                )
-            case (2, StereoMixer):
-                self.engine.add_wire_to_mixer(
-                    source.block.entity,
-                    target.entity,
-                    source.param.idx,
-                    free_input,
-                    target.transmit_stereo_func,
-                )
+                transmit_func = AAri_cpp.Wire.broadcast_1d_to_2d
+            case (2, 2):
+                transmit_func = AAri_cpp.Wire.transmit_2d_to_2d
             case other:
                 raise ValueError(
                     f"Invalid wire width combination: {source.param.width}, {target.param.width}"
                 )
+        return self.engine.add_wire(
+            source.block.entity,
+            target.block.entity,
+            source.entity,
+            target.entity,
+            transmit_func,
+            gain=gain,
+            offset=offset,
+        )
+
+    def _add_wire_to_mixer(
+        self,
+        source: "AttachedParam",
+        target: "MixerBlock",
+        gain: float = 1.0,
+        offset: float = 0.0,
+    ) -> Entity:
+        """Wire a mono or stereo output to the first free slot of a mixer,
+        the mixer sums it into its channels whatever its width"""
+        if source.param.width > 2:
+            raise ValueError(
+                f"Only mono and stereo outputs can be mixed, not width {source.param.width}"
+            )
+        return self.engine.add_wire_to_mixer(
+            source.block.entity,
+            target.entity,
+            source.entity,
+            target.find_free_slot(),
+            AAri_cpp.Wire.transmit_to_mixer,
+            gain=gain,
+            offset=offset,
+        )
 
     @property
     def _cpp_blocks(self) -> List[AAri_cpp.Block]:
@@ -46,9 +46,9 @@ class Param:
     @property
     def width(self) -> int:
         match self.io_type:
-            case AAri_cpp.Input1D, AAri_cpp.Output1D:
+            case AAri_cpp.Input1D | AAri_cpp.Output1D:
                 return 1
-            case AAri_cpp.OutputND2, AAri_cpp.InputND2:
+            case AAri_cpp.OutputND2 | AAri_cpp.InputND2:
                 return 2
             case AAri_cpp.InputND4:
                 return 4
@@ -202,7 +202,7 @@ class AddedParams(ParamExpression):
             else (2 if isinstance(target_input, StereoMixer) else 1)
         )
         # First mix the list of params
-        mixer_size = 2 ** int(np.ceil(np.log2(len(self.params_list))))
+        mixer_size = len(self.params_list)
         mixer = MonoMixer(mixer_size) if width == 1 else StereoMixer(mixer_size)
         for p in self.params_list:
             engine.add_wire(p.attached_param, mixer, gain=p.gain, offset=p.offset)
@@ -342,7 +342,7 @@ class MixerBlock(Block):
         used_inputs = np.zeros(self.num_inputs)
         # Find the free inputs
         for wire in wires:
-            used_inputs[wire.to_input] = 1
+            used_inputs[wire.slot] = 1
         free_slots = np.where(used_inputs == 0)
         if len(free_slots[0]) == 0:
             raise RuntimeError("No free inputs")
@@ -354,41 +354,9 @@ class StereoMixer(MixerBlock):
 
     def __init__(self, size: int = 4):
         engine = AudioEngine()
-        match size:
-            case (2):
-                entity = AAri_cpp.StereoMixer2.create(engine.engine)
-                self.transmit_mono_func = AAri_cpp.Wire.transmit_mono_to_stereo_mixer_2
-                self.transmit_stereo_func = (
-                    AAri_cpp.Wire.transmit_stereo_to_stereo_mixer_2
-                )
-            case (4):
-                entity = AAri_cpp.StereoMixer4.create(engine.engine)
-                self.transmit_mono_func = AAri_cpp.Wire.transmit_mono_to_stereo_mixer_4
-                self.transmit_stereo_func = (
-                    AAri_cpp.Wire.transmit_stereo_to_stereo_mixer_4
-                )
-            case (8):
-                entity = AAri_cpp.StereoMixer8.create(engine.engine)
-                self.transmit_mono_func = AAri_cpp.Wire.transmit_mono_to_stereo_mixer_8
-                self.transmit_stereo_func = (
-                    AAri_cpp.Wire.transmit_stereo_to_stereo_mixer_8
-                )
-            case (16):
-                entity = AAri_cpp.StereoMixer16.create(engine.engine)
-                self.transmit_mono_func = AAri_cpp.Wire.transmit_mono_to_stereo_mixer_16
-                self.transmit_stereo_func = (
-                    AAri_cpp.Wire.transmit_stereo_to_stereo_mixer_16
-                )
-            case (32):
-                entity = AAri_cpp.StereoMixer32.create(engine.engine)
-                self.transmit_mono_func = AAri_cpp.Wire.transmit_mono_to_stereo_mixer_32
-                self.transmit_stereo_func = (
-                    AAri_cpp.Wire.transmit_stereo_to_stereo_mixer_32
-                )
-            case other:
-                raise ValueError(
-                    "Invalid size for StereoMixer, must be a power of 2 and smaller than 32"
-                )
+        if size < 1:
+            raise ValueError("Invalid size for StereoMixer, must be at least 1")
+        entity = AAri_cpp.Mixer.create(engine.engine, size, 2)
         super().__init__(entity, size)
 
 
@@ -397,27 +365,9 @@ class MonoMixer(MixerBlock):
 
     def __init__(self, size: int = 4):
         engine = AudioEngine()
-        match size:
-            case (2):
-                entity = AAri_cpp.MonoMixer2.create(engine.engine)
-                self.transmit_func = AAri_cpp.Wire.transmit_to_mono_mixer_2
-            case (4):
-                entity = AAri_cpp.MonoMixer4.create(engine.engine)
-                self.transmit_func = AAri_cpp.Wire.transmit_to_mono_mixer_4
-            case (8):
-                entity = AAri_cpp.MonoMixer8.create(engine.engine)
-                self.transmit_func = AAri_cpp.Wire.transmit_to_mono_mixer_8
-            case (16):
-                entity = AAri_cpp.MonoMixer16.create(engine.engine)
-                self.transmit_func = AAri_cpp.Wire.transmit_to_mono_mixer_16
-            case (32):
-                entity = AAri_cpp.MonoMixer32.create(engine.engine)
-                self.transmit_func = AAri_cpp.Wire.transmit_to_mono_mixer_32
-            case other:
-                raise ValueError(
-                    "Invalid size for StereoMixer, "
-                    "must be a power of 2 and smaller than 32"
-                )
+        if size < 1:
+            raise ValueError("Invalid size for MonoMixer, must be at least 1")
+        entity = AAri_cpp.Mixer.create(engine.engine, size, 1)
         super().__init__(entity, size)
 
 
@@ -1,22 +1,88 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 
 #include "../src/core/audio_engine.h"
+#include <optional>
+#include "../src/core/kernels/kernels.h"
 #include "../src/blocks/oscillators.h"
 #include "../src/blocks/mixers.h"
+#include "../src/blocks/constants.h"
+#include "../src/blocks/additive.h"
+#include "../src/blocks/fm.h"
 #include "../src/blocks/envelopes.h"
+#include "../src/blocks/filters.h"
+#include "../src/blocks/delays.h"
+#include "../src/blocks/reverb.h"
+#include "../src/blocks/convolution.h"
+#include "../src/blocks/samples.h"
+#include "../src/blocks/audio_input.h"
+#include "../src/blocks/aux_bus.h"
 
 namespace py = pybind11;
 using namespace AAri;
 
+// Helpers for the bulk API, entity ids are passed around as numpy uint32 arrays
+using IdArray = py::array_t<uint32_t, py::array::c_style | py::array::forcecast>;
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+static std::vector<entt::entity> to_entities(const IdArray&ids) {
+        auto ids_view = ids.unchecked<1>();
+        std::vector<entt::entity> entities(ids_view.shape(0));
+        for (py::ssize_t i = 0; i < ids_view.shape(0); i++) {
+                entities[i] = static_cast<entt::entity>(ids_view(i));
+        }
+        return entities;
+}
+
+static std::vector<float> to_floats(const FloatArray&values) {
+        return {values.data(), values.data() + values.size()};
+}
+
+static IdArray to_id_array(const std::vector<entt::entity>&entities) {
+        IdArray ids(static_cast<py::ssize_t>(entities.size()));
+        auto ids_view = ids.mutable_unchecked<1>();
+        for (size_t i = 0; i < entities.size(); i++) {
+                ids_view(i) = entt::to_integral(entities[i]);
+        }
+        return ids;
+}
+
+template<typename MixerT>
+static void bind_mixer(py::module_&m, const char* name) {
+        py::class_<MixerT>(m, name, py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *>(&MixerT::create))
+                        .def_static("create_many", [](IGraphRegistry* reg, size_t count) {
+                                return to_id_array(MixerT::create_many(reg, count));
+                        }, py::arg("engine"), py::arg("count"));
+}
+
+template<typename OscT>
+static void bind_oscillator(py::module_&m, const char* name) {
+        py::class_<OscT>(m, name, py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, float, float>(&OscT::create),
+                                    py::arg("engine"), py::arg("freq") = 440.0f, py::arg("amp") = 1.0f)
+                        .def_static("create_many",
+                                    [](IGraphRegistry* reg, const FloatArray&freqs,
+                                       const FloatArray&amps) {
+                                            return to_id_array(OscT::create_many(reg, to_floats(freqs),
+                                                                                 to_floats(amps)));
+                                    }, py::arg("engine"), py::arg("freqs"), py::arg("amps"));
+}
+
 PYBIND11_MODULE(AAri_cpp, m) {
         py::class_<AudioContext>(m, "AudioContext")
                         .def_readonly("sample_freq", &AudioContext::sample_freq)
                         .def_readonly("dt", &AudioContext::dt)
                         .def_readonly("clock", &AudioContext::clock);
 
-        py::class_<entt::entity>(m, "Entity");
+        py::class_<entt::entity>(m, "Entity")
+                        .def(py::init([](uint32_t id) { return static_cast<entt::entity>(id); }))
+                        .def("__int__", [](entt::entity e) { return entt::to_integral(e); })
+                        .def("__eq__", [](entt::entity a, entt::entity b) { return a == b; }, py::is_operator())
+                        .def("__hash__", [](entt::entity e) { return entt::to_integral(e); });
+        py::implicitly_convertible<py::int_, entt::entity>();
         py::class_<entt::registry>(m, "Registry");
 
         m.doc() = "AAri_cpp: Real-time audio engine backend"; // Module documentation
@@ -29,6 +95,18 @@ PYBIND11_MODULE(AAri_cpp, m) {
         py::class_<Output1D, InputOutput>(m, "Output1D", py::module_local())
                         .def(py::init<float>(), py::arg("value") = 0.0f)
                         .def_readonly("value", &Output1D::value);
+        py::class_<InputArray, InputOutput>(m, "InputArray", py::module_local())
+                        .def(py::init([](const FloatArray&value) { return InputArray(to_floats(value)); }),
+                             py::arg("value"))
+                        .def_property_readonly("value", [](const InputArray&input) {
+                                return FloatArray((py::ssize_t)input.value.size(), input.value.data());
+                        });
+        py::class_<OutputArray, InputOutput>(m, "OutputArray", py::module_local())
+                        .def(py::init([](const FloatArray&value) { return OutputArray(to_floats(value)); }),
+                             py::arg("value"))
+                        .def_property_readonly("value", [](const OutputArray&output) {
+                                return FloatArray((py::ssize_t)output.value.size(), output.value.data());
+                        });
         py::class_<InputND<2>, InputOutput>(m, "InputND2", py::module_local())
                         .def(py::init<std::array<float, 2>>(), py::arg("value") = std::array<float, 2>{0.0f, 0.0f})
                         .def_readonly("value", &InputND<2>::value);
@@ -107,54 +185,24 @@ PYBIND11_MODULE(AAri_cpp, m) {
                         .def_readonly("to_block", &Wire::to_block)
                         .def_readonly("to_input", &Wire::to_input)
                         .def_readonly("gain", &Wire::gain)
-                        .def_readonly("offset", &Wire::offset);
+                        .def_readonly("offset", &Wire::offset)
+                        .def_readonly("slot", &Wire::slot);
 
         //Expose wire transmit static functions:
         wire.def_static("transmit_1d_to_1d", &Wire::transmit_1d_to_1d, py::arg("registry"), py::arg("wire"));
+        wire.def_static("transmit_array_to_array", &Wire::transmit_array_to_array, py::arg("registry"),
+                        py::arg("wire"));
+        wire.def_static("transmit_to_mixer", &Wire::transmit_to_mixer, py::arg("registry"), py::arg("wire"));
         wire.def_static("broadcast_1d_to_2d", &Wire::broadcast_1d_to_Nd<2>, py::arg("registry"), py::arg("wire"));
         wire.def_static("broadcast_1d_to_4d", &Wire::broadcast_1d_to_Nd<4>, py::arg("registry"), py::arg("wire"));
         wire.def_static("broadcast_1d_to_8d", &Wire::broadcast_1d_to_Nd<8>, py::arg("registry"), py::arg("wire"));
         wire.def_static("broadcast_1d_to_16d", &Wire::broadcast_1d_to_Nd<16>, py::arg("registry"), py::arg("wire"));
         wire.def_static("broadcast_1d_to_32d", &Wire::broadcast_1d_to_Nd<32>, py::arg("registry"), py::arg("wire"));
-        wire.def_static("transmit_to_mono_mixer_2", &Wire::transmit_to_mono_mixer<2>, py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_to_mono_mixer_4", &Wire::transmit_to_mono_mixer<4>, py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_to_mono_mixer_8", &Wire::transmit_to_mono_mixer<8>, py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_to_mono_mixer_16", &Wire::transmit_to_mono_mixer<16>, py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_to_mono_mixer_32", &Wire::transmit_to_mono_mixer<32>, py::arg("registry"),
-                        py::arg("wire"));
-
-        wire.def_static("transmit_mono_to_stereo_mixer_2", &Wire::transmit_mono_to_stereo_mixer<2>, py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_mono_to_stereo_mixer_4", &Wire::transmit_mono_to_stereo_mixer<4>, py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_mono_to_stereo_mixer_8", &Wire::transmit_mono_to_stereo_mixer<8>, py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_mono_to_stereo_mixer_16", &Wire::transmit_mono_to_stereo_mixer<16>,
-                        py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_mono_to_stereo_mixer_32", &Wire::transmit_mono_to_stereo_mixer<32>,
-                        py::arg("registry"),
-                        py::arg("wire"));
-
-        wire.def_static("transmit_stereo_to_stereo_mixer_2", &Wire::transmit_stereo_to_stereo_mixer<2>,
-                        py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_stereo_to_stereo_mixer_4", &Wire::transmit_stereo_to_stereo_mixer<4>,
-                        py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_stereo_to_stereo_mixer_8", &Wire::transmit_stereo_to_stereo_mixer<8>,
-                        py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_stereo_to_stereo_mixer_16", &Wire::transmit_stereo_to_stereo_mixer<16>,
-                        py::arg("registry"),
-                        py::arg("wire"));
-        wire.def_static("transmit_stereo_to_stereo_mixer_32", &Wire::transmit_stereo_to_stereo_mixer<32>,
-                        py::arg("registry"),
-                        py::arg("wire"));
+        wire.def_static("transmit_2d_to_2d", &Wire::transmit_Nd_to_Nd<2>, py::arg("registry"), py::arg("wire"));
+        wire.def_static("transmit_4d_to_4d", &Wire::transmit_Nd_to_Nd<4>, py::arg("registry"), py::arg("wire"));
+        wire.def_static("transmit_8d_to_8d", &Wire::transmit_Nd_to_Nd<8>, py::arg("registry"), py::arg("wire"));
+        wire.def_static("transmit_16d_to_16d", &Wire::transmit_Nd_to_Nd<16>, py::arg("registry"), py::arg("wire"));
+        wire.def_static("transmit_32d_to_32d", &Wire::transmit_Nd_to_Nd<32>, py::arg("registry"), py::arg("wire"));
 
 
         py::enum_<BlockType>(m, "BlockType")
@@ -167,7 +215,35 @@ PYBIND11_MODULE(AAri_cpp, m) {
                         .value("Sum", BlockType::Sum)
                         .value("Constant", BlockType::Constant)
                         .value("MonoMixer", BlockType::MonoMixer)
-                        .value("StereoMixer", BlockType::StereoMixer);
+                        .value("StereoMixer", BlockType::StereoMixer)
+                        .value("WavetableOsc", BlockType::WavetableOsc)
+                        .value("AdditiveBank", BlockType::AdditiveBank)
+                        .value("FmVoices", BlockType::FmVoices)
+                        .value("Adsr", BlockType::Adsr)
+                        .value("Ar", BlockType::Ar)
+                        .value("AdsrBank", BlockType::AdsrBank)
+                        .value("Biquad", BlockType::Biquad)
+                        .value("Svf", BlockType::Svf)
+                        .value("BiquadCascade", BlockType::BiquadCascade)
+                        .value("FilterBank", BlockType::FilterBank)
+                        .value("Delay", BlockType::Delay)
+                        .value("Comb", BlockType::Comb)
+                        .value("Allpass", BlockType::Allpass)
+                        .value("FdnReverb", BlockType::FdnReverb)
+                        .value("Convolution", BlockType::Convolution)
+                        .value("Sampler", BlockType::Sampler)
+                        .value("AudioInput", BlockType::AudioInput)
+                        .value("AuxBus", BlockType::AuxBus);
+
+        //DSP kernels dispatch
+        py::enum_<SimdLevel>(m, "SimdLevel")
+                        .value("Scalar", SimdLevel::Scalar)
+                        .value("SSE2", SimdLevel::SSE2)
+                        .value("AVX2", SimdLevel::AVX2)
+                        .value("AVX512", SimdLevel::AVX512);
+        m.def("detect_simd_level", &detect_simd_level);
+        m.def("get_simd_level", &get_simd_level);
+        m.def("set_simd_level", &set_simd_level, py::arg("level"));
 
         py::class_<WiresToBlock>(m, "WiresToBlock", py::module_local())
                         .def_readonly("input_wire_ids", &WiresToBlock::input_wire_ids);
@@ -186,7 +262,20 @@ PYBIND11_MODULE(AAri_cpp, m) {
         py::class_<IGraphRegistry>(m, "IGraphRegistry", py::module_local());
 
         py::class_<AudioEngine, IGraphRegistry>(m, "AudioEngine", py::module_local())
-                        .def(py::init<>())
+                        .def(py::init<ma_uint32, ma_uint32, bool, ma_uint32, bool, ma_uint32>(), py::arg("sample_rate") = 48000,
+                             py::arg("buffer_size") = 512, py::arg("headless") = false,
+                             py::arg("input_channels") = 0, py::arg("null_backend") = false,
+                             py::arg("output_channels") = 2)
+                        .def("render", [](AudioEngine&engine, ma_uint32 frames, const std::optional<FloatArray>&input) {
+                                py::array_t<float> buffer({(py::ssize_t)frames, (py::ssize_t)engine.get_output_channels()});
+                                if (input && (size_t)input->size() != (size_t)frames * engine.get_input_channels())
+                                        throw std::runtime_error("render: the input needs frames x input_channels values");
+                                engine.render(buffer.mutable_data(), frames, input ? input->data() : nullptr);
+                                return buffer;
+                        }, py::arg("frames"), py::arg("input") = std::nullopt)
+                        .def_property_readonly("sample_rate", &AudioEngine::get_sample_rate)
+                        .def_property_readonly("output_channels", &AudioEngine::get_output_channels)
+                        .def_property_readonly("input_channels", &AudioEngine::get_input_channels)
                         .def("startAudio", &AudioEngine::startAudio)
                         .def("stopAudio", &AudioEngine::stopAudio)
                         .def("add_wire", &AudioEngine::add_wire, py::arg("from_block"), py::arg("to_block"),
@@ -197,6 +286,36 @@ PYBIND11_MODULE(AAri_cpp, m) {
                              py::arg("to_block"),
                              py::arg("from_output"), py::arg("to_mixer_input_index"), py::arg("transmitFunc"),
                              py::arg("gain") = 1.0f, py::arg("offset") = 0.0f)
+                        .def("add_wires",
+                             [](AudioEngine&engine, const IdArray&from_blocks,
+                                const IdArray&to_blocks, const IdArray&from_outputs,
+                                const IdArray&to_inputs, TransmitFunc transmitFunc,
+                                const FloatArray&gains, const FloatArray&offsets) {
+                                     return to_id_array(engine.add_wires(
+                                             to_entities(from_blocks), to_entities(to_blocks),
+                                             to_entities(from_outputs), to_entities(to_inputs),
+                                             transmitFunc, to_floats(gains), to_floats(offsets)));
+                             },
+                             py::arg("from_blocks"), py::arg("to_blocks"), py::arg("from_outputs"),
+                             py::arg("to_inputs"), py::arg("transmitFunc"), py::arg("gains"), py::arg("offsets"))
+                        .def("add_wires_to_mixer",
+                             [](AudioEngine&engine, const IdArray&from_blocks,
+                                const IdArray&to_blocks, const IdArray&from_outputs,
+                                const IdArray&to_mixer_input_indices, TransmitFunc transmitFunc,
+                                const FloatArray&gains, const FloatArray&offsets) {
+                                     auto indices_view = to_mixer_input_indices.unchecked<1>();
+                                     std::vector<size_t> indices(indices_view.shape(0));
+                                     for (py::ssize_t i = 0; i < indices_view.shape(0); i++) {
+                                             indices[i] = indices_view(i);
+                                     }
+                                     return to_id_array(engine.add_wires_to_mixer(
+                                             to_entities(from_blocks), to_entities(to_blocks),
+                                             to_entities(from_outputs), indices,
+                                             transmitFunc, to_floats(gains), to_floats(offsets)));
+                             },
+                             py::arg("from_blocks"), py::arg("to_blocks"), py::arg("from_outputs"),
+                             py::arg("to_mixer_input_indices"), py::arg("transmitFunc"), py::arg("gains"),
+                             py::arg("offsets"))
                         .def("remove_wire", &AudioEngine::remove_wire, py::arg("wire_id"))
                         .def("remove_block", &AudioEngine::remove_block, py::arg("block_id"))
                         .def("tweak_wire_gain", &AudioEngine::tweak_wire_gain, py::arg("wire_id"), py::arg("gain"))
@@ -204,6 +323,19 @@ PYBIND11_MODULE(AAri_cpp, m) {
                              py::arg("offset"))
                         .def("set_output_ref", &AudioEngine::set_output_ref, py::arg("output_id"),
                              py::arg("output_width"))
+                        .def("set_output_bus", &AudioEngine::set_output_bus, py::arg("name"), py::arg("output_id"),
+                             py::arg("first_channel") = 0)
+                        .def("remove_output_bus", &AudioEngine::remove_output_bus, py::arg("name"))
+                        .def("add_aux_bus", &AudioEngine::add_aux_bus, py::arg("name"), py::arg("width") = 2,
+                             py::arg("gain") = 1.0f)
+                        .def("get_aux_bus", &AudioEngine::get_aux_bus, py::arg("name"))
+                        .def("remove_aux_bus", &AudioEngine::remove_aux_bus, py::arg("name"))
+                        .def("add_send", &AudioEngine::add_send, py::arg("from_block"), py::arg("from_output"),
+                             py::arg("bus"), py::arg("gain") = 1.0f)
+                        .def("tweak_send_gain", &AudioEngine::tweak_send_gain, py::arg("send_id"), py::arg("gain"))
+                        .def("remove_send", &AudioEngine::remove_send, py::arg("send_id"))
+                        .def("add_tap", &AudioEngine::add_tap, py::arg("output_id"))
+                        .def("remove_tap", &AudioEngine::remove_tap, py::arg("output_id"))
                         .def("view_block", &AudioEngine::view_block, py::arg("block_id"))
                         .def("view_wire", &AudioEngine::view_wire, py::arg("wire_id"))
                         .def("get_wires_to_block", &AudioEngine::get_wires_to_block, py::arg("block_id"))
@@ -213,34 +345,230 @@ PYBIND11_MODULE(AAri_cpp, m) {
                         .def("get_blocks", &AudioEngine::get_blocks)
                         .def("view_block_io", &AudioEngine::view_block_io, py::arg("block_id"))
                         .def("get_output_ref", &AudioEngine::get_output_ref)
+                        .def("save_snapshot", &AudioEngine::save_snapshot, py::arg("path"))
+                        .def("load_snapshot", [](AudioEngine&engine, const std::string&path) {
+                                return to_id_array(engine.load_snapshot(path));
+                        }, py::arg("path"))
+                        .def("capture_subgraph", [](AudioEngine&engine, const IdArray&blocks, const IdArray&exposed_ports) {
+                                return engine.capture_subgraph(to_entities(blocks), to_entities(exposed_ports));
+                        }, py::arg("blocks"), py::arg("exposed_ports") = IdArray(0))
+                        .def("clone_subgraph", &AudioEngine::clone_subgraph, py::arg("subgraph"), py::arg("copies"))
                         .def("set_input_1d", &AudioEngine::set_input_1d, py::arg("input_id"), py::arg("value"))
                         .def("set_input_2d", &AudioEngine::set_input_Nd<2>, py::arg("input_id"), py::arg("value"))
-                        .def("set_input_4d", &AudioEngine::set_input_Nd<4>, py::arg("input_id"), py::arg("value"));
+                        .def("set_input_4d", &AudioEngine::set_input_Nd<4>, py::arg("input_id"), py::arg("value"))
+                        .def("set_input_array", [](AudioEngine&engine, entt::entity input_id, const FloatArray&values,
+                                                   size_t offset) {
+                                engine.set_input_array(input_id, to_floats(values), offset);
+                        }, py::arg("input_id"), py::arg("values"), py::arg("offset") = 0)
+                        .def("add_voice_pool", &AudioEngine::add_voice_pool, py::arg("count"), py::arg("make_voice"),
+                             py::return_value_policy::reference_internal)
+                        .def("start_recording", &AudioEngine::start_recording, py::arg("path"),
+                             py::arg("output_id") = (entt::entity)entt::null,
+                             py::return_value_policy::reference_internal)
+                        .def("stop_recording", &AudioEngine::stop_recording, py::arg("recorder"));
+
+        py::class_<Recorder>(m, "Recorder", py::module_local())
+                        .def_property_readonly("channels", &Recorder::channels)
+                        .def_property_readonly("frames_written", &Recorder::frames_written)
+                        .def_property_readonly("dropped_frames", &Recorder::dropped_frames)
+                        .def_property_readonly("files", &Recorder::files)
+                        .def_property_readonly("failed", &Recorder::failed);
+
+        // Subgraph templates
+        py::class_<snapshot::Subgraph>(m, "Subgraph", py::module_local())
+                        .def_property_readonly("n_blocks", [](const snapshot::Subgraph&subgraph) {
+                                return subgraph.blocks.size();
+                        })
+                        .def_property_readonly("n_wires", [](const snapshot::Subgraph&subgraph) {
+                                return subgraph.wires.size();
+                        })
+                        .def_property_readonly("n_exposed_ports", [](const snapshot::Subgraph&subgraph) {
+                                return subgraph.exposed_ports.size();
+                        });
+        py::class_<snapshot::Instance>(m, "SubgraphInstance", py::module_local())
+                        .def_property_readonly("blocks", [](const snapshot::Instance&instance) {
+                                return to_id_array(instance.blocks);
+                        })
+                        .def_property_readonly("wires", [](const snapshot::Instance&instance) {
+                                return to_id_array(instance.wires);
+                        })
+                        .def_property_readonly("ports", [](const snapshot::Instance&instance) {
+                                return to_id_array(instance.ports);
+                        });
+
+        // Voices
+        py::class_<VoicePool> voice_pool(m, "VoicePool", py::module_local());
+        py::class_<VoicePool::Voice>(voice_pool, "Voice", py::module_local())
+                        .def(py::init<>())
+                        .def_readwrite("gate", &VoicePool::Voice::gate)
+                        .def_readwrite("freq", &VoicePool::Voice::freq)
+                        .def_readwrite("velocity", &VoicePool::Voice::velocity)
+                        .def_readwrite("retrigger", &VoicePool::Voice::retrigger)
+                        .def_readwrite("output_block", &VoicePool::Voice::output_block)
+                        .def_readwrite("blocks", &VoicePool::Voice::blocks);
+        voice_pool.def("note_on", &VoicePool::note_on, py::arg("note"), py::arg("velocity") = 1.0f)
+                        .def("note_off", &VoicePool::note_off, py::arg("note"))
+                        .def("all_notes_off", &VoicePool::all_notes_off)
+                        .def("voice_note", &VoicePool::voice_note, py::arg("voice"))
+                        .def_property_readonly("size", &VoicePool::size)
+                        .def_property_readonly("active_voices", &VoicePool::active_voices)
+                        .def_static("note_to_freq", &VoicePool::note_to_freq, py::arg("note"));
 
         // Mixers
-        py::class_<MonoMixer<2>>(m, "MonoMixer2", py::module_local())
-                        .def_static("create", &MonoMixer<2>::create);
-        py::class_<MonoMixer<4>>(m, "MonoMixer4", py::module_local())
-                        .def_static("create", &MonoMixer<4>::create);
-        py::class_<MonoMixer<8>>(m, "MonoMixer8", py::module_local())
-                        .def_static("create", &MonoMixer<8>::create);
-        py::class_<MonoMixer<16>>(m, "MonoMixer16", py::module_local())
-                        .def_static("create", &MonoMixer<16>::create);
-        py::class_<MonoMixer<32>>(m, "MonoMixer32", py::module_local())
-                        .def_static("create", &MonoMixer<32>::create);
-        py::class_<StereoMixer<2>>(m, "StereoMixer2", py::module_local())
-                        .def_static("create", &StereoMixer<2>::create);
-        py::class_<StereoMixer<4>>(m, "StereoMixer4", py::module_local())
-                        .def_static("create", &StereoMixer<4>::create);
-        py::class_<StereoMixer<8>>(m, "StereoMixer8", py::module_local())
-                        .def_static("create", &StereoMixer<8>::create);
-        py::class_<StereoMixer<16>>(m, "StereoMixer16", py::module_local())
-                        .def_static("create", &StereoMixer<16>::create);
-        py::class_<StereoMixer<32>>(m, "StereoMixer32", py::module_local())
-                        .def_static("create", &StereoMixer<32>::create);
+        py::class_<Mixer>(m, "Mixer", py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, size_t, size_t>(&Mixer::create),
+                                    py::arg("engine"), py::arg("slots"), py::arg("width") = 1)
+                        .def_static("create_many", [](IGraphRegistry* reg, size_t count, size_t slots, size_t width) {
+                                return to_id_array(Mixer::create_many(reg, count, slots, width));
+                        }, py::arg("engine"), py::arg("count"), py::arg("slots"), py::arg("width") = 1);
+        bind_mixer<MonoMixer<2>>(m, "MonoMixer2");
+        bind_mixer<MonoMixer<4>>(m, "MonoMixer4");
+        bind_mixer<MonoMixer<8>>(m, "MonoMixer8");
+        bind_mixer<MonoMixer<16>>(m, "MonoMixer16");
+        bind_mixer<MonoMixer<32>>(m, "MonoMixer32");
+        bind_mixer<StereoMixer<2>>(m, "StereoMixer2");
+        bind_mixer<StereoMixer<4>>(m, "StereoMixer4");
+        bind_mixer<StereoMixer<8>>(m, "StereoMixer8");
+        bind_mixer<StereoMixer<16>>(m, "StereoMixer16");
+        bind_mixer<StereoMixer<32>>(m, "StereoMixer32");
 
         //Oscillators
-        py::class_<SineOsc>(m, "SineOsc", py::module_local())
-                        .def_static("create", &SineOsc::create, py::arg("engine"), py::arg("freq") = 440.0f,
-                                    py::arg("amp") = 1.0f);
+        bind_oscillator<SineOsc>(m, "SineOsc");
+        bind_oscillator<SawOsc>(m, "SawOsc");
+        bind_oscillator<SquareOsc>(m, "SquareOsc");
+        bind_oscillator<TriOsc>(m, "TriOsc");
+
+        py::class_<Wavetables, std::unique_ptr<Wavetables, py::nodelete>> wavetables(m, "Wavetables",
+                                                                                  py::module_local());
+        wavetables.attr("SINE") = (uint32_t)Wavetables::SINE;
+        wavetables.attr("TRIANGLE") = (uint32_t)Wavetables::TRIANGLE;
+        wavetables.attr("SAW") = (uint32_t)Wavetables::SAW;
+        wavetables.attr("SQUARE") = (uint32_t)Wavetables::SQUARE;
+        wavetables.def_static("add", [](const FloatArray&cycle) {
+                    return Wavetables::instance().add(to_floats(cycle));
+                }, py::arg("cycle"))
+                .def_static("add_harmonics", [](const FloatArray&sines) {
+                    return Wavetables::instance().add_harmonics(to_floats(sines));
+                }, py::arg("sines"))
+                .def_static("size", []() { return Wavetables::instance().size(); });
+
+        py::class_<WavetableOsc> wavetable_osc(m, "WavetableOsc", py::module_local());
+        py::enum_<WavetableOsc::Interpolation>(wavetable_osc, "Interpolation")
+                        .value("Linear", WavetableOsc::Interpolation::Linear)
+                        .value("Cubic", WavetableOsc::Interpolation::Cubic);
+        wavetable_osc.def_static("create",
+                                 py::overload_cast<IGraphRegistry *, uint32_t, float, float,
+                                     WavetableOsc::Interpolation>(&WavetableOsc::create),
+                                 py::arg("engine"), py::arg("table") = (uint32_t)Wavetables::SINE,
+                                 py::arg("freq") = 440.0f, py::arg("amp") = 1.0f,
+                                 py::arg("interpolation") = WavetableOsc::Interpolation::Linear)
+                        .def_static("create_many",
+                                    [](IGraphRegistry* reg, uint32_t table, const FloatArray&freqs,
+                                       const FloatArray&amps, WavetableOsc::Interpolation interpolation) {
+                                            return to_id_array(WavetableOsc::create_many(
+                                                reg, table, to_floats(freqs), to_floats(amps), interpolation));
+                                    }, py::arg("engine"), py::arg("table"), py::arg("freqs"), py::arg("amps"),
+                                    py::arg("interpolation") = WavetableOsc::Interpolation::Linear);
+
+        py::class_<AdditiveBank>(m, "AdditiveBank", py::module_local())
+                        .def_static("create", [](IGraphRegistry* reg, const FloatArray&freqs, const FloatArray&amps,
+                                                 float amp) {
+                                            return AdditiveBank::create(reg, to_floats(freqs), to_floats(amps), amp);
+                                    }, py::arg("engine"), py::arg("freqs"), py::arg("amps"), py::arg("amp") = 1.0f);
+
+        py::class_<FmVoices> fm_voices(m, "FmVoices", py::module_local());
+        fm_voices.attr("OPERATORS") = FM_OPERATORS;
+        fm_voices.attr("ALGORITHMS") = FmVoices::ALGORITHMS.size();
+        fm_voices.def_static("create", [](IGraphRegistry* reg, const FloatArray&freqs, uint32_t algorithm, float amp) {
+                    return FmVoices::create(reg, to_floats(freqs), algorithm, amp);
+                }, py::arg("engine"), py::arg("freqs"), py::arg("algorithm") = 0, py::arg("amp") = 1.0f);
+
+        //Envelopes
+        py::class_<Adsr>(m, "Adsr", py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, float, float, float, float>(
+                                            &Adsr::create), py::arg("engine"), py::arg("attack") = 0.01f,
+                                    py::arg("decay") = 0.1f, py::arg("sustain") = 0.7f, py::arg("release") = 0.3f);
+        py::class_<Ar>(m, "Ar", py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, float, float>(&Ar::create),
+                                    py::arg("engine"), py::arg("attack") = 0.005f, py::arg("release") = 0.5f);
+        py::class_<AdsrBank>(m, "AdsrBank", py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, size_t, float, float, float, float>(
+                                            &AdsrBank::create), py::arg("engine"), py::arg("voices"),
+                                    py::arg("attack") = 0.01f, py::arg("decay") = 0.1f, py::arg("sustain") = 0.7f,
+                                    py::arg("release") = 0.3f);
+
+        //Filters, the modes are float inputs so they are given as class attributes
+        auto add_filter_modes = [](auto&cls) {
+                cls.attr("LOWPASS") = filter::LOWPASS;
+                cls.attr("HIGHPASS") = filter::HIGHPASS;
+                cls.attr("BANDPASS") = filter::BANDPASS;
+                cls.attr("NOTCH") = filter::NOTCH;
+        };
+        py::class_<Biquad> biquad(m, "Biquad", py::module_local());
+        add_filter_modes(biquad);
+        biquad.def_static("create", py::overload_cast<IGraphRegistry *, float, float, float>(&Biquad::create),
+                          py::arg("engine"), py::arg("cutoff") = 1000.0f, py::arg("q") = 0.7071f,
+                          py::arg("mode") = filter::LOWPASS);
+        py::class_<Svf> svf(m, "Svf", py::module_local());
+        add_filter_modes(svf);
+        svf.def_static("create", py::overload_cast<IGraphRegistry *, float, float, float>(&Svf::create),
+                       py::arg("engine"), py::arg("cutoff") = 1000.0f, py::arg("q") = 0.7071f,
+                       py::arg("mode") = filter::LOWPASS);
+        py::class_<BiquadCascade> cascade(m, "BiquadCascade", py::module_local());
+        add_filter_modes(cascade);
+        cascade.def_static("create", py::overload_cast<IGraphRegistry *, size_t, float, float, float>(
+                                   &BiquadCascade::create), py::arg("engine"), py::arg("sections"),
+                           py::arg("cutoff") = 1000.0f, py::arg("q") = 0.7071f, py::arg("mode") = filter::LOWPASS);
+        py::class_<FilterBank> filter_bank(m, "FilterBank", py::module_local());
+        add_filter_modes(filter_bank);
+        filter_bank.def_static("create", [](IGraphRegistry* reg, const FloatArray&cutoffs, float q, float mode) {
+                    return FilterBank::create(reg, to_floats(cutoffs), q, mode);
+                }, py::arg("engine"), py::arg("cutoffs"), py::arg("q") = 0.7071f, py::arg("mode") = filter::LOWPASS);
+
+        //Delay lines, max_delay and time in seconds
+        py::class_<Delay>(m, "Delay", py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, float, float>(&Delay::create),
+                                    py::arg("engine"), py::arg("max_delay"), py::arg("time"));
+        py::class_<Comb>(m, "Comb", py::module_local())
+                        .def_static("create",
+                                    py::overload_cast<IGraphRegistry *, float, float, float, float>(&Comb::create),
+                                    py::arg("engine"), py::arg("max_delay"), py::arg("time"),
+                                    py::arg("feedback") = 0.5f, py::arg("damping") = 0.0f);
+        py::class_<Allpass>(m, "Allpass", py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, float, float, float>(&Allpass::create),
+                                    py::arg("engine"), py::arg("max_delay"), py::arg("time"), py::arg("gain") = 0.5f);
+        py::class_<FdnReverb> fdn_reverb(m, "FdnReverb", py::module_local());
+        fdn_reverb.attr("HADAMARD") = FdnReverb::HADAMARD;
+        fdn_reverb.attr("HOUSEHOLDER") = FdnReverb::HOUSEHOLDER;
+        fdn_reverb.def_static("create", py::overload_cast<IGraphRegistry *, size_t, float, float, float>(
+                                      &FdnReverb::create), py::arg("engine"), py::arg("lines") = 16,
+                              py::arg("size") = 1.0f, py::arg("decay") = 2.0f, py::arg("damping") = 0.3f);
+        py::class_<Convolution>(m, "Convolution", py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, const std::vector<float> &, float>(
+                                        &Convolution::create), py::arg("engine"), py::arg("impulse_response"),
+                                    py::arg("gain") = 1.0f)
+                        .def_static("create_from_file", &Convolution::create_from_file, py::arg("engine"),
+                                    py::arg("path"), py::arg("channel") = 0, py::arg("gain") = 1.0f);
+
+        py::class_<Samples, std::unique_ptr<Samples, py::nodelete>>(m, "Samples", py::module_local())
+                        .def_static("load", [](const std::string&path, uint32_t sample_rate, size_t preload_frames) {
+                            return Samples::instance().load(path, sample_rate, preload_frames);
+                        }, py::arg("path"), py::arg("sample_rate") = 48000,
+                                    py::arg("preload_frames") = Samples::PRELOAD_FRAMES)
+                        .def_static("size", []() { return Samples::instance().size(); });
+        py::class_<AudioInput>(m, "AudioInput", py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, size_t, size_t, float>(
+                                        &AudioInput::create), py::arg("engine"), py::arg("first_channel") = 0,
+                                    py::arg("channels") = 2, py::arg("gain") = 1.0f);
+        py::class_<Sampler>(m, "Sampler", py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, uint32_t, float>(&Sampler::create),
+                                    py::arg("engine"), py::arg("sample"), py::arg("gain") = 1.0f);
+
+        py::class_<Constant>(m, "Constant", py::module_local())
+                        .def_static("create", py::overload_cast<IGraphRegistry *, float>(&Constant::create),
+                                    py::arg("engine"), py::arg("value") = 0.0f)
+                        .def_static("create_many",
+                                    [](IGraphRegistry* reg, const FloatArray&values) {
+                                            return to_id_array(Constant::create_many(reg, to_floats(values)));
+                                    }, py::arg("engine"), py::arg("values"));
 }
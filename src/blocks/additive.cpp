@@ -0,0 +1,78 @@
+//
+//
+
+#include "additive.h"
+#include "../core/kernels/kernels.h"
+
+using namespace AAri;
+
+void AdditiveBank::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&pitch = registry.get<Input1D>(block.inputIds[0]);
+    auto&amp = registry.get<Input1D>(block.inputIds[1]);
+    auto&freqs = registry.get<InputArray>(block.inputIds[2]);
+    auto&amps = registry.get<InputArray>(block.inputIds[3]);
+    auto&phases = registry.get<InputArray>(block.inputIds[4]);
+    auto&out = registry.get<Output1D>(block.outputIds[0]);
+
+    out.value = amp.value * kernels().sine_bank(phases.value.data(), freqs.value.data(), amps.value.data(),
+                                                phases.value.size(), pitch.value * ctx.dt);
+}
+
+entt::entity AdditiveBank::create(IGraphRegistry* reg, const std::vector<float>&freqs,
+                                  const std::vector<float>&amps, float init_amp) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, freqs, amps, init_amp);
+}
+
+entt::entity AdditiveBank::create(entt::registry&registry, const std::vector<float>&freqs,
+                                  const std::vector<float>&amps, float init_amp) {
+    if (freqs.size() != amps.size())
+        throw std::runtime_error("AdditiveBank: freqs and amps must have the same size");
+
+    auto pitch = registry.create();
+    registry.emplace<Input1D>(pitch, 1.0f);
+    auto amp = registry.create();
+    registry.emplace<Input1D>(amp, init_amp);
+    auto freqs_id = registry.create();
+    registry.emplace<InputArray>(freqs_id, freqs);
+    auto amps_id = registry.create();
+    registry.emplace<InputArray>(amps_id, amps);
+    auto phases = registry.create();
+    registry.emplace<InputArray>(phases, std::vector<float>(freqs.size(), 0.0f));
+    auto out = registry.create();
+    registry.emplace<Output1D>(out, 0.0f);
+
+    auto block = Block::create(registry, BlockType::AdditiveBank,
+                               fill_with_null<N_INPUTS>(pitch, amp, freqs_id, amps_id, phases),
+                               fill_with_null<N_OUTPUTS>(out),
+                               process, view);
+    setup(registry, block);
+    return block;
+}
+
+void AdditiveBank::setup(entt::registry&registry, entt::entity block) {
+    const auto&ids = registry.get<Block>(block).inputIds;
+    const size_t size = registry.get<InputArray>(ids[2]).value.size();
+    if (registry.get<InputArray>(ids[3]).value.size() != size || registry.get<InputArray>(ids[4]).value.size() != size)
+        throw std::runtime_error("AdditiveBank: freqs, amps and phases must have the same size");
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool AdditiveBank::is_silent(entt::registry&registry, const Block&block) {
+    return registry.get<Input1D>(block.inputIds[1]).value == 0.0f;
+}
+
+IoMap AdditiveBank::view(entt::registry&registry, const Block&block) {
+    IoMap io_map;
+    for (size_t i = 0; i < 2; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+    }
+    for (size_t i = 2; i < 5; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<InputArray>(registry.get<InputArray>(inputid));
+    }
+    auto outid = block.outputIds[0];
+    io_map[outid] = std::make_unique<Output1D>(registry.get<Output1D>(outid));
+    return io_map;
+}
@@ -0,0 +1,45 @@
+//
+//
+
+#ifndef RELEASE_ADDITIVE_H
+#define RELEASE_ADDITIVE_H
+
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include <entt/entt.hpp>
+
+namespace AAri {
+    /**
+     * Bank of sine partials rendered by a single block, instead of one SineOsc per partial and a tree of mixers.
+     * Inputs:
+     *   0 pitch   multiplies the frequencies of all the partials, 1 by default
+     *   1 amp     overall amplitude
+     *   2 freqs   InputArray, frequency of each partial in Hz
+     *   3 amps    InputArray, amplitude of each partial
+     *   4 phases  InputArray, phase of each partial in cycles
+     * The arrays are set in bulk with AudioEngine::set_input_array. Partials above Nyquist are muted.
+     */
+    struct AdditiveBank {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, const std::vector<float> &freqs,
+                                   const std::vector<float> &amps, float init_amp = 1.0f);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, const std::vector<float> &freqs,
+                                   const std::vector<float> &amps, float init_amp = 1.0f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        // Throws if the arrays don't all have the same size, e.g. in a corrupt snapshot
+        static void setup(entt::registry &registry, entt::entity block);
+
+        // Silent when the overall amplitude is zero
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+}
+
+#endif //RELEASE_ADDITIVE_H
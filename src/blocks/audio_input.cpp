@@ -0,0 +1,52 @@
+//
+//
+
+#include "audio_input.h"
+#include <stdexcept>
+
+using namespace AAri;
+
+void AudioInput::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    const float first = registry.get<Input1D>(block.inputIds[0]).value;
+    const float gain = registry.get<Input1D>(block.inputIds[1]).value;
+    const size_t channel = first > 0.0f ? size_t(first) : 0;
+    for (size_t i = 0; i < MAX_CHANNELS && block.outputIds[i] != entt::null; i++) {
+        auto&out = registry.get<Output1D>(block.outputIds[i]);
+        out.value = ctx.input != nullptr && channel + i < ctx.input_channels ? gain * ctx.input[channel + i] : 0.0f;
+    }
+}
+
+entt::entity AudioInput::create(IGraphRegistry* reg, size_t first_channel, size_t channels, float gain) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, first_channel, channels, gain);
+}
+
+entt::entity AudioInput::create(entt::registry&registry, size_t first_channel, size_t channels, float gain) {
+    if (channels == 0 || channels > MAX_CHANNELS)
+        throw std::runtime_error("AudioInput: 1 to " + std::to_string(MAX_CHANNELS) + " channels per block");
+    std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+    const float values[] = {float(first_channel), gain};
+    for (size_t i = 0; i < 2; i++) {
+        inputs[i] = registry.create();
+        registry.emplace<Input1D>(inputs[i], values[i]);
+    }
+    std::array<entt::entity, N_OUTPUTS> outputs = fill_with_null<N_OUTPUTS>();
+    for (size_t i = 0; i < channels; i++) {
+        outputs[i] = registry.create();
+        registry.emplace<Output1D>(outputs[i], 0.0f);
+    }
+    return Block::create(registry, BlockType::AudioInput, inputs, outputs, process, view);
+}
+
+IoMap AudioInput::view(entt::registry&registry, const Block&block) {
+    IoMap io_map;
+    for (size_t i = 0; i < 2; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+    }
+    for (size_t i = 0; i < MAX_CHANNELS && block.outputIds[i] != entt::null; i++) {
+        auto outid = block.outputIds[i];
+        io_map[outid] = std::make_unique<Output1D>(registry.get<Output1D>(outid));
+    }
+    return io_map;
+}
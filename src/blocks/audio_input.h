@@ -0,0 +1,39 @@
+//
+//
+
+#ifndef AARI_AUDIO_INPUT_H
+#define AARI_AUDIO_INPUT_H
+
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include <entt/entt.hpp>
+
+namespace AAri {
+    /**
+     * Live input: channels captured by the audio device of an engine opened with input channels, read
+     * straight from the device buffer (AudioContext::input), e.g. to run a guitar or a microphone through effects.
+     * Inputs: first channel and gain.
+     * Outputs: 1 to 4 consecutive channels from the first one, 0 for channels the device doesn't have
+     * or when there is no input, e.g. offline renders without input.
+     * The block never sleeps, its output changes without any input changing.
+     */
+    struct AudioInput {
+        static constexpr size_t MAX_CHANNELS = N_OUTPUTS;
+
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, size_t first_channel = 0, size_t channels = 2,
+                                   float gain = 1.0f);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, size_t first_channel = 0, size_t channels = 2,
+                                   float gain = 1.0f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+    };
+}
+
+#endif //AARI_AUDIO_INPUT_H
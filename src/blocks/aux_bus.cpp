@@ -0,0 +1,65 @@
+//
+//
+
+#include "aux_bus.h"
+#include <stdexcept>
+
+using namespace AAri;
+
+void AuxBus::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    const auto&sends = registry.get<GatherList>(block.inputIds[0]);
+    const float gain = registry.get<Input1D>(block.inputIds[0]).value;
+    if (sends.width == 1) {
+        registry.get<Output1D>(block.outputIds[0]).value = gain * sends.sum(0);
+        return;
+    }
+    auto&out = registry.get<OutputND<2>>(block.outputIds[0]).value;
+    out[0] = gain * sends.sum(0);
+    out[1] = gain * sends.sum(1);
+}
+
+entt::entity AuxBus::create(IGraphRegistry* reg, size_t width, float gain) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, width, gain);
+}
+
+entt::entity AuxBus::create(entt::registry&registry, size_t width, float gain) {
+    if (width != 1 && width != 2)
+        throw std::runtime_error("AuxBus: a bus is mono or stereo");
+    std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+    inputs[0] = registry.create();
+    registry.emplace<Input1D>(inputs[0], gain);
+    auto out = registry.create();
+    if (width == 1)
+        registry.emplace<Output1D>(out, 0.0f);
+    else
+        registry.emplace<OutputND<2>>(out, std::array<float, 2>{0.0f, 0.0f});
+
+    auto block = Block::create(registry, BlockType::AuxBus, inputs, fill_with_null<N_OUTPUTS>(out), process, view);
+    setup(registry, block);
+    return block;
+}
+
+void AuxBus::setup(entt::registry&registry, entt::entity block) {
+    const auto&b = registry.get<Block>(block);
+    GatherList sends;
+    sends.width = registry.all_of<Output1D>(b.outputIds[0]) ? 1 : 2;
+    registry.emplace_or_replace<GatherList>(b.inputIds[0], std::move(sends));
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool AuxBus::is_silent(entt::registry&registry, const Block&block) {
+    return registry.get<GatherList>(block.inputIds[0]).sources_asleep(registry);
+}
+
+IoMap AuxBus::view(entt::registry&registry, const Block&block) {
+    IoMap io_map;
+    auto gainid = block.inputIds[0];
+    io_map[gainid] = std::make_unique<Input1D>(registry.get<Input1D>(gainid));
+    auto outid = block.outputIds[0];
+    if (auto* mono = registry.try_get<Output1D>(outid))
+        io_map[outid] = std::make_unique<Output1D>(*mono);
+    else
+        io_map[outid] = std::make_unique<OutputND<2>>(registry.get<OutputND<2>>(outid));
+    return io_map;
+}
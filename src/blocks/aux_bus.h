@@ -0,0 +1,51 @@
+//
+//
+
+#ifndef AARI_AUX_BUS_H
+#define AARI_AUX_BUS_H
+
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include "../core/gather.h"
+#include <entt/entt.hpp>
+
+namespace AAri {
+    /**
+     * A block output sent to an AuxBus with a gain, on its own entity like a Wire.
+     * Sends are made through the AudioEngine (add_send) since they change the order of the blocks
+     */
+    struct Send {
+        entt::entity from_block = entt::null;
+        entt::entity from_output = entt::null;
+        entt::entity bus = entt::null;
+        float gain = 1.0f;
+    };
+
+    /**
+     * Send/return bus: any number of block outputs are sent to it, each with its own gain, and summed into
+     * its output, which feeds a single effect chain through ordinary wires, e.g. one reverb for all the voices
+     * rather than one per voice. The sends are gathered like the wires of a mixer (see GatherList).
+     * Inputs: gain, the return level.
+     * Outputs: Output1D for a mono bus, OutputND<2> for a stereo one. Mono sources are sent to both channels
+     * of a stereo bus and stereo sources to a mono bus as the mean of their channels.
+     */
+    struct AuxBus {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, size_t width = 2, float gain = 1.0f);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, size_t width = 2, float gain = 1.0f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+}
+
+#endif //AARI_AUX_BUS_H
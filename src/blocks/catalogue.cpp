@@ -0,0 +1,115 @@
+//
+//
+
+#include "catalogue.h"
+#include "oscillators.h"
+#include "mixers.h"
+#include "constants.h"
+#include "additive.h"
+#include "fm.h"
+#include "envelopes.h"
+#include "filters.h"
+#include "delays.h"
+#include "reverb.h"
+#include "convolution.h"
+#include "samples.h"
+#include "audio_input.h"
+#include "aux_bus.h"
+
+using namespace AAri;
+
+const std::vector<BlockKind>&AAri::block_kinds() {
+    static const std::vector<BlockKind> kinds = {
+        {"SineOsc", BlockType::SineOsc, SineOsc::process, SineOsc::view, SineOsc::setup, "f f f / f"},
+        {"WavetableOsc", BlockType::WavetableOsc, WavetableOsc::process, WavetableOsc::view, WavetableOsc::setup, "f f f f / f"},
+        {
+            "WavetableOscCubic", BlockType::WavetableOsc, WavetableOsc::process_cubic, WavetableOsc::view,
+            WavetableOsc::setup, "f f f f / f"
+        },
+        {"SawOsc", BlockType::SawOsc, SawOsc::process, SawOsc::view, SawOsc::setup, "f f f / f"},
+        {"SquareOsc", BlockType::SquareOsc, SquareOsc::process, SquareOsc::view, SquareOsc::setup, "f f f / f"},
+        {"TriOsc", BlockType::TriOsc, TriOsc::process, TriOsc::view, TriOsc::setup, "f f f / f"},
+        {"AdditiveBank", BlockType::AdditiveBank, AdditiveBank::process, AdditiveBank::view, AdditiveBank::setup, "f f a a a / f"},
+        {"FmVoices", BlockType::FmVoices, FmVoices::process, FmVoices::view, FmVoices::setup, "f f f a a a a a / f"},
+        {"Adsr", BlockType::Adsr, Adsr::process, Adsr::view, Adsr::setup, "f f f f f f / f"},
+        {"Ar", BlockType::Ar, Ar::process, Ar::view, Ar::setup, "f f f f / f"},
+        {"AdsrBank", BlockType::AdsrBank, AdsrBank::process, AdsrBank::view, AdsrBank::setup, "f f f f a a / a"},
+        {"Biquad", BlockType::Biquad, Biquad::process, Biquad::view, Biquad::setup, "f f f f n4 / f"},
+        {"Svf", BlockType::Svf, Svf::process, Svf::view, Svf::setup, "f f f f n4 / f f f f"},
+        {
+            "BiquadCascade", BlockType::BiquadCascade, BiquadCascade::process, BiquadCascade::view,
+            BiquadCascade::setup, "f f f f a / f"
+        },
+        {"FilterBank", BlockType::FilterBank, FilterBank::process, FilterBank::view, FilterBank::setup, "f a a a a / a f"},
+        {"Delay", BlockType::Delay, Delay::process, Delay::view, Delay::setup, "f f f / f"},
+        {"Comb", BlockType::Comb, Comb::process, Comb::view, Comb::setup, "f f f f f / f"},
+        {"Allpass", BlockType::Allpass, Allpass::process, Allpass::view, Allpass::setup, "f f f f / f"},
+        {"FdnReverb", BlockType::FdnReverb, FdnReverb::process, FdnReverb::view, FdnReverb::setup, "n2 f f f a / n2"},
+        {"Convolution", BlockType::Convolution, Convolution::process, Convolution::view, Convolution::setup, "f f a / f"},
+        {"Sampler", BlockType::Sampler, Sampler::process, Sampler::view, Sampler::setup, "f f f / n2"},
+        {"AudioInput", BlockType::AudioInput, AudioInput::process, AudioInput::view, nullptr, "f f / f*"},
+        {"AuxBus", BlockType::AuxBus, AuxBus::process, AuxBus::view, AuxBus::setup, "f / x"},
+        {"Constant", BlockType::Constant, Constant::process, Constant::view, Constant::setup, "f / f"},
+        {"MonoMixer", BlockType::MonoMixer, Mixer::process_mono, nullptr, Mixer::setup, "m / f"},
+        {"StereoMixer", BlockType::StereoMixer, Mixer::process_stereo, nullptr, Mixer::setup, "m / n2"},
+    };
+    return kinds;
+}
+
+const std::vector<TransmitKind>&AAri::transmit_kinds() {
+    static const std::vector<TransmitKind> kinds = {
+        {"transmit_1d_to_1d", Wire::transmit_1d_to_1d, "f / f"},
+        {"broadcast_1d_to_2d", Wire::broadcast_1d_to_Nd<2>, "f / n2"},
+        {"broadcast_1d_to_4d", Wire::broadcast_1d_to_Nd<4>, "f / n4"},
+        {"broadcast_1d_to_8d", Wire::broadcast_1d_to_Nd<8>, "f / n8"},
+        {"broadcast_1d_to_16d", Wire::broadcast_1d_to_Nd<16>, "f / n16"},
+        {"broadcast_1d_to_32d", Wire::broadcast_1d_to_Nd<32>, "f / n32"},
+        {"transmit_2d_to_2d", Wire::transmit_Nd_to_Nd<2>, "n2 / n2"},
+        {"transmit_4d_to_4d", Wire::transmit_Nd_to_Nd<4>, "n4 / n4"},
+        {"transmit_8d_to_8d", Wire::transmit_Nd_to_Nd<8>, "n8 / n8"},
+        {"transmit_16d_to_16d", Wire::transmit_Nd_to_Nd<16>, "n16 / n16"},
+        {"transmit_32d_to_32d", Wire::transmit_Nd_to_Nd<32>, "n32 / n32"},
+        {"transmit_array_to_array", Wire::transmit_array_to_array, "a / a"},
+        {"transmit_to_mixer", Wire::transmit_to_mixer, "x / m"},
+    };
+    return kinds;
+}
+
+int AAri::find_block_kind(const Block&block) {
+    const auto&kinds = block_kinds();
+    for (size_t i = 0; i < kinds.size(); i++) {
+        if (kinds[i].type == block.type && kinds[i].processFunc == block.processFunc)
+            return (int)i;
+    }
+    return -1;
+}
+
+int AAri::find_block_kind(std::string_view name) {
+    const auto&kinds = block_kinds();
+    for (size_t i = 0; i < kinds.size(); i++) {
+        if (name == kinds[i].name)
+            return (int)i;
+    }
+    return -1;
+}
+
+int AAri::find_transmit_kind(const Wire&wire) {
+    auto* func = wire.transmitFunc.target<TransmitFuncPtr>();
+    if (func == nullptr)
+        return -1;
+    const auto&kinds = transmit_kinds();
+    for (size_t i = 0; i < kinds.size(); i++) {
+        if (kinds[i].transmitFunc == *func)
+            return (int)i;
+    }
+    return -1;
+}
+
+int AAri::find_transmit_kind(std::string_view name) {
+    const auto&kinds = transmit_kinds();
+    for (size_t i = 0; i < kinds.size(); i++) {
+        if (name == kinds[i].name)
+            return (int)i;
+    }
+    return -1;
+}
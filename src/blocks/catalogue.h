@@ -0,0 +1,64 @@
+//
+//
+
+#ifndef AARI_CATALOGUE_H
+#define AARI_CATALOGUE_H
+
+#include "../core/blocks.h"
+#include "../core/wires.h"
+#include <string_view>
+#include <vector>
+
+namespace AAri {
+    using TransmitFuncPtr = void (*)(entt::registry &, const Wire &);
+
+    // Adds the components of a block other than its inputs and outputs
+    typedef void (*SetupFunc)(entt::registry &registry, entt::entity block);
+
+    /**
+     * Stable names for the block implementations and wire transmit functions.
+     * Function pointers are not stable between builds so anything that is persisted
+     * (snapshots) refers to blocks and wires through these names.
+     *
+     * The ports are what the functions expect, so that snapshots can reject files they would crash on:
+     * space separated tokens, the inputs then the outputs of a block, or the output then the input of a wire,
+     * with a " / " in between. f is a 1D port, a an array, m a MixerInput, nW an ND port of width W
+     * (e.g. n4), x an Output1D or an OutputND<2>. A token ending with * stands for any number of such ports,
+     * including none. The slots after the last token are empty.
+     */
+    struct BlockKind {
+        const char *name;
+        BlockType type;
+        ProcessFunc processFunc;
+        ViewFunc viewFunc;
+        SetupFunc setupFunc;
+        const char *ports;
+    };
+
+    struct TransmitKind {
+        const char *name;
+        TransmitFuncPtr transmitFunc;
+        const char *ports;
+    };
+
+    const std::vector<BlockKind> &block_kinds();
+
+    const std::vector<TransmitKind> &transmit_kinds();
+
+    /**
+     * @return the index of the block's kind in block_kinds() or -1 if unknown
+     */
+    int find_block_kind(const Block &block);
+
+    int find_block_kind(std::string_view name);
+
+    /**
+     * @return the index of the wire's transmit function in transmit_kinds() or -1 if unknown
+     * (e.g. a lambda or a python function)
+     */
+    int find_transmit_kind(const Wire &wire);
+
+    int find_transmit_kind(std::string_view name);
+}
+
+#endif //AARI_CATALOGUE_H
@@ -0,0 +1,54 @@
+//
+//
+
+#include "constants.h"
+
+using namespace AAri;
+
+void Constant::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    registry.get<Output1D>(block.outputIds[0]).value = registry.get<Input1D>(block.inputIds[0]).value;
+}
+
+entt::entity Constant::create(IGraphRegistry* reg, float value) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, value);
+}
+
+entt::entity Constant::create(entt::registry&registry, float value) {
+    auto input = registry.create();
+    registry.emplace<Input1D>(input, value);
+    auto output = registry.create();
+    registry.emplace<Output1D>(output, value);
+
+    auto block = Block::create(registry, BlockType::Constant,
+                               fill_with_null<N_INPUTS>(input),
+                               fill_with_null<N_OUTPUTS>(output),
+                               process, view);
+    setup(registry, block);
+    return block;
+}
+
+std::vector<entt::entity> Constant::create_many(IGraphRegistry* reg, const std::vector<float>&values) {
+    auto [registry, guard] = reg->get_graph_registry();
+    std::vector<entt::entity> blocks;
+    blocks.reserve(values.size());
+    for (auto value: values) {
+        blocks.push_back(create(registry, value));
+    }
+    return blocks;
+}
+
+void Constant::setup(entt::registry&registry, entt::entity block) {
+    //Silent when its input is
+    registry.emplace<Silence>(block);
+}
+
+IoMap Constant::view(entt::registry&registry, const Block&block) {
+    auto inputid = block.inputIds[0];
+    auto outputid = block.outputIds[0];
+
+    IoMap io_map;
+    io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+    io_map[outputid] = std::make_unique<Output1D>(registry.get<Output1D>(outputid));
+    return io_map;
+}
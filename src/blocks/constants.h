@@ -0,0 +1,37 @@
+//
+//
+
+#ifndef RELEASE_CONSTANTS_H
+#define RELEASE_CONSTANTS_H
+
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include <entt/entt.hpp>
+
+namespace AAri {
+    /**
+     * Copies its input to its output: a fixed value when the input is left unwired (e.g. a parameter
+     * set from python), or a named passthrough point when it is wired.
+     * The graph compiler folds the former into the inputs it feeds and fuses the wires around the latter,
+     * so neither costs anything per sample unless its output is tapped.
+     */
+    struct Constant {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, float value = 0.0f);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, float value = 0.0f);
+
+        static std::vector<entt::entity> create_many(IGraphRegistry *reg, const std::vector<float> &values);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
+    };
+}
+
+#endif //RELEASE_CONSTANTS_H
@@ -0,0 +1,75 @@
+//
+//
+
+#include "convolution.h"
+#include "../core/audio_file.h"
+#include <stdexcept>
+
+using namespace AAri;
+
+void Convolution::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&input = registry.get<Input1D>(block.inputIds[0]);
+    auto&gain = registry.get<Input1D>(block.inputIds[1]);
+    auto&state = registry.get<ConvolutionState>(block.inputIds[2]);
+    auto&out = registry.get<Output1D>(block.outputIds[0]);
+    out.value = gain.value * state.convolver->process(input.value, ctx.realtime);
+}
+
+entt::entity Convolution::create(IGraphRegistry* reg, const std::vector<float>&impulse_response, float gain) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, impulse_response, gain);
+}
+
+entt::entity Convolution::create_from_file(IGraphRegistry* reg, const std::string&path, size_t channel,
+                                           float gain) {
+    //Decoded before locking, it can take a while
+    auto channels = read_audio_file(path, reg->get_sample_rate());
+    if (channel >= channels.size())
+        throw std::runtime_error("Convolution: " + path + " has no channel " + std::to_string(channel));
+    return create(reg, channels[channel], gain);
+}
+
+entt::entity Convolution::create(entt::registry&registry, const std::vector<float>&impulse_response, float gain) {
+    if (impulse_response.empty())
+        throw std::runtime_error("Convolution: the impulse response is empty");
+    std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+    inputs[0] = registry.create();
+    registry.emplace<Input1D>(inputs[0], 0.0f);
+    inputs[1] = registry.create();
+    registry.emplace<Input1D>(inputs[1], gain);
+    inputs[2] = registry.create();
+    registry.emplace<InputArray>(inputs[2], impulse_response);
+    auto out = registry.create();
+    registry.emplace<Output1D>(out, 0.0f);
+
+    auto block = Block::create(registry, BlockType::Convolution, inputs, fill_with_null<N_OUTPUTS>(out), process,
+                               view);
+    setup(registry, block);
+    return block;
+}
+
+void Convolution::setup(entt::registry&registry, entt::entity block) {
+    const auto irid = registry.get<Block>(block).inputIds[2];
+    const auto&impulse_response = registry.get<InputArray>(irid).value;
+    if (impulse_response.empty())
+        throw std::runtime_error("Convolution: the impulse response is empty");
+    registry.emplace_or_replace<ConvolutionState>(irid, std::make_unique<Convolver>(impulse_response));
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool Convolution::is_silent(entt::registry&registry, const Block&block) {
+    return registry.get<Input1D>(block.inputIds[0]).value == 0.0f &&
+           registry.get<ConvolutionState>(block.inputIds[2]).convolver->is_silent();
+}
+
+IoMap Convolution::view(entt::registry&registry, const Block&block) {
+    IoMap io_map;
+    for (size_t i = 0; i < 2; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+    }
+    io_map[block.inputIds[2]] = std::make_unique<InputArray>(registry.get<InputArray>(block.inputIds[2]));
+    auto outid = block.outputIds[0];
+    io_map[outid] = std::make_unique<Output1D>(registry.get<Output1D>(outid));
+    return io_map;
+}
@@ -0,0 +1,61 @@
+//
+//
+
+#ifndef AARI_CONVOLUTION_H
+#define AARI_CONVOLUTION_H
+
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include "../core/convolver.h"
+#include <entt/entt.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace AAri {
+    /**
+     * Convolver of a Convolution block, kept as a component of its impulse response input
+     */
+    struct ConvolutionState {
+        std::unique_ptr<Convolver> convolver;
+    };
+
+    /**
+     * Convolution with a recorded impulse response (room, cabinet, plate...), without latency.
+     * The impulse response is split in partitions convolved by FFT, the long tail on a thread of its own
+     * per block (see Convolver).
+     * Inputs: input, gain, impulse response in samples at the rate of the engine (InputArray, only read by setup).
+     * Output: the convolved input times gain, i.e. the wet signal alone.
+     * The block is mono, a stereo impulse response takes one block per channel.
+     * It sleeps once its input has been 0 for the length of the impulse response.
+     */
+    struct Convolution {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, const std::vector<float> &impulse_response,
+                                   float gain = 1.0f);
+
+        /**
+         * Load the impulse response from channel of an audio file, resampled to the rate of the engine.
+         * Throws if the file cannot be decoded or has no such channel
+         */
+        static entt::entity create_from_file(IGraphRegistry *reg, const std::string &path, size_t channel = 0,
+                                             float gain = 1.0f);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, const std::vector<float> &impulse_response,
+                                   float gain = 1.0f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        // Throws if the impulse response is empty
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+}
+
+#endif //AARI_CONVOLUTION_H
@@ -0,0 +1,178 @@
+//
+//
+
+#include "delays.h"
+#include "../core/utils/filter.h"
+#include <cmath>
+#include <stdexcept>
+
+using namespace AAri;
+
+namespace {
+    /**
+     * Input1D inputs with values, then the ring length sized for max_delay seconds
+     */
+    template<size_t N>
+    entt::entity create_delay_block(entt::registry&registry, BlockType type, const float (&values)[N],
+                                    float max_delay, float sample_rate, ProcessFunc process, ViewFunc view) {
+        if (!(max_delay > 0.0f))
+            throw std::runtime_error("Delay lines need a positive max_delay");
+        std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+        for (size_t i = 0; i < N; i++) {
+            inputs[i] = registry.create();
+            registry.emplace<Input1D>(inputs[i], values[i]);
+        }
+        inputs[N] = registry.create();
+        registry.emplace<Input1D>(inputs[N], float(DelayLine::length_for(max_delay * sample_rate)));
+        auto out = registry.create();
+        registry.emplace<Output1D>(out, 0.0f);
+        return Block::create(registry, type, inputs, fill_with_null<N_OUTPUTS>(out), process, view);
+    }
+
+    // Takes the ring from the pool, a fresh one for copies of a block
+    void setup_line(entt::registry&registry, entt::entity block, size_t length_input, SilenceFunc is_silent) {
+        const auto lengthid = registry.get<Block>(block).inputIds[length_input];
+        const float length = registry.get<Input1D>(lengthid).value;
+        const auto n = size_t(length);
+        if (!(length >= 16.0f && length <= float(size_t(1) << 30)) || float(n) != length || (n & (n - 1)) != 0)
+            throw std::runtime_error("Delay lines need a power of two length of at least 16 samples");
+        registry.emplace_or_replace<DelayLine>(lengthid, n);
+        registry.emplace<Silence>(block, is_silent);
+    }
+
+    bool is_silent_line(entt::registry&registry, const Block&block, size_t length_input) {
+        return registry.get<Input1D>(block.inputIds[0]).value == 0.0f &&
+               registry.get<DelayLine>(block.inputIds[length_input]).is_silent();
+    }
+
+    IoMap view_line(entt::registry&registry, const Block&block) {
+        IoMap io_map;
+        for (auto inputid: block.inputIds) {
+            if (inputid != entt::null)
+                io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+        }
+        auto outid = block.outputIds[0];
+        io_map[outid] = std::make_unique<Output1D>(registry.get<Output1D>(outid));
+        return io_map;
+    }
+
+    // Feedback loops write 0 rather than decaying forever in the denormals, so that the lines fall silent
+    float flush(float x) {
+        return std::abs(x) < filter::SILENCE ? 0.0f : x;
+    }
+}
+
+// Delay ---------------------------------------------------------------------------------------
+
+void Delay::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&input = registry.get<Input1D>(block.inputIds[0]);
+    auto&time = registry.get<Input1D>(block.inputIds[1]);
+    auto&line = registry.get<DelayLine>(block.inputIds[2]);
+    registry.get<Output1D>(block.outputIds[0]).value = line.read(time.value * ctx.sample_freq);
+    line.write(input.value);
+}
+
+entt::entity Delay::create(IGraphRegistry* reg, float max_delay, float time) {
+    const auto sample_rate = float(reg->get_sample_rate());
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, max_delay, time, sample_rate);
+}
+
+entt::entity Delay::create(entt::registry&registry, float max_delay, float time, float sample_rate) {
+    const float values[] = {0.0f, time};
+    auto block = create_delay_block(registry, BlockType::Delay, values, max_delay, sample_rate, process, view);
+    setup(registry, block);
+    return block;
+}
+
+void Delay::setup(entt::registry&registry, entt::entity block) {
+    setup_line(registry, block, 2, is_silent);
+}
+
+bool Delay::is_silent(entt::registry&registry, const Block&block) {
+    return is_silent_line(registry, block, 2);
+}
+
+IoMap Delay::view(entt::registry&registry, const Block&block) {
+    return view_line(registry, block);
+}
+
+// Comb ----------------------------------------------------------------------------------------
+
+void Comb::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&input = registry.get<Input1D>(block.inputIds[0]);
+    auto&time = registry.get<Input1D>(block.inputIds[1]);
+    auto&feedback = registry.get<Input1D>(block.inputIds[2]);
+    auto&damping = registry.get<Input1D>(block.inputIds[3]);
+    auto&line = registry.get<DelayLine>(block.inputIds[4]);
+
+    const float delayed = line.read(time.value * ctx.sample_freq);
+    line.state = flush(delayed + (line.state - delayed) * damping.value);
+    line.write(flush(input.value + feedback.value * line.state));
+    registry.get<Output1D>(block.outputIds[0]).value = delayed;
+}
+
+entt::entity Comb::create(IGraphRegistry* reg, float max_delay, float time, float feedback, float damping) {
+    const auto sample_rate = float(reg->get_sample_rate());
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, max_delay, time, feedback, damping, sample_rate);
+}
+
+entt::entity Comb::create(entt::registry&registry, float max_delay, float time, float feedback, float damping,
+                          float sample_rate) {
+    const float values[] = {0.0f, time, feedback, damping};
+    auto block = create_delay_block(registry, BlockType::Comb, values, max_delay, sample_rate, process, view);
+    setup(registry, block);
+    return block;
+}
+
+void Comb::setup(entt::registry&registry, entt::entity block) {
+    setup_line(registry, block, 4, is_silent);
+}
+
+bool Comb::is_silent(entt::registry&registry, const Block&block) {
+    return is_silent_line(registry, block, 4);
+}
+
+IoMap Comb::view(entt::registry&registry, const Block&block) {
+    return view_line(registry, block);
+}
+
+// Allpass -------------------------------------------------------------------------------------
+
+void Allpass::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&input = registry.get<Input1D>(block.inputIds[0]);
+    auto&time = registry.get<Input1D>(block.inputIds[1]);
+    auto&gain = registry.get<Input1D>(block.inputIds[2]);
+    auto&line = registry.get<DelayLine>(block.inputIds[3]);
+
+    const float delayed = line.read(time.value * ctx.sample_freq);
+    const float w = flush(input.value + gain.value * delayed);
+    line.write(w);
+    registry.get<Output1D>(block.outputIds[0]).value = delayed - gain.value * w;
+}
+
+entt::entity Allpass::create(IGraphRegistry* reg, float max_delay, float time, float gain) {
+    const auto sample_rate = float(reg->get_sample_rate());
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, max_delay, time, gain, sample_rate);
+}
+
+entt::entity Allpass::create(entt::registry&registry, float max_delay, float time, float gain, float sample_rate) {
+    const float values[] = {0.0f, time, gain};
+    auto block = create_delay_block(registry, BlockType::Allpass, values, max_delay, sample_rate, process, view);
+    setup(registry, block);
+    return block;
+}
+
+void Allpass::setup(entt::registry&registry, entt::entity block) {
+    setup_line(registry, block, 3, is_silent);
+}
+
+bool Allpass::is_silent(entt::registry&registry, const Block&block) {
+    return is_silent_line(registry, block, 3);
+}
+
+IoMap Allpass::view(entt::registry&registry, const Block&block) {
+    return view_line(registry, block);
+}
@@ -0,0 +1,85 @@
+//
+//
+
+#ifndef AARI_DELAYS_H
+#define AARI_DELAYS_H
+
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include "../core/utils/delay_line.h"
+#include <entt/entt.hpp>
+
+namespace AAri {
+    /**
+     * Delay lines, the building blocks of chorus, flanger and reverbs.
+     * Their ring buffers come from the MemoryPool when the blocks are set up and are sized for max_delay
+     * seconds. The last input is the length of the ring in samples: it is only read by setup, e.g.
+     * when the block is cloned, changing it afterwards has no effect.
+     * The delay times are in seconds and can be modulated at audio rate, with cubic interpolation.
+     * The blocks sleep once their input has been 0 for the length of their ring.
+     */
+    struct Delay {
+        /**
+         * Inputs: input, delay time, ring length. Output: the delayed input
+         */
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, float max_delay, float time);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, float max_delay, float time,
+                                   float sample_rate = 48000.0f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        // Throws if the ring length is not a power of two
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+
+    /**
+     * Feedback comb filter with a one-pole lowpass in the loop, as in Freeverb.
+     * Inputs: input, delay time, feedback, damping in [0, 1) (0 is no damping), ring length.
+     * Output: the delayed signal, i.e. the input is heard after one delay.
+     */
+    struct Comb {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, float max_delay, float time, float feedback = 0.5f,
+                                   float damping = 0.0f);
+
+        static entt::entity create(entt::registry &registry, float max_delay, float time, float feedback = 0.5f,
+                                   float damping = 0.0f, float sample_rate = 48000.0f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+
+    /**
+     * Schroeder allpass: flat magnitude response, only the phase is smeared, the diffuser of reverbs.
+     * Inputs: input, delay time, gain, ring length.
+     */
+    struct Allpass {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, float max_delay, float time, float gain = 0.5f);
+
+        static entt::entity create(entt::registry &registry, float max_delay, float time, float gain = 0.5f,
+                                   float sample_rate = 48000.0f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+}
+
+#endif //AARI_DELAYS_H
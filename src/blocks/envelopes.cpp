@@ -2,3 +2,196 @@
 //
 
 #include "envelopes.h"
+#include "../core/kernels/kernels.h"
+#include "../core/utils/envelope.h"
+
+using namespace AAri;
+
+namespace {
+    IoMap view_1d(entt::registry&registry, const Block&block, size_t n_inputs) {
+        IoMap io_map;
+        for (size_t i = 0; i < n_inputs; i++) {
+            auto inputid = block.inputIds[i];
+            io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+        }
+        auto outid = block.outputIds[0];
+        io_map[outid] = std::make_unique<Output1D>(registry.get<Output1D>(outid));
+        return io_map;
+    }
+}
+
+// Adsr ----------------------------------------------------------------------------------------
+
+void Adsr::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&gate = registry.get<Input1D>(block.inputIds[0]);
+    auto&attack = registry.get<Input1D>(block.inputIds[1]);
+    auto&decay = registry.get<Input1D>(block.inputIds[2]);
+    auto&sustain = registry.get<Input1D>(block.inputIds[3]);
+    auto&release = registry.get<Input1D>(block.inputIds[4]);
+    auto&stage = registry.get<Input1D>(block.inputIds[5]);
+    auto&out = registry.get<Output1D>(block.outputIds[0]);
+
+    const auto coefficients = envelope::adsr_coefficients(attack.value, decay.value, sustain.value,
+                                                          release.value, ctx.sample_freq);
+    out.value = envelope::step(gate.value, stage.value, out.value, coefficients);
+}
+
+entt::entity Adsr::create(IGraphRegistry* reg, float attack, float decay, float sustain, float release) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, attack, decay, sustain, release);
+}
+
+entt::entity Adsr::create(entt::registry&registry, float attack, float decay, float sustain, float release) {
+    std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+    const float values[] = {0.0f, attack, decay, sustain, release, envelope::RELEASE};
+    for (size_t i = 0; i < 6; i++) {
+        inputs[i] = registry.create();
+        registry.emplace<Input1D>(inputs[i], values[i]);
+    }
+    auto out = registry.create();
+    registry.emplace<Output1D>(out, 0.0f);
+
+    auto block = Block::create(registry, BlockType::Adsr, inputs, fill_with_null<N_OUTPUTS>(out), process, view);
+    setup(registry, block);
+    return block;
+}
+
+void Adsr::setup(entt::registry&registry, entt::entity block) {
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool Adsr::is_silent(entt::registry&registry, const Block&block) {
+    return registry.get<Input1D>(block.inputIds[0]).value <= 0.0f &&
+           registry.get<Output1D>(block.outputIds[0]).value == 0.0f;
+}
+
+IoMap Adsr::view(entt::registry&registry, const Block&block) {
+    return view_1d(registry, block, 6);
+}
+
+// Ar ------------------------------------------------------------------------------------------
+
+void Ar::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&gate = registry.get<Input1D>(block.inputIds[0]);
+    auto&attack = registry.get<Input1D>(block.inputIds[1]);
+    auto&release = registry.get<Input1D>(block.inputIds[2]);
+    auto&stage = registry.get<Input1D>(block.inputIds[3]);
+    auto&out = registry.get<Output1D>(block.outputIds[0]);
+
+    //An ADSR without sustain, decaying at the release rate
+    const auto coefficients = envelope::adsr_coefficients(attack.value, release.value, 0.0f, release.value,
+                                                          ctx.sample_freq);
+    out.value = envelope::step(gate.value, stage.value, out.value, coefficients);
+}
+
+entt::entity Ar::create(IGraphRegistry* reg, float attack, float release) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, attack, release);
+}
+
+entt::entity Ar::create(entt::registry&registry, float attack, float release) {
+    std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+    const float values[] = {0.0f, attack, release, envelope::RELEASE};
+    for (size_t i = 0; i < 4; i++) {
+        inputs[i] = registry.create();
+        registry.emplace<Input1D>(inputs[i], values[i]);
+    }
+    auto out = registry.create();
+    registry.emplace<Output1D>(out, 0.0f);
+
+    auto block = Block::create(registry, BlockType::Ar, inputs, fill_with_null<N_OUTPUTS>(out), process, view);
+    setup(registry, block);
+    return block;
+}
+
+void Ar::setup(entt::registry&registry, entt::entity block) {
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool Ar::is_silent(entt::registry&registry, const Block&block) {
+    return registry.get<Input1D>(block.inputIds[0]).value <= 0.0f &&
+           registry.get<Output1D>(block.outputIds[0]).value == 0.0f;
+}
+
+IoMap Ar::view(entt::registry&registry, const Block&block) {
+    return view_1d(registry, block, 4);
+}
+
+// AdsrBank ------------------------------------------------------------------------------------
+
+void AdsrBank::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&attack = registry.get<Input1D>(block.inputIds[0]);
+    auto&decay = registry.get<Input1D>(block.inputIds[1]);
+    auto&sustain = registry.get<Input1D>(block.inputIds[2]);
+    auto&release = registry.get<Input1D>(block.inputIds[3]);
+    auto&gates = registry.get<InputArray>(block.inputIds[4]);
+    auto&stages = registry.get<InputArray>(block.inputIds[5]);
+    auto&levels = registry.get<OutputArray>(block.outputIds[0]);
+
+    //Once per sample for all the voices
+    const auto coefficients = envelope::adsr_coefficients(attack.value, decay.value, sustain.value,
+                                                          release.value, ctx.sample_freq);
+    kernels().adsr(gates.value.data(), stages.value.data(), levels.value.data(), levels.value.size(),
+                   coefficients);
+}
+
+entt::entity AdsrBank::create(IGraphRegistry* reg, size_t voices, float attack, float decay, float sustain,
+                              float release) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, voices, attack, decay, sustain, release);
+}
+
+entt::entity AdsrBank::create(entt::registry&registry, size_t voices, float attack, float decay, float sustain,
+                              float release) {
+    std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+    const float values[] = {attack, decay, sustain, release};
+    for (size_t i = 0; i < 4; i++) {
+        inputs[i] = registry.create();
+        registry.emplace<Input1D>(inputs[i], values[i]);
+    }
+    inputs[4] = registry.create();
+    registry.emplace<InputArray>(inputs[4], std::vector<float>(voices, 0.0f));
+    inputs[5] = registry.create();
+    registry.emplace<InputArray>(inputs[5], std::vector<float>(voices, envelope::RELEASE));
+    auto out = registry.create();
+    registry.emplace<OutputArray>(out, std::vector<float>(voices, 0.0f));
+
+    auto block = Block::create(registry, BlockType::AdsrBank, inputs, fill_with_null<N_OUTPUTS>(out), process,
+                               view);
+    setup(registry, block);
+    return block;
+}
+
+void AdsrBank::setup(entt::registry&registry, entt::entity block) {
+    const auto&b = registry.get<Block>(block);
+    const size_t voices = registry.get<OutputArray>(b.outputIds[0]).value.size();
+    if (registry.get<InputArray>(b.inputIds[4]).value.size() != voices ||
+        registry.get<InputArray>(b.inputIds[5]).value.size() != voices)
+        throw std::runtime_error("AdsrBank: gates, stages and levels must have the same size");
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool AdsrBank::is_silent(entt::registry&registry, const Block&block) {
+    const auto&gates = registry.get<InputArray>(block.inputIds[4]).value;
+    const auto&levels = registry.get<OutputArray>(block.outputIds[0]).value;
+    for (size_t i = 0; i < levels.size(); i++) {
+        if (gates[i] > 0.0f || levels[i] != 0.0f)
+            return false;
+    }
+    return true;
+}
+
+IoMap AdsrBank::view(entt::registry&registry, const Block&block) {
+    IoMap io_map;
+    for (size_t i = 0; i < 4; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+    }
+    for (size_t i = 4; i < 6; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<InputArray>(registry.get<InputArray>(inputid));
+    }
+    auto outid = block.outputIds[0];
+    io_map[outid] = std::make_unique<OutputArray>(registry.get<OutputArray>(outid));
+    return io_map;
+}
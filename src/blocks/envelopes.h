@@ -1,44 +1,80 @@
 //
 //
-#include <cmath>
 
 #ifndef RELEASE_ENVELOPES_H
 #define RELEASE_ENVELOPES_H
 
-#endif //RELEASE_ENVELOPES_H
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include <entt/entt.hpp>
 
+namespace AAri {
+    /**
+     * ADSR envelope with exponential segments (see utils/envelope.h).
+     * Inputs: gate (on while > 0), attack, decay and release times in seconds, sustain level, and the stage
+     * it is in, which is its state. Output: the level, between 0 and 1.
+     * It sleeps once released to 0 with the gate off.
+     */
+    struct Adsr {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
 
-//class Product : public deprecated_Graph::Block {
-//public:
-//    enum ProductType {
-//        DUAL_CHANNELS, // 2 independent channels doing one product each
-//        CASCADE// First output is the product of first two inputs, second output is the product of four outputs
-//    };
-//    enum Outputs {
-//        OUT1,
-//        OUT2
-//    };
-//    IMPLEMENT_BLOCK_IO(4, 2);
-//
-//    Product(ProductType ptype) : _ptype(ptype) {
-//        for (float &input: io.inputs) {
-//            input = 1.0f;
-//        }
-//    };
-//
-//    void process(deprecated_Graph::AudioContext ctx) override {
-//        for (int i = 0; i < 2; i += 2) {
-//            io.outputs[i] = io.inputs[2 * i] * io.inputs[2 * i + 1];
-//        }
-//        if (_ptype == ProductType::CASCADE) {
-//            io.outputs[1] = io.outputs[0] * io.outputs[1];
-//        }
-//    }
-//
-//    std::string name() const override {
-//        return "Product_" + std::to_string(id());
-//    }
-//
-//protected:
-//    ProductType _ptype;
-//};
\ No newline at end of file
+        static entt::entity create(IGraphRegistry *reg, float attack = 0.01f, float decay = 0.1f,
+                                   float sustain = 0.7f, float release = 0.3f);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, float attack = 0.01f, float decay = 0.1f,
+                                   float sustain = 0.7f, float release = 0.3f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+
+    /**
+     * Percussive envelope: the attack is followed by the release right away, even with the gate still on.
+     * Inputs: gate, attack and release times in seconds, stage. Output: the level.
+     */
+    struct Ar {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, float attack = 0.005f, float release = 0.5f);
+
+        static entt::entity create(entt::registry &registry, float attack = 0.005f, float release = 0.5f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+
+    /**
+     * ADSR envelopes of many voices sharing their settings, computed in one pass of the adsr kernel.
+     * Inputs: attack, decay, sustain, release like Adsr, then the gates and stages of the voices as InputArrays.
+     * Output: OutputArray of the levels, e.g. wired to the amps of FmVoices with Wire::transmit_array_to_array.
+     */
+    struct AdsrBank {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, size_t voices, float attack = 0.01f, float decay = 0.1f,
+                                   float sustain = 0.7f, float release = 0.3f);
+
+        static entt::entity create(entt::registry &registry, size_t voices, float attack = 0.01f,
+                                   float decay = 0.1f, float sustain = 0.7f, float release = 0.3f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        // Throws if the array sizes don't match, e.g. in a corrupt snapshot
+        static void setup(entt::registry &registry, entt::entity block);
+
+        // Silent when every voice is released to 0
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+}
+
+#endif //RELEASE_ENVELOPES_H
@@ -0,0 +1,325 @@
+//
+//
+
+#include "filters.h"
+#include "../core/kernels/kernels.h"
+
+using namespace AAri;
+
+namespace {
+    // input, mode, cutoff and Q as Input1D then the state as InputND<4>
+    std::array<entt::entity, N_INPUTS> create_inputs(entt::registry&registry, float cutoff, float q, float mode) {
+        std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+        const float values[] = {0.0f, mode, cutoff, q};
+        for (size_t i = 0; i < 4; i++) {
+            inputs[i] = registry.create();
+            registry.emplace<Input1D>(inputs[i], values[i]);
+        }
+        //The smoothed values start at their targets
+        inputs[4] = registry.create();
+        registry.emplace<InputND<4>>(inputs[4], std::array<float, 4>{0.0f, 0.0f, cutoff, q});
+        return inputs;
+    }
+
+    IoMap view_inputs(entt::registry&registry, const Block&block) {
+        IoMap io_map;
+        for (size_t i = 0; i < 4; i++) {
+            auto inputid = block.inputIds[i];
+            io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+        }
+        return io_map;
+    }
+
+    bool is_silent_single(entt::registry&registry, const Block&block) {
+        const auto&state = registry.get<InputND<4>>(block.inputIds[4]).value;
+        return registry.get<Input1D>(block.inputIds[0]).value == 0.0f && state[0] == 0.0f && state[1] == 0.0f;
+    }
+}
+
+// Biquad --------------------------------------------------------------------------------------
+
+void Biquad::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&input = registry.get<Input1D>(block.inputIds[0]);
+    auto&mode = registry.get<Input1D>(block.inputIds[1]);
+    auto&cutoff = registry.get<Input1D>(block.inputIds[2]);
+    auto&q = registry.get<Input1D>(block.inputIds[3]);
+    auto&state = registry.get<InputND<4>>(block.inputIds[4]).value;
+    auto&out = registry.get<Output1D>(block.outputIds[0]);
+
+    const float smoothing = filter::smoothing_coefficient(ctx.sample_freq);
+    state[2] = filter::smooth(state[2], cutoff.value, smoothing);
+    state[3] = filter::smooth(state[3], q.value, smoothing);
+    const auto coefficients = filter::biquad_coefficients(mode.value, filter::normalized_cutoff(state[2], ctx.dt),
+                                                          state[3]);
+    out.value = filter::biquad_step(input.value, coefficients, state[0], state[1]);
+    filter::flush(input.value, state[0], state[1]);
+}
+
+entt::entity Biquad::create(IGraphRegistry* reg, float cutoff, float q, float mode) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, cutoff, q, mode);
+}
+
+entt::entity Biquad::create(entt::registry&registry, float cutoff, float q, float mode) {
+    auto inputs = create_inputs(registry, cutoff, q, mode);
+    auto out = registry.create();
+    registry.emplace<Output1D>(out, 0.0f);
+
+    auto block = Block::create(registry, BlockType::Biquad, inputs, fill_with_null<N_OUTPUTS>(out), process, view);
+    setup(registry, block);
+    return block;
+}
+
+void Biquad::setup(entt::registry&registry, entt::entity block) {
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool Biquad::is_silent(entt::registry&registry, const Block&block) {
+    return is_silent_single(registry, block);
+}
+
+IoMap Biquad::view(entt::registry&registry, const Block&block) {
+    auto io_map = view_inputs(registry, block);
+    auto stateid = block.inputIds[4];
+    io_map[stateid] = std::make_unique<InputND<4>>(registry.get<InputND<4>>(stateid));
+    auto outid = block.outputIds[0];
+    io_map[outid] = std::make_unique<Output1D>(registry.get<Output1D>(outid));
+    return io_map;
+}
+
+// Svf -----------------------------------------------------------------------------------------
+
+void Svf::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&input = registry.get<Input1D>(block.inputIds[0]);
+    auto&mode = registry.get<Input1D>(block.inputIds[1]);
+    auto&cutoff = registry.get<Input1D>(block.inputIds[2]);
+    auto&q = registry.get<Input1D>(block.inputIds[3]);
+    auto&state = registry.get<InputND<4>>(block.inputIds[4]).value;
+
+    const float smoothing = filter::smoothing_coefficient(ctx.sample_freq);
+    state[2] = filter::smooth(state[2], cutoff.value, smoothing);
+    state[3] = filter::smooth(state[3], q.value, smoothing);
+    const auto outputs = filter::svf_step(input.value, filter::normalized_cutoff(state[2], ctx.dt), state[3],
+                                          state[0], state[1]);
+    filter::flush(input.value, state[0], state[1]);
+
+    registry.get<Output1D>(block.outputIds[0]).value = filter::svf_select(filter::svf_mix(mode.value), outputs);
+    registry.get<Output1D>(block.outputIds[1]).value = outputs.lowpass;
+    registry.get<Output1D>(block.outputIds[2]).value = outputs.bandpass;
+    registry.get<Output1D>(block.outputIds[3]).value = outputs.highpass;
+}
+
+entt::entity Svf::create(IGraphRegistry* reg, float cutoff, float q, float mode) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, cutoff, q, mode);
+}
+
+entt::entity Svf::create(entt::registry&registry, float cutoff, float q, float mode) {
+    auto inputs = create_inputs(registry, cutoff, q, mode);
+    std::array<entt::entity, N_OUTPUTS> outputs = fill_with_null<N_OUTPUTS>();
+    for (auto&out: outputs) {
+        out = registry.create();
+        registry.emplace<Output1D>(out, 0.0f);
+    }
+
+    auto block = Block::create(registry, BlockType::Svf, inputs, outputs, process, view);
+    setup(registry, block);
+    return block;
+}
+
+void Svf::setup(entt::registry&registry, entt::entity block) {
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool Svf::is_silent(entt::registry&registry, const Block&block) {
+    return is_silent_single(registry, block);
+}
+
+IoMap Svf::view(entt::registry&registry, const Block&block) {
+    auto io_map = view_inputs(registry, block);
+    auto stateid = block.inputIds[4];
+    io_map[stateid] = std::make_unique<InputND<4>>(registry.get<InputND<4>>(stateid));
+    for (auto outid: block.outputIds)
+        io_map[outid] = std::make_unique<Output1D>(registry.get<Output1D>(outid));
+    return io_map;
+}
+
+// BiquadCascade -------------------------------------------------------------------------------
+
+void BiquadCascade::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&input = registry.get<Input1D>(block.inputIds[0]);
+    auto&mode = registry.get<Input1D>(block.inputIds[1]);
+    auto&cutoff = registry.get<Input1D>(block.inputIds[2]);
+    auto&q = registry.get<Input1D>(block.inputIds[3]);
+    auto&state = registry.get<InputArray>(block.inputIds[4]).value;
+    auto&out = registry.get<Output1D>(block.outputIds[0]);
+
+    const size_t n = sections(state.size());
+    float* ins = state.data();
+    float* outs = ins + n;
+    float* coefficients = outs + n;
+    float* delays = coefficients + 5 * n;
+    float* smoothed = delays + 2 * n;
+
+    //The sections share their coefficients, they are computed once and broadcast to the lanes
+    const float smoothing = filter::smoothing_coefficient(ctx.sample_freq);
+    smoothed[0] = filter::smooth(smoothed[0], cutoff.value, smoothing);
+    smoothed[1] = filter::smooth(smoothed[1], q.value, smoothing);
+    const auto c = filter::biquad_coefficients(mode.value, filter::normalized_cutoff(smoothed[0], ctx.dt),
+                                               smoothed[1]);
+    const float values[] = {c.b0, c.b1, c.b2, c.a1, c.a2};
+    for (size_t j = 0; j < 5; j++)
+        std::fill(coefficients + j * n, coefficients + (j + 1) * n, values[j]);
+
+    //Each section takes the previous output of the one before it
+    for (size_t k = n - 1; k > 0; k--)
+        ins[k] = outs[k - 1];
+    ins[0] = input.value;
+    kernels().biquad_bank({ins, outs, coefficients, delays, n});
+    out.value = outs[n - 1];
+}
+
+entt::entity BiquadCascade::create(IGraphRegistry* reg, size_t sections, float cutoff, float q, float mode) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, sections, cutoff, q, mode);
+}
+
+entt::entity BiquadCascade::create(entt::registry&registry, size_t sections, float cutoff, float q, float mode) {
+    if (sections == 0)
+        throw std::runtime_error("BiquadCascade: at least one section is needed");
+    std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+    const float values[] = {0.0f, mode, cutoff, q};
+    for (size_t i = 0; i < 4; i++) {
+        inputs[i] = registry.create();
+        registry.emplace<Input1D>(inputs[i], values[i]);
+    }
+    std::vector<float> state(STATE_PER_SECTION * sections + 2, 0.0f);
+    state[state.size() - 2] = cutoff;
+    state[state.size() - 1] = q;
+    inputs[4] = registry.create();
+    registry.emplace<InputArray>(inputs[4], std::move(state));
+    auto out = registry.create();
+    registry.emplace<Output1D>(out, 0.0f);
+
+    auto block = Block::create(registry, BlockType::BiquadCascade, inputs, fill_with_null<N_OUTPUTS>(out), process,
+                               view);
+    setup(registry, block);
+    return block;
+}
+
+void BiquadCascade::setup(entt::registry&registry, entt::entity block) {
+    const size_t size = registry.get<InputArray>(registry.get<Block>(block).inputIds[4]).value.size();
+    if (size < STATE_PER_SECTION + 2 || (size - 2) % STATE_PER_SECTION != 0)
+        throw std::runtime_error("BiquadCascade: invalid state size");
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool BiquadCascade::is_silent(entt::registry&registry, const Block&block) {
+    if (registry.get<Input1D>(block.inputIds[0]).value != 0.0f)
+        return false;
+    //The inputs, outputs and delays of all the sections
+    const auto&state = registry.get<InputArray>(block.inputIds[4]).value;
+    const size_t n = sections(state.size());
+    for (size_t i = 0; i < 2 * n; i++) {
+        if (state[i] != 0.0f || state[7 * n + i] != 0.0f)
+            return false;
+    }
+    return true;
+}
+
+IoMap BiquadCascade::view(entt::registry&registry, const Block&block) {
+    auto io_map = view_inputs(registry, block);
+    auto stateid = block.inputIds[4];
+    io_map[stateid] = std::make_unique<InputArray>(registry.get<InputArray>(stateid));
+    auto outid = block.outputIds[0];
+    io_map[outid] = std::make_unique<Output1D>(registry.get<Output1D>(outid));
+    return io_map;
+}
+
+// FilterBank ----------------------------------------------------------------------------------
+
+void FilterBank::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&mode = registry.get<Input1D>(block.inputIds[0]);
+    auto&inputs = registry.get<InputArray>(block.inputIds[1]);
+    auto&cutoffs = registry.get<InputArray>(block.inputIds[2]);
+    auto&qs = registry.get<InputArray>(block.inputIds[3]);
+    auto&state = registry.get<InputArray>(block.inputIds[4]);
+    auto&outs = registry.get<OutputArray>(block.outputIds[0]);
+    auto&sum = registry.get<Output1D>(block.outputIds[1]);
+
+    const auto&k = kernels();
+    k.svf_bank({
+        inputs.value.data(), outs.value.data(), cutoffs.value.data(), qs.value.data(), state.value.data(),
+        outs.value.size(), mode.value, ctx.dt, filter::smoothing_coefficient(ctx.sample_freq)
+    });
+    sum.value = k.sum(outs.value.data(), outs.value.size());
+}
+
+entt::entity FilterBank::create(IGraphRegistry* reg, const std::vector<float>&cutoffs, float q, float mode) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, cutoffs, q, mode);
+}
+
+entt::entity FilterBank::create(entt::registry&registry, const std::vector<float>&cutoffs, float q, float mode) {
+    const size_t n = cutoffs.size();
+    std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+    std::vector<float> state(4 * n, 0.0f);
+    std::copy(cutoffs.begin(), cutoffs.end(), state.begin() + 2 * n);
+    std::fill(state.begin() + 3 * n, state.end(), q);
+    inputs[0] = registry.create();
+    registry.emplace<Input1D>(inputs[0], mode);
+    inputs[1] = registry.create();
+    registry.emplace<InputArray>(inputs[1], std::vector<float>(n, 0.0f));
+    inputs[2] = registry.create();
+    registry.emplace<InputArray>(inputs[2], cutoffs);
+    inputs[3] = registry.create();
+    registry.emplace<InputArray>(inputs[3], std::vector<float>(n, q));
+    inputs[4] = registry.create();
+    registry.emplace<InputArray>(inputs[4], std::move(state));
+    auto outs = registry.create();
+    registry.emplace<OutputArray>(outs, std::vector<float>(n, 0.0f));
+    auto sum = registry.create();
+    registry.emplace<Output1D>(sum, 0.0f);
+
+    auto block = Block::create(registry, BlockType::FilterBank, inputs, fill_with_null<N_OUTPUTS>(outs, sum),
+                               process, view);
+    setup(registry, block);
+    return block;
+}
+
+void FilterBank::setup(entt::registry&registry, entt::entity block) {
+    const auto&b = registry.get<Block>(block);
+    const size_t n = registry.get<OutputArray>(b.outputIds[0]).value.size();
+    if (registry.get<InputArray>(b.inputIds[1]).value.size() != n ||
+        registry.get<InputArray>(b.inputIds[2]).value.size() != n ||
+        registry.get<InputArray>(b.inputIds[3]).value.size() != n ||
+        registry.get<InputArray>(b.inputIds[4]).value.size() != 4 * n)
+        throw std::runtime_error("FilterBank: inputs, cutoffs, qs, state and outputs sizes don't match");
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool FilterBank::is_silent(entt::registry&registry, const Block&block) {
+    const auto&inputs = registry.get<InputArray>(block.inputIds[1]).value;
+    const auto&state = registry.get<InputArray>(block.inputIds[4]).value;
+    for (float input: inputs) {
+        if (input != 0.0f)
+            return false;
+    }
+    for (size_t i = 0; i < 2 * inputs.size(); i++) {
+        if (state[i] != 0.0f)
+            return false;
+    }
+    return true;
+}
+
+IoMap FilterBank::view(entt::registry&registry, const Block&block) {
+    IoMap io_map;
+    io_map[block.inputIds[0]] = std::make_unique<Input1D>(registry.get<Input1D>(block.inputIds[0]));
+    for (size_t i = 1; i < 5; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<InputArray>(registry.get<InputArray>(inputid));
+    }
+    io_map[block.outputIds[0]] = std::make_unique<OutputArray>(registry.get<OutputArray>(block.outputIds[0]));
+    io_map[block.outputIds[1]] = std::make_unique<Output1D>(registry.get<Output1D>(block.outputIds[1]));
+    return io_map;
+}
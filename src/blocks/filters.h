@@ -0,0 +1,113 @@
+//
+//
+
+#ifndef AARI_FILTERS_H
+#define AARI_FILTERS_H
+
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include "../core/utils/filter.h"
+#include <entt/entt.hpp>
+#include <vector>
+
+namespace AAri {
+    /**
+     * Biquad filter (see utils/filter.h for the modes).
+     * Inputs: input, mode, cutoff in Hz, Q, and the state: the two delays then the smoothed cutoff and Q.
+     * Output: the filtered input. It sleeps once its input and its state are 0.
+     */
+    struct Biquad {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, float cutoff = 1000.0f, float q = 0.7071f,
+                                   float mode = filter::LOWPASS);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, float cutoff = 1000.0f, float q = 0.7071f,
+                                   float mode = filter::LOWPASS);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+
+    /**
+     * State variable filter, the one to modulate at audio rate.
+     * Inputs: same as Biquad, the state is the two integrators then the smoothed cutoff and Q.
+     * Outputs: the mode selected, then lowpass, bandpass and highpass all at once.
+     */
+    struct Svf {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, float cutoff = 1000.0f, float q = 0.7071f,
+                                   float mode = filter::LOWPASS);
+
+        static entt::entity create(entt::registry &registry, float cutoff = 1000.0f, float q = 0.7071f,
+                                   float mode = filter::LOWPASS);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+
+    /**
+     * Identical biquad sections in series for steeper slopes, computed in one pass of the biquad_bank kernel.
+     * To run the sections side by side in vector lanes, section k filters what section k - 1 output on the
+     * previous sample: the output is the one of the sections in series, delayed by sections - 1 samples.
+     * Inputs: input, mode, cutoff, Q like Biquad, and the state as an InputArray of STATE_PER_SECTION * sections + 2.
+     */
+    struct BiquadCascade {
+        // Input and output, 5 coefficients and 2 delays of each section
+        static constexpr size_t STATE_PER_SECTION = 9;
+
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, size_t sections, float cutoff = 1000.0f, float q = 0.7071f,
+                                   float mode = filter::LOWPASS);
+
+        static entt::entity create(entt::registry &registry, size_t sections, float cutoff = 1000.0f,
+                                   float q = 0.7071f, float mode = filter::LOWPASS);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        // Throws if the state doesn't hold a whole number of sections, e.g. in a corrupt snapshot
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+
+        static size_t sections(size_t state_size) {
+            return (state_size - 2) / STATE_PER_SECTION;
+        }
+    };
+
+    /**
+     * Many independent state variable filters sharing their mode, one per vector lane of the svf_bank kernel,
+     * e.g. one per voice. Inputs: mode, then InputArrays of the inputs, cutoffs and Qs of the filters,
+     * and their state (4 values per filter). Outputs: OutputArray of the filtered inputs, and their sum.
+     */
+    struct FilterBank {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, const std::vector<float> &cutoffs, float q = 0.7071f,
+                                   float mode = filter::LOWPASS);
+
+        static entt::entity create(entt::registry &registry, const std::vector<float> &cutoffs, float q = 0.7071f,
+                                   float mode = filter::LOWPASS);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        // Throws if the array sizes don't match
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+}
+
+#endif //AARI_FILTERS_H
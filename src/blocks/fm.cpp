@@ -0,0 +1,151 @@
+//
+//
+
+#include "fm.h"
+
+using namespace AAri;
+
+namespace {
+    constexpr uint8_t op(size_t index) {
+        return uint8_t(1u << index);
+    }
+
+    //Operators needed by the carriers, directly or through other modulators
+    uint8_t used_operators(const FmAlgorithm&algorithm) {
+        uint8_t used = algorithm.carriers;
+        for (size_t k = 0; k < FM_OPERATORS; k++) {
+            if (used & op(k))
+                used |= algorithm.modulators[k];
+        }
+        return used;
+    }
+}
+
+const std::array<FmAlgorithm, 11> FmVoices::ALGORITHMS = {
+    {
+        //4 -> 3 -> 2 -> 1
+        {{op(1), op(2), op(3), 0, 0, 0}, op(0), 3},
+        //(3 + 4) -> 2 -> 1
+        {{op(1), op(2) | op(3), 0, 0, 0, 0}, op(0), 3},
+        //(3 -> 2) + 4 -> 1
+        {{op(1) | op(3), op(2), 0, 0, 0, 0}, op(0), 3},
+        //(4 -> 3) + 2 -> 1
+        {{op(1) | op(2), 0, op(3), 0, 0, 0}, op(0), 3},
+        //4 -> 3, 2 -> 1
+        {{op(1), 0, op(3), 0, 0, 0}, op(0) | op(2), 3},
+        //4 -> 1, 2 and 3
+        {{op(3), op(3), op(3), 0, 0, 0}, op(0) | op(1) | op(2), 3},
+        //4 -> 3, 1, 2
+        {{0, 0, op(3), 0, 0, 0}, op(0) | op(1) | op(2), 3},
+        //1, 2, 3, 4
+        {{0, 0, 0, 0, 0, 0}, op(0) | op(1) | op(2) | op(3), 3},
+        //DX7 1: 6 -> 5 -> 4 -> 3, 2 -> 1
+        {{op(1), 0, op(3), op(4), op(5), 0}, op(0) | op(2), 5},
+        //DX7 5: 6 -> 5, 4 -> 3, 2 -> 1
+        {{op(1), 0, op(3), 0, op(5), 0}, op(0) | op(2) | op(4), 5},
+        //DX7 32: all carriers
+        {{0, 0, 0, 0, 0, 0}, op(0) | op(1) | op(2) | op(3) | op(4) | op(5), 5},
+    }
+};
+
+void FmVoices::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&amp = registry.get<Input1D>(block.inputIds[0]);
+    auto&algorithm_index = registry.get<Input1D>(block.inputIds[1]);
+    auto&feedback = registry.get<Input1D>(block.inputIds[2]);
+    auto&ratios = registry.get<InputArray>(block.inputIds[3]);
+    auto&levels = registry.get<InputArray>(block.inputIds[4]);
+    auto&freqs = registry.get<InputArray>(block.inputIds[5]);
+    auto&amps = registry.get<InputArray>(block.inputIds[6]);
+    auto&state = registry.get<InputArray>(block.inputIds[7]);
+    auto&out = registry.get<Output1D>(block.outputIds[0]);
+
+    const size_t index = std::min(algorithm_index.value > 0.0f ? size_t(algorithm_index.value) : 0,
+                                  ALGORITHMS.size() - 1);
+    const auto&algorithm = ALGORITHMS[index];
+    const size_t voices = freqs.value.size();
+    const FmArgs args{
+        algorithm.modulators.data(),
+        algorithm.carriers,
+        used_operators(algorithm),
+        algorithm.feedback_op,
+        feedback.value,
+        ratios.value.data(),
+        levels.value.data(),
+        freqs.value.data(),
+        amps.value.data(),
+        state.value.data(),
+        state.value.data() + FM_OPERATORS * voices,
+        voices,
+        ctx.dt,
+    };
+    out.value = amp.value * kernels().fm(args);
+}
+
+entt::entity FmVoices::create(IGraphRegistry* reg, const std::vector<float>&freqs, uint32_t algorithm,
+                              float init_amp) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, freqs, algorithm, init_amp);
+}
+
+entt::entity FmVoices::create(entt::registry&registry, const std::vector<float>&freqs, uint32_t algorithm,
+                              float init_amp) {
+    if (algorithm >= ALGORITHMS.size())
+        throw std::runtime_error("FmVoices: unknown algorithm " + std::to_string(algorithm));
+
+    auto amp = registry.create();
+    registry.emplace<Input1D>(amp, init_amp);
+    auto algorithm_id = registry.create();
+    registry.emplace<Input1D>(algorithm_id, float(algorithm));
+    auto feedback = registry.create();
+    registry.emplace<Input1D>(feedback, 0.0f);
+    auto ratios = registry.create();
+    registry.emplace<InputArray>(ratios, std::vector<float>(FM_OPERATORS, 1.0f));
+    auto levels = registry.create();
+    registry.emplace<InputArray>(levels, std::vector<float>(FM_OPERATORS, 1.0f));
+    auto freqs_id = registry.create();
+    registry.emplace<InputArray>(freqs_id, freqs);
+    auto amps = registry.create();
+    registry.emplace<InputArray>(amps, std::vector<float>(freqs.size(), 1.0f));
+    auto state = registry.create();
+    registry.emplace<InputArray>(state, std::vector<float>((FM_OPERATORS + 2) * freqs.size(), 0.0f));
+    auto out = registry.create();
+    registry.emplace<Output1D>(out, 0.0f);
+
+    auto block = Block::create(registry, BlockType::FmVoices,
+                               fill_with_null<N_INPUTS>(amp, algorithm_id, feedback, ratios, levels, freqs_id, amps,
+                                                        state),
+                               fill_with_null<N_OUTPUTS>(out),
+                               process, view);
+    setup(registry, block);
+    return block;
+}
+
+void FmVoices::setup(entt::registry&registry, entt::entity block) {
+    const auto&ids = registry.get<Block>(block).inputIds;
+    const size_t voices = registry.get<InputArray>(ids[5]).value.size();
+    if (registry.get<InputArray>(ids[3]).value.size() != FM_OPERATORS ||
+        registry.get<InputArray>(ids[4]).value.size() != FM_OPERATORS ||
+        registry.get<InputArray>(ids[6]).value.size() != voices ||
+        registry.get<InputArray>(ids[7]).value.size() != (FM_OPERATORS + 2) * voices)
+        throw std::runtime_error("FmVoices: inconsistent array sizes");
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool FmVoices::is_silent(entt::registry&registry, const Block&block) {
+    return registry.get<Input1D>(block.inputIds[0]).value == 0.0f;
+}
+
+IoMap FmVoices::view(entt::registry&registry, const Block&block) {
+    IoMap io_map;
+    for (size_t i = 0; i < 3; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+    }
+    for (size_t i = 3; i < 8; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<InputArray>(registry.get<InputArray>(inputid));
+    }
+    auto outid = block.outputIds[0];
+    io_map[outid] = std::make_unique<Output1D>(registry.get<Output1D>(outid));
+    return io_map;
+}
@@ -0,0 +1,66 @@
+//
+//
+
+#ifndef RELEASE_FM_H
+#define RELEASE_FM_H
+
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include "../core/kernels/kernels.h"
+#include <entt/entt.hpp>
+
+namespace AAri {
+    /**
+     * How the operators of an FM voice are connected, see FmArgs.
+     * Operators are numbered from 0, i.e. operator 1 of the synth manuals is 0 here.
+     */
+    struct FmAlgorithm {
+        std::array<uint8_t, FM_OPERATORS> modulators;
+        uint8_t carriers;
+        uint8_t feedback_op;
+    };
+
+    /**
+     * Polyphonic DX style FM synth in a single block: every voice runs the same FM_OPERATORS operators
+     * and algorithm, with its own frequency and amplitude. Operators are phase modulated at audio rate,
+     * which a chain of SineOsc blocks can only approximate through their freq inputs.
+     * Inputs:
+     *   0 amp        overall amplitude
+     *   1 algorithm  index in ALGORITHMS
+     *   2 feedback   of the top operator of the algorithm, in radians
+     *   3 ratios     InputArray[FM_OPERATORS], frequency of each operator relative to the voice
+     *   4 levels     InputArray[FM_OPERATORS], output level of each operator (modulation index for modulators)
+     *   5 freqs      InputArray[voices], in Hz
+     *   6 amps       InputArray[voices], 0 for voices not playing
+     *   7 state      InputArray[(FM_OPERATORS + 2) * voices], phases of the operators then feedback history
+     */
+    struct FmVoices {
+        /**
+         * 0 to 7 are the eight algorithms of 4 operator synths (TX81Z numbering minus one),
+         * 8 to 10 are the 6 operator algorithms 1, 5 and 32 of the DX7.
+         */
+        static const std::array<FmAlgorithm, 11> ALGORITHMS;
+
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, const std::vector<float> &freqs, uint32_t algorithm = 0,
+                                   float init_amp = 1.0f);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, const std::vector<float> &freqs, uint32_t algorithm = 0,
+                                   float init_amp = 1.0f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        // Throws if the array sizes don't match, e.g. in a corrupt snapshot
+        static void setup(entt::registry &registry, entt::entity block);
+
+        // Silent when the overall amplitude is zero
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+}
+
+#endif //RELEASE_FM_H
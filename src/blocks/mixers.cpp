@@ -2,84 +2,66 @@
 //
 
 #include "mixers.h"
+#include <stdexcept>
 
 using namespace AAri;
 
-template<size_t N>
-void MonoMixer<N>::process(entt::registry&registry, const Block&block, AudioContext ctx) {
-    auto&input = registry.get<InputND<N>>(block.inputIds[0]);
-    auto&out = registry.get<Output1D>(block.outputIds[0]);
+void Mixer::process_mono(entt::registry&registry, const Block&block, AudioContext ctx) {
+    const auto&inputs = registry.get<GatherList>(block.inputIds[0]);
+    registry.get<Output1D>(block.outputIds[0]).value = inputs.sum(0);
+}
 
-    out.value = 0.0f;
-    for (size_t i = 0; i < N; i++) {
-        out.value += input.value[i];
-    }
+void Mixer::process_stereo(entt::registry&registry, const Block&block, AudioContext ctx) {
+    const auto&inputs = registry.get<GatherList>(block.inputIds[0]);
+    auto&out = registry.get<OutputND<2>>(block.outputIds[0]);
+    out.value[0] = inputs.sum(0);
+    out.value[1] = inputs.sum(1);
 }
 
-template<size_t N>
-entt::entity MonoMixer<N>::create(IGraphRegistry* reg) {
+entt::entity Mixer::create(IGraphRegistry* reg, size_t slots, size_t width) {
     auto [registry, guard] = reg->get_graph_registry();
-    auto input = registry.create();
-    registry.emplace<InputND<N>>(input, std::array<float, N>{0.0f});
-    auto output = registry.create();
-    registry.emplace<Output1D>(output, 0.0f);
-
-    return Block::create(registry, BlockType::MonoMixer,
-                         fill_with_null<N_INPUTS>(input),
-                         fill_with_null<N_OUTPUTS>(output),
-                         process, nullptr);
+    return create(registry, slots, width);
 }
 
+std::vector<entt::entity> Mixer::create_many(IGraphRegistry* reg, size_t count, size_t slots, size_t width) {
+    auto [registry, guard] = reg->get_graph_registry();
+    std::vector<entt::entity> blocks;
+    blocks.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        blocks.push_back(create(registry, slots, width));
+    }
+    return blocks;
+}
 
-template<size_t N>
-void StereoMixer<N>::process(entt::registry&registry, const Block&block, AudioContext ctx) {
-    auto&input = registry.get<InputNDStereo<N>>(block.inputIds[0]);
-    auto&out = registry.get<OutputND<2>>(block.outputIds[0]);
+void Mixer::setup(entt::registry&registry, entt::entity block) {
+    const auto&b = registry.get<Block>(block);
+    GatherList inputs;
+    inputs.width = registry.all_of<Output1D>(b.outputIds[0]) ? 1 : 2;
+    registry.emplace_or_replace<GatherList>(b.inputIds[0], std::move(inputs));
+    registry.emplace<Silence>(block, is_silent);
+}
 
-    out.value[0] = 0.0f;
-    out.value[1] = 0.0f;
-    for (size_t i = 0; i < N; i++) {
-        out.value[0] += input.left[i];
-        out.value[1] += input.right[i];
-    }
+bool Mixer::is_silent(entt::registry&registry, const Block&block) {
+    return registry.get<GatherList>(block.inputIds[0]).sources_asleep(registry);
 }
 
-template<size_t N>
-entt::entity StereoMixer<N>::create(IGraphRegistry* reg) {
-    auto [registry, guard] = reg->get_graph_registry();
+entt::entity Mixer::create(entt::registry&registry, size_t slots, size_t width) {
+    if (slots == 0 || slots > UINT32_MAX)
+        throw std::runtime_error("Mixer: invalid number of slots " + std::to_string(slots));
+    if (width != 1 && width != 2)
+        throw std::runtime_error("Mixer: a mixer is mono or stereo");
     auto input = registry.create();
-    registry.emplace<InputNDStereo<N>>(input, std::array<float, N>{0.0f}, std::array<float, N>{0.0f});
+    registry.emplace<MixerInput>(input, uint32_t(slots));
     auto output = registry.create();
-    registry.emplace<OutputND<2>>(output, std::array<float, 2>{0.0f, 0.0f});
-
-    return Block::create(registry, BlockType::StereoMixer,
-                         fill_with_null<N_INPUTS>(input),
-                         fill_with_null<N_OUTPUTS>(output),
-                         process, nullptr);
+    if (width == 1)
+        registry.emplace<Output1D>(output, 0.0f);
+    else
+        registry.emplace<OutputND<2>>(output, std::array<float, 2>{0.0f, 0.0f});
+
+    auto block = Block::create(registry, width == 1 ? BlockType::MonoMixer : BlockType::StereoMixer,
+                               fill_with_null<N_INPUTS>(input),
+                               fill_with_null<N_OUTPUTS>(output),
+                               width == 1 ? process_mono : process_stereo, nullptr);
+    setup(registry, block);
+    return block;
 }
-
-
-//Explicit template instantiations of power of 2 mixers
-template
-struct AAri::MonoMixer<2>;
-template
-struct AAri::MonoMixer<4>;
-template
-struct AAri::MonoMixer<8>;
-template
-struct AAri::MonoMixer<16>;
-template
-struct AAri::MonoMixer<32>;
-
-template
-struct AAri::StereoMixer<2>;
-template
-struct AAri::StereoMixer<4>;
-template
-struct AAri::StereoMixer<8>;
-template
-struct AAri::StereoMixer<16>;
-template
-struct AAri::StereoMixer<32>;
-
-
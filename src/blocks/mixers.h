@@ -6,31 +6,74 @@
 
 #include "../core/graph.h"
 #include "../core/audio_context.h"
+#include "../core/gather.h"
 #include "../core/graph_registry.h"
 #include <entt/entt.hpp>
 #include <cmath>
 
 namespace AAri {
+    /**
+     * Sum of any number of block outputs.
+     * Inputs: a MixerInput whose slots take one wire each (see AudioEngine::add_wire_to_mixer).
+     * Outputs: Output1D for a mono mixer, OutputND<2> for a stereo one. Mono outputs are mixed into both
+     * channels of a stereo mixer and stereo outputs into a mono one as the mean of their channels.
+     * The wires are not transmitted, the graph gathers their sources, gains and offsets into a GatherList
+     * that the mixer sums in one pass.
+     */
     struct Mixer {
-        //Note that in mixers we abuse the system a bit by using entt::entity types
-        // to store the index of the inputs in an array of floats
+        static void process_mono(entt::registry &registry, const Block &block, AudioContext ctx);
 
+        static void process_stereo(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        /**
+         * @param width 1 for a mono mixer, 2 for a stereo one
+         */
+        static entt::entity create(IGraphRegistry *reg, size_t slots, size_t width = 1);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, size_t slots, size_t width = 1);
+
+        static std::vector<entt::entity> create_many(IGraphRegistry *reg, size_t count, size_t slots,
+                                                     size_t width = 1);
+
+        static void setup(entt::registry &registry, entt::entity block);
+
+        //Mixers are silent when all their sources are
+        static bool is_silent(entt::registry &registry, const Block &block);
     };
 
-    //A mixer with a templated input size
+    //Mixers of N slots, as they were created before mixers took any number of them
     template<size_t N>
     struct MonoMixer : public Mixer {
-        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+        static entt::entity create(IGraphRegistry *reg) {
+            return Mixer::create(reg, N, 1);
+        }
+
+        static entt::entity create(entt::registry &registry) {
+            return Mixer::create(registry, N, 1);
+        }
 
-        static entt::entity create(IGraphRegistry *reg);
+        static std::vector<entt::entity> create_many(IGraphRegistry *reg, size_t count) {
+            return Mixer::create_many(reg, count, N, 1);
+        }
     };
 
 
     template<size_t N>
     struct StereoMixer : public Mixer {
-        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+        static entt::entity create(IGraphRegistry *reg) {
+            return Mixer::create(reg, N, 2);
+        }
+
+        static entt::entity create(entt::registry &registry) {
+            return Mixer::create(registry, N, 2);
+        }
 
-        static entt::entity create(IGraphRegistry *reg);
+        static std::vector<entt::entity> create_many(IGraphRegistry *reg, size_t count) {
+            return Mixer::create_many(reg, count, N, 2);
+        }
     };
 
 
@@ -12,13 +12,18 @@ void SineOsc::process(entt::registry&registry, const Block&block, AudioContext c
     auto&amp = registry.get<Input1D>(block.inputIds[2]);
     auto&out = registry.get<Output1D>(block.outputIds[0]);
 
-    out.value = amp.value * sinf(2.0f * PI * freq.value * phase.value);
-    phase.value = fmodf(phase.value + ctx.dt, 1.0f);
+    out.value = amp.value * fast_math::sin2pi(freq.value * phase.value);
+    phase.value = fast_math::fraction(phase.value + ctx.dt);
 }
 
 entt::entity
 SineOsc::create(IGraphRegistry* reg, float init_freq, float init_amp) {
     auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, init_freq, init_amp);
+}
+
+entt::entity
+SineOsc::create(entt::registry&registry, float init_freq, float init_amp) {
     auto phase = registry.create();
     registry.emplace<Input1D>(phase, 0.0f);
     auto freq = registry.create();
@@ -28,10 +33,34 @@ SineOsc::create(IGraphRegistry* reg, float init_freq, float init_amp) {
     auto out = registry.create();
     registry.emplace<Output1D>(out, 0.0f);
 
-    return Block::create(registry, BlockType::SineOsc,
-                         fill_with_null<N_INPUTS>(phase, freq, amp),
-                         fill_with_null<N_OUTPUTS>(out),
-                         process, view);
+    auto block = Block::create(registry, BlockType::SineOsc,
+                               fill_with_null<N_INPUTS>(phase, freq, amp),
+                               fill_with_null<N_OUTPUTS>(out),
+                               process, view);
+    setup(registry, block);
+    return block;
+}
+
+void SineOsc::setup(entt::registry&registry, entt::entity block) {
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool SineOsc::is_silent(entt::registry&registry, const Block&block) {
+    return registry.get<Input1D>(block.inputIds[2]).value == 0.0f;
+}
+
+std::vector<entt::entity>
+SineOsc::create_many(IGraphRegistry* reg, const std::vector<float>&freqs, const std::vector<float>&amps) {
+    if (freqs.size() != amps.size())
+        throw std::runtime_error("create_many: freqs and amps must have the same size");
+
+    auto [registry, guard] = reg->get_graph_registry();
+    std::vector<entt::entity> blocks;
+    blocks.reserve(freqs.size());
+    for (size_t i = 0; i < freqs.size(); i++) {
+        blocks.push_back(create(registry, freqs[i], amps[i]));
+    }
+    return blocks;
 }
 
 IoMap SineOsc::view(entt::registry&registry, const Block&block) {
@@ -49,3 +78,180 @@ IoMap SineOsc::view(entt::registry&registry, const Block&block) {
     return io_map;
 }
 
+
+namespace {
+    //Into [0, 1) whatever the sign: a tiny negative phase plus 1 rounds to 1.0f, which would read
+    //past the end of the table
+    float wrap_phase(float x) {
+        float p = fast_math::fraction(x);
+        p += float(p < 0.0f);
+        return p - float(p >= 1.0f);
+    }
+
+    template<WavetableOsc::Interpolation I>
+    void process_wavetable(entt::registry&registry, const Block&block, AudioContext ctx) {
+        auto&phase = registry.get<Input1D>(block.inputIds[0]);
+        auto&freq = registry.get<Input1D>(block.inputIds[1]);
+        auto&amp = registry.get<Input1D>(block.inputIds[2]);
+        auto&table = registry.get<Input1D>(block.inputIds[3]);
+        auto&out = registry.get<Output1D>(block.outputIds[0]);
+
+        const auto&wavetable = Wavetables::instance().get(table.value > 0.0f ? uint32_t(table.value) : 0u);
+        const size_t level = Wavetable::level_for(std::abs(freq.value), ctx.sample_freq);
+        //The phase may have been set from outside the graph
+        const float p = wrap_phase(phase.value);
+        if constexpr (I == WavetableOsc::Interpolation::Linear)
+            out.value = amp.value * wavetable.read_linear(level, p);
+        else
+            out.value = amp.value * wavetable.read_cubic(level, p);
+
+        phase.value = wrap_phase(p + freq.value * ctx.dt);
+    }
+}
+
+void WavetableOsc::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    process_wavetable<Interpolation::Linear>(registry, block, ctx);
+}
+
+void WavetableOsc::process_cubic(entt::registry&registry, const Block&block, AudioContext ctx) {
+    process_wavetable<Interpolation::Cubic>(registry, block, ctx);
+}
+
+entt::entity WavetableOsc::create(IGraphRegistry* reg, uint32_t table, float init_freq, float init_amp,
+                                  Interpolation interpolation) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, table, init_freq, init_amp, interpolation);
+}
+
+entt::entity WavetableOsc::create(entt::registry&registry, uint32_t table, float init_freq, float init_amp,
+                                  Interpolation interpolation) {
+    auto phase = registry.create();
+    registry.emplace<Input1D>(phase, 0.0f);
+    auto freq = registry.create();
+    registry.emplace<Input1D>(freq, init_freq);
+    auto amp = registry.create();
+    registry.emplace<Input1D>(amp, init_amp);
+    auto table_id = registry.create();
+    registry.emplace<Input1D>(table_id, float(table));
+    auto out = registry.create();
+    registry.emplace<Output1D>(out, 0.0f);
+
+    auto block = Block::create(registry, BlockType::WavetableOsc,
+                               fill_with_null<N_INPUTS>(phase, freq, amp, table_id),
+                               fill_with_null<N_OUTPUTS>(out),
+                               interpolation == Interpolation::Linear ? process : process_cubic, view);
+    setup(registry, block);
+    return block;
+}
+
+std::vector<entt::entity>
+WavetableOsc::create_many(IGraphRegistry* reg, uint32_t table, const std::vector<float>&freqs,
+                          const std::vector<float>&amps, Interpolation interpolation) {
+    if (freqs.size() != amps.size())
+        throw std::runtime_error("create_many: freqs and amps must have the same size");
+
+    auto [registry, guard] = reg->get_graph_registry();
+    std::vector<entt::entity> blocks;
+    blocks.reserve(freqs.size());
+    for (size_t i = 0; i < freqs.size(); i++) {
+        blocks.push_back(create(registry, table, freqs[i], amps[i], interpolation));
+    }
+    return blocks;
+}
+
+void WavetableOsc::setup(entt::registry&registry, entt::entity block) {
+    //Build the shared tables now rather than in the audio callback
+    Wavetables::instance();
+    //Same amplitude input as SineOsc
+    registry.emplace<Silence>(block, SineOsc::is_silent);
+}
+
+IoMap WavetableOsc::view(entt::registry&registry, const Block&block) {
+    IoMap io_map;
+    for (size_t i = 0; i < 4; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+    }
+    auto outid = block.outputIds[0];
+    io_map[outid] = std::make_unique<Output1D>(registry.get<Output1D>(outid));
+    return io_map;
+}
+
+template<BlockType Type>
+void PolyBlepOsc<Type>::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&phase = registry.get<Input1D>(block.inputIds[0]);
+    auto&freq = registry.get<Input1D>(block.inputIds[1]);
+    auto&amp = registry.get<Input1D>(block.inputIds[2]);
+    auto&out = registry.get<Output1D>(block.outputIds[0]);
+
+    //The phase may have been set from outside the graph
+    float p = fast_math::fraction(phase.value);
+    p += float(p < 0.0f);
+    const float dt = freq.value * ctx.dt;
+    if constexpr (Type == BlockType::SawOsc)
+        out.value = amp.value * polyblep::saw(p, dt);
+    else if constexpr (Type == BlockType::SquareOsc)
+        out.value = amp.value * polyblep::square(p, dt);
+    else
+        out.value = amp.value * polyblep::triangle(p, dt);
+
+    phase.value = polyblep::advance(p, dt);
+}
+
+template<BlockType Type>
+entt::entity PolyBlepOsc<Type>::create(IGraphRegistry* reg, float init_freq, float init_amp) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, init_freq, init_amp);
+}
+
+template<BlockType Type>
+entt::entity PolyBlepOsc<Type>::create(entt::registry&registry, float init_freq, float init_amp) {
+    auto phase = registry.create();
+    registry.emplace<Input1D>(phase, 0.0f);
+    auto freq = registry.create();
+    registry.emplace<Input1D>(freq, init_freq);
+    auto amp = registry.create();
+    registry.emplace<Input1D>(amp, init_amp);
+    auto out = registry.create();
+    registry.emplace<Output1D>(out, 0.0f);
+
+    auto block = Block::create(registry, Type,
+                               fill_with_null<N_INPUTS>(phase, freq, amp),
+                               fill_with_null<N_OUTPUTS>(out),
+                               process, view);
+    setup(registry, block);
+    return block;
+}
+
+template<BlockType Type>
+std::vector<entt::entity>
+PolyBlepOsc<Type>::create_many(IGraphRegistry* reg, const std::vector<float>&freqs, const std::vector<float>&amps) {
+    if (freqs.size() != amps.size())
+        throw std::runtime_error("create_many: freqs and amps must have the same size");
+
+    auto [registry, guard] = reg->get_graph_registry();
+    std::vector<entt::entity> blocks;
+    blocks.reserve(freqs.size());
+    for (size_t i = 0; i < freqs.size(); i++) {
+        blocks.push_back(create(registry, freqs[i], amps[i]));
+    }
+    return blocks;
+}
+
+template<BlockType Type>
+void PolyBlepOsc<Type>::setup(entt::registry&registry, entt::entity block) {
+    registry.emplace<Silence>(block, SineOsc::is_silent);
+}
+
+template<BlockType Type>
+IoMap PolyBlepOsc<Type>::view(entt::registry&registry, const Block&block) {
+    //Same ports as SineOsc
+    return SineOsc::view(registry, block);
+}
+
+template
+struct AAri::PolyBlepOsc<BlockType::SawOsc>;
+template
+struct AAri::PolyBlepOsc<BlockType::SquareOsc>;
+template
+struct AAri::PolyBlepOsc<BlockType::TriOsc>;
@@ -6,6 +6,9 @@
 #include "../core/graph.h"
 #include "../core/audio_context.h"
 #include "../core/graph_registry.h"
+#include "../core/utils/fast_math.h"
+#include "../core/utils/polyblep.h"
+#include "wavetables.h"
 #include <entt/entt.hpp>
 #include <cmath>
 
@@ -24,8 +27,81 @@ namespace AAri {
 
         static entt::entity create(IGraphRegistry *reg, float init_freq = 440.0f, float init_amp = 1.0f);
 
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, float init_freq = 440.0f, float init_amp = 1.0f);
+
+        /**
+         * Bulk creation of freqs.size() oscillators under a single lock
+         */
+        static std::vector<entt::entity> create_many(IGraphRegistry *reg, const std::vector<float> &freqs,
+                                                     const std::vector<float> &amps);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        // Add the components other than inputs and outputs, this is also used when restoring snapshots
+        static void setup(entt::registry &registry, entt::entity block);
+
+        // Silent when the amplitude is zero
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+
+    /**
+     * Oscillator reading one of the shared Wavetables, picking the band-limited level for its frequency.
+     * Inputs: phase (in cycles), freq, amp and table (index in Wavetables, as a float so that it can be wired).
+     */
+    struct WavetableOsc : public Oscillator {
+        enum class Interpolation {
+            Linear,
+            Cubic,
+        };
+
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static void process_cubic(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, uint32_t table = Wavetables::SINE, float init_freq = 440.0f,
+                                   float init_amp = 1.0f, Interpolation interpolation = Interpolation::Linear);
+
+        static entt::entity create(entt::registry &registry, uint32_t table = Wavetables::SINE,
+                                   float init_freq = 440.0f, float init_amp = 1.0f,
+                                   Interpolation interpolation = Interpolation::Linear);
+
+        static std::vector<entt::entity> create_many(IGraphRegistry *reg, uint32_t table,
+                                                     const std::vector<float> &freqs,
+                                                     const std::vector<float> &amps,
+                                                     Interpolation interpolation = Interpolation::Linear);
+
         static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
     };
+
+    /**
+     * Saw, square or triangle oscillator with PolyBLEP anti-aliasing (see utils/polyblep.h),
+     * Type is BlockType::SawOsc, SquareOsc or TriOsc.
+     * Inputs: phase (in cycles), freq and amp, like WavetableOsc but without the table lookups.
+     */
+    template<BlockType Type>
+    struct PolyBlepOsc : public Oscillator {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, float init_freq = 440.0f, float init_amp = 1.0f);
+
+        static entt::entity create(entt::registry &registry, float init_freq = 440.0f, float init_amp = 1.0f);
+
+        static std::vector<entt::entity> create_many(IGraphRegistry *reg, const std::vector<float> &freqs,
+                                                     const std::vector<float> &amps);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
+    };
+
+    using SawOsc = PolyBlepOsc<BlockType::SawOsc>;
+    using SquareOsc = PolyBlepOsc<BlockType::SquareOsc>;
+    using TriOsc = PolyBlepOsc<BlockType::TriOsc>;
 }
 
 
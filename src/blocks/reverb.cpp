@@ -0,0 +1,155 @@
+//
+//
+
+#include "reverb.h"
+#include "../core/kernels/kernels.h"
+#include <cmath>
+#include <stdexcept>
+
+using namespace AAri;
+
+namespace {
+    // log2(1000): a line loses 60 dB in decay seconds
+    constexpr float LOG2_1000 = 9.9657843f;
+
+    bool is_prime(size_t n) {
+        if (n < 2)
+            return false;
+        for (size_t d = 2; d * d <= n; d++) {
+            if (n % d == 0)
+                return false;
+        }
+        return true;
+    }
+}
+
+void FdnReverb::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&input = registry.get<InputND<2>>(block.inputIds[0]).value;
+    auto&decay = registry.get<Input1D>(block.inputIds[1]);
+    auto&damping = registry.get<Input1D>(block.inputIds[2]);
+    auto&matrix = registry.get<Input1D>(block.inputIds[3]);
+    auto&fdn = registry.get<FdnLines>(block.inputIds[4]);
+    auto&out = registry.get<OutputND<2>>(block.outputIds[0]).value;
+
+    const size_t n = fdn.lines.size();
+    if (decay.value != fdn.decay || ctx.sample_freq != fdn.sample_rate) {
+        fdn.decay = decay.value;
+        fdn.sample_rate = ctx.sample_freq;
+        const float per_sample = -LOG2_1000 / (std::max(decay.value, 0.01f) * ctx.sample_freq);
+        for (size_t i = 0; i < n; i++)
+            fdn.gains[i] = std::exp2(per_sample * float(fdn.delays[i]));
+    }
+
+    float lines[FDN_MAX_LINES];
+    for (size_t i = 0; i < n; i++)
+        lines[i] = fdn.lines[i].tap(fdn.delays[i]);
+    //Alternate signs within each side so that the lines don't add up in phase
+    float left = 0.0f;
+    float right = 0.0f;
+    for (size_t i = 0; i < n; i += 4) {
+        left += lines[i] - lines[i + 2];
+        right += lines[i + 1] - lines[i + 3];
+    }
+    const float scale = 1.0f / std::sqrt(float(n / 2));
+    out[0] = left * scale;
+    out[1] = right * scale;
+
+    kernels().fdn({
+        lines, fdn.filters.data(), fdn.gains.data(), n, std::clamp(damping.value, 0.0f, 0.99f), input[0], input[1],
+        matrix.value == HOUSEHOLDER
+    });
+    for (size_t i = 0; i < n; i++)
+        fdn.lines[i].write(lines[i]);
+}
+
+entt::entity FdnReverb::create(IGraphRegistry* reg, size_t lines, float size, float decay, float damping) {
+    const auto sample_rate = float(reg->get_sample_rate());
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, lines, size, decay, damping, sample_rate);
+}
+
+entt::entity FdnReverb::create(entt::registry&registry, size_t lines, float size, float decay, float damping,
+                               float sample_rate) {
+    if (lines != 4 && lines != 8 && lines != 16)
+        throw std::runtime_error("FdnReverb: 4, 8 or 16 delay lines are needed");
+    if (!(size > 0.0f))
+        throw std::runtime_error("FdnReverb: the size must be positive");
+    std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+    inputs[0] = registry.create();
+    registry.emplace<InputND<2>>(inputs[0], std::array<float, 2>{0.0f, 0.0f});
+    const float values[] = {decay, damping, HADAMARD};
+    for (size_t i = 0; i < 3; i++) {
+        inputs[i + 1] = registry.create();
+        registry.emplace<Input1D>(inputs[i + 1], values[i]);
+    }
+    inputs[4] = registry.create();
+    registry.emplace<InputArray>(inputs[4], default_delays(lines, size, sample_rate));
+    auto out = registry.create();
+    registry.emplace<OutputND<2>>(out, std::array<float, 2>{0.0f, 0.0f});
+
+    auto block = Block::create(registry, BlockType::FdnReverb, inputs, fill_with_null<N_OUTPUTS>(out), process,
+                               view);
+    setup(registry, block);
+    return block;
+}
+
+void FdnReverb::setup(entt::registry&registry, entt::entity block) {
+    const auto delaysid = registry.get<Block>(block).inputIds[4];
+    const auto&delays = registry.get<InputArray>(delaysid).value;
+    const size_t n = delays.size();
+    if (n != 4 && n != 8 && n != 16)
+        throw std::runtime_error("FdnReverb: 4, 8 or 16 delay lines are needed");
+    FdnLines fdn;
+    fdn.lines.reserve(n);
+    for (float delay: delays) {
+        if (!(delay >= 1.0f && delay <= float(MemoryPool::ARENA_SIZE)))
+            throw std::runtime_error("FdnReverb: invalid delay");
+        fdn.delays.push_back(size_t(delay));
+        fdn.lines.emplace_back(DelayLine::length_for(delay));
+    }
+    fdn.filters.assign(n, 0.0f);
+    fdn.gains.assign(n, 0.0f);
+    registry.emplace_or_replace<FdnLines>(delaysid, std::move(fdn));
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool FdnReverb::is_silent(entt::registry&registry, const Block&block) {
+    const auto&input = registry.get<InputND<2>>(block.inputIds[0]).value;
+    if (input[0] != 0.0f || input[1] != 0.0f)
+        return false;
+    for (const auto&line: registry.get<FdnLines>(block.inputIds[4]).lines) {
+        if (!line.is_silent())
+            return false;
+    }
+    return true;
+}
+
+IoMap FdnReverb::view(entt::registry&registry, const Block&block) {
+    IoMap io_map;
+    io_map[block.inputIds[0]] = std::make_unique<InputND<2>>(registry.get<InputND<2>>(block.inputIds[0]));
+    for (size_t i = 1; i < 4; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+    }
+    io_map[block.inputIds[4]] = std::make_unique<InputArray>(registry.get<InputArray>(block.inputIds[4]));
+    auto outid = block.outputIds[0];
+    io_map[outid] = std::make_unique<OutputND<2>>(registry.get<OutputND<2>>(outid));
+    return io_map;
+}
+
+std::vector<float> FdnReverb::default_delays(size_t lines, float size, float sample_rate) {
+    std::vector<float> delays;
+    const float shortest = MIN_DELAY_TIME * size * sample_rate;
+    const float ratio = MAX_DELAY_TIME / MIN_DELAY_TIME;
+    size_t previous = 0;
+    for (size_t i = 0; i < lines; i++) {
+        const float t = lines > 1 ? float(i) / float(lines - 1) : 0.0f;
+        //Distinct primes have no common factor, so the echoes of the lines rarely coincide
+        auto delay = std::max(size_t(shortest * std::pow(ratio, t)), previous + 1);
+        while (!is_prime(delay))
+            delay++;
+        delays.push_back(float(delay));
+        previous = delay;
+    }
+    return delays;
+}
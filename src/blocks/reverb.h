@@ -0,0 +1,73 @@
+//
+//
+
+#ifndef AARI_REVERB_H
+#define AARI_REVERB_H
+
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include "../core/utils/delay_line.h"
+#include <entt/entt.hpp>
+#include <vector>
+
+namespace AAri {
+    /**
+     * Delay lines of a FdnReverb and what is derived from its inputs, kept as a component of its delays input
+     */
+    struct FdnLines {
+        std::vector<DelayLine> lines;
+        std::vector<size_t> delays;
+        std::vector<float> filters;
+        std::vector<float> gains;
+        // Inputs the gains were computed for
+        float decay = -1.0f;
+        float sample_rate = 0.0f;
+    };
+
+    /**
+     * Feedback delay network reverb: 4 to 16 delay lines of mutually prime lengths whose outputs are damped,
+     * mixed by an orthogonal matrix (Hadamard or Householder) and fed back, all lines at once in the fdn kernel.
+     * Inputs: stereo input (InputND<2>, e.g. wired from a StereoMixer with transmit_2d_to_2d), decay time
+     * (T60 in seconds), damping in [0, 1), matrix (0 Hadamard, 1 Householder), and the delays of the lines
+     * in samples (InputArray, only read by setup).
+     * Output: the stereo reverb alone (OutputND<2>), to be mixed back with the dry signal, e.g. in a StereoMixer.
+     * The left input feeds the even lines and the left output reads them, the right the odd ones.
+     */
+    struct FdnReverb {
+        static constexpr float HADAMARD = 0.0f;
+        static constexpr float HOUSEHOLDER = 1.0f;
+        // Range of the default delays for a size of 1, in seconds
+        static constexpr float MIN_DELAY_TIME = 0.02f;
+        static constexpr float MAX_DELAY_TIME = 0.08f;
+
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        /**
+         * @param lines 4, 8 or 16
+         * @param size scales the default delays, i.e. the size of the room
+         */
+        static entt::entity create(IGraphRegistry *reg, size_t lines = 16, float size = 1.0f, float decay = 2.0f,
+                                   float damping = 0.3f);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, size_t lines = 16, float size = 1.0f,
+                                   float decay = 2.0f, float damping = 0.3f, float sample_rate = 48000.0f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        // Throws if there are not 4, 8 or 16 positive delays
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+
+        /**
+         * Primes spread exponentially between MIN_DELAY_TIME and MAX_DELAY_TIME times size, in samples
+         */
+        static std::vector<float> default_delays(size_t lines, float size, float sample_rate);
+    };
+}
+
+#endif //AARI_REVERB_H
@@ -0,0 +1,87 @@
+//
+//
+
+#include "samples.h"
+#include <stdexcept>
+
+using namespace AAri;
+
+Samples::Samples() : _samples(MAX_SAMPLES) {
+}
+
+Samples &Samples::instance() {
+    static Samples samples;
+    return samples;
+}
+
+uint32_t Samples::load(const std::string&path, uint32_t sample_rate, size_t preload_frames) {
+    //Decoded before locking, it reads from the disk
+    auto sample = std::make_unique<SampleFile>(path, sample_rate, preload_frames);
+    std::lock_guard lock(_add_mutex);
+    const uint32_t index = _count.load(std::memory_order_relaxed);
+    if (index >= MAX_SAMPLES)
+        throw std::runtime_error("Too many samples, the maximum is " + std::to_string(MAX_SAMPLES));
+    _samples[index] = std::move(sample);
+    //Publish the sample only once it is fully loaded
+    _count.store(index + 1, std::memory_order_release);
+    return index;
+}
+
+void Sampler::process(entt::registry&registry, const Block&block, AudioContext ctx) {
+    auto&gate = registry.get<Input1D>(block.inputIds[0]);
+    auto&sample = registry.get<Input1D>(block.inputIds[1]);
+    auto&gain = registry.get<Input1D>(block.inputIds[2]);
+    auto&state = registry.get<SamplerState>(block.inputIds[0]);
+    auto&out = registry.get<OutputND<2>>(block.outputIds[0]).value;
+
+    if (gate.value > 0.0f && state.gate <= 0.0f)
+        state.stream->start(sample.value >= 0.0f ? Samples::instance().get(uint32_t(sample.value)) : nullptr);
+    state.gate = gate.value;
+    float left, right;
+    state.stream->next(left, right, ctx.realtime);
+    out[0] = gain.value * left;
+    out[1] = gain.value * right;
+}
+
+entt::entity Sampler::create(IGraphRegistry* reg, uint32_t sample, float gain) {
+    auto [registry, guard] = reg->get_graph_registry();
+    return create(registry, sample, gain);
+}
+
+entt::entity Sampler::create(entt::registry&registry, uint32_t sample, float gain) {
+    std::array<entt::entity, N_INPUTS> inputs = fill_with_null<N_INPUTS>();
+    const float values[] = {0.0f, float(sample), gain};
+    for (size_t i = 0; i < 3; i++) {
+        inputs[i] = registry.create();
+        registry.emplace<Input1D>(inputs[i], values[i]);
+    }
+    auto out = registry.create();
+    registry.emplace<OutputND<2>>(out, std::array<float, 2>{0.0f, 0.0f});
+
+    auto block = Block::create(registry, BlockType::Sampler, inputs, fill_with_null<N_OUTPUTS>(out), process, view);
+    setup(registry, block);
+    return block;
+}
+
+void Sampler::setup(entt::registry&registry, entt::entity block) {
+    const auto gateid = registry.get<Block>(block).inputIds[0];
+    registry.emplace_or_replace<SamplerState>(gateid, SampleStream::create());
+    registry.emplace<Silence>(block, is_silent);
+}
+
+bool Sampler::is_silent(entt::registry&registry, const Block&block) {
+    const auto&state = registry.get<SamplerState>(block.inputIds[0]);
+    const bool starting = registry.get<Input1D>(block.inputIds[0]).value > 0.0f && state.gate <= 0.0f;
+    return !starting && !state.stream->playing();
+}
+
+IoMap Sampler::view(entt::registry&registry, const Block&block) {
+    IoMap io_map;
+    for (size_t i = 0; i < 3; i++) {
+        auto inputid = block.inputIds[i];
+        io_map[inputid] = std::make_unique<Input1D>(registry.get<Input1D>(inputid));
+    }
+    auto outid = block.outputIds[0];
+    io_map[outid] = std::make_unique<OutputND<2>>(registry.get<OutputND<2>>(outid));
+    return io_map;
+}
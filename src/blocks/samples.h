@@ -0,0 +1,95 @@
+//
+//
+
+#ifndef AARI_SAMPLES_H
+#define AARI_SAMPLES_H
+
+#include "../core/graph.h"
+#include "../core/audio_context.h"
+#include "../core/graph_registry.h"
+#include "../core/sample_stream.h"
+#include <entt/entt.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace AAri {
+    /**
+     * Audio files shared by all the Samplers and referred to by index, like the Wavetables.
+     * Only the attack of each file is in memory, so libraries much larger than the memory can be loaded.
+     * Files can be added at any time (even while audio is running) but are never removed, which keeps
+     * reads lock free.
+     */
+    class Samples {
+    public:
+        static constexpr size_t MAX_SAMPLES = size_t(1) << 16;
+        // 340 ms at 48 kHz: the streaming thread has that long to catch up after a note starts
+        static constexpr size_t PRELOAD_FRAMES = 16384;
+
+        static Samples &instance();
+
+        /**
+         * Open an audio file (WAV, FLAC or MP3) and decode its attack, resampled to sample_rate.
+         * Throws if the file cannot be decoded
+         * @return the index of the sample
+         */
+        uint32_t load(const std::string &path, uint32_t sample_rate, size_t preload_frames = PRELOAD_FRAMES);
+
+        /**
+         * @return the sample at index, or nullptr if there is none
+         */
+        const SampleFile *get(uint32_t index) const {
+            if (index >= _count.load(std::memory_order_acquire))
+                return nullptr;
+            return _samples[index].get();
+        }
+
+        size_t size() const {
+            return _count.load(std::memory_order_acquire);
+        }
+
+    private:
+        Samples();
+
+        std::vector<std::unique_ptr<SampleFile>> _samples;
+        std::atomic<uint32_t> _count = 0;
+        std::mutex _add_mutex;
+    };
+
+    /**
+     * Stream of a Sampler, kept as a component of its gate input with the last gate seen
+     */
+    struct SamplerState {
+        std::shared_ptr<SampleStream> stream;
+        float gate = 0.0f;
+    };
+
+    /**
+     * One shot player of the Samples, streamed from disk (see SampleStream).
+     * Inputs: gate (going above 0 plays the sample from its start), sample (index in Samples, as a float so
+     * that it can be wired, read when the gate goes up) and gain.
+     * Output: stereo (OutputND<2>).
+     * The sample plays to its end whatever the gate does afterwards, an envelope shapes the release.
+     * A voice of a sampled instrument is a Sampler per layer, e.g. in a VoicePool.
+     */
+    struct Sampler {
+        static void process(entt::registry &registry, const Block &block, AudioContext ctx);
+
+        static entt::entity create(IGraphRegistry *reg, uint32_t sample, float gain = 1.0f);
+
+        /**
+         * Create the block directly in the registry, the caller is responsible for locking it
+         */
+        static entt::entity create(entt::registry &registry, uint32_t sample, float gain = 1.0f);
+
+        static IoMap view(entt::registry &registry, const Block &block);
+
+        static void setup(entt::registry &registry, entt::entity block);
+
+        static bool is_silent(entt::registry &registry, const Block &block);
+    };
+}
+
+#endif //AARI_SAMPLES_H
@@ -0,0 +1,125 @@
+//
+//
+
+#include "wavetables.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+using namespace AAri;
+
+namespace {
+    constexpr double PI_D = 3.14159265358979323846;
+
+    //Harmonic series of the classic waveforms, all with a peak around 1
+    std::vector<float> triangle_harmonics() {
+        std::vector<float> sines(Wavetable::MAX_HARMONICS, 0.0f);
+        for (size_t h = 1; h <= sines.size(); h += 2) {
+            const double sign = ((h - 1) / 2) % 2 == 0 ? 1.0 : -1.0;
+            sines[h - 1] = float(sign * 8.0 / (PI_D * PI_D * double(h * h)));
+        }
+        return sines;
+    }
+
+    std::vector<float> saw_harmonics() {
+        //Rising saw going from -1 to 1 over the cycle (2 p - 1), like SawOsc
+        std::vector<float> sines(Wavetable::MAX_HARMONICS, 0.0f);
+        for (size_t h = 1; h <= sines.size(); h++)
+            sines[h - 1] = float(-2.0 / (PI_D * double(h)));
+        return sines;
+    }
+
+    std::vector<float> square_harmonics() {
+        std::vector<float> sines(Wavetable::MAX_HARMONICS, 0.0f);
+        for (size_t h = 1; h <= sines.size(); h += 2)
+            sines[h - 1] = float(4.0 / (PI_D * double(h)));
+        return sines;
+    }
+}
+
+Wavetable::Wavetable(const std::vector<float>&sines, const std::vector<float>&cosines)
+    : _data(LEVELS * STRIDE, 0.0f) {
+    //sin(2 pi h i / SIZE) is the base cycle read at index h * i, so a single
+    //table of sines and cosines is enough to sum all the harmonics
+    std::vector<double> base_sin(SIZE), base_cos(SIZE);
+    for (size_t i = 0; i < SIZE; i++) {
+        base_sin[i] = std::sin(2.0 * PI_D * double(i) / double(SIZE));
+        base_cos[i] = std::cos(2.0 * PI_D * double(i) / double(SIZE));
+    }
+
+    std::vector<double> cycle(SIZE);
+    for (size_t l = 0; l < LEVELS; l++) {
+        std::fill(cycle.begin(), cycle.end(), 0.0);
+        const size_t harmonics = MAX_HARMONICS >> l;
+        for (size_t h = 1; h <= harmonics; h++) {
+            const double sine = h <= sines.size() ? sines[h - 1] : 0.0;
+            const double cosine = h <= cosines.size() ? cosines[h - 1] : 0.0;
+            if (sine == 0.0 && cosine == 0.0)
+                continue;
+            for (size_t i = 0; i < SIZE; i++) {
+                const size_t index = (h * i) % SIZE;
+                cycle[i] += sine * base_sin[index] + cosine * base_cos[index];
+            }
+        }
+
+        float *data = _data.data() + l * STRIDE;
+        data[0] = float(cycle[SIZE - 1]);
+        for (size_t i = 0; i < SIZE; i++)
+            data[i + 1] = float(cycle[i]);
+        data[SIZE + 1] = float(cycle[0]);
+        data[SIZE + 2] = float(cycle[1]);
+    }
+}
+
+Wavetables::Wavetables() {
+    std::vector<float> sine = {1.0f};
+    add_harmonics(sine);
+    add_harmonics(triangle_harmonics());
+    add_harmonics(saw_harmonics());
+    add_harmonics(square_harmonics());
+}
+
+Wavetables &Wavetables::instance() {
+    static Wavetables tables;
+    return tables;
+}
+
+uint32_t Wavetables::add(const std::vector<float>&cycle) {
+    if (cycle.size() < 2)
+        throw std::runtime_error("A wavetable cycle needs at least 2 samples");
+
+    //Direct DFT, this is only done when adding a table
+    const size_t length = cycle.size();
+    const size_t harmonics = std::min(length / 2, Wavetable::MAX_HARMONICS);
+    std::vector<float> sines(harmonics), cosines(harmonics);
+    for (size_t h = 1; h <= harmonics; h++) {
+        double re = 0.0, im = 0.0;
+        for (size_t i = 0; i < length; i++) {
+            const double angle = 2.0 * PI_D * double((h * i) % length) / double(length);
+            re += cycle[i] * std::cos(angle);
+            im += cycle[i] * std::sin(angle);
+        }
+        //The Nyquist bin of even lengths is not doubled
+        const double scale = (2 * h == length ? 1.0 : 2.0) / double(length);
+        sines[h - 1] = float(im * scale);
+        cosines[h - 1] = float(re * scale);
+    }
+    //The DC offset is dropped, it would only shift the output
+    return add_table(std::make_unique<Wavetable>(sines, cosines));
+}
+
+uint32_t Wavetables::add_harmonics(const std::vector<float>&sines) {
+    return add_table(std::make_unique<Wavetable>(sines, std::vector<float>{}));
+}
+
+uint32_t Wavetables::add_table(std::unique_ptr<Wavetable> table) {
+    std::lock_guard lock(_add_mutex);
+    const uint32_t index = _count.load(std::memory_order_relaxed);
+    if (index >= MAX_TABLES)
+        throw std::runtime_error("Too many wavetables, the maximum is " + std::to_string(MAX_TABLES));
+    _tables[index] = std::move(table);
+    //Publish the table only once it is fully built
+    _count.store(index + 1, std::memory_order_release);
+    return index;
+}
@@ -0,0 +1,135 @@
+//
+//
+
+#ifndef RELEASE_WAVETABLES_H
+#define RELEASE_WAVETABLES_H
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace AAri {
+    /**
+     * One waveform as a set of band-limited tables, one per octave.
+     * Level l keeps the first MAX_HARMONICS >> l harmonics, so an oscillator at frequency f
+     * reads the first level whose highest harmonic stays below Nyquist.
+     */
+    class Wavetable {
+    public:
+        static constexpr size_t SIZE = 2048;
+        static constexpr size_t MAX_HARMONICS = SIZE / 2;
+        static constexpr size_t LEVELS = 11;
+        // Guard points: one before and two after the cycle, for cubic interpolation without wrapping
+        static constexpr size_t STRIDE = SIZE + 3;
+
+        /**
+         * @param sines amplitudes of the sine harmonics, starting with the fundamental
+         * @param cosines same for the cosine harmonics, may be empty
+         */
+        Wavetable(const std::vector<float> &sines, const std::vector<float> &cosines);
+
+        /**
+         * @return the level to use at frequency freq
+         */
+        static size_t level_for(float freq, float sample_rate) {
+            const float ratio = float(MAX_HARMONICS) * 2.0f * freq / sample_rate;
+            if (!(ratio > 1.0f))
+                return 0;
+            //ceil(log2(ratio)) from the float's exponent
+            int exponent;
+            const float mantissa = std::frexp(ratio, &exponent);
+            const size_t level = mantissa == 0.5f ? exponent - 1 : exponent;
+            return level < LEVELS ? level : LEVELS - 1;
+        }
+
+        /**
+         * @return the samples of a level, with the cycle starting at index 1
+         */
+        const float *level(size_t l) const {
+            return _data.data() + l * STRIDE;
+        }
+
+        float read_linear(size_t l, float phase) const {
+            const float position = phase * float(SIZE);
+            const auto i = size_t(position);
+            const float frac = position - float(i);
+            const float *data = level(l) + i + 1;
+            return data[0] + frac * (data[1] - data[0]);
+        }
+
+        // 4 points Catmull-Rom / Hermite interpolation
+        float read_cubic(size_t l, float phase) const {
+            const float position = phase * float(SIZE);
+            const auto i = size_t(position);
+            const float frac = position - float(i);
+            const float *data = level(l) + i;
+            const float c1 = 0.5f * (data[2] - data[0]);
+            const float c2 = data[0] - 2.5f * data[1] + 2.0f * data[2] - 0.5f * data[3];
+            const float c3 = 0.5f * (data[3] - data[0]) + 1.5f * (data[1] - data[2]);
+            return ((c3 * frac + c2) * frac + c1) * frac + data[1];
+        }
+
+    private:
+        std::vector<float> _data;
+    };
+
+    /**
+     * Wavetables shared by all the oscillators and referred to by index.
+     * The built in waveforms are created on first use; user tables can be added at any time
+     * (even while audio is running) but are never removed, which keeps reads lock free.
+     */
+    class Wavetables {
+    public:
+        enum BuiltIn : uint32_t {
+            SINE,
+            TRIANGLE,
+            SAW,
+            SQUARE,
+        };
+
+        static constexpr size_t MAX_TABLES = 256;
+
+        static Wavetables &instance();
+
+        /**
+         * Add a table from one cycle of an arbitrary waveform, of any length.
+         * It is band-limited through its DFT, so the harmonics above half its length are lost.
+         * @return the index of the new table
+         */
+        uint32_t add(const std::vector<float> &cycle);
+
+        /**
+         * Add a table from the amplitudes of its sine harmonics, starting with the fundamental
+         */
+        uint32_t add_harmonics(const std::vector<float> &sines);
+
+        /**
+         * @return the table at index, or the sine table if there is none
+         */
+        const Wavetable &get(uint32_t index) const {
+            if (index >= _count.load(std::memory_order_acquire))
+                index = SINE;
+            return *_tables[index];
+        }
+
+        size_t size() const {
+            return _count.load(std::memory_order_acquire);
+        }
+
+    private:
+        Wavetables();
+
+        uint32_t add_table(std::unique_ptr<Wavetable> table);
+
+        std::array<std::unique_ptr<Wavetable>, MAX_TABLES> _tables;
+        std::atomic<uint32_t> _count = 0;
+        std::mutex _add_mutex;
+    };
+}
+
+#endif //RELEASE_WAVETABLES_H
@@ -9,5 +9,8 @@ struct AudioContext {
     float sample_freq;
     float dt;
     double clock; // Current elapsed time in seconds
+    bool realtime = false; // Rendering for the audio device, blocks must not wait for other threads
+    const float *input = nullptr; // Current frame of the captured audio, input_channels values, or null
+    unsigned int input_channels = 0;
 };
 #endif //AARI_AUDIO_CONTEXT_H
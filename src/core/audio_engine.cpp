@@ -2,77 +2,356 @@
 
 #include "audio_engine.h"
 #include "blocks.h"
+#include "../blocks/aux_bus.h"
 #include "graph.h"
 #include "inputs_outputs.h"
+#include "snapshot.h"
+#include "memory_pool.h"
+#include "kernels/kernels.h"
+#include <algorithm>
+#include <array>
 #include <iostream>
 
 using namespace AAri;
 
-AudioEngine::AudioEngine(ma_uint32 sample_rate, ma_uint32 buffer_size)
-    : clock_seconds(0), _output_id(entt::null), _output_width(0) {
-    // Open audio device
-    _deviceConfig = ma_device_config_init(ma_device_type_playback);
+namespace {
+    // Values of an output and how many there are, none if it is not an output (any more)
+    std::pair<const float *, size_t> output_values(entt::registry&registry, entt::entity id) {
+        if (id == entt::null || !registry.valid(id))
+            return {nullptr, 0};
+        if (auto* mono = registry.try_get<Output1D>(id))
+            return {&mono->value, 1};
+        if (auto* output = registry.try_get<OutputND<2>>(id))
+            return {output->value.data(), 2};
+        if (auto* output = registry.try_get<OutputND<4>>(id))
+            return {output->value.data(), 4};
+        if (auto* output = registry.try_get<OutputND<8>>(id))
+            return {output->value.data(), 8};
+        if (auto* output = registry.try_get<OutputND<16>>(id))
+            return {output->value.data(), 16};
+        if (auto* output = registry.try_get<OutputND<32>>(id))
+            return {output->value.data(), 32};
+        if (auto* output = registry.try_get<OutputArray>(id))
+            return {output->value.data(), output->value.size()};
+        return {nullptr, 0};
+    }
+
+    // Mixer wires are gathered rather than transmitted, any other function would be ignored
+    void check_mixer_transmit(const TransmitFunc&transmitFunc) {
+        auto* func = transmitFunc.target<decltype(&Wire::transmit_to_mixer)>();
+        if (func == nullptr || *func != &Wire::transmit_to_mixer)
+            throw std::runtime_error("Cannot create wire, wires to a mixer take Wire::transmit_to_mixer");
+    }
+
+    // The inputs of mixers have slots, which only add_wire_to_mixer gives
+    void check_not_mixer(entt::registry&registry, entt::entity to_input) {
+        if (registry.valid(to_input) && registry.all_of<MixerInput>(to_input))
+            throw std::runtime_error("Cannot create wire, use add_wire_to_mixer for the input of a mixer");
+    }
+}
+
+AudioEngine::AudioEngine(ma_uint32 sample_rate, ma_uint32 buffer_size, bool headless, ma_uint32 input_channels,
+                         bool null_backend, ma_uint32 output_channels)
+    : clock_seconds(0), _sample_rate(sample_rate), _headless(headless), _output_channels(output_channels),
+      _input_channels(input_channels), _output_id(entt::null), _output_width(0) {
+    if (output_channels == 0)
+        throw std::runtime_error("The engine needs at least one output channel");
+    _planar.assign(output_channels * PLANAR_FRAMES, 0.0f);
+    // Select the DSP kernels for this CPU now rather than in the first audio callback
+    kernels();
+    // Same for the memory of the delay lines
+    MemoryPool::instance().reserve(MemoryPool::ARENA_SIZE);
+    if (headless)
+        return;
+
+    if (null_backend) {
+        const ma_backend backends[] = {ma_backend_null};
+        if (ma_context_init(backends, 1, nullptr, &_context) != MA_SUCCESS)
+            throw std::runtime_error("Failed to initialize the null audio backend.");
+        _own_context = true;
+    }
+
+    // Open audio device, capturing in the same callback so that live input goes through without added latency
+    _deviceConfig = ma_device_config_init(input_channels > 0 ? ma_device_type_duplex : ma_device_type_playback);
     _deviceConfig.playback.format = ma_format_f32;
-    _deviceConfig.playback.channels = 2;
+    _deviceConfig.playback.channels = output_channels;
+    _deviceConfig.capture.format = ma_format_f32;
+    _deviceConfig.capture.channels = input_channels;
     _deviceConfig.sampleRate = sample_rate;
     _deviceConfig.dataCallback = audio_callback;
     _deviceConfig.pUserData = this;
     _deviceConfig.periodSizeInFrames = buffer_size;
 
-    if (ma_device_init(nullptr, &_deviceConfig, &_device) != MA_SUCCESS) {
+    if (ma_device_init(_own_context ? &_context : nullptr, &_deviceConfig, &_device) != MA_SUCCESS) {
+        if (_own_context)
+            ma_context_uninit(&_context);
         throw std::runtime_error("Failed to open playback device.");
     }
+    _sample_rate = _device.sampleRate;
+    _output_channels = _device.playback.channels;
+    _planar.assign(_output_channels * PLANAR_FRAMES, 0.0f);
+    if (input_channels > 0)
+        _input_channels = _device.capture.channels;
 }
 
 AudioEngine::~AudioEngine() {
+    if (_headless)
+        return;
     ma_device_uninit(&_device);
     ma_device_stop(&_device);
+    if (_own_context)
+        ma_context_uninit(&_context);
     // printf("Audio engine destroyed\n");
 }
 
 void AudioEngine::startAudio() {
+    if (_headless)
+        throw std::runtime_error("Cannot start audio on a headless engine, use render instead");
     ma_device_start(&_device);
     clock_seconds = 0.0;
 }
 
 void AudioEngine::stopAudio() {
+    if (_headless)
+        return;
     ma_device_stop(&_device);
 }
 
 void AudioEngine::audio_callback(ma_device* pDevice, void* pOutput,
                                  const void* pInput, ma_uint32 frameCount) {
     auto* engine = static_cast<AudioEngine *>(pDevice->pUserData);
-    auto [registry, guard] = engine->get_graph_registry();
+    engine->render(static_cast<float *>(pOutput), static_cast<const float *>(pInput), frameCount, true);
+}
+
+void AudioEngine::render(float* buffer, ma_uint32 frameCount, const float* input) {
+    if (input != nullptr && _input_channels == 0)
+        throw std::runtime_error("render: the engine has no input channels");
+    render(buffer, input, frameCount, false);
+}
 
-    auto* buffer = (float *)pOutput;
-    const auto sample_freq = (float)pDevice->sampleRate;
+void AudioEngine::render(float* buffer, const float* input, ma_uint32 frameCount, bool realtime) {
+    auto [registry, guard] = get_graph_registry();
+    for (auto&pool: _voice_pools)
+        pool->process_events(registry);
+
+    const auto sample_freq = (float)_sample_rate;
     const float seconds_per_sample = 1.0f / sample_freq;
 
-    float* output;
-    const size_t width = engine->_output_width;
-    if (width == 0)
+    const size_t channels = _output_channels;
+    //A tapped output is recorded even when nothing is played
+    const bool tapped_recordings = std::any_of(_recordings.begin(), _recordings.end(),
+                                               [](const Recording&r) { return r.output_id != entt::null; });
+    if (_output_width == 0 && _buses.empty() && !tapped_recordings) {
+        std::fill(buffer, buffer + channels * frameCount, 0.0f);
+        for (auto&recording: _recordings) {
+            if (recording.output_id == entt::null)
+                recording.recorder->push(buffer, frameCount, realtime);
+        }
+        for (auto&pool: _voice_pools)
+            pool->update_voices(registry);
         return;
-    if (width == 1)
-        output = &(registry.get<Output1D>(engine->_output_id).value);
-    else if (width == 2)
-        output = &(registry.get<OutputND<2>>(engine->_output_id).value[0]);
-    else
-        throw std::runtime_error("Invalid output width: " + std::to_string(width));
+    }
+
+    //Outputs whose block was removed are silent
+    _routes.clear();
+    add_routes(registry, _output_id, _output_width, 0);
+    if (_output_width == 1 && channels >= 2 && !_routes.empty())
+        _routes.push_back({_routes.back().value, 1});
+    for (const auto&bus: _buses)
+        add_routes(registry, bus.output_id, bus.width, bus.first_channel);
+
+    //Recorded outputs, looked up once per buffer. One whose block was removed records silence
+    const float silence[2] = {0.0f, 0.0f};
+    std::array<const float *, MAX_RECORDINGS> recorded;
+    const size_t n_recorded = std::min(_recordings.size(), MAX_RECORDINGS);
+    for (size_t r = 0; r < n_recorded; r++) {
+        const auto id = _recordings[r].output_id;
+        recorded[r] = silence;
+        if (id == entt::null || !registry.valid(id))
+            continue;
+        if (auto* mono = registry.try_get<Output1D>(id))
+            recorded[r] = &mono->value;
+        else if (auto* stereo = registry.try_get<OutputND<2>>(id))
+            recorded[r] = stereo->value.data();
+    }
 
-    for (size_t i = 0; i < 2 * frameCount; i += 2) {
-        engine->clock_seconds += seconds_per_sample;
-        engine->_graph.process(
-            {sample_freq, seconds_per_sample, engine->clock_seconds});
+    //The graph runs one sample at a time, so the buses are gathered into one row per channel
+    //and the rows transposed into the device frames once per segment
+    const unsigned int input_channels = input != nullptr ? _input_channels : 0;
+    for (size_t start = 0; start < frameCount; start += PLANAR_FRAMES) {
+        const size_t frames = std::min<size_t>(PLANAR_FRAMES, frameCount - start);
+        std::fill(_planar.begin(), _planar.end(), 0.0f);
+        for (size_t f = 0; f < frames; f++) {
+            clock_seconds += seconds_per_sample;
+            _graph.process(
+                {sample_freq, seconds_per_sample, clock_seconds, realtime, input, input_channels});
+            if (input != nullptr)
+                input += input_channels;
+
+            for (const auto&route: _routes)
+                _planar[route.channel * PLANAR_FRAMES + f] += *route.value;
+            for (size_t r = 0; r < n_recorded; r++) {
+                if (_recordings[r].output_id != entt::null)
+                    _recordings[r].recorder->push_frame(recorded[r], realtime);
+            }
+        }
+        kernels().interleave(_planar.data(), PLANAR_FRAMES, channels, frames, buffer + start * channels);
+    }
+    for (size_t r = 0; r < n_recorded; r++) {
+        if (_recordings[r].output_id == entt::null)
+            _recordings[r].recorder->push(buffer, frameCount, realtime);
+        else
+            _recordings[r].recorder->publish();
+    }
+    for (auto&pool: _voice_pools)
+        pool->update_voices(registry);
+}
 
-        buffer[i] = output[0];
-        buffer[i + 1] = width == 2 ? output[1] : output[0];
+void AudioEngine::add_routes(entt::registry&registry, entt::entity output_id, size_t width, size_t first_channel) {
+    auto [values, available] = output_values(registry, output_id);
+    width = std::min(width, available);
+    for (size_t k = 0; k < width && first_channel + k < _output_channels; k++) {
+        if (_routes.size() == _routes.capacity())
+            return;
+        _routes.push_back({values + k, first_channel + k});
     }
 }
 
+void AudioEngine::reserve_routes() {
+    //One more for the second channel of a mono main output
+    size_t routes = _output_width + 1;
+    for (const auto&bus: _buses)
+        routes += bus.width;
+    _routes.reserve(routes);
+}
+
 void AudioEngine::set_output_ref(entt::entity output_id, size_t output_width) {
-    auto guard = lock_till_function_returns();
+    auto [registry, guard] = get_graph_registry();
+    if (output_width > _output_channels)
+        throw std::runtime_error("set_output_ref: an output of width " + std::to_string(output_width) +
+                                 " doesn't fit in " + std::to_string(_output_channels) + " channels");
+    if (_output_width > 0 && registry.valid(_output_id))
+        _graph.untap_output(_output_id);
     _output_id = output_id;
     _output_width = output_width;
+    if (_output_width > 0)
+        _graph.tap_output(_output_id);
+    reserve_routes();
+
+    // The set of blocks that need to run depends on the output
+    _graph.toposort_blocks();
+}
+
+void AudioEngine::set_output_bus(const std::string&name, entt::entity output_id, size_t first_channel) {
+    auto [registry, guard] = get_graph_registry();
+    const size_t width = output_values(registry, output_id).second;
+    if (width == 0)
+        throw std::runtime_error("set_output_bus: the bus " + name + " is not given an output");
+    if (first_channel + width > _output_channels)
+        throw std::runtime_error("set_output_bus: " + name + " needs channels " + std::to_string(first_channel) +
+                                 " to " + std::to_string(first_channel + width - 1) + " but the device has " +
+                                 std::to_string(_output_channels));
+
+    auto found = std::find_if(_buses.begin(), _buses.end(), [&](const OutputBus&bus) {
+        return bus.name == name;
+    });
+    if (found != _buses.end()) {
+        if (registry.valid(found->output_id))
+            _graph.untap_output(found->output_id);
+        *found = {name, output_id, first_channel, width};
+    }
+    else {
+        _buses.push_back({name, output_id, first_channel, width});
+    }
+    _graph.tap_output(output_id);
+    reserve_routes();
+    _graph.toposort_blocks();
+}
+
+void AudioEngine::remove_output_bus(const std::string&name) {
+    auto [registry, guard] = get_graph_registry();
+    auto found = std::find_if(_buses.begin(), _buses.end(), [&](const OutputBus&bus) {
+        return bus.name == name;
+    });
+    if (found == _buses.end())
+        throw std::runtime_error("remove_output_bus: no bus named " + name);
+    if (registry.valid(found->output_id))
+        _graph.untap_output(found->output_id);
+    _buses.erase(found);
+    _graph.toposort_blocks();
+}
+
+void AudioEngine::add_tap(entt::entity output_id) {
+    auto [registry, guard] = get_graph_registry();
+    _graph.tap_output(output_id);
+    _graph.toposort_blocks();
+}
+
+VoicePool& AudioEngine::add_voice_pool(size_t count, const std::function<VoicePool::Voice()>&make_voice) {
+    std::vector<VoicePool::Voice> voices;
+    voices.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        voices.push_back(make_voice());
+    auto pool = std::make_unique<VoicePool>(std::move(voices));
+
+    auto [registry, guard] = get_graph_registry();
+    _voice_pools.push_back(std::move(pool));
+    return *_voice_pools.back();
+}
+
+Recorder& AudioEngine::start_recording(const std::string&path, entt::entity output_id) {
+    size_t channels = _output_channels;
+    if (output_id != entt::null) {
+        channels = 2;
+        auto [registry, guard] = get_graph_registry();
+        if (!registry.valid(output_id))
+            throw std::runtime_error("start_recording: the output doesn't exist");
+        if (registry.all_of<Output1D>(output_id))
+            channels = 1;
+        else if (!registry.all_of<OutputND<2>>(output_id))
+            throw std::runtime_error("start_recording: only mono and stereo outputs can be recorded");
+    }
+    //The file is created without the lock
+    auto recorder = std::make_unique<Recorder>(path, channels, _sample_rate);
+
+    auto [registry, guard] = get_graph_registry();
+    if (_recordings.size() >= MAX_RECORDINGS)
+        throw std::runtime_error("Too many recordings, the maximum is " + std::to_string(MAX_RECORDINGS));
+    if (output_id != entt::null) {
+        //Removed while the file was created
+        if (!registry.valid(output_id))
+            throw std::runtime_error("start_recording: the output doesn't exist");
+        _graph.tap_output(output_id);
+        _graph.toposort_blocks();
+    }
+    _recordings.push_back({std::move(recorder), output_id});
+    return *_recordings.back().recorder;
+}
+
+void AudioEngine::stop_recording(const Recorder&recorder) {
+    std::unique_ptr<Recorder> stopped;
+    {
+        auto [registry, guard] = get_graph_registry();
+        auto found = std::find_if(_recordings.begin(), _recordings.end(), [&](const Recording&recording) {
+            return recording.recorder.get() == &recorder;
+        });
+        if (found == _recordings.end())
+            throw std::runtime_error("stop_recording: not a recording of this engine");
+        if (found->output_id != entt::null && registry.valid(found->output_id)) {
+            _graph.untap_output(found->output_id);
+            _graph.toposort_blocks();
+        }
+        stopped = std::move(found->recorder);
+        _recordings.erase(found);
+    }
+    //Flushing and closing the file happen without the lock
+    stopped.reset();
+}
+
+void AudioEngine::remove_tap(entt::entity output_id) {
+    auto [registry, guard] = get_graph_registry();
+    _graph.untap_output(output_id);
+    _graph.toposort_blocks();
 }
 
 entt::entity AudioEngine::add_wire(entt::entity from_block,
@@ -80,6 +359,7 @@ entt::entity AudioEngine::add_wire(entt::entity from_block,
                                    entt::entity to_input, TransmitFunc transmitFunc,
                                    float gain, float offset) {
     auto [registry, lock] = get_graph_registry();
+    check_not_mixer(registry, to_input);
     auto entity =
             Wire::create(registry, from_block, to_block,
                          from_output,
@@ -95,9 +375,75 @@ entt::entity AudioEngine::add_wire_to_mixer(entt::entity from_block,
                                             entt::entity to_block, entt::entity from_output,
                                             size_t to_mixer_input_index, TransmitFunc transmitFunc,
                                             float gain, float offset) {
-    //For mixers we abuse the system a bit and store an index as an entity
-    return add_wire(from_block, to_block, from_output, (entt::entity)to_mixer_input_index,
-                    transmitFunc, gain, offset);
+    check_mixer_transmit(transmitFunc);
+    auto [registry, lock] = get_graph_registry();
+    auto to_input = mixer_input(registry, to_block, to_mixer_input_index, from_output);
+    auto entity = Wire::create(registry, from_block, to_block, from_output, to_input, transmitFunc, gain, offset,
+                               (uint32_t)to_mixer_input_index);
+
+    _graph.toposort_blocks();
+    return entity;
+}
+
+std::vector<entt::entity> AudioEngine::add_wires(const std::vector<entt::entity>&from_blocks,
+                                                 const std::vector<entt::entity>&to_blocks,
+                                                 const std::vector<entt::entity>&from_outputs,
+                                                 const std::vector<entt::entity>&to_inputs,
+                                                 TransmitFunc transmitFunc,
+                                                 const std::vector<float>&gains,
+                                                 const std::vector<float>&offsets) {
+    auto [registry, lock] = get_graph_registry();
+    for (auto to_input: to_inputs)
+        check_not_mixer(registry, to_input);
+    auto entities = Wire::create_many(registry, from_blocks, to_blocks, from_outputs, to_inputs,
+                                      transmitFunc, gains, offsets);
+
+    // A single topological sort for the whole batch
+    _graph.toposort_blocks();
+    return entities;
+}
+
+std::vector<entt::entity> AudioEngine::add_wires_to_mixer(const std::vector<entt::entity>&from_blocks,
+                                                          const std::vector<entt::entity>&to_blocks,
+                                                          const std::vector<entt::entity>&from_outputs,
+                                                          const std::vector<size_t>&to_mixer_input_indices,
+                                                          TransmitFunc transmitFunc,
+                                                          const std::vector<float>&gains,
+                                                          const std::vector<float>&offsets) {
+    check_mixer_transmit(transmitFunc);
+    auto [registry, lock] = get_graph_registry();
+    if (to_mixer_input_indices.size() != to_blocks.size() || from_outputs.size() != to_blocks.size())
+        throw std::runtime_error("Cannot create wires, all arrays must have the same size");
+    std::vector<entt::entity> to_inputs;
+    std::vector<uint32_t> slots;
+    to_inputs.reserve(to_blocks.size());
+    slots.reserve(to_blocks.size());
+    for (size_t i = 0; i < to_blocks.size(); i++) {
+        to_inputs.push_back(mixer_input(registry, to_blocks[i], to_mixer_input_indices[i], from_outputs[i]));
+        slots.push_back((uint32_t)to_mixer_input_indices[i]);
+    }
+    auto entities = Wire::create_many(registry, from_blocks, to_blocks, from_outputs, to_inputs,
+                                      transmitFunc, gains, offsets, slots);
+
+    _graph.toposort_blocks();
+    return entities;
+}
+
+entt::entity AudioEngine::mixer_input(entt::registry&registry, entt::entity mixer, size_t slot,
+                                      entt::entity from_output) {
+    auto *block = registry.valid(mixer) ? registry.try_get<Block>(mixer) : nullptr;
+    auto input_id = block == nullptr ? entt::null : block->inputIds[0];
+    auto *input = input_id == entt::null ? nullptr : registry.try_get<MixerInput>(input_id);
+    if (input == nullptr)
+        throw std::runtime_error("Cannot create wire, the block is not a mixer");
+    if (slot >= input->slots)
+        throw std::runtime_error("Cannot create wire, slot " + std::to_string(slot) + " of a mixer with " +
+                                 std::to_string(input->slots) + " slots");
+    //What GatherList can sum
+    if (!registry.valid(from_output) ||
+        (!registry.all_of<Output1D>(from_output) && !registry.all_of<OutputND<2>>(from_output)))
+        throw std::runtime_error("Cannot create wire, only mono and stereo outputs can be mixed");
+    return input_id;
 }
 
 void AudioEngine::remove_wire(entt::entity wire_id) {
@@ -110,7 +456,7 @@ void AudioEngine::remove_wire(entt::entity wire_id) {
 
 void AudioEngine::remove_block(entt::entity block_id) {
     auto [registry, guard] = get_graph_registry();
-    // First remove all the wires connected to this block:
+    // First remove all the wires and sends connected to this block:
     auto view = registry.view<Wire>();
     for (auto entity: view) {
         auto&wire = view.get<Wire>(entity);
@@ -118,12 +464,79 @@ void AudioEngine::remove_block(entt::entity block_id) {
             Wire::destroy(registry, entity);
         }
     }
+    auto sends = registry.view<Send>();
+    for (auto entity: sends) {
+        auto&send = sends.get<Send>(entity);
+        if (send.from_block == block_id || send.bus == block_id)
+            registry.destroy(entity);
+    }
+    std::erase_if(_aux_buses, [&](const auto&bus) { return bus.second == block_id; });
     Block::destroy(registry, block_id);
 
     // Need to do a topological sort of the graph
     _graph.toposort_blocks();
 }
 
+entt::entity AudioEngine::add_aux_bus(const std::string&name, size_t width, float gain) {
+    auto [registry, guard] = get_graph_registry();
+    if (_aux_buses.contains(name))
+        throw std::runtime_error("add_aux_bus: there is already a bus named " + name);
+    auto bus = AuxBus::create(registry, width, gain);
+    _aux_buses[name] = bus;
+    _graph.toposort_blocks();
+    return bus;
+}
+
+entt::entity AudioEngine::get_aux_bus(const std::string&name) const {
+    auto found = _aux_buses.find(name);
+    if (found == _aux_buses.end())
+        throw std::runtime_error("No aux bus named " + name);
+    return found->second;
+}
+
+void AudioEngine::remove_aux_bus(const std::string&name) {
+    remove_block(get_aux_bus(name));
+}
+
+entt::entity AudioEngine::add_send(entt::entity from_block, entt::entity from_output, const std::string&bus,
+                                   float gain) {
+    auto bus_id = get_aux_bus(bus);
+    auto [registry, guard] = get_graph_registry();
+    const auto* block = registry.valid(from_block) ? registry.try_get<Block>(from_block) : nullptr;
+    if (block == nullptr || from_output == entt::null ||
+        std::find(std::begin(block->outputIds), std::end(block->outputIds), from_output) == std::end(block->outputIds))
+        throw std::runtime_error("add_send: from_output is not an output of from_block");
+    if (!registry.all_of<Output1D>(from_output) && !registry.all_of<OutputND<2>>(from_output))
+        throw std::runtime_error("add_send: only mono and stereo outputs can be sent to a bus");
+    auto entity = registry.create();
+    registry.emplace<Send>(entity, from_block, from_output, bus_id, gain);
+
+    // The bus now runs after from_block
+    try {
+        _graph.toposort_blocks();
+    } catch (...) {
+        //A send from the effect chain of the bus back into it
+        registry.destroy(entity);
+        _graph.toposort_blocks();
+        throw;
+    }
+    return entity;
+}
+
+void AudioEngine::tweak_send_gain(entt::entity send_id, float gain) {
+    auto [registry, guard] = get_graph_registry();
+    registry.get<Send>(send_id).gain = gain;
+    refresh_after_edit(registry, send_id);
+}
+
+void AudioEngine::remove_send(entt::entity send_id) {
+    auto [registry, guard] = get_graph_registry();
+    if (!registry.all_of<Send>(send_id))
+        throw std::runtime_error("remove_send: not a send");
+    registry.destroy(send_id);
+    _graph.toposort_blocks();
+}
+
 Block AudioEngine::view_block(entt::entity block_id) const {
     return _graph.registry.get<Block>(block_id);
 }
@@ -187,12 +600,14 @@ void AudioEngine::tweak_wire_gain(entt::entity wire_id, float gain) {
     auto [registry, guard] = get_graph_registry();
     auto&wire = registry.get<Wire>(wire_id);
     wire.gain = gain;
+    refresh_after_edit(registry, wire_id);
 }
 
 void AudioEngine::tweak_wire_offset(entt::entity wire_id, float offset) {
     auto [registry, guard] = get_graph_registry();
     auto&wire = registry.get<Wire>(wire_id);
     wire.offset = offset;
+    refresh_after_edit(registry, wire_id);
 }
 
 std::vector<Block> AudioEngine::get_blocks() const {
@@ -212,6 +627,18 @@ void AudioEngine::set_input_1d(entt::entity input_id, float value) {
     auto [registry, guard] = get_graph_registry();
     auto&input = registry.get<Input1D>(input_id);
     input.value = value;
+    refresh_after_edit(registry, input_id);
+}
+
+void AudioEngine::set_input_array(entt::entity input_id, const std::vector<float>&values, size_t offset) {
+    auto [registry, guard] = get_graph_registry();
+    auto&input = registry.get<InputArray>(input_id);
+    if (offset > input.value.size() || values.size() > input.value.size() - offset)
+        throw std::runtime_error("set_input_array: " + std::to_string(values.size()) + " values at offset " +
+                                 std::to_string(offset) + " don't fit in an array of " +
+                                 std::to_string(input.value.size()));
+    std::copy(values.begin(), values.end(), input.value.begin() + (std::ptrdiff_t)offset);
+    refresh_after_edit(registry, input_id);
 }
 
 IoMap AudioEngine::view_block_io(entt::entity block_id) {
@@ -220,11 +647,76 @@ IoMap AudioEngine::view_block_io(entt::entity block_id) {
     return block.viewFunc(registry, block);
 }
 
+void AudioEngine::refresh_after_edit(entt::registry&registry, entt::entity id) {
+    //Values the compiler folded into the graph have to be recomputed,
+    //this also wakes the sleeping blocks
+    if (registry.all_of<Compiled>(id))
+        _graph.refresh_compiled();
+    else
+        _graph.wake_all();
+}
+
+void AudioEngine::save_snapshot(const std::string&path) {
+    auto [registry, guard] = get_graph_registry();
+    snapshot::save(registry, _output_id, _output_width, path);
+}
+
+std::vector<entt::entity> AudioEngine::load_snapshot(const std::string&path) {
+    auto [registry, guard] = get_graph_registry();
+    auto loaded = snapshot::load(registry, path);
+    const auto previous_id = _output_id;
+    const auto previous_width = _output_width;
+    const bool previous_tapped = _output_width > 0 && registry.valid(_output_id);
+    if (loaded.output_width > 0) {
+        if (previous_tapped)
+            _graph.untap_output(_output_id);
+        _output_id = loaded.output_id;
+        _output_width = loaded.output_width;
+        _graph.tap_output(_output_id);
+        reserve_routes();
+    }
+
+    try {
+        _graph.toposort_blocks();
+    } catch (...) {
+        //The records are valid one by one but not as a graph (e.g. a cycle), leave the engine as it was
+        if (loaded.output_width > 0) {
+            _graph.untap_output(_output_id);
+            _output_id = previous_id;
+            _output_width = previous_width;
+            if (previous_tapped)
+                _graph.tap_output(_output_id);
+            reserve_routes();
+        }
+        for (auto wire: loaded.wires)
+            Wire::destroy(registry, wire);
+        for (auto block: loaded.blocks)
+            Block::destroy(registry, block);
+        _graph.toposort_blocks();
+        throw;
+    }
+    return loaded.blocks;
+}
+
+snapshot::Subgraph AudioEngine::capture_subgraph(const std::vector<entt::entity>&blocks,
+                                                 const std::vector<entt::entity>&exposed_ports) {
+    auto [registry, guard] = get_graph_registry();
+    return snapshot::capture(registry, blocks, exposed_ports);
+}
+
+std::vector<snapshot::Instance> AudioEngine::clone_subgraph(const snapshot::Subgraph&subgraph, size_t copies) {
+    auto [registry, guard] = get_graph_registry();
+    auto instances = snapshot::instantiate(registry, subgraph, copies);
+    _graph.toposort_blocks();
+    return instances;
+}
+
 template<size_t N>
 void AudioEngine::set_input_Nd(entt::entity input_id, const std::array<float, N>&value) {
     auto [registry, guard] = get_graph_registry();
     auto&input = registry.get<InputND<N>>(input_id);
     input.value = value;
+    refresh_after_edit(registry, input_id);
 }
 
 //Explicit template instantiation of set_input_Nd for powers of 2
@@ -7,6 +7,10 @@
 #include <mutex>
 #include "graph.h"
 #include "graph_registry.h"
+#include "recorder.h"
+#include "snapshot.h"
+#include "voice_pool.h"
+#include <functional>
 #include <memory>
 #include <tuple>
 #include <optional>
@@ -16,7 +20,15 @@
 namespace AAri {
     class AudioEngine : public IGraphRegistry {
     public:
-        AudioEngine(ma_uint32 sample_rate = 48000, ma_uint32 buffer_size = 512);
+        /**
+         * @param headless if true no audio device is opened, and the graph is only
+         * processed by explicit calls to render (offline rendering)
+         * @param input_channels channels captured along with the playback (full duplex), read by AudioInput blocks
+         * @param null_backend open miniaudio's null device instead of a sound card, e.g. for tests
+         * @param output_channels channels of the device, e.g. 8 or 64 for a speaker array (see set_output_bus)
+         */
+        AudioEngine(ma_uint32 sample_rate = 48000, ma_uint32 buffer_size = 512, bool headless = false,
+                    ma_uint32 input_channels = 0, bool null_backend = false, ma_uint32 output_channels = 2);
 
         ~AudioEngine();
 
@@ -24,6 +36,32 @@ namespace AAri {
 
         void stopAudio();
 
+        /**
+         * Process the graph for frameCount samples and write them to buffer as frames of output_channels
+         * interleaved values.
+         * This is what the audio callback does, it is public for offline rendering: blocks that depend on
+         * other threads wait for them rather than drop their output
+         * @param input frameCount frames of input_channels interleaved values for the AudioInput blocks,
+         * which output 0 without it. Throws if the engine has no input channels
+         */
+        void render(float *buffer, ma_uint32 frameCount, const float *input = nullptr);
+
+        ma_uint32 get_sample_rate() const override {
+            return _sample_rate;
+        }
+
+        ma_uint32 get_output_channels() const {
+            return _output_channels;
+        }
+
+        ma_uint32 get_input_channels() const {
+            return _input_channels;
+        }
+
+        bool is_headless() const {
+            return _headless;
+        }
+
 
         /**
          * Any access to the registry is most likely not thread-safe with the callback
@@ -49,8 +87,31 @@ namespace AAri {
         }
 
         //Graph modification functions ----------------------------------------------
+        /**
+         * The main output, played from the first channel of the device. A mono output is played on the first
+         * two channels, like on a stereo device. A width of 0 removes it
+         */
         void set_output_ref(entt::entity output_id, size_t output_width);
 
+        /**
+         * Play an output on the channels of the device from first_channel on, e.g. one bus per group of
+         * speakers of an array. The bus is as wide as the output: Output1D, OutputND or OutputArray.
+         * Buses sharing channels are summed, with the main output too. Setting a bus again replaces it.
+         * Only the main output is saved in snapshots.
+         * Throws if the output does not fit in the channels of the device
+         */
+        void set_output_bus(const std::string &name, entt::entity output_id, size_t first_channel = 0);
+
+        void remove_output_bus(const std::string &name);
+
+        /**
+         * Blocks that don't feed the output are not processed. Tapping an output
+         * keeps the blocks it depends on running, e.g. to monitor it with view_block_io
+         */
+        void add_tap(entt::entity output_id);
+
+        void remove_tap(entt::entity output_id);
+
         entt::entity add_wire(entt::entity from_block,
                               entt::entity to_block,
                               entt::entity from_output,
@@ -58,6 +119,10 @@ namespace AAri {
                               TransmitFunc transmitFunc,
                               float gain = 1.0f, float offset = 0.0f);
 
+        /**
+         * Wire a mono or stereo output to a slot of a mixer. The mixer sums its slots itself (see GatherList),
+         * so transmitFunc must be Wire::transmit_to_mixer
+         */
         entt::entity add_wire_to_mixer(entt::entity from_block,
                                        entt::entity to_block,
                                        entt::entity from_output,
@@ -65,6 +130,28 @@ namespace AAri {
                                        TransmitFunc transmitFunc,
                                        float gain = 1.0f, float offset = 0.0f);
 
+        /**
+         * Bulk versions of add_wire and add_wire_to_mixer, all the wires share the same transmit function.
+         * The graph is only sorted once at the end, which is what makes this much faster
+         * than adding the wires one by one for large generated patches.
+         * @return the ids of the new wires, in the same order as the inputs
+         */
+        std::vector<entt::entity> add_wires(const std::vector<entt::entity> &from_blocks,
+                                            const std::vector<entt::entity> &to_blocks,
+                                            const std::vector<entt::entity> &from_outputs,
+                                            const std::vector<entt::entity> &to_inputs,
+                                            TransmitFunc transmitFunc,
+                                            const std::vector<float> &gains,
+                                            const std::vector<float> &offsets);
+
+        std::vector<entt::entity> add_wires_to_mixer(const std::vector<entt::entity> &from_blocks,
+                                                     const std::vector<entt::entity> &to_blocks,
+                                                     const std::vector<entt::entity> &from_outputs,
+                                                     const std::vector<size_t> &to_mixer_input_indices,
+                                                     TransmitFunc transmitFunc,
+                                                     const std::vector<float> &gains,
+                                                     const std::vector<float> &offsets);
+
         void remove_wire(entt::entity wire_id);
 
         void remove_block(entt::entity block_id);
@@ -75,6 +162,64 @@ namespace AAri {
 
         IoMap view_block_io(entt::entity block_id);
 
+        //Aux buses ----------------------------------------------------------------------
+        /**
+         * Add a send/return bus (see AuxBus): the outputs sent to it are summed into its output,
+         * which is wired to a single effect chain like any other block output.
+         * Sends are not saved in snapshots nor copied with subgraphs. Throws if the name is taken
+         * @param width 1 for a mono bus, 2 for a stereo one
+         * @return the AuxBus block
+         */
+        entt::entity add_aux_bus(const std::string &name, size_t width = 2, float gain = 1.0f);
+
+        entt::entity get_aux_bus(const std::string &name) const;
+
+        /**
+         * Remove the bus block with its sends and wires, the effect chain is left in the graph
+         */
+        void remove_aux_bus(const std::string &name);
+
+        /**
+         * Send an Output1D or OutputND<2> of from_block to a bus. Throws if the send would make a cycle
+         * @return the id of the send
+         */
+        entt::entity add_send(entt::entity from_block, entt::entity from_output, const std::string &bus,
+                              float gain = 1.0f);
+
+        void tweak_send_gain(entt::entity send_id, float gain);
+
+        void remove_send(entt::entity send_id);
+
+        //Persistence ------------------------------------------------------------------
+        /**
+         * Save all the blocks and wires, and the output reference, to a binary snapshot
+         * (see snapshot.h for the format)
+         */
+        void save_snapshot(const std::string &path);
+
+        /**
+         * Add the content of a snapshot to the graph, and set the output reference
+         * if the snapshot has one. Throws and leaves the graph as it was if the file is invalid,
+         * including a graph that can't be sorted (a cycle, too many wires into a block).
+         * @return the ids of the loaded blocks in topological order
+         */
+        std::vector<entt::entity> load_snapshot(const std::string &path);
+
+        //Subgraph templates -------------------------------------------------------------
+        /**
+         * Record blocks and the wires between them as a template (see snapshot::capture),
+         * e.g. one voice built by hand. exposed_ports are the ports given back for each copy,
+         * to wire the copies to the rest of the graph. The blocks are left in the graph.
+         */
+        snapshot::Subgraph capture_subgraph(const std::vector<entt::entity> &blocks,
+                                            const std::vector<entt::entity> &exposed_ports = {});
+
+        /**
+         * Add copies of a template. All the copies are inserted at once
+         * and the graph is only sorted once at the end.
+         */
+        std::vector<snapshot::Instance> clone_subgraph(const snapshot::Subgraph &subgraph, size_t copies);
+
         //"free" inspection functions ----------------------------------------------
         // these can be called without locking the registry
         Block view_block(entt::entity block_id) const;
@@ -99,11 +244,64 @@ namespace AAri {
         template<size_t N>
         void set_input_Nd(entt::entity input_id, const std::array<float, N>&value);
 
+        /**
+         * Overwrite values.size() values of an InputArray starting at offset, all at once.
+         * Throws if they don't fit, the size of the array is fixed by its block.
+         */
+        void set_input_array(entt::entity input_id, const std::vector<float>&values, size_t offset = 0);
+
+        //Voices -------------------------------------------------------------------------
+        /**
+         * Build count copies of a voice subgraph up front and play them through note events
+         * (see voice_pool.h). make_voice is called count times without the lock, it creates the blocks
+         * and wires of one copy and returns its ports. The engine applies the note events of the pool
+         * at the start of each rendered buffer.
+         * @return the pool, owned by the engine
+         */
+        VoicePool &add_voice_pool(size_t count, const std::function<VoicePool::Voice()> &make_voice);
+
+        //Recording ------------------------------------------------------------------------
+        /**
+         * Record to a WAV file while rendering (see recorder.h): the output of the engine as sent to the device
+         * when output_id is null, else an Output1D or OutputND<2>, which is tapped until the recording stops.
+         * The audio thread only copies the frames, the file is written by a thread of the recorder.
+         * Throws if the file cannot be created or the output is neither mono nor stereo
+         * @return the recorder, owned by the engine until stop_recording
+         */
+        Recorder &start_recording(const std::string &path, entt::entity output_id = entt::null);
+
+        /**
+         * Stop recording and write what is left to the file, which is complete when this returns
+         */
+        void stop_recording(const Recorder &recorder);
+
     private:
         static void audio_callback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount);
 
+        void render(float *buffer, const float *input, ma_uint32 frameCount, bool realtime);
+
+        // Audio thread, see _routes
+        void add_routes(entt::registry &registry, entt::entity output_id, size_t width, size_t first_channel);
+
+        // Called with the lock held after the outputs changed, so that render never allocates routes
+        void reserve_routes();
+
+        // Called with the lock held after a wire or input value was changed from outside the graph
+        void refresh_after_edit(entt::registry &registry, entt::entity id);
+
+        // The MixerInput of a mixer block, throws if the block is not a mixer or has no such slot,
+        // or if from_output is neither an Output1D nor an OutputND<2>
+        static entt::entity mixer_input(entt::registry &registry, entt::entity mixer, size_t slot,
+                                        entt::entity from_output);
+
         double clock_seconds;
 
+        ma_uint32 _sample_rate;
+        bool _headless;
+        ma_uint32 _output_channels;
+        ma_uint32 _input_channels;
+        ma_context _context;
+        bool _own_context = false;
         ma_device _device;
         ma_device_config _deviceConfig;
         ma_spinlock _callback_lock = 0;
@@ -111,6 +309,41 @@ namespace AAri {
         Graph _graph;
         entt::entity _output_id;
         size_t _output_width;
+
+        struct OutputBus {
+            std::string name;
+            entt::entity output_id;
+            size_t first_channel;
+            size_t width;
+        };
+
+        std::vector<OutputBus> _buses;
+
+        // Where each value of the outputs is played, looked up once per buffer
+        struct Route {
+            const float *value;
+            size_t channel;
+        };
+
+        std::vector<Route> _routes;
+
+        // The outputs are gathered by segments of PLANAR_FRAMES, one row per channel, then interleaved at once
+        static constexpr size_t PLANAR_FRAMES = 256;
+        std::vector<float> _planar;
+
+        std::unordered_map<std::string, entt::entity> _aux_buses;
+
+        std::vector<std::unique_ptr<VoicePool>> _voice_pools;
+
+        static constexpr size_t MAX_RECORDINGS = 16;
+
+        struct Recording {
+            std::unique_ptr<Recorder> recorder;
+            // Null for the output of the engine
+            entt::entity output_id;
+        };
+
+        std::vector<Recording> _recordings;
     };
 }
 
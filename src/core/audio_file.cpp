@@ -0,0 +1,38 @@
+//
+//
+
+#include "audio_file.h"
+#include "../miniaudio.h"
+#include <stdexcept>
+
+using namespace AAri;
+
+std::vector<std::vector<float>> AAri::read_audio_file(const std::string&path, uint32_t sample_rate) {
+    // 0 channels keeps those of the file
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, sample_rate);
+    ma_decoder decoder;
+    if (ma_decoder_init_file(path.c_str(), &config, &decoder) != MA_SUCCESS)
+        throw std::runtime_error("Cannot decode audio file " + path);
+
+    const size_t channels = decoder.outputChannels;
+    std::vector<std::vector<float>> samples(channels);
+    //The length isn't known up front for every format, read by chunks until the end
+    constexpr ma_uint64 CHUNK = 4096;
+    std::vector<float> interleaved(CHUNK * channels);
+    while (true) {
+        ma_uint64 read = 0;
+        const ma_result result = ma_decoder_read_pcm_frames(&decoder, interleaved.data(), CHUNK, &read);
+        for (size_t c = 0; c < channels; c++) {
+            for (ma_uint64 i = 0; i < read; i++)
+                samples[c].push_back(interleaved[i * channels + c]);
+        }
+        if (result == MA_AT_END || read < CHUNK)
+            break;
+        if (result != MA_SUCCESS) {
+            ma_decoder_uninit(&decoder);
+            throw std::runtime_error("Cannot decode audio file " + path);
+        }
+    }
+    ma_decoder_uninit(&decoder);
+    return samples;
+}
@@ -0,0 +1,21 @@
+//
+//
+
+#ifndef AARI_AUDIO_FILE_H
+#define AARI_AUDIO_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace AAri {
+    /**
+     * Decode a whole audio file (WAV, FLAC or MP3, through miniaudio's decoders) as float, resampled to
+     * sample_rate. Meant for files that fit in memory, e.g. impulse responses.
+     * @return the samples of each channel
+     * Throws if the file cannot be opened or decoded
+     */
+    std::vector<std::vector<float>> read_audio_file(const std::string &path, uint32_t sample_rate);
+}
+
+#endif //AARI_AUDIO_FILE_H
@@ -26,6 +26,9 @@ namespace AAri {
     typedef IoMap (*ViewFunc)(entt::registry &registry,
                               const Block &block);
 
+    //Block specific test of whether its output is static given its current inputs
+    typedef bool (*SilenceFunc)(entt::registry &registry, const Block &block);
+
 
     struct Visited {
         enum State {
@@ -36,6 +39,35 @@ namespace AAri {
         State state = UNVISITED;
     };
 
+    /**
+     * Marks an output that is read from outside the graph: the engine output set
+     * with set_output_ref, or anything tapped for monitoring.
+     * Counted since the same output can be tapped several times.
+     */
+    struct Tap {
+        uint32_t count = 1;
+    };
+
+    /**
+     * Tag for blocks that don't feed any tapped output, directly or transitively.
+     * They are skipped by Graph::process until they get connected again.
+     */
+    struct Dormant {
+    };
+
+    /**
+     * Optional component for blocks that can be put to sleep.
+     * A block is quiet when all the blocks wired into it are asleep and its silenceFunc
+     * (if any) says its current inputs give a static output, e.g. an oscillator with zero amplitude.
+     * After one more sample of processing, to pick up the final upstream values, a quiet block falls asleep
+     * and is skipped, wires included, until it stops being quiet.
+     * "Silent" therefore means the output doesn't change, which is what matters to downstream blocks.
+     */
+    struct Silence {
+        SilenceFunc silenceFunc = nullptr;
+        bool asleep = false;
+    };
+
     enum class BlockType {
         NONE,
         SineOsc,
@@ -47,6 +79,24 @@ namespace AAri {
         Constant,
         MonoMixer,
         StereoMixer,
+        WavetableOsc,
+        AdditiveBank,
+        FmVoices,
+        Adsr,
+        Ar,
+        AdsrBank,
+        Biquad,
+        Svf,
+        BiquadCascade,
+        FilterBank,
+        Delay,
+        Comb,
+        Allpass,
+        FdnReverb,
+        Convolution,
+        Sampler,
+        AudioInput,
+        AuxBus,
     };
     struct WiresToBlock {
         /** Record wires incoming to block in order to avoid to find all wires
@@ -0,0 +1,164 @@
+//
+//
+
+#include "convolver.h"
+#include <algorithm>
+
+using namespace AAri;
+
+Convolver::Partitions::Partitions(const std::vector<float>&impulse_response, size_t start, size_t end,
+                                  size_t block) : _block(block), _count((end - start + block - 1) / block),
+                                                  _fft(2 * block) {
+    const size_t bins = _fft.bins();
+    _filters.resize(_count * bins);
+    _inputs.assign(_count * bins, Fft::Complex(0.0f, 0.0f));
+    _sum.resize(bins);
+    _frame.assign(2 * block, 0.0f);
+    _result.resize(2 * block);
+    //Each partition zero padded to the size of the frames
+    std::vector<float> padded(2 * block);
+    for (size_t p = 0; p < _count; p++) {
+        std::fill(padded.begin(), padded.end(), 0.0f);
+        const size_t from = start + p * block;
+        const size_t to = std::min(from + block, end);
+        std::copy(impulse_response.begin() + from, impulse_response.begin() + to, padded.begin());
+        _fft.forward(padded.data(), _filters.data() + p * bins);
+    }
+}
+
+void Convolver::Partitions::run(const float* input, float* output) {
+    const size_t bins = _fft.bins();
+    std::copy_n(_frame.begin() + _block, _block, _frame.begin());
+    std::copy_n(input, _block, _frame.begin() + _block);
+    _newest = _newest == 0 ? _count - 1 : _newest - 1;
+    _fft.forward(_frame.data(), _inputs.data() + _newest * bins);
+    //The frame of p blocks ago goes through partition p
+    std::fill(_sum.begin(), _sum.end(), Fft::Complex(0.0f, 0.0f));
+    for (size_t p = 0; p < _count; p++) {
+        const Fft::Complex* frame = _inputs.data() + ((_newest + p) % _count) * bins;
+        const Fft::Complex* filter = _filters.data() + p * bins;
+        for (size_t k = 0; k < bins; k++)
+            _sum[k] += Fft::multiply(frame[k], filter[k]);
+    }
+    _fft.inverse(_sum.data(), _result.data());
+    //The first half wrapped around, the second is the linear convolution
+    std::copy_n(_result.begin() + _block, _block, output);
+}
+
+Convolver::Convolver(const std::vector<float>&impulse_response) : _length(impulse_response.size()),
+                                                                   _zeros(impulse_response.size()) {
+    _taps.assign(HEAD, 0.0f);
+    for (size_t i = 0; i < std::min(_length, HEAD); i++)
+        _taps[HEAD - 1 - i] = impulse_response[i];
+    _history.assign(2 * HEAD, 0.0f);
+    if (_length > HEAD) {
+        _body = std::make_unique<Partitions>(impulse_response, HEAD, std::min(_length, TAIL_START), HEAD);
+        _body_input.assign(HEAD, 0.0f);
+        _body_output.assign(HEAD, 0.0f);
+    }
+    if (_length > TAIL_START) {
+        _tail = std::make_unique<Partitions>(impulse_response, TAIL_START, _length, TAIL_BLOCK);
+        _tail_inputs.assign(SLOTS * TAIL_BLOCK, 0.0f);
+        _tail_outputs.assign(SLOTS * TAIL_BLOCK, 0.0f);
+        _worker = std::thread(&Convolver::tail_worker, this);
+    }
+}
+
+Convolver::~Convolver() {
+    if (_worker.joinable()) {
+        _stop.store(true);
+        _test_only_hold_worker(false);
+        _written.fetch_add(1);
+        _written.notify_one();
+        _worker.join();
+    }
+}
+
+float Convolver::process(float x, bool realtime) {
+    _zeros = x == 0.0f ? _zeros + 1 : 0;
+
+    _history[_history_position] = x;
+    _history[_history_position + HEAD] = x;
+    const float* recent = _history.data() + _history_position + 1;
+    _history_position = (_history_position + 1) % HEAD;
+    float y = 0.0f;
+    for (size_t i = 0; i < HEAD; i++)
+        y += recent[i] * _taps[i];
+
+    if (_body) {
+        y += _body_output[_body_position];
+        _body_input[_body_position] = x;
+        if (++_body_position == HEAD) {
+            _body->run(_body_input.data(), _body_output.data());
+            _body_position = 0;
+        }
+    }
+
+    if (_tail) {
+        //Block m is being written, the output of block m - 2 is being read
+        const size_t m = _written.load(std::memory_order_relaxed);
+        if (_tail_position == 0) {
+            size_t done = _done.load(std::memory_order_acquire);
+            if (m >= 2) {
+                if (!realtime) {
+                    while (done < m - 1) {
+                        _done.wait(done, std::memory_order_acquire);
+                        done = _done.load(std::memory_order_acquire);
+                    }
+                }
+                _tail_ready = done >= m - 1;
+                if (!_tail_ready)
+                    _late.fetch_add(1, std::memory_order_relaxed);
+            }
+            //The worker is on block done or later, SLOTS blocks behind it may still read the slot of block m
+            _tail_dropped = m - done >= SLOTS;
+            if (_tail_dropped)
+                _late.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (_tail_ready)
+            y += _tail_outputs[((m + SLOTS - 2) % SLOTS) * TAIL_BLOCK + _tail_position];
+        if (!_tail_dropped)
+            _tail_inputs[(m % SLOTS) * TAIL_BLOCK + _tail_position] = x;
+        if (++_tail_position == TAIL_BLOCK) {
+            _tail_position = 0;
+            if (!_tail_dropped)
+                _slot_blocks[m % SLOTS].store(m, std::memory_order_relaxed);
+            _written.store(m + 1, std::memory_order_release);
+            _written.notify_one();
+        }
+    }
+    return y;
+}
+
+void Convolver::tail_worker() {
+    size_t next = 0;
+    while (true) {
+        size_t written = _written.load(std::memory_order_acquire);
+        if (_stop.load())
+            return;
+        if (_held.load()) {
+            _held.wait(true);
+            continue;
+        }
+        if (next == written) {
+            _written.wait(written, std::memory_order_acquire);
+            continue;
+        }
+        //Far behind in real time: skip to the newest block, the output of the others would be heard too late.
+        //Their slots would still hold the output of older blocks, they are heard as silence instead
+        if (written - next > SLOTS - 2) {
+            for (size_t block = std::max(next + SLOTS, written) - SLOTS; block + 1 < written; block++)
+                std::fill_n(_tail_outputs.data() + (block % SLOTS) * TAIL_BLOCK, TAIL_BLOCK, 0.0f);
+            next = written - 1;
+        }
+        const size_t slot = next % SLOTS;
+        float* output = _tail_outputs.data() + slot * TAIL_BLOCK;
+        if (_slot_blocks[slot].load(std::memory_order_relaxed) == next)
+            _tail->run(_tail_inputs.data() + slot * TAIL_BLOCK, output);
+        else
+            std::fill_n(output, TAIL_BLOCK, 0.0f);
+        next++;
+        _done.store(next, std::memory_order_release);
+        _done.notify_one();
+    }
+}
@@ -0,0 +1,127 @@
+//
+//
+
+#ifndef AARI_CONVOLVER_H
+#define AARI_CONVOLVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "utils/fft.h"
+
+namespace AAri {
+    /**
+     * Zero latency convolution with long impulse responses, one sample at a time.
+     *
+     * The impulse response is cut in three, each part convolved the cheapest way its deadline allows:
+     *   [0, HEAD)                  direct FIR, the only part that needs the current sample
+     *   [HEAD, TAIL_START)         uniformly partitioned FFT convolution in blocks of HEAD,
+     *                              on the audio thread once per HEAD samples
+     *   [TAIL_START, end)          same in blocks of TAIL_BLOCK, on a worker thread.
+     * A tail block is handed to the worker as soon as its input is complete and only heard TAIL_BLOCK samples
+     * later, so the worker has a whole block of time for it and the callback never runs the big FFTs.
+     *
+     * When rendering in real time a tail block that isn't ready in time is skipped and counted in late_blocks,
+     * offline renders wait for the worker instead so that they are exact. A worker so late that it may still
+     * be reading the slot of the next block makes the callback drop that block (counted too), it is heard as
+     * silence in the tail.
+     */
+    class Convolver {
+    public:
+        static constexpr size_t HEAD = 64;
+        static constexpr size_t TAIL_BLOCK = 1024;
+        static constexpr size_t TAIL_START = 2 * TAIL_BLOCK;
+
+        explicit Convolver(const std::vector<float> &impulse_response);
+
+        ~Convolver();
+
+        Convolver(const Convolver &) = delete;
+
+        Convolver &operator=(const Convolver &) = delete;
+
+        float process(float x, bool realtime);
+
+        size_t length() const {
+            return _length;
+        }
+
+        // Once the input has been 0 for the length of the impulse response the output is 0
+        bool is_silent() const {
+            return _zeros >= _length;
+        }
+
+        size_t late_blocks() const {
+            return _late.load(std::memory_order_relaxed);
+        }
+
+        // Keeps the worker from starting another block, to test a worker that falls behind
+        void _test_only_hold_worker(bool held) {
+            _held.store(held);
+            _held.notify_one();
+        }
+
+    private:
+        /**
+         * Uniformly partitioned overlap-save convolution with the part [start, end) of an impulse response.
+         * run takes a block of input and gives the matching block of output, i.e. the output is late
+         * by one block, which the start of the part makes up for.
+         */
+        class Partitions {
+        public:
+            Partitions(const std::vector<float> &impulse_response, size_t start, size_t end, size_t block);
+
+            void run(const float *input, float *output);
+
+        private:
+            size_t _block;
+            size_t _count;
+            Fft _fft;
+            // Spectra of the partitions, then of the last _count input frames as a ring
+            std::vector<Fft::Complex> _filters;
+            std::vector<Fft::Complex> _inputs;
+            size_t _newest = 0;
+            std::vector<Fft::Complex> _sum;
+            // The previous block then the current one
+            std::vector<float> _frame;
+            std::vector<float> _result;
+        };
+
+        void tail_worker();
+
+        size_t _length;
+        size_t _zeros;
+
+        // Direct part: the taps reversed and the last HEAD inputs written twice, to read them contiguously
+        std::vector<float> _taps;
+        std::vector<float> _history;
+        size_t _history_position = 0;
+
+        std::unique_ptr<Partitions> _body;
+        std::vector<float> _body_input;
+        std::vector<float> _body_output;
+        size_t _body_position = 0;
+
+        // Tail, the slots are rings of blocks shared with the worker
+        static constexpr size_t SLOTS = 4;
+        std::unique_ptr<Partitions> _tail;
+        std::vector<float> _tail_inputs;
+        std::vector<float> _tail_outputs;
+        size_t _tail_position = 0;
+        // Blocks handed to the worker and blocks it finished, the worker processes them in order
+        std::atomic<size_t> _written = 0;
+        std::atomic<size_t> _done = 0;
+        // Block whose input each slot holds, a dropped block leaves its slot to the previous one
+        std::atomic<size_t> _slot_blocks[SLOTS] = {};
+        bool _tail_ready = false;
+        bool _tail_dropped = false;
+        std::atomic<size_t> _late = 0;
+        std::atomic<bool> _stop = false;
+        std::atomic<bool> _held = false;
+        std::thread _worker;
+    };
+}
+
+#endif //AARI_CONVOLVER_H
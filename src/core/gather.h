@@ -0,0 +1,93 @@
+//
+//
+
+#ifndef AARI_GATHER_H
+#define AARI_GATHER_H
+
+#include "blocks.h"
+#include "inputs_outputs.h"
+#include "kernels/kernels.h"
+#include <entt/entt.hpp>
+#include <array>
+#include <vector>
+
+namespace AAri {
+    /**
+     * What a mixer or an aux bus sums, on the entity of its first input: a dense list of pointers to the
+     * outputs feeding each of its channels, with their gains. It is rebuilt by Graph::gather_inputs whenever
+     * the graph changes, so that summing is one pass over contiguous arrays instead of a wire per source.
+     */
+    struct GatherList {
+        size_t width = 1;
+        std::array<std::vector<const float *>, 2> sources;
+        std::array<std::vector<float>, 2> gains;
+        std::array<float, 2> offsets = {0.0f, 0.0f};
+        // Blocks owning the sources, the block sleeps when they all do
+        std::vector<entt::entity> from_blocks;
+
+        void clear() {
+            for (size_t c = 0; c < 2; c++) {
+                sources[c].clear();
+                gains[c].clear();
+                offsets[c] = 0.0f;
+            }
+            from_blocks.clear();
+        }
+
+        /**
+         * Gather an Output1D, summed into every channel, or an OutputND<2>, summed channel by channel
+         * or as the mean of its channels into a mono list
+         * @return false if output is neither
+         */
+        bool add(entt::registry &registry, entt::entity from_block, entt::entity output, float gain,
+                 float offset = 0.0f) {
+            if (auto *mono = registry.try_get<Output1D>(output)) {
+                for (size_t c = 0; c < width; c++)
+                    add_source(c, &mono->value, gain, offset);
+            } else if (auto *stereo = registry.try_get<OutputND<2>>(output)) {
+                if (width == 2) {
+                    add_source(0, &stereo->value[0], gain, offset);
+                    add_source(1, &stereo->value[1], gain, offset);
+                } else {
+                    add_source(0, &stereo->value[0], 0.5f * gain, offset);
+                    add_source(0, &stereo->value[1], 0.5f * gain, 0.0f);
+                }
+            } else {
+                return false;
+            }
+            from_blocks.push_back(from_block);
+            return true;
+        }
+
+        float sum(size_t channel) const {
+            const auto &channel_sources = sources[channel];
+            const auto &channel_gains = gains[channel];
+            //From 8 sources the sums go through the SIMD kernels, below that the call costs more than it saves
+            if (channel_sources.size() >= 8)
+                return kernels().gather_sum(channel_sources.data(), channel_gains.data(), channel_sources.size()) +
+                       offsets[channel];
+            float total = offsets[channel];
+            for (size_t i = 0; i < channel_sources.size(); i++)
+                total += channel_gains[i] * *channel_sources[i];
+            return total;
+        }
+
+        bool sources_asleep(entt::registry &registry) const {
+            for (auto from_block: from_blocks) {
+                const auto *silence = registry.try_get<Silence>(from_block);
+                if (silence == nullptr || !silence->asleep)
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        void add_source(size_t channel, const float *source, float gain, float offset) {
+            sources[channel].push_back(source);
+            gains[channel].push_back(gain);
+            offsets[channel] += offset;
+        }
+    };
+}
+
+#endif //AARI_GATHER_H
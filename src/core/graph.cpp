@@ -2,6 +2,12 @@
 //
 
 #include "graph.h"
+#include "../blocks/catalogue.h"
+#include "../blocks/constants.h"
+#include "../blocks/aux_bus.h"
+#include "gather.h"
+#include <algorithm>
+#include <unordered_map>
 
 void AAri::Graph::toposort_blocks() {
     //First get all the blocks and all the wires from the registry:
@@ -18,6 +24,14 @@ void AAri::Graph::toposort_blocks() {
     registry.view<Visited>().each([](auto &visited) {
         visited.state = Visited::UNVISITED;
     });
+    _children.clear();
+    wires.each([&](auto wire_id, auto &wire) {
+        _children[wire.from_block].push_back(wire.to_block);
+    });
+    //A bus runs after the blocks sending to it
+    registry.view<Send>().each([&](auto &send) {
+        _children[send.from_block].push_back(send.bus);
+    });
     // Do a dfs on the blocks:
     for (auto block: blocks) {
         if (registry.get<Visited>(block).state == Visited::UNVISITED) {
@@ -34,30 +48,28 @@ void AAri::Graph::toposort_blocks() {
         return lhs.topo_sort_index > rhs.topo_sort_index;
     });
     //3) Update each block's WiresToBlock struct:
-    registry.view<WiresToBlock>().each([&](auto id, auto &wires_to_block) {
-        //First clear the array:
+    registry.view<WiresToBlock>().each([&](auto &wires_to_block) {
         for (auto &input_id: wires_to_block.input_wire_ids) {
             input_id = entt::null;
         }
-        //
-        //Now fill it with the wires connected to this block:
-        wires.each([&](auto wire_id, auto &wire) {
-            if (wire.to_block == id) {
-                //Find the first available slot in the array and throw an error if there is
-                //none:
-                bool found = false;
-                for (auto &input_id: wires_to_block.input_wire_ids) {
-                    if (input_id == entt::null) {
-                        input_id = wire_id;
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) {
-                    throw std::runtime_error("Too many wires. we only support 16 wires to each block at present");
-                }
+    });
+    //Then fill it with the wires connected to each block, in a single pass over the wires.
+    //Wires to mixers are gathered instead (see gather_inputs), so mixers take any number of them
+    wires.each([&](auto wire_id, auto &wire) {
+        if (registry.all_of<MixerInput>(wire.to_input))
+            return;
+        //Find the first available slot in the array and throw an error if there is none:
+        bool found = false;
+        for (auto &input_id: registry.get<WiresToBlock>(wire.to_block).input_wire_ids) {
+            if (input_id == entt::null) {
+                input_id = wire_id;
+                found = true;
+                break;
             }
-        });
+        }
+        if (!found) {
+            throw std::runtime_error("Too many wires. we only support 16 wires to each block at present");
+        }
     });
     //4) Also sort the wires so that if block i is before block j in the registry,
     //then all the input wires to block i are before all the input wires to block j
@@ -69,7 +81,13 @@ void AAri::Graph::toposort_blocks() {
         return registry.get<Block>(lhs_block).topo_sort_index >
                registry.get<Block>(rhs_block).topo_sort_index;
     });
-
+    //5) Fold constants and fuse wires, this changes which wires are transmitted
+    compile();
+    gather_inputs();
+    //6) Finally skip the blocks whose outputs are never used
+    cull_blocks();
+    //and make sleeping blocks re-check their inputs since the wiring may have changed
+    wake_all();
 
 }
 
@@ -89,16 +107,220 @@ void AAri::Graph::dfs(entt::entity block) {
             visit.state = Visited::VISITING;
             _dfs_stack.push(current_block); // Push back to process after all children
             //Now push all the children of this block on the stack
-            //Get all the wires that start from this block:
-            registry.view<Wire>().each([&](auto id, auto &wire) {
-                if (wire.from_block == current_block) {
-                    auto target_state = registry.get<Visited>(wire.to_block).state;
-                    if (target_state == Visited::UNVISITED)
-                        _dfs_stack.push(wire.to_block);
-                    else if (target_state == Visited::VISITING)
-                        throw std::runtime_error("Cycle detected in the graph!");
-                }
-            });
+            auto children = _children.find(current_block);
+            if (children == _children.end())
+                continue;
+            for (auto child: children->second) {
+                auto target_state = registry.get<Visited>(child).state;
+                if (target_state == Visited::UNVISITED)
+                    _dfs_stack.push(child);
+                else if (target_state == Visited::VISITING)
+                    throw std::runtime_error("Cycle detected in the graph!");
+            }
+        }
+    }
+}
+
+void AAri::Graph::cull_blocks() {
+    registry.clear<Dormant>();
+    auto taps = registry.view<Tap>();
+    if (taps.size() == 0) {
+        //Nothing is tapped (e.g. the output is not set yet), so there is no way to tell
+        //what is used: keep everything running
+        return;
+    }
+
+    //Reverse reachability from the blocks owning a tapped output:
+    //Visited is free to reuse at this point since the sort is done
+    registry.view<Visited>().each([](auto &visited) {
+        visited.state = Visited::UNVISITED;
+    });
+    _dfs_stack.clear();
+    registry.view<Block>().each([&](auto id, auto &block) {
+        for (auto output_id: block.outputIds) {
+            if (output_id != entt::null && taps.contains(output_id)) {
+                registry.get<Visited>(id).state = Visited::VISITED;
+                _dfs_stack.push(id);
+                break;
+            }
+        }
+    });
+    auto wires = registry.view<Wire>();
+    auto visit = [&](entt::entity upstream) {
+        auto &visited = registry.get<Visited>(upstream);
+        if (visited.state == Visited::UNVISITED) {
+            visited.state = Visited::VISITED;
+            _dfs_stack.push(upstream);
+        }
+    };
+    while (!_dfs_stack.empty()) {
+        auto current_block = _dfs_stack.pop();
+        for (auto wire_id: registry.get<WiresToBlock>(current_block).input_wire_ids) {
+            if (wire_id == entt::null)
+                continue;
+            auto *fused = registry.try_get<Fused>(wire_id);
+            visit(fused != nullptr ? fused->wire.from_block : wires.get<Wire>(wire_id).from_block);
+        }
+        //And the blocks gathered by a mixer or a bus
+        auto first_input = registry.get<Block>(current_block).inputIds[0];
+        if (first_input == entt::null)
+            continue;
+        if (auto *gathered = registry.try_get<GatherList>(first_input)) {
+            for (auto from_block: gathered->from_blocks)
+                visit(from_block);
+        }
+    }
+
+    registry.view<Block>().each([&](auto id, auto &block) {
+        if (registry.get<Visited>(id).state == Visited::UNVISITED)
+            registry.emplace<Dormant>(id);
+    });
+}
+
+void AAri::Graph::tap_output(entt::entity output_id) {
+    if (auto *tap = registry.try_get<Tap>(output_id))
+        tap->count++;
+    else
+        registry.emplace<Tap>(output_id);
+}
+
+void AAri::Graph::gather_inputs() {
+    registry.view<GatherList>().each([](auto &gathered) {
+        gathered.clear();
+    });
+    //In slot order, so that the sums don't depend on the order the wires were made in (e.g. in a snapshot).
+    //Their gains are baked in, changing one goes through refresh_compiled
+    _gathered_wires.clear();
+    registry.view<Wire>().each([&](auto wire_id, auto &wire) {
+        if (registry.all_of<MixerInput>(wire.to_input))
+            _gathered_wires.push_back(wire_id);
+    });
+    std::sort(_gathered_wires.begin(), _gathered_wires.end(), [&](auto lhs, auto rhs) {
+        return registry.get<Wire>(lhs).slot < registry.get<Wire>(rhs).slot;
+    });
+    for (auto wire_id: _gathered_wires) {
+        auto &wire = registry.get<Wire>(wire_id);
+        registry.get<GatherList>(wire.to_input).add(registry, wire.from_block, wire.from_output, wire.gain,
+                                                    wire.offset);
+        registry.emplace_or_replace<Compiled>(wire_id);
+    }
+    registry.view<Send>().each([&](auto send_id, auto &send) {
+        auto bus_input = registry.get<Block>(send.bus).inputIds[0];
+        registry.get<GatherList>(bus_input).add(registry, send.from_block, send.from_output, send.gain);
+        registry.emplace_or_replace<Compiled>(send_id);
+    });
+}
+
+void AAri::Graph::untap_output(entt::entity output_id) {
+    auto *tap = registry.try_get<Tap>(output_id);
+    if (tap == nullptr)
+        return;
+    if (--tap->count == 0)
+        registry.remove<Tap>(output_id);
+}
+
+namespace {
+    bool is_constant(const AAri::Block &block) {
+        return block.type == AAri::BlockType::Constant && block.processFunc == AAri::Constant::process;
+    }
+
+}
+
+void AAri::Graph::compile() {
+    registry.clear<Folded>();
+    registry.clear<Fused>();
+    registry.clear<Compiled>();
+    _compiled_blocks.clear();
+
+    //Wires out of Constant blocks, only those with a known transmit function can be compiled
+    //since the others (e.g. python functions) may do anything. Wires to mixers are never transmitted
+    std::unordered_map<entt::entity, std::vector<entt::entity>> outgoing;
+    registry.view<Wire>().each([&](auto wire_id, auto &wire) {
+        if (is_constant(registry.get<Block>(wire.from_block)) && find_transmit_kind(wire) >= 0 &&
+            !registry.all_of<MixerInput>(wire.to_input))
+            outgoing[wire.from_block].push_back(wire_id);
+    });
+    if (outgoing.empty())
+        return;
+
+    //_sorted_blocks is in reverse topological order, so that the upstream
+    //constants are compiled before the ones they feed
+    for (auto it = _sorted_blocks.rbegin(); it != _sorted_blocks.rend(); ++it) {
+        auto &block = registry.get<Block>(*it);
+        if (!is_constant(block))
+            continue;
+        auto found = outgoing.find(*it);
+        if (found == outgoing.end())
+            continue;
+
+        //A Constant input takes at most one wire
+        auto input_wire = registry.get<WiresToBlock>(*it).input_wire_ids[0];
+        CompiledBlock compiled{*it, entt::null, std::move(found->second)};
+        if (input_wire == entt::null || registry.all_of<Folded>(input_wire)) {
+            //Its value only changes when its input is set: fold it into the inputs it feeds
+            registry.emplace_or_replace<Compiled>(block.inputIds[0]);
+            for (auto wire_id: compiled.output_wires) {
+                registry.emplace<Folded>(wire_id);
+                registry.emplace_or_replace<Compiled>(wire_id);
+                registry.emplace_or_replace<Compiled>(registry.get<Wire>(wire_id).to_input);
+            }
+        } else {
+            auto *transmit = registry.get<Wire>(input_wire).transmitFunc.target<TransmitFuncPtr>();
+            if (transmit == nullptr || *transmit != &Wire::transmit_1d_to_1d)
+                continue;
+            //Passthrough: y = g2 * (g1 * x + o1) + o2 is a single wire from x
+            compiled.input_wire = input_wire;
+            registry.emplace_or_replace<Compiled>(input_wire);
+            for (auto wire_id: compiled.output_wires) {
+                registry.emplace<Fused>(wire_id, registry.get<Wire>(wire_id));
+                registry.emplace_or_replace<Compiled>(wire_id);
+            }
+        }
+        _compiled_blocks.push_back(std::move(compiled));
+    }
+
+    //Folded wires are not transmitted anymore
+    registry.view<WiresToBlock>().each([&](auto &wires_to_block) {
+        size_t kept = 0;
+        for (auto wire_id: wires_to_block.input_wire_ids) {
+            if (wire_id != entt::null && !registry.all_of<Folded>(wire_id))
+                wires_to_block.input_wire_ids[kept++] = wire_id;
+        }
+        for (; kept < N_WIRES; kept++)
+            wires_to_block.input_wire_ids[kept] = entt::null;
+    });
+
+    refresh_compiled();
+}
+
+void AAri::Graph::refresh_compiled() {
+    const AudioContext ctx{};
+    for (auto &compiled: _compiled_blocks) {
+        if (compiled.input_wire == entt::null) {
+            auto &block = registry.get<Block>(compiled.block);
+            block.processFunc(registry, block, ctx);
+            for (auto wire_id: compiled.output_wires) {
+                auto &wire = registry.get<Wire>(wire_id);
+                wire.transmitFunc(registry, wire);
+            }
+        } else {
+            //The upstream wire may itself be fused if passthroughs are chained
+            auto *upstream_fused = registry.try_get<Fused>(compiled.input_wire);
+            const Wire &upstream = upstream_fused != nullptr
+                                       ? upstream_fused->wire
+                                       : registry.get<Wire>(compiled.input_wire);
+            for (auto wire_id: compiled.output_wires) {
+                auto &wire = registry.get<Wire>(wire_id);
+                auto &fused = registry.get<Fused>(wire_id).wire;
+                fused = wire;
+                fused.from_block = upstream.from_block;
+                fused.from_output = upstream.from_output;
+                fused.gain = upstream.gain * wire.gain;
+                fused.offset = upstream.offset * wire.gain + wire.offset;
+            }
         }
     }
+    gather_inputs();
+    //Inputs may have changed under sleeping blocks
+    wake_all();
 }
@@ -8,6 +8,7 @@
 #include <vector>
 #include <string>
 #include <stack>
+#include <unordered_map>
 #include "inputs_outputs.h"
 #include "blocks.h"
 #include "wires.h"
@@ -19,6 +20,30 @@ namespace AAri {
         float speed_multiplier = 1.0;
     };
 
+    // Components written by the graph compiler (see Graph::compile), they are rebuilt on every toposort
+
+    /**
+     * Wire out of a constant block: its value was written to its input once at compile time
+     * and it is not transmitted per sample.
+     */
+    struct Folded {
+    };
+
+    /**
+     * Wire out of a passthrough Constant block: it is transmitted straight from the block feeding the
+     * passthrough, with the two affine transforms (gain, offset) merged into one.
+     */
+    struct Fused {
+        Wire wire;
+    };
+
+    /**
+     * Marks the wires and inputs whose values were baked in by the compiler,
+     * changing them needs a call to Graph::refresh_compiled.
+     */
+    struct Compiled {
+    };
+
     class Graph {
     public:
         /**
@@ -33,38 +58,119 @@ namespace AAri {
         void process(AudioContext ctx) {
             //The blocks are already sorted at this point, so
             //we just need to use the entt functions to iterate through them
-            auto block_view = registry.view<Block, WiresToBlock>();
+            auto block_view = registry.view<Block, WiresToBlock>(entt::exclude<Dormant>);
             auto wire_view = registry.view<Wire>();
+            auto silence_view = registry.view<Silence>();
+            auto fused_view = registry.view<Fused>();
             for (auto entity: block_view) {
                 //Find all inbound wires to this block
                 //and transmit the data from upstream blocks
                 auto &wires_to_block = block_view.get<WiresToBlock>(entity);
                 auto &block = block_view.get<Block>(entity);
+
+                Silence *silence = nullptr;
+                bool quiet = false;
+                if (silence_view.contains(entity)) {
+                    silence = &silence_view.get<Silence>(entity);
+                    quiet = upstream_asleep(wires_to_block, wire_view, fused_view, silence_view) &&
+                            (silence->silenceFunc == nullptr || silence->silenceFunc(registry, block));
+                    if (quiet && silence->asleep)
+                        continue;
+                }
+
                 for (auto wire_id: wires_to_block.input_wire_ids) {
                     if (wire_id == entt::null)
                         continue;
-                    auto &wire = wire_view.get<Wire>(wire_id);
+                    auto &wire = fused_view.contains(wire_id)
+                                     ? fused_view.get<Fused>(wire_id).wire
+                                     : wire_view.get<Wire>(wire_id);
                     wire.transmitFunc(registry, wire);
                 }
 
                 // Now the block's inputs are up-to-date and we can
                 // process it
                 block.processFunc(registry, block, ctx);
+
+                if (silence != nullptr)
+                    silence->asleep = quiet;
             }
         }
 
+        /**
+         * Wake all sleeping blocks, e.g. because an input was set from outside the graph.
+         * The ones that are still quiet go back to sleep after one sample.
+         */
+        void wake_all() {
+            registry.view<Silence>().each([](auto &silence) {
+                silence.asleep = false;
+            });
+        }
+
         /**
          * Topological sort of the blocs in the graph
+         * This also compiles the graph (see compile) and marks the blocks that don't reach
+         * a tapped output as dormant
          */
         void toposort_blocks();
 
+        /**
+         * Recompute the values baked in by the compiler after a Compiled input or wire changed.
+         * Much cheaper than a full toposort since the structure of the graph is the same.
+         */
+        void refresh_compiled();
+
+        /**
+         * Mark an output as read from outside the graph. Needs a new toposort to take effect.
+         */
+        void tap_output(entt::entity output_id);
+
+        void untap_output(entt::entity output_id);
+
+        /**
+         * Rebuild the GatherLists of the mixers and aux buses from the wires to mixers and the sends.
+         * Done by toposort_blocks and refresh_compiled
+         */
+        void gather_inputs();
+
 
     private:
 
+        template<typename WireView, typename FusedView, typename SilenceView>
+        static bool upstream_asleep(const WiresToBlock &wires_to_block, WireView &wire_view, FusedView &fused_view,
+                                    SilenceView &silence_view) {
+            for (auto wire_id: wires_to_block.input_wire_ids) {
+                if (wire_id == entt::null)
+                    continue;
+                auto from_block = fused_view.contains(wire_id)
+                                      ? fused_view.template get<Fused>(wire_id).wire.from_block
+                                      : wire_view.template get<Wire>(wire_id).from_block;
+                if (!silence_view.contains(from_block) || !silence_view.template get<Silence>(from_block).asleep)
+                    return false;
+            }
+            return true;
+        }
+
         void dfs(entt::entity block);
 
+        void cull_blocks();
+
+        void compile();
+
+        // Constant blocks handled by the compiler, in topological order
+        struct CompiledBlock {
+            entt::entity block = entt::null;
+            // Wire feeding a passthrough, null for folded constants
+            entt::entity input_wire = entt::null;
+            std::vector<entt::entity> output_wires;
+        };
+
+        std::vector<CompiledBlock> _compiled_blocks;
         std::vector<entt::entity> _sorted_blocks;
         Stack<entt::entity> _dfs_stack;
+        // Blocks fed by each block, built once per sort so that it stays linear in the number of wires
+        std::unordered_map<entt::entity, std::vector<entt::entity>> _children;
+        // Wires to mixers, kept to reuse the allocation in gather_inputs
+        std::vector<entt::entity> _gathered_wires;
     };
 }
 
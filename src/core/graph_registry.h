@@ -29,6 +29,9 @@ namespace AAri {
     class IGraphRegistry {
     public:
         virtual std::tuple<entt::registry &, std::unique_ptr<SpinLockGuard>> get_graph_registry() = 0;
+
+        // For the blocks sized in seconds, e.g. delay lines
+        virtual ma_uint32 get_sample_rate() const = 0;
     };
 }
 
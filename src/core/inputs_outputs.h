@@ -5,7 +5,10 @@
 #define AARI_INPUTS_OUTPUTS_H
 
 #include <cstddef>
+#include <cstdint>
 #include <array>
+#include <utility>
+#include <vector>
 
 
 namespace AAri {
@@ -56,5 +59,37 @@ namespace AAri {
         OutputND(std::array<float, N> value): value(value) {
         };
     };
+
+    /**
+     * Input of a mixer: slots fed by one wire each (see Wire::slot). The wires are not transmitted
+     * to it one by one, the mixer sums what feeds them directly (see GatherList)
+     */
+    struct MixerInput : public InputOutput {
+        uint32_t slots = 0;
+
+        MixerInput(uint32_t slots) : slots(slots) {
+        };
+    };
+
+    /**
+     * Input holding an array of values whose size is chosen when the block is created,
+     * e.g. the per-partial parameters of an AdditiveBank. It is set in bulk rather than wired.
+     */
+    struct InputArray : public InputOutput {
+        std::vector<float> value;
+
+        InputArray(std::vector<float> value) : value(std::move(value)) {
+        };
+    };
+
+    /**
+     * Output counterpart of InputArray, e.g. one envelope level per voice, see Wire::transmit_array_to_array
+     */
+    struct OutputArray : public InputOutput {
+        std::vector<float> value;
+
+        OutputArray(std::vector<float> value) : value(std::move(value)) {
+        };
+    };
 }
 #endif //AARI_INPUTS_OUTPUTS_H
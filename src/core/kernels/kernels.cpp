@@ -0,0 +1,182 @@
+//
+//
+
+#include "kernels.h"
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#if defined(AARI_X86_KERNELS)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+using namespace AAri;
+
+#if !defined(AARI_X86_KERNELS)
+//Only the scalar kernels are compiled for other architectures
+const Kernels *AAri::sse2_kernels() {
+    return nullptr;
+}
+
+const Kernels *AAri::avx2_kernels() {
+    return nullptr;
+}
+
+const Kernels *AAri::avx512_kernels() {
+    return nullptr;
+}
+#endif
+
+namespace {
+    const Kernels *kernels_for(SimdLevel level) {
+        switch (level) {
+            case SimdLevel::Scalar:
+                return scalar_kernels();
+            case SimdLevel::SSE2:
+                return sse2_kernels();
+            case SimdLevel::AVX2:
+                return avx2_kernels();
+            case SimdLevel::AVX512:
+                return avx512_kernels();
+        }
+        return nullptr;
+    }
+
+#if defined(AARI_X86_KERNELS)
+    void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, (int)leaf, (int)subleaf);
+        for (int i = 0; i < 4; i++)
+            regs[i] = (uint32_t)info[i];
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    //Which register states the OS saves on context switches
+    uint64_t xgetbv0() {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return ((uint64_t)edx << 32) | eax;
+#endif
+    }
+
+    SimdLevel cpu_simd_level() {
+        uint32_t regs[4];
+        cpuid(0, 0, regs);
+        const uint32_t max_leaf = regs[0];
+        if (max_leaf < 1)
+            return SimdLevel::Scalar;
+
+        cpuid(1, 0, regs);
+        const bool sse2 = regs[3] & (1u << 26);
+        const bool osxsave = regs[2] & (1u << 27);
+        const bool avx = regs[2] & (1u << 28);
+        const bool fma = regs[2] & (1u << 12);
+        if (!sse2)
+            return SimdLevel::Scalar;
+        if (!osxsave || !avx || !fma || max_leaf < 7)
+            return SimdLevel::SSE2;
+
+        const uint64_t xcr0 = xgetbv0();
+        //XMM and YMM state
+        if ((xcr0 & 0x6) != 0x6)
+            return SimdLevel::SSE2;
+
+        cpuid(7, 0, regs);
+        const bool avx2 = regs[1] & (1u << 5);
+        const bool avx512f = regs[1] & (1u << 16);
+        const bool avx512dq = regs[1] & (1u << 17);
+        const bool avx512vl = regs[1] & (1u << 31);
+        if (!avx2)
+            return SimdLevel::SSE2;
+        //Opmask and upper ZMM state as well
+        if (avx512f && avx512dq && avx512vl && (xcr0 & 0xE6) == 0xE6)
+            return SimdLevel::AVX512;
+        return SimdLevel::AVX2;
+    }
+#else
+    SimdLevel cpu_simd_level() {
+        return SimdLevel::Scalar;
+    }
+#endif
+
+    const Kernels *initial_kernels() {
+        if (const char *forced = std::getenv("AARI_SIMD")) {
+            auto level = parse_simd_level(forced);
+            if (level > detect_simd_level())
+                throw std::runtime_error(std::string("AARI_SIMD=") + forced + " is not supported on this CPU");
+            return kernels_for(level);
+        }
+        return kernels_for(detect_simd_level());
+    }
+
+    std::atomic<const Kernels *> &selected() {
+        static std::atomic<const Kernels *> selected{initial_kernels()};
+        return selected;
+    }
+}
+
+const Kernels &AAri::kernels() {
+    return *selected().load(std::memory_order_relaxed);
+}
+
+SimdLevel AAri::detect_simd_level() {
+    static const SimdLevel detected = [] {
+        auto level = cpu_simd_level();
+        //The CPU may support more than what was compiled in
+        while (level > SimdLevel::Scalar && kernels_for(level) == nullptr)
+            level = SimdLevel((int)level - 1);
+        return level;
+    }();
+    return detected;
+}
+
+SimdLevel AAri::get_simd_level() {
+    return kernels().level;
+}
+
+void AAri::set_simd_level(SimdLevel level) {
+    if (level > detect_simd_level()) {
+        throw std::runtime_error(std::string("SIMD level ") + simd_level_name(level) +
+                                 " is not supported, the best available is " +
+                                 simd_level_name(detect_simd_level()));
+    }
+    selected().store(kernels_for(level), std::memory_order_relaxed);
+}
+
+const char *AAri::simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar:
+            return "scalar";
+        case SimdLevel::SSE2:
+            return "sse2";
+        case SimdLevel::AVX2:
+            return "avx2";
+        case SimdLevel::AVX512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+SimdLevel AAri::parse_simd_level(std::string_view name) {
+    std::string lower(name);
+    for (auto &c: lower)
+        c = (char)std::tolower((unsigned char)c);
+    for (auto level: {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (lower == simd_level_name(level))
+            return level;
+    }
+    throw std::runtime_error("Unknown SIMD level " + std::string(name));
+}
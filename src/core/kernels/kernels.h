@@ -0,0 +1,198 @@
+//
+//
+
+#ifndef AARI_KERNELS_H
+#define AARI_KERNELS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace AAri {
+    /**
+     * Instruction set levels the DSP kernels are compiled for, in increasing order.
+     * Scalar has vectorisation turned off, it is mostly a reference for tests and benchmarks.
+     */
+    enum class SimdLevel {
+        Scalar,
+        SSE2,
+        AVX2,
+        AVX512,
+    };
+
+    using ArrayKernel = void (*)(const float *in, float *out, size_t n);
+
+    /**
+     * One-pole coefficients and targets of the stages of an ADSR envelope,
+     * see envelope::adsr_coefficients in utils/envelope.h
+     */
+    struct AdsrCoefficients {
+        float attack;
+        float attack_target;
+        float decay;
+        float decay_target;
+        float sustain;
+        float release;
+        float release_target;
+    };
+
+    /**
+     * Normalised biquad coefficients (a0 = 1), see filter::biquad_coefficients in utils/filter.h
+     */
+    struct BiquadCoefficients {
+        float b0;
+        float b1;
+        float b2;
+        float a1;
+        float a2;
+    };
+
+    /**
+     * A bank of n independent state variable filters for the svf_bank kernel, all arrays are SoA
+     * so that each filter runs in a vector lane.
+     */
+    struct SvfBankArgs {
+        const float *in;        // [n]
+        float *out;             // [n]
+        const float *cutoffs;   // [n] in Hz
+        const float *qs;        // [n]
+        float *state;           // [4][n] the two integrators, then the smoothed cutoffs and qs
+        size_t n;
+        float mode;             // same for all the filters, see utils/filter.h
+        float inv_sample_rate;
+        float smoothing;        // see filter::smoothing_coefficient
+    };
+
+    /**
+     * n independent biquads for the biquad_bank kernel, all arrays are SoA
+     */
+    struct BiquadBankArgs {
+        const float *in;            // [n]
+        float *out;                 // [n]
+        const float *coefficients;  // [5][n] b0, b1, b2, a1, a2
+        float *state;               // [2][n]
+        size_t n;
+    };
+
+    constexpr size_t FDN_MAX_LINES = 16;
+
+    /**
+     * One sample of a feedback delay network for the fdn kernel: the outputs of its n delay lines
+     * are damped, scaled by their decay gains and mixed by an orthogonal matrix, then the inputs are added.
+     */
+    struct FdnArgs {
+        float *lines;           // [n] in: the outputs of the delay lines, out: what to write into them
+        float *filters;         // [n] states of the one-pole damping filters
+        const float *gains;     // [n] decay gain of each line
+        size_t n;               // a power of two up to FDN_MAX_LINES
+        float damping;          // in [0, 1), 0 leaves the highs alone
+        float left;             // added to the even lines
+        float right;            // added to the odd lines
+        bool householder;       // Householder reflection rather than Hadamard matrix
+    };
+
+    constexpr size_t FM_OPERATORS = 6;
+
+    /**
+     * A bank of FM voices for the fm kernel, all arrays are SoA.
+     * Operator k is modulated by the operators whose bits are set in modulators[k], which must all be above k,
+     * and operator feedback_op also by the average of its last two outputs times feedback.
+     * Modulation is in radians: an operator at level 1 deviates the phase of the ones it modulates by 1 radian.
+     */
+    struct FmArgs {
+        const uint8_t *modulators;  // [FM_OPERATORS]
+        uint8_t carriers;           // bit mask of the operators heard
+        uint8_t used;               // bit mask of the operators to compute
+        uint8_t feedback_op;
+        float feedback;
+        const float *ratios;        // [FM_OPERATORS] frequency of each operator relative to the voice
+        const float *levels;        // [FM_OPERATORS] output level of each operator
+        const float *freqs;         // [voices]
+        const float *amps;          // [voices]
+        float *phases;              // [FM_OPERATORS][voices] in cycles
+        float *history;             // [2][voices] last outputs of the feedback operator
+        size_t voices;
+        float dt;                   // seconds per sample
+    };
+
+    /**
+     * Table of the kernels compiled for one SimdLevel.
+     * The approximations have one entry per fast_math::Accuracy.
+     */
+    struct Kernels {
+        SimdLevel level;
+
+        // Sum of the n values of in, what mixers do
+        float (*sum)(const float *in, size_t n);
+
+        // Sum of gains[i] * *sources[i], what mixers and aux buses do with the outputs they gather
+        float (*gather_sum)(const float *const *sources, const float *gains, size_t n);
+
+        // out[i] = in[i] * gain + offset, what wires do
+        void (*affine)(const float *in, float *out, size_t n, float gain, float offset);
+
+        std::array<ArrayKernel, 3> sin2pi;
+        std::array<ArrayKernel, 3> cos2pi;
+        std::array<ArrayKernel, 3> exp2;
+        std::array<ArrayKernel, 3> tanh;
+
+        // Sum of amps[i] * sin(2 pi phases[i]) over a bank of n sine oscillators, the phases (in cycles) are then
+        // advanced by freqs[i] * freq_scale. Oscillators at or above Nyquist (|increment| >= 0.5) are left out.
+        float (*sine_bank)(float *phases, const float *freqs, const float *amps, size_t n, float freq_scale);
+
+        // Sum of all the voices of an FM bank for one sample, vectorised across voices
+        float (*fm)(const FmArgs &args);
+
+        // One sample of n ADSR envelopes sharing the same coefficients, stages and levels are updated in place
+        void (*adsr)(const float *gates, float *stages, float *levels, size_t n, const AdsrCoefficients &coefficients);
+
+        // One sample of banks of filters (see utils/filter.h)
+        void (*svf_bank)(const SvfBankArgs &args);
+        void (*biquad_bank)(const BiquadBankArgs &args);
+
+        // One sample of the mixing of a feedback delay network
+        void (*fdn)(const FdnArgs &args);
+
+        // Transpose channels planar rows of frames samples, stride floats apart, into out one frame after the
+        // other, i.e. planar buses into what the audio device takes
+        void (*interleave)(const float *planar, size_t stride, size_t channels, size_t frames, float *out);
+    };
+
+    /**
+     * @return the kernels for the selected level. The first call selects the best level
+     * the CPU supports, unless the AARI_SIMD environment variable forces one (scalar, sse2, avx2 or avx512).
+     */
+    const Kernels &kernels();
+
+    /**
+     * Highest level supported by both the CPU (through cpuid) and this build
+     */
+    SimdLevel detect_simd_level();
+
+    SimdLevel get_simd_level();
+
+    /**
+     * Force the kernels of a given level, e.g. to compare them in tests and benchmarks.
+     * Throws if the CPU or the build doesn't support it.
+     */
+    void set_simd_level(SimdLevel level);
+
+    const char *simd_level_name(SimdLevel level);
+
+    /**
+     * Inverse of simd_level_name (case insensitive), throws on unknown names
+     */
+    SimdLevel parse_simd_level(std::string_view name);
+
+    // One per kernels_<level>.cpp file, null when the level is not compiled in this build
+    const Kernels *scalar_kernels();
+
+    const Kernels *sse2_kernels();
+
+    const Kernels *avx2_kernels();
+
+    const Kernels *avx512_kernels();
+}
+
+#endif //AARI_KERNELS_H
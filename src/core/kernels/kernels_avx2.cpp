@@ -0,0 +1,11 @@
+//
+//
+
+#define AARI_SIMD_NAMESPACE avx2
+
+#include "kernels_impl.h"
+
+const AAri::Kernels *AAri::avx2_kernels() {
+    static const Kernels kernels = make_kernels(SimdLevel::AVX2);
+    return &kernels;
+}
@@ -0,0 +1,11 @@
+//
+//
+
+#define AARI_SIMD_NAMESPACE avx512
+
+#include "kernels_impl.h"
+
+const AAri::Kernels *AAri::avx512_kernels() {
+    static const Kernels kernels = make_kernels(SimdLevel::AVX512);
+    return &kernels;
+}
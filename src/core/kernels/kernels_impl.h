@@ -0,0 +1,354 @@
+//
+//
+
+#ifndef AARI_KERNELS_IMPL_H
+#define AARI_KERNELS_IMPL_H
+
+/**
+ * Kernel implementations, only included by the kernels_<level>.cpp files.
+ * They are written as plain loops for the compiler to vectorise with the instruction set
+ * of the file including this, which must define AARI_SIMD_NAMESPACE before.
+ */
+#ifndef AARI_SIMD_NAMESPACE
+#error "AARI_SIMD_NAMESPACE must be defined before including kernels_impl.h"
+#endif
+
+#include "kernels.h"
+#include "../utils/fast_math.h"
+#include "../utils/polyblep.h"
+#include "../utils/envelope.h"
+#include "../utils/filter.h"
+
+namespace {
+    using AAri::fast_math::Accuracy;
+
+    float sum(const float *in, size_t n) {
+        //Several accumulators so that the additions can be reordered into vector lanes
+        //without -ffast-math
+        float acc[8] = {0.0f};
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            for (size_t j = 0; j < 8; j++)
+                acc[j] += in[i + j];
+        }
+        for (; i < n; i++)
+            acc[0] += in[i];
+        return ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+    }
+
+    float gather_sum(const float *const *sources, const float *gains, size_t n) {
+        //The sources are scattered in the registry: copy them next to each other a chunk at a time,
+        //then the products are summed in vector lanes like in sum
+        constexpr size_t CHUNK = 64;
+        float values[CHUNK];
+        float acc[8] = {0.0f};
+        for (size_t start = 0; start < n; start += CHUNK) {
+            const size_t count = std::min(CHUNK, n - start);
+            for (size_t i = 0; i < count; i++)
+                values[i] = *sources[start + i];
+            const float *chunk_gains = gains + start;
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                for (size_t j = 0; j < 8; j++)
+                    acc[j] += values[i + j] * chunk_gains[i + j];
+            }
+            for (; i < count; i++)
+                acc[0] += values[i] * chunk_gains[i];
+        }
+        return ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+    }
+
+    void affine(const float *in, float *out, size_t n, float gain, float offset) {
+        for (size_t i = 0; i < n; i++)
+            out[i] = in[i] * gain + offset;
+    }
+
+    template<Accuracy A>
+    void sin2pi(const float *in, float *out, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            out[i] = AAri::fast_math::sin2pi<A>(in[i]);
+    }
+
+    template<Accuracy A>
+    void cos2pi(const float *in, float *out, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            out[i] = AAri::fast_math::cos2pi<A>(in[i]);
+    }
+
+    template<Accuracy A>
+    void exp2(const float *in, float *out, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            out[i] = AAri::fast_math::exp2<A>(in[i]);
+    }
+
+    template<Accuracy A>
+    void tanh(const float *in, float *out, size_t n) {
+        for (size_t i = 0; i < n; i++)
+            out[i] = AAri::fast_math::tanh<A>(in[i]);
+    }
+
+    float sine_bank(float *phases, const float *freqs, const float *amps, size_t n, float freq_scale) {
+        //Chunks keep the values on the stack, the loop below has no reduction so it vectorises without -ffast-math
+        constexpr size_t CHUNK = 256;
+        float values[CHUNK];
+        float total = 0.0f;
+        for (size_t start = 0; start < n; start += CHUNK) {
+            const size_t count = std::min(CHUNK, n - start);
+            float *p = phases + start;
+            const float *f = freqs + start;
+            const float *a = amps + start;
+            for (size_t i = 0; i < count; i++) {
+                const float increment = f[i] * freq_scale;
+                const float amp = std::abs(increment) < 0.5f ? a[i] : 0.0f;
+                values[i] = amp * AAri::fast_math::sin2pi<Accuracy::High>(p[i]);
+                p[i] = AAri::polyblep::advance(p[i], increment);
+            }
+            total += sum(values, count);
+        }
+        return total;
+    }
+
+    float fm(const AAri::FmArgs &args) {
+        using AAri::FM_OPERATORS;
+        constexpr size_t CHUNK = 64;
+        float outputs[FM_OPERATORS][CHUNK];
+        float modulation[CHUNK];
+        float mix[CHUNK];
+        float total = 0.0f;
+        for (size_t start = 0; start < args.voices; start += CHUNK) {
+            const size_t count = std::min(CHUNK, args.voices - start);
+            const float *freqs = args.freqs + start;
+            for (size_t i = 0; i < count; i++)
+                mix[i] = 0.0f;
+            //Modulators are above the operators they modulate, so going down computes them first
+            for (size_t op = FM_OPERATORS; op-- > 0;) {
+                if (!(args.used & (1u << op)))
+                    continue;
+                for (size_t i = 0; i < count; i++)
+                    modulation[i] = 0.0f;
+                for (size_t m = op + 1; m < FM_OPERATORS; m++) {
+                    if (args.modulators[op] & (1u << m)) {
+                        for (size_t i = 0; i < count; i++)
+                            modulation[i] += outputs[m][i];
+                    }
+                }
+                if (op == args.feedback_op) {
+                    float *h0 = args.history + start;
+                    float *h1 = args.history + args.voices + start;
+                    for (size_t i = 0; i < count; i++)
+                        modulation[i] += args.feedback * 0.5f * (h0[i] + h1[i]);
+                }
+
+                float *phases = args.phases + op * args.voices + start;
+                float *out = outputs[op];
+                const float level = args.levels[op];
+                const float scale = args.ratios[op] * args.dt;
+                for (size_t i = 0; i < count; i++) {
+                    out[i] = level * AAri::fast_math::sin2pi(phases[i] + modulation[i] * AAri::fast_math::INV_TWO_PI);
+                    phases[i] = AAri::polyblep::advance(phases[i], freqs[i] * scale);
+                }
+
+                if (op == args.feedback_op) {
+                    float *h0 = args.history + start;
+                    float *h1 = args.history + args.voices + start;
+                    for (size_t i = 0; i < count; i++) {
+                        h1[i] = h0[i];
+                        h0[i] = out[i];
+                    }
+                }
+                if (args.carriers & (1u << op)) {
+                    for (size_t i = 0; i < count; i++)
+                        mix[i] += out[i];
+                }
+            }
+            const float *amps = args.amps + start;
+            for (size_t i = 0; i < count; i++)
+                mix[i] *= amps[i];
+            total += sum(mix, count);
+        }
+        return total;
+    }
+
+    void adsr(const float *gates, float *stages, float *levels, size_t n, const AAri::AdsrCoefficients &coefficients) {
+        for (size_t i = 0; i < n; i++)
+            levels[i] = AAri::envelope::step(gates[i], stages[i], levels[i], coefficients);
+    }
+
+    void svf_bank(const AAri::SvfBankArgs &args) {
+        namespace filter = AAri::filter;
+        //The state goes through local chunks, so that the loop doesn't need alias checks between all its arrays
+        constexpr size_t CHUNK = 64;
+        float ic1[CHUNK], ic2[CHUNK], cutoffs[CHUNK], qs[CHUNK], out[CHUNK];
+        const size_t n = args.n;
+        const auto mix = filter::svf_mix(args.mode);
+        const float inv_sample_rate = args.inv_sample_rate;
+        const float smoothing = args.smoothing;
+        for (size_t start = 0; start < n; start += CHUNK) {
+            const size_t count = std::min(CHUNK, n - start);
+            const float *in = args.in + start;
+            const float *targets = args.cutoffs + start;
+            const float *target_qs = args.qs + start;
+            float *state = args.state + start;
+            std::copy_n(state, count, ic1);
+            std::copy_n(state + n, count, ic2);
+            std::copy_n(state + 2 * n, count, cutoffs);
+            std::copy_n(state + 3 * n, count, qs);
+            for (size_t i = 0; i < count; i++) {
+                cutoffs[i] = filter::smooth(cutoffs[i], targets[i], smoothing);
+                qs[i] = filter::smooth(qs[i], target_qs[i], smoothing);
+                const float f = filter::normalized_cutoff(cutoffs[i], inv_sample_rate);
+                const auto outputs = filter::svf_step(in[i], f, qs[i], ic1[i], ic2[i]);
+                out[i] = filter::svf_select(mix, outputs);
+                filter::flush(in[i], ic1[i], ic2[i]);
+            }
+            std::copy_n(out, count, args.out + start);
+            std::copy_n(ic1, count, state);
+            std::copy_n(ic2, count, state + n);
+            std::copy_n(cutoffs, count, state + 2 * n);
+            std::copy_n(qs, count, state + 3 * n);
+        }
+    }
+
+    void biquad_bank(const AAri::BiquadBankArgs &args) {
+        constexpr size_t CHUNK = 64;
+        float s1[CHUNK], s2[CHUNK], out[CHUNK];
+        const size_t n = args.n;
+        for (size_t start = 0; start < n; start += CHUNK) {
+            const size_t count = std::min(CHUNK, n - start);
+            const float *in = args.in + start;
+            const float *b0 = args.coefficients + start;
+            const float *b1 = b0 + n;
+            const float *b2 = b1 + n;
+            const float *a1 = b2 + n;
+            const float *a2 = a1 + n;
+            float *state = args.state + start;
+            std::copy_n(state, count, s1);
+            std::copy_n(state + n, count, s2);
+            for (size_t i = 0; i < count; i++) {
+                const AAri::BiquadCoefficients coefficients{b0[i], b1[i], b2[i], a1[i], a2[i]};
+                out[i] = AAri::filter::biquad_step(in[i], coefficients, s1[i], s2[i]);
+                AAri::filter::flush(in[i], s1[i], s2[i]);
+            }
+            std::copy_n(out, count, args.out + start);
+            std::copy_n(s1, count, state);
+            std::copy_n(s2, count, state + n);
+        }
+    }
+
+    //In place fast Walsh-Hadamard transform, N known at compile time so that the butterflies become shuffles
+    template<size_t N>
+    void hadamard(float *v) {
+        for (size_t h = 1; h < N; h *= 2) {
+            for (size_t i = 0; i < N; i += 2 * h) {
+                for (size_t j = i; j < i + h; j++) {
+                    const float a = v[j];
+                    const float b = v[j + h];
+                    v[j] = a + b;
+                    v[j + h] = a - b;
+                }
+            }
+        }
+    }
+
+    void fdn(const AAri::FdnArgs &args) {
+        using AAri::FDN_MAX_LINES;
+        const size_t n = args.n;
+        const float damping = args.damping;
+        float v[FDN_MAX_LINES];
+        for (size_t i = 0; i < n; i++) {
+            const float x = args.lines[i];
+            const float f = x + (args.filters[i] - x) * damping;
+            args.filters[i] = std::abs(f) < AAri::filter::SILENCE ? 0.0f : f;
+            v[i] = f * args.gains[i];
+        }
+        //Both matrices are orthogonal, so the gains alone set the decay
+        float scale = 1.0f;
+        if (args.householder) {
+            //I - 2/n 11^T
+            float total = 0.0f;
+            for (size_t i = 0; i < n; i++)
+                total += v[i];
+            const float reflection = 2.0f * total / float(n);
+            for (size_t i = 0; i < n; i++)
+                v[i] -= reflection;
+        } else {
+            switch (n) {
+                case 2: hadamard<2>(v);
+                    break;
+                case 4: hadamard<4>(v);
+                    break;
+                case 8: hadamard<8>(v);
+                    break;
+                default: hadamard<FDN_MAX_LINES>(v);
+                    break;
+            }
+            scale = 1.0f / std::sqrt(float(n));
+        }
+        for (size_t i = 0; i < n; i++) {
+            //Flushed to 0 so that the lines fall silent instead of ringing on in the denormals
+            const float x = v[i] * scale + ((i & 1) ? args.right : args.left);
+            args.lines[i] = std::abs(x) < AAri::filter::SILENCE ? 0.0f : x;
+        }
+    }
+
+    //Interleave G of the channels, through local arrays so that the transpose has constant strides
+    template<size_t G>
+    void interleave_group(const float *planar, size_t stride, size_t channels, size_t frames, float *out) {
+        constexpr size_t CHUNK = 64;
+        float rows[G][CHUNK];
+        float frames_out[CHUNK * G];
+        for (size_t start = 0; start < frames; start += CHUNK) {
+            const size_t count = std::min(CHUNK, frames - start);
+            for (size_t c = 0; c < G; c++)
+                std::copy_n(planar + c * stride + start, count, rows[c]);
+            for (size_t i = 0; i < count; i++) {
+                for (size_t c = 0; c < G; c++)
+                    frames_out[i * G + c] = rows[c][i];
+            }
+            if (G == channels) {
+                std::copy_n(frames_out, count * G, out + start * G);
+            } else {
+                for (size_t i = 0; i < count; i++)
+                    std::copy_n(frames_out + i * G, G, out + (start + i) * channels);
+            }
+        }
+    }
+
+    void interleave(const float *planar, size_t stride, size_t channels, size_t frames, float *out) {
+        size_t c = 0;
+        for (; c + 8 <= channels; c += 8)
+            interleave_group<8>(planar + c * stride, stride, channels, frames, out + c);
+        if (c + 4 <= channels) {
+            interleave_group<4>(planar + c * stride, stride, channels, frames, out + c);
+            c += 4;
+        }
+        if (c + 2 <= channels) {
+            interleave_group<2>(planar + c * stride, stride, channels, frames, out + c);
+            c += 2;
+        }
+        if (c < channels)
+            interleave_group<1>(planar + c * stride, stride, channels, frames, out + c);
+    }
+
+    AAri::Kernels make_kernels(AAri::SimdLevel level) {
+        return {
+            level,
+            sum,
+            gather_sum,
+            affine,
+            {sin2pi<Accuracy::Low>, sin2pi<Accuracy::Medium>, sin2pi<Accuracy::High>},
+            {cos2pi<Accuracy::Low>, cos2pi<Accuracy::Medium>, cos2pi<Accuracy::High>},
+            {exp2<Accuracy::Low>, exp2<Accuracy::Medium>, exp2<Accuracy::High>},
+            {tanh<Accuracy::Low>, tanh<Accuracy::Medium>, tanh<Accuracy::High>},
+            sine_bank,
+            fm,
+            adsr,
+            svf_bank,
+            biquad_bank,
+            fdn,
+            interleave,
+        };
+    }
+}
+
+#endif //AARI_KERNELS_IMPL_H
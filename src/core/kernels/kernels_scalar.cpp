@@ -0,0 +1,11 @@
+//
+//
+
+#define AARI_SIMD_NAMESPACE scalar
+
+#include "kernels_impl.h"
+
+const AAri::Kernels *AAri::scalar_kernels() {
+    static const Kernels kernels = make_kernels(SimdLevel::Scalar);
+    return &kernels;
+}
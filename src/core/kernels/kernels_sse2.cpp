@@ -0,0 +1,11 @@
+//
+//
+
+#define AARI_SIMD_NAMESPACE sse2
+
+#include "kernels_impl.h"
+
+const AAri::Kernels *AAri::sse2_kernels() {
+    static const Kernels kernels = make_kernels(SimdLevel::SSE2);
+    return &kernels;
+}
@@ -0,0 +1,138 @@
+//
+//
+
+#include "memory_pool.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace AAri;
+
+namespace {
+    size_t round_up(size_t size) {
+        return (size + MemoryPool::ALIGNMENT - 1) / MemoryPool::ALIGNMENT * MemoryPool::ALIGNMENT;
+    }
+}
+
+// Buffer --------------------------------------------------------------------------------------
+
+MemoryPool::Buffer::Buffer(float* data, size_t size, size_t arena, size_t offset) : _data(data), _size(size),
+    _arena(arena), _offset(offset) {
+}
+
+MemoryPool::Buffer::Buffer(Buffer&&other) noexcept : _data(other._data), _size(other._size), _arena(other._arena),
+                                                      _offset(other._offset) {
+    other._data = nullptr;
+    other._size = 0;
+}
+
+MemoryPool::Buffer& MemoryPool::Buffer::operator=(Buffer&&other) noexcept {
+    if (this != &other) {
+        release();
+        _data = other._data;
+        _size = other._size;
+        _arena = other._arena;
+        _offset = other._offset;
+        other._data = nullptr;
+        other._size = 0;
+    }
+    return *this;
+}
+
+MemoryPool::Buffer::~Buffer() {
+    release();
+}
+
+void MemoryPool::Buffer::release() {
+    if (_data != nullptr)
+        instance().release(_arena, _offset, _size);
+    _data = nullptr;
+    _size = 0;
+}
+
+// MemoryPool ----------------------------------------------------------------------------------
+
+MemoryPool& MemoryPool::instance() {
+    static auto* pool = new MemoryPool();
+    return *pool;
+}
+
+MemoryPool::Buffer MemoryPool::allocate(size_t size) {
+    if (size == 0)
+        throw std::runtime_error("MemoryPool: cannot allocate an empty buffer");
+    size = round_up(size);
+    std::lock_guard lock(_mutex);
+    for (size_t a = 0;; a++) {
+        if (a == _arenas.size())
+            add_arena(std::max(ARENA_SIZE, size));
+        auto&arena = _arenas[a];
+        //First fit
+        for (auto it = arena.free.begin(); it != arena.free.end(); ++it) {
+            auto [offset, free_size] = *it;
+            if (free_size < size)
+                continue;
+            arena.free.erase(it);
+            if (free_size > size)
+                arena.free.emplace(offset + size, free_size - size);
+            _used += size;
+            float* data = arena.data + offset;
+            std::fill(data, data + size, 0.0f);
+            return {data, size, a, offset};
+        }
+    }
+}
+
+void MemoryPool::reserve(size_t size) {
+    size = round_up(size);
+    std::lock_guard lock(_mutex);
+    for (const auto&arena: _arenas) {
+        for (auto [offset, free_size]: arena.free) {
+            if (free_size >= size)
+                return;
+        }
+    }
+    add_arena(std::max(ARENA_SIZE, size));
+}
+
+size_t MemoryPool::capacity() const {
+    std::lock_guard lock(_mutex);
+    size_t capacity = 0;
+    for (const auto&arena: _arenas)
+        capacity += arena.size;
+    return capacity;
+}
+
+size_t MemoryPool::used() const {
+    std::lock_guard lock(_mutex);
+    return _used;
+}
+
+void MemoryPool::add_arena(size_t size) {
+    Arena arena;
+    arena.storage = std::make_unique_for_overwrite<float[]>(size + ALIGNMENT);
+    void* data = arena.storage.get();
+    size_t space = (size + ALIGNMENT) * sizeof(float);
+    arena.data = static_cast<float*>(std::align(ALIGNMENT * sizeof(float), size * sizeof(float), data, space));
+    arena.size = size;
+    arena.free.emplace(0, size);
+    _arenas.push_back(std::move(arena));
+}
+
+void MemoryPool::release(size_t arena, size_t offset, size_t size) {
+    std::lock_guard lock(_mutex);
+    _used -= size;
+    auto&free = _arenas[arena].free;
+    auto next = free.lower_bound(offset);
+    //Merge with the free ranges right after and right before
+    if (next != free.end() && offset + size == next->first) {
+        size += next->second;
+        next = free.erase(next);
+    }
+    if (next != free.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += size;
+            return;
+        }
+    }
+    free.emplace(offset, size);
+}
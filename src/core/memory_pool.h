@@ -0,0 +1,111 @@
+//
+//
+
+#ifndef AARI_MEMORY_POOL_H
+#define AARI_MEMORY_POOL_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace AAri {
+    /**
+     * Float memory shared by all the engines for the blocks that need large buffers, e.g. delay lines.
+     *
+     * The memory comes from a few big arenas allocated ahead of time (see reserve), and blocks take their
+     * buffers from them when they are set up, on the control thread. The audio thread never allocates, and
+     * buffers stay where they are for their whole life. A buffer goes back to the pool when its handle is
+     * destroyed, which happens with the entity it is a component of.
+     * A request that doesn't fit in the free space adds an arena instead of failing.
+     */
+    class MemoryPool {
+    public:
+        // Floats per arena: 87 s of delay at 48 kHz
+        static constexpr size_t ARENA_SIZE = size_t(1) << 22;
+        // Buffer sizes and offsets are multiples of this, so that buffers start on 64 byte boundaries
+        static constexpr size_t ALIGNMENT = 16;
+
+        /**
+         * Owner of a buffer, move only. An empty handle (default constructed or moved from) owns nothing
+         */
+        class Buffer {
+        public:
+            Buffer() = default;
+
+            Buffer(Buffer &&other) noexcept;
+
+            Buffer &operator=(Buffer &&other) noexcept;
+
+            Buffer(const Buffer &) = delete;
+
+            Buffer &operator=(const Buffer &) = delete;
+
+            ~Buffer();
+
+            float *data() const {
+                return _data;
+            }
+
+            size_t size() const {
+                return _size;
+            }
+
+        private:
+            friend class MemoryPool;
+
+            Buffer(float *data, size_t size, size_t arena, size_t offset);
+
+            void release();
+
+            float *_data = nullptr;
+            size_t _size = 0;
+            size_t _arena = 0;
+            size_t _offset = 0;
+        };
+
+        /**
+         * The pool is never destroyed, so that buffers can still be released by registries destroyed
+         * during static destruction
+         */
+        static MemoryPool &instance();
+
+        /**
+         * @return a zeroed buffer of at least size floats
+         */
+        Buffer allocate(size_t size);
+
+        /**
+         * Make sure size floats can be allocated without adding an arena later
+         */
+        void reserve(size_t size);
+
+        // In floats
+        size_t capacity() const;
+
+        size_t used() const;
+
+    private:
+        struct Arena {
+            std::unique_ptr<float[]> storage;
+            // storage aligned to ALIGNMENT floats
+            float *data = nullptr;
+            size_t size = 0;
+            // Free ranges, offset -> size, merged with their neighbours when released
+            std::map<size_t, size_t> free;
+        };
+
+        MemoryPool() = default;
+
+        void add_arena(size_t size);
+
+        void release(size_t arena, size_t offset, size_t size);
+
+        std::vector<Arena> _arenas;
+        size_t _used = 0;
+        mutable std::mutex _mutex;
+    };
+}
+
+#endif //AARI_MEMORY_POOL_H
@@ -0,0 +1,157 @@
+//
+//
+
+#include "recorder.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace AAri;
+
+namespace {
+    // RIFF sizes are 32 bits, with room for the header
+    constexpr uint64_t WAV_MAX_BYTES = 0xFFFFFFFFull - (uint64_t(1) << 16);
+}
+
+Recorder::Recorder(const std::string&path, size_t channels, uint32_t sample_rate, uint64_t max_file_frames)
+    : _path(path), _channels(channels), _sample_rate(sample_rate),
+      _max_file_frames(max_file_frames > 0 ? max_file_frames : WAV_MAX_BYTES / (channels * sizeof(float))) {
+    if (channels == 0)
+        throw std::runtime_error("Recorder: at least one channel is needed");
+    _ring.assign(RING_FRAMES * channels, 0.0f);
+    open_file();
+    if (!_encoder_open)
+        throw std::runtime_error("Recorder: cannot create " + path);
+    _writer = std::thread(&Recorder::writer, this);
+}
+
+Recorder::~Recorder() {
+    _stop.store(true);
+    _wake.fetch_add(1);
+    _wake.notify_one();
+    _writer.join();
+    if (_encoder_open)
+        ma_encoder_uninit(&_encoder);
+}
+
+std::string Recorder::file_path(const std::string&path, size_t index) {
+    if (index <= 1)
+        return path;
+    const auto dot = path.rfind('.');
+    const auto slash = path.find_last_of("/\\");
+    const bool has_extension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    const auto stem_end = has_extension ? dot : path.size();
+    return path.substr(0, stem_end) + "_" + std::to_string(index) + path.substr(stem_end);
+}
+
+void Recorder::push(const float* frames, size_t count, bool realtime) {
+    while (count > 0) {
+        size_t n = std::min(count, space());
+        if (n == 0) {
+            if (realtime) {
+                _dropped.fetch_add(count, std::memory_order_relaxed);
+                break;
+            }
+            wait_for_space();
+            continue;
+        }
+        copy_in(frames, n);
+        frames += n * _channels;
+        count -= n;
+    }
+    publish();
+}
+
+void Recorder::push_frame(const float* frame, bool realtime) {
+    if (space() == 0) {
+        if (realtime) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        wait_for_space();
+    }
+    copy_in(frame, 1);
+}
+
+void Recorder::publish() {
+    _write.store(_write_local, std::memory_order_release);
+    //Only wake the writer once there is a chunk to write
+    if (_write_local - _notified >= CHUNK_FRAMES) {
+        _notified = _write_local;
+        _wake.fetch_add(1, std::memory_order_release);
+        _wake.notify_one();
+    }
+}
+
+void Recorder::wait_for_space() {
+    publish();
+    _notified = _write_local;
+    _wake.fetch_add(1, std::memory_order_release);
+    _wake.notify_one();
+    uint64_t read = _read.load(std::memory_order_acquire);
+    while (RING_FRAMES - size_t(_write_local - read) == 0) {
+        _read.wait(read, std::memory_order_acquire);
+        read = _read.load(std::memory_order_acquire);
+    }
+}
+
+void Recorder::copy_in(const float* frames, size_t count) {
+    //At most two copies, around the end of the ring
+    const size_t start = _write_local % RING_FRAMES;
+    const size_t first = std::min(count, RING_FRAMES - start);
+    std::memcpy(_ring.data() + start * _channels, frames, first * _channels * sizeof(float));
+    std::memcpy(_ring.data(), frames + first * _channels, (count - first) * _channels * sizeof(float));
+    _write_local += count;
+}
+
+void Recorder::open_file() {
+    const auto path = file_path(_path, _files.load(std::memory_order_relaxed) + 1);
+    ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, ma_uint32(_channels),
+                                                      _sample_rate);
+    _encoder_open = ma_encoder_init_file(path.c_str(), &config, &_encoder) == MA_SUCCESS;
+    _file_frames = 0;
+    if (_encoder_open)
+        _files.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Recorder::writer() {
+    uint64_t read = 0;
+    while (true) {
+        const uint32_t seen = _wake.load(std::memory_order_acquire);
+        const bool stopping = _stop.load(std::memory_order_acquire);
+        const uint64_t written = _write.load(std::memory_order_acquire);
+        if (written == read) {
+            if (stopping)
+                return;
+            _wake.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+        if (written - read < CHUNK_FRAMES && !stopping) {
+            _wake.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+
+        //Up to the end of the ring, and of the file
+        const size_t start = read % RING_FRAMES;
+        size_t count = std::min(size_t(written - read), RING_FRAMES - start);
+        if (_encoder_open && !_failed.load(std::memory_order_relaxed)) {
+            count = size_t(std::min<uint64_t>(count, _max_file_frames - _file_frames));
+            ma_uint64 frames = 0;
+            if (ma_encoder_write_pcm_frames(&_encoder, _ring.data() + start * _channels, count, &frames) !=
+                MA_SUCCESS || frames < count) {
+                _failed.store(true, std::memory_order_relaxed);
+            }
+            _file_frames += count;
+            _frames_written.fetch_add(frames, std::memory_order_relaxed);
+            if (_file_frames == _max_file_frames) {
+                ma_encoder_uninit(&_encoder);
+                open_file();
+                if (!_encoder_open)
+                    _failed.store(true, std::memory_order_relaxed);
+            }
+        }
+        read += count;
+        _read.store(read, std::memory_order_release);
+        _read.notify_one();
+    }
+}
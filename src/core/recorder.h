@@ -0,0 +1,131 @@
+//
+//
+
+#ifndef AARI_RECORDER_H
+#define AARI_RECORDER_H
+
+#include "../miniaudio.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace AAri {
+    /**
+     * Recording of interleaved float frames to 32 bit float WAV files, safe to feed from the audio thread.
+     *
+     * The audio thread copies frames into a single producer single consumer ring and nothing else, a writer
+     * thread encodes them and writes the file by chunks of CHUNK_FRAMES. A WAV file can't hold more than 4 GB
+     * (about 3 hours of 48 kHz stereo), so a long recording goes on in numbered files: take.wav, take_2.wav...
+     * Frames that don't fit in the ring are dropped and counted when recording in real time, offline renders
+     * wait for the writer instead.
+     */
+    class Recorder {
+    public:
+        // 11 s of 48 kHz audio
+        static constexpr size_t RING_FRAMES = size_t(1) << 19;
+        static constexpr size_t CHUNK_FRAMES = size_t(1) << 14;
+
+        /**
+         * Create the first file. Throws if it cannot be created
+         * @param max_file_frames frames per file, by default as many as fit in a WAV file
+         */
+        Recorder(const std::string &path, size_t channels, uint32_t sample_rate, uint64_t max_file_frames = 0);
+
+        // Writes what was pushed and closes the file
+        ~Recorder();
+
+        Recorder(const Recorder &) = delete;
+
+        Recorder &operator=(const Recorder &) = delete;
+
+        size_t channels() const {
+            return _channels;
+        }
+
+        /**
+         * Copy count frames to the ring. Audio thread
+         */
+        void push(const float *frames, size_t count, bool realtime);
+
+        /**
+         * Copy one frame to the ring without handing it to the writer yet, for frames gathered one at a time.
+         * Audio thread
+         */
+        void push_frame(const float *frame, bool realtime);
+
+        /**
+         * Hand the frames of push_frame to the writer. Audio thread
+         */
+        void publish();
+
+        uint64_t frames_written() const {
+            return _frames_written.load(std::memory_order_relaxed);
+        }
+
+        uint64_t dropped_frames() const {
+            return _dropped.load(std::memory_order_relaxed);
+        }
+
+        // Files created so far, including the first one
+        size_t files() const {
+            return _files.load(std::memory_order_relaxed);
+        }
+
+        // True once writing failed, e.g. the disk is full. What comes after is dropped
+        bool failed() const {
+            return _failed.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return the path of the index-th file of a recording to path, counting from 1
+         */
+        static std::string file_path(const std::string &path, size_t index);
+
+    private:
+        size_t space() const {
+            return RING_FRAMES - size_t(_write_local - _read.load(std::memory_order_acquire));
+        }
+
+        // Wait until the writer frees some of the ring, offline only
+        void wait_for_space();
+
+        void copy_in(const float *frames, size_t count);
+
+        void open_file();
+
+        void writer();
+
+        std::string _path;
+        size_t _channels;
+        uint32_t _sample_rate;
+        uint64_t _max_file_frames;
+        std::vector<float> _ring;
+
+        // Audio thread
+        uint64_t _write_local = 0;
+        uint64_t _notified = 0;
+
+        // Frames pushed and frames written, both only ever increase. Like SpscQueue but copying frames
+        // by blocks, and on separate cache lines so that the two threads don't fight over them
+        alignas(64) std::atomic<uint64_t> _write = 0;
+        alignas(64) std::atomic<uint64_t> _read = 0;
+        std::atomic<uint32_t> _wake = 0;
+        std::atomic<bool> _stop = false;
+
+        // Writer thread
+        ma_encoder _encoder{};
+        bool _encoder_open = false;
+        uint64_t _file_frames = 0;
+
+        std::atomic<uint64_t> _frames_written = 0;
+        std::atomic<uint64_t> _dropped = 0;
+        std::atomic<size_t> _files = 0;
+        std::atomic<bool> _failed = false;
+        std::thread _writer;
+    };
+}
+
+#endif //AARI_RECORDER_H
@@ -0,0 +1,226 @@
+//
+//
+
+#include "sample_stream.h"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace AAri;
+
+namespace {
+    /**
+     * The thread decoding ahead for all the streams, one chunk per stream and per pass so that a long file
+     * doesn't starve the others. It sleeps until a stream wakes it, never dies, and like the MemoryPool
+     * is never destroyed, so that streams can still be destroyed during static destruction.
+     *
+     * The streams are added with the registry locked, so the lock of the list is never held while decoding:
+     * each pass refills the streams still alive from a copy of the list, which keeps them alive until it is over.
+     */
+    class Streamer {
+    public:
+        static Streamer &instance() {
+            static auto* streamer = new Streamer();
+            return *streamer;
+        }
+
+        void add(const std::shared_ptr<SampleStream>&stream) {
+            std::lock_guard lock(_mutex);
+            _streams.push_back(stream);
+        }
+
+        void wake() {
+            _wake.fetch_add(1, std::memory_order_release);
+            _wake.notify_one();
+        }
+
+    private:
+        Streamer() {
+            std::thread([this]() { run(); }).detach();
+        }
+
+        void run() {
+            std::vector<std::shared_ptr<SampleStream>> streams;
+            while (true) {
+                const uint32_t seen = _wake.load(std::memory_order_acquire);
+                {
+                    std::lock_guard lock(_mutex);
+                    std::erase_if(_streams, [](const auto&stream) { return stream.expired(); });
+                    for (const auto&stream: _streams) {
+                        if (auto alive = stream.lock())
+                            streams.push_back(std::move(alive));
+                    }
+                }
+                bool work = false;
+                for (const auto&stream: streams)
+                    work |= stream->refill();
+                //The streams of removed players are destroyed here
+                streams.clear();
+                if (!work)
+                    _wake.wait(seen, std::memory_order_acquire);
+            }
+        }
+
+        std::vector<std::weak_ptr<SampleStream>> _streams;
+        std::mutex _mutex;
+        std::atomic<uint32_t> _wake = 0;
+    };
+}
+
+SampleFile::SampleFile(const std::string&path, uint32_t sample_rate, size_t preload_frames) : _path(path),
+    _sample_rate(sample_rate) {
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, sample_rate);
+    ma_decoder decoder;
+    if (ma_decoder_init_file(path.c_str(), &config, &decoder) != MA_SUCCESS)
+        throw std::runtime_error("Cannot decode audio file " + path);
+    _attack.resize(2 * preload_frames);
+    ma_uint64 read = 0;
+    const ma_result result = ma_decoder_read_pcm_frames(&decoder, _attack.data(), preload_frames, &read);
+    if (result != MA_SUCCESS && result != MA_AT_END) {
+        ma_decoder_uninit(&decoder);
+        throw std::runtime_error("Cannot decode audio file " + path);
+    }
+    _attack.resize(2 * read);
+    ma_uint64 length = 0;
+    if (read < preload_frames) {
+        _complete = true;
+        _length = read;
+    } else if (ma_decoder_get_length_in_pcm_frames(&decoder, &length) == MA_SUCCESS && length > 0) {
+        _length = length;
+    }
+    ma_decoder_uninit(&decoder);
+}
+
+SampleStream::SampleStream() : _ring(MemoryPool::instance().allocate(2 * RING_FRAMES)) {
+}
+
+std::shared_ptr<SampleStream> SampleStream::create() {
+    std::shared_ptr<SampleStream> stream(new SampleStream());
+    Streamer::instance().add(stream);
+    return stream;
+}
+
+SampleStream::~SampleStream() {
+    close_decoder();
+}
+
+void SampleStream::start(const SampleFile* file) {
+    _playing_file = file;
+    _playing = file != nullptr;
+    _position = 0;
+    _consumed.store(0, std::memory_order_relaxed);
+    _file.store(file, std::memory_order_relaxed);
+    _generation = (_generation + 1) & GENERATION_MASK;
+    _requested.store(_generation, std::memory_order_release);
+    Streamer::instance().wake();
+}
+
+void SampleStream::next(float&left, float&right, bool realtime) {
+    left = 0.0f;
+    right = 0.0f;
+    if (!_playing)
+        return;
+    const size_t attack_frames = _playing_file->attack_frames();
+    if (_position < attack_frames) {
+        left = _playing_file->attack()[2 * _position];
+        right = _playing_file->attack()[2 * _position + 1];
+        _position++;
+        return;
+    }
+
+    uint64_t filled = _filled.load(std::memory_order_acquire);
+    auto available = [&]() {
+        return generation_of(filled) == _generation && _position < (filled & FRAMES_MASK);
+    };
+    if (!available()) {
+        if (generation_of(filled) == _generation && (filled & END_FLAG) != 0) {
+            _playing = false;
+            return;
+        }
+        if (realtime) {
+            //Keep time: the frame is lost, not delayed
+            _underruns.fetch_add(1, std::memory_order_relaxed);
+            _position++;
+            _consumed.store(_position, std::memory_order_release);
+            return;
+        }
+        _consumed.store(_position, std::memory_order_release);
+        while (!available()) {
+            if (generation_of(filled) == _generation && (filled & END_FLAG) != 0) {
+                _playing = false;
+                return;
+            }
+            Streamer::instance().wake();
+            _filled.wait(filled, std::memory_order_acquire);
+            filled = _filled.load(std::memory_order_acquire);
+        }
+    }
+
+    const float* frame = _ring.data() + 2 * ((_position - attack_frames) % RING_FRAMES);
+    left = frame[0];
+    right = frame[1];
+    _position++;
+    //The frame read can now be overwritten
+    _consumed.store(_position, std::memory_order_release);
+    if ((_position - attack_frames) % CHUNK_FRAMES == 0)
+        Streamer::instance().wake();
+}
+
+bool SampleStream::refill() {
+    const uint32_t generation = _requested.load(std::memory_order_acquire);
+    if (generation != _stream_generation) {
+        _stream_generation = generation;
+        const SampleFile* file = _file.load(std::memory_order_relaxed);
+        if (file != _stream_file)
+            close_decoder();
+        _stream_file = file;
+        _end = true;
+        if (file == nullptr) {
+            _next = 0;
+            publish(true);
+            return true;
+        }
+        _next = file->attack_frames();
+        if (!file->complete()) {
+            if (!_decoder_open) {
+                ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, file->sample_rate());
+                _decoder_open = ma_decoder_init_file(file->path().c_str(), &config, &_decoder) == MA_SUCCESS;
+            }
+            //A file that can't be read any more, e.g. deleted since it was loaded, ends after its attack
+            _end = !_decoder_open || ma_decoder_seek_to_pcm_frame(&_decoder, _next) != MA_SUCCESS;
+        }
+        publish(_end);
+        return true;
+    }
+    if (_end)
+        return false;
+
+    const uint64_t attack_frames = _stream_file->attack_frames();
+    const uint64_t limit = std::max(_consumed.load(std::memory_order_acquire), attack_frames) + RING_FRAMES;
+    if (_next + CHUNK_FRAMES > limit)
+        return false;
+    float* chunk = _ring.data() + 2 * ((_next - attack_frames) % RING_FRAMES);
+    ma_uint64 read = 0;
+    const ma_result result = ma_decoder_read_pcm_frames(&_decoder, chunk, CHUNK_FRAMES, &read);
+    _next += read;
+    if (read < CHUNK_FRAMES || result != MA_SUCCESS) {
+        //Free the file handle until the next start
+        _end = true;
+        close_decoder();
+    }
+    publish(_end);
+    return true;
+}
+
+void SampleStream::publish(bool end) {
+    _filled.store(pack(_stream_generation, end, _next), std::memory_order_release);
+    _filled.notify_all();
+}
+
+void SampleStream::close_decoder() {
+    if (_decoder_open) {
+        ma_decoder_uninit(&_decoder);
+        _decoder_open = false;
+    }
+}
@@ -0,0 +1,166 @@
+//
+//
+
+#ifndef AARI_SAMPLE_STREAM_H
+#define AARI_SAMPLE_STREAM_H
+
+#include "memory_pool.h"
+#include "../miniaudio.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace AAri {
+    /**
+     * An audio file played from disk: only its first frames, the attack, are kept in memory, as stereo
+     * at the rate it was loaded for. The rest is decoded while it plays (see SampleStream).
+     */
+    class SampleFile {
+    public:
+        static constexpr uint64_t UNKNOWN_LENGTH = UINT64_MAX;
+
+        /**
+         * Decode the attack of a WAV, FLAC or MP3 file, resampled to sample_rate.
+         * Mono files are played on both channels, the channels after the first two are mixed into them.
+         * Throws if the file cannot be decoded
+         */
+        SampleFile(const std::string &path, uint32_t sample_rate, size_t preload_frames);
+
+        const std::string &path() const {
+            return _path;
+        }
+
+        uint32_t sample_rate() const {
+            return _sample_rate;
+        }
+
+        // In frames, UNKNOWN_LENGTH for formats that don't tell it without decoding the whole file
+        uint64_t length() const {
+            return _length;
+        }
+
+        // Interleaved stereo
+        const std::vector<float> &attack() const {
+            return _attack;
+        }
+
+        size_t attack_frames() const {
+            return _attack.size() / 2;
+        }
+
+        // True when the attack is the whole file, which then never touches the disk again
+        bool complete() const {
+            return _complete;
+        }
+
+    private:
+        std::string _path;
+        uint32_t _sample_rate;
+        uint64_t _length = UNKNOWN_LENGTH;
+        std::vector<float> _attack;
+        bool _complete = false;
+    };
+
+    /**
+     * Playback of SampleFiles for one player: the audio thread plays the attack from memory while a thread
+     * shared by all the streams decodes the rest ahead into a ring, so starting a note never waits for the disk.
+     *
+     * The audio thread only touches atomics and the ring. Each start begins a new generation: the streaming
+     * thread opens the file, seeks past the attack and fills the ring, tagging what it publishes with
+     * the generation so that frames of the previous file are never played.
+     * The streaming thread shares the ownership of the streams while it refills them, so the last owner
+     * may be that thread.
+     */
+    class SampleStream {
+    public:
+        // Frames of the ring, i.e. how far ahead the file is decoded, and of each read from the file
+        static constexpr size_t RING_FRAMES = size_t(1) << 15;
+        static constexpr size_t CHUNK_FRAMES = 4096;
+
+        /**
+         * A stream known to the streaming thread
+         */
+        static std::shared_ptr<SampleStream> create();
+
+        ~SampleStream();
+
+        SampleStream(const SampleStream &) = delete;
+
+        SampleStream &operator=(const SampleStream &) = delete;
+
+        /**
+         * Play file from its start, or stop when it is null. Audio thread
+         */
+        void start(const SampleFile *file);
+
+        /**
+         * Next frame of the file, 0 once it is over.
+         * When the ring is late an offline render waits for it, a real time one plays 0 and counts an underrun.
+         * Audio thread
+         */
+        void next(float &left, float &right, bool realtime);
+
+        bool playing() const {
+            return _playing;
+        }
+
+        size_t underruns() const {
+            return _underruns.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Decode one chunk ahead if the ring has room. Streaming thread
+         * @return true if there was something to do
+         */
+        bool refill();
+
+    private:
+        // What the streaming thread published: generation, end of file reached, and frames of the file available
+        static constexpr int FRAMES_BITS = 40;
+        static constexpr uint64_t FRAMES_MASK = (uint64_t(1) << FRAMES_BITS) - 1;
+        static constexpr uint64_t END_FLAG = uint64_t(1) << FRAMES_BITS;
+        static constexpr uint32_t GENERATION_MASK = (uint32_t(1) << (63 - FRAMES_BITS)) - 1;
+
+        static uint64_t pack(uint32_t generation, bool end, uint64_t frames) {
+            return (uint64_t(generation) << (FRAMES_BITS + 1)) | (end ? END_FLAG : 0) | frames;
+        }
+
+        static uint32_t generation_of(uint64_t packed) {
+            return uint32_t(packed >> (FRAMES_BITS + 1));
+        }
+
+        SampleStream();
+
+        void publish(bool end);
+
+        void close_decoder();
+
+        MemoryPool::Buffer _ring;
+
+        // Audio thread
+        const SampleFile *_playing_file = nullptr;
+        uint32_t _generation = 0;
+        uint64_t _position = 0;
+        bool _playing = false;
+        std::atomic<size_t> _underruns = 0;
+
+        // Shared
+        std::atomic<const SampleFile *> _file = nullptr;
+        std::atomic<uint32_t> _requested = 0;
+        std::atomic<uint64_t> _consumed = 0;
+        std::atomic<uint64_t> _filled = 0;
+
+        // Streaming thread
+        uint32_t _stream_generation = 0;
+        const SampleFile *_stream_file = nullptr;
+        uint64_t _next = 0;
+        bool _end = true;
+        ma_decoder _decoder{};
+        bool _decoder_open = false;
+    };
+}
+
+#endif //AARI_SAMPLE_STREAM_H
@@ -0,0 +1,669 @@
+//
+//
+
+#include "snapshot.h"
+#include "wires.h"
+#include "inputs_outputs.h"
+#include "../blocks/catalogue.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace AAri;
+using namespace AAri::snapshot;
+
+namespace {
+    /**
+     * Calls f with std::integral_constant<size_t, N> for each of the power of 2 port widths
+     * that are instantiated, until f returns true.
+     * @return true if f returned true for one of the widths
+     */
+    template<typename F>
+    bool for_each_width(F f) {
+        return f(std::integral_constant<size_t, 2>{}) ||
+               f(std::integral_constant<size_t, 4>{}) ||
+               f(std::integral_constant<size_t, 8>{}) ||
+               f(std::integral_constant<size_t, 16>{}) ||
+               f(std::integral_constant<size_t, 32>{});
+    }
+
+    template<size_t N>
+    std::array<float, N> read_array(const float* values) {
+        std::array<float, N> arr;
+        std::memcpy(arr.data(), values, N * sizeof(float));
+        return arr;
+    }
+
+    template<typename T>
+    const T* take(const char*&cursor, size_t count) {
+        auto* items = reinterpret_cast<const T *>(cursor);
+        cursor += count * sizeof(T);
+        return items;
+    }
+
+    KindName make_name(const char* name) {
+        KindName kind_name{};
+        std::strncpy(kind_name.name, name, NAME_SIZE - 1);
+        return kind_name;
+    }
+
+    /**
+     * Read only memory mapping of a whole file
+     */
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string&path) {
+#ifdef _WIN32
+            _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (_file == INVALID_HANDLE_VALUE)
+                throw std::runtime_error("Cannot open snapshot " + path);
+            LARGE_INTEGER size;
+            GetFileSizeEx(_file, &size);
+            _size = (size_t)size.QuadPart;
+            if (_size > 0) {
+                _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (_mapping != nullptr)
+                    _data = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+                if (_data == nullptr) {
+                    close();
+                    throw std::runtime_error("Cannot map snapshot " + path);
+                }
+            }
+#else
+            _fd = open(path.c_str(), O_RDONLY);
+            if (_fd < 0)
+                throw std::runtime_error("Cannot open snapshot " + path);
+            struct stat st{};
+            fstat(_fd, &st);
+            _size = (size_t)st.st_size;
+            if (_size > 0) {
+                _data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+                if (_data == MAP_FAILED) {
+                    _data = nullptr;
+                    close();
+                    throw std::runtime_error("Cannot map snapshot " + path);
+                }
+            }
+#endif
+        }
+
+        ~MappedFile() {
+            close();
+        }
+
+        MappedFile(const MappedFile&) = delete;
+
+        MappedFile&operator=(const MappedFile&) = delete;
+
+        [[nodiscard]] const char* data() const {
+            return static_cast<const char *>(_data);
+        }
+
+        [[nodiscard]] size_t size() const {
+            return _size;
+        }
+
+    private:
+        void close() {
+#ifdef _WIN32
+            if (_data != nullptr)
+                UnmapViewOfFile(_data);
+            if (_mapping != nullptr)
+                CloseHandle(_mapping);
+            if (_file != INVALID_HANDLE_VALUE)
+                CloseHandle(_file);
+            _mapping = nullptr;
+            _file = INVALID_HANDLE_VALUE;
+#else
+            if (_data != nullptr)
+                munmap(_data, _size);
+            if (_fd >= 0)
+                ::close(_fd);
+            _fd = -1;
+#endif
+            _data = nullptr;
+        }
+
+#ifdef _WIN32
+        HANDLE _file = INVALID_HANDLE_VALUE;
+        HANDLE _mapping = nullptr;
+#else
+        int _fd = -1;
+#endif
+        void* _data = nullptr;
+        size_t _size = 0;
+    };
+
+    /**
+     * Flat records of blocks and of the wires between them, shared by capture and save.
+     * port_indices maps the recorded ports to their index in the records.
+     */
+    Subgraph record(const entt::registry&registry, const std::vector<entt::entity>&block_ids,
+                    std::unordered_map<entt::entity, int32_t>&port_indices) {
+        Subgraph subgraph;
+        std::unordered_map<entt::entity, uint32_t> block_indices;
+        std::unordered_map<TransmitFuncPtr, uint32_t> transmit_indices;
+
+        auto add_values = [&](const float* data, size_t count) {
+            auto offset = (uint32_t)subgraph.values.size();
+            subgraph.values.insert(subgraph.values.end(), data, data + count);
+            return offset;
+        };
+
+        auto add_port = [&](entt::entity id) -> int32_t {
+            if (id == entt::null)
+                return NONE;
+            PortRecord port{};
+            if (auto* input = registry.try_get<Input1D>(id)) {
+                port = {PortKind::Input1D, 1, add_values(&input->value, 1)};
+            } else if (auto* output = registry.try_get<Output1D>(id)) {
+                port = {PortKind::Output1D, 1, add_values(&output->value, 1)};
+            } else if (auto* array = registry.try_get<InputArray>(id)) {
+                port = {PortKind::InputArray, (uint32_t)array->value.size(), add_values(array->value.data(),
+                                                                                       array->value.size())};
+            } else if (auto* output_array = registry.try_get<OutputArray>(id)) {
+                port = {PortKind::OutputArray, (uint32_t)output_array->value.size(),
+                        add_values(output_array->value.data(), output_array->value.size())};
+            } else if (auto* mixer_input = registry.try_get<MixerInput>(id)) {
+                //Nothing to store, the width is the number of slots
+                port = {PortKind::MixerInput, mixer_input->slots, (uint32_t)subgraph.values.size()};
+            } else {
+                bool found = for_each_width([&](auto width) {
+                    constexpr size_t N = decltype(width)::value;
+                    if (auto* input_nd = registry.try_get<InputND<N>>(id)) {
+                        port = {PortKind::InputND, N, add_values(input_nd->value.data(), N)};
+                    } else if (auto* stereo = registry.try_get<InputNDStereo<N>>(id)) {
+                        port = {PortKind::InputNDStereo, N, add_values(stereo->left.data(), N)};
+                        add_values(stereo->right.data(), N);
+                    } else if (auto* output_nd = registry.try_get<OutputND<N>>(id)) {
+                        port = {PortKind::OutputND, N, add_values(output_nd->value.data(), N)};
+                    } else {
+                        return false;
+                    }
+                    return true;
+                });
+                if (!found)
+                    throw std::runtime_error("Cannot record block, unknown input/output type");
+            }
+            auto index = (int32_t)subgraph.ports.size();
+            subgraph.ports.push_back(port);
+            port_indices[id] = index;
+            return index;
+        };
+
+        for (auto entity: block_ids) {
+            const auto&block = registry.get<Block>(entity);
+            int kind = find_block_kind(block);
+            if (kind < 0)
+                throw std::runtime_error("Cannot record block, block type is not in the catalogue");
+
+            BlockRecord record{};
+            record.kind = (uint32_t)kind;
+            for (size_t i = 0; i < N_INPUTS; i++)
+                record.inputs[i] = add_port(block.inputIds[i]);
+            for (size_t i = 0; i < N_OUTPUTS; i++)
+                record.outputs[i] = add_port(block.outputIds[i]);
+            block_indices[entity] = (uint32_t)subgraph.blocks.size();
+            subgraph.blocks.push_back(record);
+        }
+
+        for (auto entity: registry.view<Wire>()) {
+            const auto&wire = registry.get<Wire>(entity);
+            auto from = block_indices.find(wire.from_block);
+            auto to = block_indices.find(wire.to_block);
+            if (from == block_indices.end() || to == block_indices.end())
+                continue;
+
+            //Wires sharing a plain function share its entry, e.g. for the kind names of the files
+            uint32_t transmit_index = (uint32_t)subgraph.transmit_funcs.size();
+            auto* func = wire.transmitFunc.target<TransmitFuncPtr>();
+            if (func != nullptr && transmit_indices.contains(*func)) {
+                transmit_index = transmit_indices[*func];
+            } else {
+                if (func != nullptr)
+                    transmit_indices[*func] = transmit_index;
+                subgraph.transmit_funcs.push_back(wire.transmitFunc);
+            }
+
+            WireRecord record{};
+            record.from_block = from->second;
+            record.to_block = to->second;
+            //The ports are looked up on the blocks the wire connects, so that a record always names
+            //an input of to_block (and for mixers a slot of it) rather than whatever port has that id
+            const auto&from_outputs = registry.get<Block>(wire.from_block).outputIds;
+            const auto&to_inputs = registry.get<Block>(wire.to_block).inputIds;
+            if (std::find(from_outputs.begin(), from_outputs.end(), wire.from_output) == from_outputs.end() ||
+                std::find(to_inputs.begin(), to_inputs.end(), wire.to_input) == to_inputs.end())
+                throw std::runtime_error("Cannot record wire, its ports don't belong to the blocks it connects");
+            record.from_output = port_indices.at(wire.from_output);
+            record.to_input = port_indices.at(wire.to_input);
+            record.slot = wire.slot;
+            record.transmit_kind = transmit_index;
+            record.gain = wire.gain;
+            record.offset = wire.offset;
+            subgraph.wires.push_back(record);
+        }
+        return subgraph;
+    }
+
+    // The ports that have a bulk path in instantiate are handled there
+    void emplace_port(entt::registry&registry, entt::entity id, const PortRecord&port, const float* value) {
+        switch (port.kind) {
+            case PortKind::InputArray:
+                registry.emplace<InputArray>(id, std::vector<float>(value, value + port.width));
+                return;
+            case PortKind::OutputArray:
+                registry.emplace<OutputArray>(id, std::vector<float>(value, value + port.width));
+                return;
+            case PortKind::MixerInput:
+                registry.emplace<MixerInput>(id, port.width);
+                return;
+            default:
+                break;
+        }
+        bool valid = for_each_width([&](auto width) {
+            constexpr size_t N = decltype(width)::value;
+            if (port.width != N)
+                return false;
+            if (port.kind == PortKind::InputND)
+                registry.emplace<InputND<N>>(id, read_array<N>(value));
+            else if (port.kind == PortKind::InputNDStereo)
+                registry.emplace<InputNDStereo<N>>(id, read_array<N>(value), read_array<N>(value + N));
+            else if (port.kind == PortKind::OutputND)
+                registry.emplace<OutputND<N>>(id, read_array<N>(value));
+            else
+                return false;
+            return true;
+        });
+        if (!valid)
+            throw std::runtime_error("Unsupported input/output kind or width");
+    }
+
+    bool valid_port(const PortRecord&port) {
+        switch (port.kind) {
+            case PortKind::Input1D:
+            case PortKind::Output1D:
+                return port.width == 1;
+            case PortKind::InputArray:
+            case PortKind::OutputArray:
+            case PortKind::MixerInput:
+                return true;
+            case PortKind::InputND:
+            case PortKind::InputNDStereo:
+            case PortKind::OutputND:
+                return for_each_width([&](auto width) { return port.width == decltype(width)::value; });
+        }
+        return false;
+    }
+
+    /**
+     * Checks a port against one token of a catalogue port signature, see BlockKind.
+     */
+    bool port_matches(const PortRecord&port, std::string_view token, bool input) {
+        if (token == "f")
+            return port.kind == (input ? PortKind::Input1D : PortKind::Output1D);
+        if (token == "a")
+            return port.kind == (input ? PortKind::InputArray : PortKind::OutputArray);
+        if (token == "m")
+            return input && port.kind == PortKind::MixerInput;
+        if (token == "x")
+            return !input && (port.kind == PortKind::Output1D || (port.kind == PortKind::OutputND && port.width == 2));
+        if (token.starts_with('n'))
+            return port.kind == (input ? PortKind::InputND : PortKind::OutputND) &&
+                   token.substr(1) == std::to_string(port.width);
+        return false;
+    }
+
+    /**
+     * Checks port indices against the inputs (first) or the outputs side of a catalogue port signature.
+     * For a wire the output side comes first, its from_output is checked with first and input false.
+     * @return true if each index refers to a port of the kind that the function will get from the registry
+     */
+    bool ports_match(std::string_view signature, bool first, const int32_t* indices, size_t n,
+                     const PortRecord* ports, bool input) {
+        const size_t separator = signature.find(" / ");
+        std::string_view side = first ? signature.substr(0, separator) : signature.substr(separator + 3);
+        std::string_view token;
+        bool repeat = false;
+        size_t i = 0;
+        while (!side.empty() && !repeat) {
+            const size_t end = std::min(side.find(' '), side.size());
+            token = side.substr(0, end);
+            side.remove_prefix(std::min(end + 1, side.size()));
+            repeat = token.ends_with('*');
+            if (repeat)
+                token.remove_suffix(1);
+            else if (i >= n || indices[i] == NONE || !port_matches(ports[indices[i]], token, input))
+                return false;
+            else
+                i++;
+        }
+        for (; i < n; i++) {
+            if (indices[i] != NONE && !(repeat && port_matches(ports[indices[i]], token, input)))
+                return false;
+        }
+        return true;
+    }
+}
+
+Subgraph snapshot::capture(const entt::registry&registry, const std::vector<entt::entity>&blocks,
+                           const std::vector<entt::entity>&exposed_ports) {
+    std::unordered_map<entt::entity, int32_t> port_indices;
+    auto subgraph = record(registry, blocks, port_indices);
+    for (auto id: exposed_ports) {
+        auto it = port_indices.find(id);
+        if (it == port_indices.end())
+            throw std::runtime_error("Cannot capture subgraph, exposed port is not a port of its blocks");
+        subgraph.exposed_ports.push_back(it->second);
+    }
+    return subgraph;
+}
+
+std::vector<Instance> snapshot::instantiate(entt::registry&registry, const Subgraph&subgraph, size_t copies) {
+    const size_t n_ports = subgraph.ports.size();
+    const size_t n_blocks = subgraph.blocks.size();
+    const size_t n_wires = subgraph.wires.size();
+    std::vector<entt::entity> port_ids(n_ports * copies);
+    std::vector<entt::entity> block_ids(n_blocks * copies);
+    std::vector<entt::entity> wire_ids(n_wires * copies);
+    registry.create(port_ids.begin(), port_ids.end());
+    registry.create(block_ids.begin(), block_ids.end());
+    registry.create(wire_ids.begin(), wire_ids.end());
+
+    try {
+        // Ports, the 1D ones are most of them and go in bulk
+        std::vector<entt::entity> input_ids;
+        std::vector<Input1D> inputs;
+        std::vector<entt::entity> output_ids;
+        std::vector<Output1D> outputs;
+        for (size_t c = 0; c < copies; c++) {
+            const auto* ids = port_ids.data() + c * n_ports;
+            for (size_t i = 0; i < n_ports; i++) {
+                const auto&port = subgraph.ports[i];
+                const float* value = subgraph.values.data() + port.value_offset;
+                if (port.kind == PortKind::Input1D) {
+                    input_ids.push_back(ids[i]);
+                    inputs.emplace_back(value[0]);
+                } else if (port.kind == PortKind::Output1D) {
+                    output_ids.push_back(ids[i]);
+                    outputs.emplace_back(value[0]);
+                } else {
+                    emplace_port(registry, ids[i], port, value);
+                }
+            }
+        }
+        registry.insert<Input1D>(input_ids.begin(), input_ids.end(), inputs.begin());
+        registry.insert<Output1D>(output_ids.begin(), output_ids.end(), outputs.begin());
+
+        // Blocks
+        const auto&kinds = block_kinds();
+        std::vector<Block> blocks;
+        blocks.reserve(block_ids.size());
+        for (size_t c = 0; c < copies; c++) {
+            const auto* ids = port_ids.data() + c * n_ports;
+            auto port_id = [&](int32_t index) {
+                return index == NONE ? (entt::entity)entt::null : ids[index];
+            };
+            for (const auto&record: subgraph.blocks) {
+                const auto&kind = kinds[record.kind];
+                Block block{};
+                for (size_t j = 0; j < N_INPUTS; j++)
+                    block.inputIds[j] = port_id(record.inputs[j]);
+                for (size_t j = 0; j < N_OUTPUTS; j++)
+                    block.outputIds[j] = port_id(record.outputs[j]);
+                block.type = kind.type;
+                block.processFunc = kind.processFunc;
+                block.viewFunc = kind.viewFunc;
+                blocks.push_back(block);
+            }
+        }
+        registry.insert<Block>(block_ids.begin(), block_ids.end(), blocks.begin());
+        registry.insert<Visited>(block_ids.begin(), block_ids.end(), Visited{Visited::UNVISITED});
+        registry.insert<WiresToBlock>(block_ids.begin(), block_ids.end());
+        for (size_t c = 0; c < copies; c++) {
+            for (size_t i = 0; i < n_blocks; i++) {
+                const auto&kind = kinds[subgraph.blocks[i].kind];
+                if (kind.setupFunc != nullptr)
+                    kind.setupFunc(registry, block_ids[c * n_blocks + i]);
+            }
+        }
+
+        // Wires, emplaced directly: the records come from a valid graph,
+        // and it is up to the caller to sort the graph
+        std::vector<Wire> wires;
+        wires.reserve(wire_ids.size());
+        for (size_t c = 0; c < copies; c++) {
+            const auto* ids = port_ids.data() + c * n_ports;
+            const auto* copy_blocks = block_ids.data() + c * n_blocks;
+            for (const auto&record: subgraph.wires) {
+                wires.push_back({copy_blocks[record.from_block], copy_blocks[record.to_block],
+                                 ids[record.from_output], ids[record.to_input], record.gain, record.offset,
+                                 subgraph.transmit_funcs[record.transmit_kind], record.slot});
+            }
+        }
+        registry.insert<Wire>(wire_ids.begin(), wire_ids.end(), wires.begin());
+    } catch (...) {
+        //Leave the registry as it was
+        for (const auto* ids: {&port_ids, &block_ids, &wire_ids}) {
+            for (auto id: *ids) {
+                if (registry.valid(id))
+                    registry.destroy(id);
+            }
+        }
+        throw;
+    }
+
+    std::vector<Instance> instances(copies);
+    for (size_t c = 0; c < copies; c++) {
+        auto&instance = instances[c];
+        instance.blocks.assign(block_ids.begin() + c * n_blocks, block_ids.begin() + (c + 1) * n_blocks);
+        instance.wires.assign(wire_ids.begin() + c * n_wires, wire_ids.begin() + (c + 1) * n_wires);
+        for (auto index: subgraph.exposed_ports)
+            instance.ports.push_back(port_ids[c * n_ports + index]);
+    }
+    return instances;
+}
+
+void snapshot::save(const entt::registry&registry, entt::entity output_id, size_t output_width,
+                    const std::string&path) {
+    // Blocks, in the order they are processed
+    std::vector<entt::entity> block_ids;
+    for (auto entity: registry.view<Block>())
+        block_ids.push_back(entity);
+    std::unordered_map<entt::entity, int32_t> port_indices;
+    auto subgraph = record(registry, block_ids, port_indices);
+
+    // Only the kinds that are used are named in the file, the records refer to them by index
+    std::vector<KindName> block_kind_names;
+    std::vector<KindName> transmit_kind_names;
+    std::unordered_map<uint32_t, uint32_t> block_kind_indices;
+    for (auto&block: subgraph.blocks) {
+        if (!block_kind_indices.contains(block.kind)) {
+            block_kind_indices[block.kind] = (uint32_t)block_kind_names.size();
+            block_kind_names.push_back(make_name(block_kinds()[block.kind].name));
+        }
+        block.kind = block_kind_indices[block.kind];
+    }
+    for (const auto&func: subgraph.transmit_funcs) {
+        Wire wire;
+        wire.transmitFunc = func;
+        int kind = find_transmit_kind(wire);
+        if (kind < 0)
+            throw std::runtime_error("Cannot save snapshot, wire transmit function is not in the catalogue");
+        transmit_kind_names.push_back(make_name(transmit_kinds()[kind].name));
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.n_block_kinds = (uint32_t)block_kind_names.size();
+    header.n_transmit_kinds = (uint32_t)transmit_kind_names.size();
+    header.n_ports = (uint32_t)subgraph.ports.size();
+    header.n_blocks = (uint32_t)subgraph.blocks.size();
+    header.n_wires = (uint32_t)subgraph.wires.size();
+    header.n_values = (uint32_t)subgraph.values.size();
+    header.output_port = NONE;
+    header.output_width = 0;
+    if (output_width > 0 && port_indices.contains(output_id)) {
+        header.output_port = port_indices[output_id];
+        header.output_width = (uint32_t)output_width;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw std::runtime_error("Cannot open " + path + " for writing");
+    auto write = [&](const auto&items) {
+        out.write(reinterpret_cast<const char *>(items.data()),
+                  (std::streamsize)(items.size() * sizeof(items[0])));
+    };
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    write(block_kind_names);
+    write(transmit_kind_names);
+    write(subgraph.ports);
+    write(subgraph.blocks);
+    write(subgraph.wires);
+    write(subgraph.values);
+    if (!out)
+        throw std::runtime_error("Failed writing snapshot " + path);
+}
+
+LoadedGraph snapshot::load(entt::registry&registry, const std::string&path) {
+    MappedFile file(path);
+    if (file.size() < sizeof(SnapshotHeader))
+        throw std::runtime_error("Invalid snapshot " + path + ": file too small");
+
+    const char* cursor = file.data();
+    const auto* header = reinterpret_cast<const SnapshotHeader *>(cursor);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error("Invalid snapshot " + path + ": bad magic");
+    if (header->version != VERSION)
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(header->version));
+
+    const size_t expected_size = sizeof(SnapshotHeader)
+                                 + (size_t)header->n_block_kinds * sizeof(KindName)
+                                 + (size_t)header->n_transmit_kinds * sizeof(KindName)
+                                 + (size_t)header->n_ports * sizeof(PortRecord)
+                                 + (size_t)header->n_blocks * sizeof(BlockRecord)
+                                 + (size_t)header->n_wires * sizeof(WireRecord)
+                                 + (size_t)header->n_values * sizeof(float);
+    if (file.size() != expected_size)
+        throw std::runtime_error("Invalid snapshot " + path + ": size does not match header");
+
+    cursor += sizeof(SnapshotHeader);
+    const auto* block_kind_names = take<KindName>(cursor, header->n_block_kinds);
+    const auto* transmit_kind_names = take<KindName>(cursor, header->n_transmit_kinds);
+    const auto* ports = take<PortRecord>(cursor, header->n_ports);
+    const auto* blocks = take<BlockRecord>(cursor, header->n_blocks);
+    const auto* wires = take<WireRecord>(cursor, header->n_wires);
+    const auto* values = take<float>(cursor, header->n_values);
+
+    auto corrupt = [&]() {
+        return std::runtime_error("Invalid snapshot " + path + ": corrupt record");
+    };
+
+    // Resolve the names to the catalogue of this build
+    std::vector<uint32_t> file_block_kinds;
+    for (uint32_t i = 0; i < header->n_block_kinds; i++) {
+        std::string name(block_kind_names[i].name, strnlen(block_kind_names[i].name, NAME_SIZE));
+        int kind = find_block_kind(name);
+        if (kind < 0)
+            throw std::runtime_error("Unknown block kind in snapshot: " + name);
+        file_block_kinds.push_back((uint32_t)kind);
+    }
+    Subgraph subgraph;
+    std::vector<uint32_t> file_transmit_kinds;
+    for (uint32_t i = 0; i < header->n_transmit_kinds; i++) {
+        std::string name(transmit_kind_names[i].name, strnlen(transmit_kind_names[i].name, NAME_SIZE));
+        int kind = find_transmit_kind(name);
+        if (kind < 0)
+            throw std::runtime_error("Unknown wire transmit function in snapshot: " + name);
+        subgraph.transmit_funcs.emplace_back(transmit_kinds()[kind].transmitFunc);
+        file_transmit_kinds.push_back((uint32_t)kind);
+    }
+
+    // Check the records before anything is added to the registry
+    auto has_port = [](const auto&ports, int32_t index) {
+        return std::find(std::begin(ports), std::end(ports), index) != std::end(ports);
+    };
+    auto valid_index = [&](int32_t index) {
+        return index == NONE || (index >= 0 && (uint32_t)index < header->n_ports);
+    };
+    for (uint32_t i = 0; i < header->n_ports; i++) {
+        const auto&port = ports[i];
+        size_t n_values = port.kind == PortKind::InputNDStereo ? 2 * port.width : port.width;
+        if (port.kind == PortKind::MixerInput)
+            n_values = 0;
+        if (!valid_port(port) || (size_t)port.value_offset + n_values > header->n_values)
+            throw corrupt();
+    }
+    subgraph.blocks.assign(blocks, blocks + header->n_blocks);
+    for (auto&record: subgraph.blocks) {
+        if (record.kind >= header->n_block_kinds ||
+            !std::all_of(std::begin(record.inputs), std::end(record.inputs), valid_index) ||
+            !std::all_of(std::begin(record.outputs), std::end(record.outputs), valid_index))
+            throw corrupt();
+        record.kind = file_block_kinds[record.kind];
+        //The blocks get their ports from the registry by type, a mismatch would crash them
+        const char* signature = block_kinds()[record.kind].ports;
+        if (!ports_match(signature, true, record.inputs, N_INPUTS, ports, true) ||
+            !ports_match(signature, false, record.outputs, N_OUTPUTS, ports, false))
+            throw corrupt();
+    }
+    for (uint32_t i = 0; i < header->n_wires; i++) {
+        const auto&record = wires[i];
+        if (record.from_block >= header->n_blocks || record.to_block >= header->n_blocks ||
+            record.transmit_kind >= header->n_transmit_kinds || record.from_output == NONE ||
+            record.to_input == NONE || !valid_index(record.from_output) || !valid_index(record.to_input))
+            throw corrupt();
+        if (!has_port(subgraph.blocks[record.from_block].outputs, record.from_output) ||
+            !has_port(subgraph.blocks[record.to_block].inputs, record.to_input))
+            throw corrupt();
+        const char* signature = transmit_kinds()[file_transmit_kinds[record.transmit_kind]].ports;
+        if (!ports_match(signature, true, &record.from_output, 1, ports, false) ||
+            !ports_match(signature, false, &record.to_input, 1, ports, true))
+            throw corrupt();
+        //Only the slots of a mixer input are told apart
+        const auto&to_port = ports[record.to_input];
+        if (to_port.kind == PortKind::MixerInput ? record.slot >= to_port.width : record.slot != 0)
+            throw corrupt();
+    }
+    if (!valid_index(header->output_port))
+        throw corrupt();
+    if (header->output_port != NONE) {
+        //The engine reads the output as an Output1D or an OutputND of the output width
+        const auto&port = ports[header->output_port];
+        const bool output_1d = header->output_width == 1 && port.kind == PortKind::Output1D;
+        if (!output_1d && (port.kind != PortKind::OutputND || port.width != header->output_width))
+            throw corrupt();
+    }
+
+    subgraph.ports.assign(ports, ports + header->n_ports);
+    subgraph.wires.assign(wires, wires + header->n_wires);
+    subgraph.values.assign(values, values + header->n_values);
+    if (header->output_port != NONE)
+        subgraph.exposed_ports.push_back(header->output_port);
+
+    auto instance = std::move(instantiate(registry, subgraph, 1)[0]);
+    LoadedGraph loaded;
+    loaded.blocks = std::move(instance.blocks);
+    loaded.wires = std::move(instance.wires);
+    if (header->output_port != NONE) {
+        loaded.output_id = instance.ports[0];
+        loaded.output_width = header->output_width;
+    }
+    return loaded;
+}
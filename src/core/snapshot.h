@@ -0,0 +1,155 @@
+//
+//
+
+#ifndef AARI_SNAPSHOT_H
+#define AARI_SNAPSHOT_H
+
+#include <entt/entt.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "blocks.h"
+#include "wires.h"
+
+namespace AAri {
+    /**
+     * Binary graph snapshot format.
+     *
+     * The file is a header followed by flat arrays of fixed size records, so that loading
+     * is a matter of mapping the file and walking the arrays:
+     *
+     *   SnapshotHeader
+     *   KindName[n_block_kinds]      names of the block kinds used (see catalogue.h)
+     *   KindName[n_transmit_kinds]   names of the wire transmit functions used
+     *   PortRecord[n_ports]          inputs and outputs, values are in the float pool
+     *   BlockRecord[n_blocks]        in topological order
+     *   WireRecord[n_wires]
+     *   float[n_values]              pool of input / output values
+     *
+     * All the values are stored in native byte order.
+     */
+    namespace snapshot {
+        constexpr char MAGIC[4] = {'A', 'A', 'R', 'I'};
+        constexpr uint32_t VERSION = 2;
+        constexpr size_t NAME_SIZE = 48;
+        constexpr int32_t NONE = -1;
+
+        enum class PortKind : uint32_t {
+            Input1D,
+            Output1D,
+            InputND,
+            InputNDStereo,
+            OutputND,
+            InputArray,
+            OutputArray,
+            // No values, the width is the number of slots
+            MixerInput,
+        };
+
+        struct SnapshotHeader {
+            char magic[4];
+            uint32_t version;
+            uint32_t n_block_kinds;
+            uint32_t n_transmit_kinds;
+            uint32_t n_ports;
+            uint32_t n_blocks;
+            uint32_t n_wires;
+            uint32_t n_values;
+            int32_t output_port;
+            uint32_t output_width;
+        };
+
+        struct KindName {
+            char name[NAME_SIZE];
+        };
+
+        struct PortRecord {
+            PortKind kind;
+            uint32_t width;
+            uint32_t value_offset;
+        };
+
+        struct BlockRecord {
+            uint32_t kind;
+            int32_t inputs[N_INPUTS];
+            int32_t outputs[N_OUTPUTS];
+        };
+
+        struct WireRecord {
+            uint32_t from_block;
+            uint32_t to_block;
+            int32_t from_output;
+            int32_t to_input;
+            // Slot of to_input when it is a MixerInput, 0 otherwise
+            uint32_t slot;
+            uint32_t transmit_kind;
+            float gain;
+            float offset;
+        };
+
+        /**
+         * Blocks and internal wires kept in memory with the same flat records as the files,
+         * so that they can be stamped out many times (see instantiate). Unlike the files
+         * the wires keep their transmit functions, so any wire can be part of a subgraph.
+         */
+        struct Subgraph {
+            std::vector<PortRecord> ports;
+            // kind is an index in block_kinds() (see catalogue.h)
+            std::vector<BlockRecord> blocks;
+            // transmit_kind is an index in transmit_funcs
+            std::vector<WireRecord> wires;
+            std::vector<TransmitFunc> transmit_funcs;
+            std::vector<float> values;
+            // Indices in ports of the ports callers want back from each copy
+            std::vector<int32_t> exposed_ports;
+        };
+
+        /**
+         * Entities of one copy of a subgraph, in the same order as the records
+         */
+        struct Instance {
+            std::vector<entt::entity> blocks;
+            std::vector<entt::entity> wires;
+            std::vector<entt::entity> ports;
+        };
+
+        /**
+         * Record blocks, the wires between them and their current input / output values.
+         * Wires from or to blocks outside of the set are left out, the exposed ports are there
+         * to connect the copies to the rest of the graph.
+         * Throws if a block is not in the catalogue or an exposed port doesn't belong to the blocks.
+         */
+        Subgraph capture(const entt::registry &registry, const std::vector<entt::entity> &blocks,
+                         const std::vector<entt::entity> &exposed_ports = {});
+
+        /**
+         * Add copies of a subgraph to the registry. The components of all the copies are inserted
+         * kind by kind in bulk rather than block by block.
+         * The caller is responsible for locking the registry and sorting the graph afterwards.
+         */
+        std::vector<Instance> instantiate(entt::registry &registry, const Subgraph &subgraph, size_t copies);
+
+        struct LoadedGraph {
+            // Blocks in the order they were stored, i.e. topological order
+            std::vector<entt::entity> blocks;
+            std::vector<entt::entity> wires;
+            entt::entity output_id = entt::null;
+            size_t output_width = 0;
+        };
+
+        /**
+         * Write all the blocks and wires of the registry to path.
+         * Throws if a block or wire has no entry in the catalogue (e.g. python transmit functions).
+         */
+        void save(const entt::registry &registry, entt::entity output_id, size_t output_width,
+                  const std::string &path);
+
+        /**
+         * Add the content of the snapshot at path to the registry.
+         * The caller is responsible for locking the registry and sorting the graph afterwards.
+         */
+        LoadedGraph load(entt::registry &registry, const std::string &path);
+    }
+}
+
+#endif //AARI_SNAPSHOT_H
@@ -4,6 +4,9 @@
 #ifndef AARI_DATA_STRUCTURES_H
 #define AARI_DATA_STRUCTURES_H
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <string>
 #include <exception>
 #include <vector>
@@ -52,6 +55,51 @@ public:
     std::vector<T> _items;
 };
 
+template<typename T>
+class SpscQueue {
+    /** Lock free single producer, single consumer ring buffer, e.g. to pass events
+     * to the audio thread without locking the registry. The capacity is rounded up to a power of 2.
+     * push must only be called from one thread at a time, and pop from one (other) thread.
+     */
+public:
+    explicit SpscQueue(size_t capacity) : _items(std::bit_ceil(std::max<size_t>(capacity, 2))) {
+    }
+
+    // @return false, without blocking, when the queue is full
+    bool push(const T &item) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == _items.size())
+            return false;
+        _items[tail & (_items.size() - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // @return false when the queue is empty
+    bool pop(T &item) {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire))
+            return false;
+        item = _items[head & (_items.size() - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] size_t capacity() const {
+        return _items.size();
+    }
+
+private:
+    std::vector<T> _items;
+    // On separate cache lines so that the two threads don't fight over them
+    alignas(64) std::atomic<size_t> _head{0};
+    alignas(64) std::atomic<size_t> _tail{0};
+};
+
 template<size_t N, typename... Args>
 auto fill_with_null(Args... args) {
     std::array<entt::entity, N> arr = {args...};
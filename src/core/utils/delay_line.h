@@ -0,0 +1,101 @@
+//
+//
+
+#ifndef AARI_DELAY_LINE_H
+#define AARI_DELAY_LINE_H
+
+#include <algorithm>
+#include <cstddef>
+#include "../memory_pool.h"
+
+namespace AAri {
+    /**
+     * Ring buffer of a power of two length in MemoryPool memory, read at fractional delays.
+     *
+     * The first GUARD samples of the ring are mirrored after its end, like the guard points of the
+     * wavetables, so that the 4 points of the cubic interpolation are always contiguous in memory:
+     * a read is one masked index and 4 consecutive loads, whatever the delay.
+     * Kept as a component, the memory goes back to the pool with the entity.
+     */
+    struct DelayLine {
+        static constexpr size_t GUARD = 3;
+        // In samples. The interpolation reads one sample newer than the delay
+        static constexpr float MIN_DELAY = 2.0f;
+
+        MemoryPool::Buffer memory;
+        size_t mask = 0;
+        // Where the next sample is written
+        size_t position = 0;
+        // Number of zeros written in a row, the line is silent once they fill it
+        size_t zeros = 0;
+        // Free for the blocks, e.g. the damping filter of a comb
+        float state = 0.0f;
+
+        DelayLine() = default;
+
+        /**
+         * @param length power of two, see length_for
+         */
+        explicit DelayLine(size_t length) : memory(MemoryPool::instance().allocate(length + GUARD)),
+                                            mask(length - 1) {
+        }
+
+        /**
+         * @return the smallest power of two length for delays up to max_delay samples
+         */
+        static size_t length_for(float max_delay) {
+            size_t length = 16;
+            while (float(length) < max_delay + MIN_DELAY + float(GUARD))
+                length *= 2;
+            return length;
+        }
+
+        size_t length() const {
+            return mask + 1;
+        }
+
+        float max_delay() const {
+            return float(length() - GUARD - 1);
+        }
+
+        bool is_silent() const {
+            return zeros >= length();
+        }
+
+        void write(float x) {
+            float* data = memory.data();
+            data[position] = x;
+            if (position < GUARD)
+                data[position + length()] = x;
+            position = (position + 1) & mask;
+            zeros = x == 0.0f ? zeros + 1 : 0;
+        }
+
+        /**
+         * Read a whole number of samples ago, without interpolation, before writing the current sample
+         * @param delay in [1, length()]
+         */
+        float tap(size_t delay) const {
+            return memory.data()[(position - delay) & mask];
+        }
+
+        /**
+         * Read before writing the current sample
+         * @param delay in samples, clamped to [MIN_DELAY, max_delay()]
+         */
+        float read(float delay) const {
+            delay = std::clamp(delay, MIN_DELAY, max_delay());
+            const auto whole = size_t(delay);
+            const float frac = delay - float(whole);
+            //Oldest of the 4 points, the newest one is delay - 1 samples ago
+            const float* p = memory.data() + ((position - whole - 2) & mask);
+            //Catmull-Rom from p[2] (whole samples ago) to p[1] (whole + 1 samples ago)
+            const float c1 = 0.5f * (p[1] - p[3]);
+            const float c2 = p[3] - 2.5f * p[2] + 2.0f * p[1] - 0.5f * p[0];
+            const float c3 = 0.5f * (p[0] - p[3]) + 1.5f * (p[2] - p[1]);
+            return ((c3 * frac + c2) * frac + c1) * frac + p[2];
+        }
+    };
+}
+
+#endif //AARI_DELAY_LINE_H
@@ -0,0 +1,72 @@
+//
+//
+
+#ifndef AARI_ENVELOPE_H
+#define AARI_ENVELOPE_H
+
+#include <algorithm>
+#include "fast_math.h"
+#include "../kernels/kernels.h"
+
+/**
+ * ADSR envelopes made of one-pole exponential segments, as analog envelopes are.
+ * Each segment aims a bit past its end (see the ratios) so that it actually gets there in the set time,
+ * and the level is clamped when it does. A sample is then a select of the stage's coefficients
+ * and one multiply-add, which vectorises across voices.
+ */
+namespace AAri::envelope {
+    // Stages are floats so that they can be stored in inputs
+    constexpr float RELEASE = 0.0f; // also idle once the level is 0
+    constexpr float ATTACK = 1.0f;
+    constexpr float DECAY = 2.0f;   // then sustain
+
+    // How far past 1 the attack aims, relative to its range. Lower is more exponential
+    constexpr float ATTACK_RATIO = 0.3f;
+    // Same for the decay and release, small enough to sound exponential to the end (-80 dB)
+    constexpr float DECAY_RATIO = 1e-4f;
+    // log((1 + ratio) / ratio), the number of time constants in a segment
+    constexpr float ATTACK_TIME_CONSTANTS = 1.4663371f;
+    constexpr float DECAY_TIME_CONSTANTS = 9.2104404f;
+}
+
+namespace AAri::envelope::inline AARI_SIMD_NAMESPACE {
+    /**
+     * Coefficient of a one-pole segment covering its range in time seconds
+     */
+    inline float coefficient(float time, float time_constants, float sample_rate) {
+        const float samples = std::max(time * sample_rate, 1.0f);
+        return 1.0f - fast_math::exp(-time_constants / samples);
+    }
+
+    inline AdsrCoefficients adsr_coefficients(float attack, float decay, float sustain, float release,
+                                              float sample_rate) {
+        sustain = std::clamp(sustain, 0.0f, 1.0f);
+        return {
+            coefficient(attack, ATTACK_TIME_CONSTANTS, sample_rate),
+            1.0f + ATTACK_RATIO,
+            coefficient(decay, DECAY_TIME_CONSTANTS, sample_rate),
+            sustain - DECAY_RATIO,
+            sustain,
+            coefficient(release, DECAY_TIME_CONSTANTS, sample_rate),
+            -DECAY_RATIO,
+        };
+    }
+
+    /**
+     * One sample of an envelope: gate > 0 holds it on, stage is updated in place.
+     * @return the new level
+     */
+    inline float step(float gate, float&stage, float level, const AdsrCoefficients&c) {
+        //A new gate restarts the attack from the current level
+        const float current = gate > 0.0f ? (stage == RELEASE ? ATTACK : stage) : RELEASE;
+        const float target = current == ATTACK ? c.attack_target : (current == DECAY ? c.decay_target : c.release_target);
+        const float coef = current == ATTACK ? c.attack : (current == DECAY ? c.decay : c.release);
+        const float next = level + (target - level) * coef;
+        const bool peaked = current == ATTACK && next >= 1.0f;
+        const float floor = current == DECAY ? c.sustain : 0.0f;
+        stage = peaked ? DECAY : current;
+        return peaked ? 1.0f : std::max(next, floor);
+    }
+}
+
+#endif //AARI_ENVELOPE_H
@@ -0,0 +1,40 @@
+//
+//
+
+#include "fast_math.h"
+#include "../kernels/kernels.h"
+
+using namespace AAri;
+
+template<fast_math::Accuracy A>
+void fast_math::sin2pi_array(const float *in, float *out, size_t n) {
+    kernels().sin2pi[(size_t)A](in, out, n);
+}
+
+template<fast_math::Accuracy A>
+void fast_math::cos2pi_array(const float *in, float *out, size_t n) {
+    kernels().cos2pi[(size_t)A](in, out, n);
+}
+
+template<fast_math::Accuracy A>
+void fast_math::exp2_array(const float *in, float *out, size_t n) {
+    kernels().exp2[(size_t)A](in, out, n);
+}
+
+template<fast_math::Accuracy A>
+void fast_math::tanh_array(const float *in, float *out, size_t n) {
+    kernels().tanh[(size_t)A](in, out, n);
+}
+
+//Explicit template instantiation for all accuracies
+#define AARI_INSTANTIATE_ARRAY_KERNELS(A) \
+    template void fast_math::sin2pi_array<A>(const float *in, float *out, size_t n); \
+    template void fast_math::cos2pi_array<A>(const float *in, float *out, size_t n); \
+    template void fast_math::exp2_array<A>(const float *in, float *out, size_t n); \
+    template void fast_math::tanh_array<A>(const float *in, float *out, size_t n);
+
+AARI_INSTANTIATE_ARRAY_KERNELS(fast_math::Accuracy::Low)
+
+AARI_INSTANTIATE_ARRAY_KERNELS(fast_math::Accuracy::Medium)
+
+AARI_INSTANTIATE_ARRAY_KERNELS(fast_math::Accuracy::High)
@@ -0,0 +1,169 @@
+//
+//
+
+#ifndef AARI_FAST_MATH_H
+#define AARI_FAST_MATH_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Polynomial approximations of the transcendental functions used in the blocks.
+ *
+ * Everything is branch free (comparisons become masks, rounding is done through int conversions)
+ * so that the array versions are vectorised by the compiler, and they are cheap enough per sample
+ * for the scalar versions to beat libm too.
+ *
+ * Max absolute errors over the supported range:
+ *   Accuracy::Low     ~1e-4
+ *   Accuracy::Medium  ~1e-6
+ *   Accuracy::High    a few float ulps
+ */
+//kernels/kernels_<level>.cpp compile this with other instruction sets, each in its own namespace
+//so that the linker can't mix up their out of line copies
+#ifndef AARI_SIMD_NAMESPACE
+#define AARI_SIMD_NAMESPACE generic
+#endif
+
+namespace AAri::fast_math {
+    enum class Accuracy {
+        Low,
+        Medium,
+        High,
+    };
+
+    constexpr float TWO_PI = 6.2831853f;
+    constexpr float INV_TWO_PI = 0.15915494f;
+    constexpr float LOG2E = 1.4426950f;
+}
+
+namespace AAri::fast_math::inline AARI_SIMD_NAMESPACE {
+
+    namespace detail {
+        //Minimax coefficients of sin(2 pi r) on r in [-1/4, 1/4], odd powers of r
+        template<Accuracy A>
+        inline float sin2pi_quarter(float r) {
+            const float r2 = r * r;
+            if constexpr (A == Accuracy::Low) {
+                return r * (6.28128004f + r2 * (-41.0952377f + r2 * 73.5854187f));
+            } else if constexpr (A == Accuracy::Medium) {
+                return r * (6.28316402f + r2 * (-41.3371429f + r2 * (81.3407669f + r2 * -70.9933853f)));
+            } else {
+                return r * (6.28318501f + r2 * (-41.3416557f + r2 * (81.6010056f + r2 * (-76.5497665f +
+                                                                                       r2 * 39.5366058f))));
+            }
+        }
+
+        //Minimax coefficients of 2^f on f in [-1/2, 1/2] (relative error)
+        template<Accuracy A>
+        inline float exp2_fraction(float f) {
+            if constexpr (A == Accuracy::Low) {
+                return 0.999928057f + f * (0.693261027f + f * (0.242611229f + f * 0.0551716425f));
+            } else if constexpr (A == Accuracy::Medium) {
+                return 0.999999285f + f * (0.693121791f + f * (0.240247443f + f * (0.0559178777f +
+                                                                                     f * 0.00957009848f)));
+            } else {
+                return 1.00000012f + f * (0.693146944f + f * (0.240221202f + f * (0.0555071346f +
+                                                                                   f * (0.00967554282f +
+                                                                                        f * 0.00132764690f))));
+            }
+        }
+    }
+
+    /**
+     * x - trunc(x), same as fmodf(x, 1.0f) (e.g. to wrap phases). Floats of 2^23 and more are whole,
+     * so they are not cast, which would overflow int32 from 2^31
+     */
+    inline float fraction(float x) {
+        return std::abs(x) < 8388608.0f ? x - float(int32_t(x)) : 0.0f;
+    }
+
+    /**
+     * sin(2 pi x), i.e. x is in turns, which is what oscillators have at hand.
+     * Accurate for |x| < 2^22, the fractional part of larger floats is too coarse anyway.
+     */
+    template<Accuracy A = Accuracy::High>
+    inline float sin2pi(float x) {
+        //Reduce to [-1/2, 1/2] then use sin(pi - t) = sin(t) to fold into [-1/4, 1/4]
+        float r = fraction(x);
+        r -= float(r > 0.5f);
+        r += float(r < -0.5f);
+        const float a = std::abs(r);
+        const float folded = std::min(a, 0.5f - a);
+        return detail::sin2pi_quarter<A>(r < 0.0f ? -folded : folded);
+    }
+
+    template<Accuracy A = Accuracy::High>
+    inline float cos2pi(float x) {
+        return sin2pi<A>(x + 0.25f);
+    }
+
+    template<Accuracy A = Accuracy::High>
+    inline float sin(float x) {
+        return sin2pi<A>(x * INV_TWO_PI);
+    }
+
+    template<Accuracy A = Accuracy::High>
+    inline float cos(float x) {
+        return cos2pi<A>(x * INV_TWO_PI);
+    }
+
+    /**
+     * 2^x, x is clamped to [-126, 127] so that the result is always a normal float
+     */
+    template<Accuracy A = Accuracy::High>
+    inline float exp2(float x) {
+        x = std::clamp(x, -126.0f, 127.0f);
+        //Round to nearest so that the fractional part is in [-1/2, 1/2]
+        const int32_t n = int32_t(x + (x < 0.0f ? -0.5f : 0.5f));
+        const float f = x - float(n);
+        return detail::exp2_fraction<A>(f) * std::bit_cast<float>((n + 127) << 23);
+    }
+
+    template<Accuracy A = Accuracy::High>
+    inline float exp(float x) {
+        return exp2<A>(x * LOG2E);
+    }
+
+    template<Accuracy A = Accuracy::High>
+    inline float tanh(float x) {
+        if constexpr (A == Accuracy::Low) {
+            //Pade approximant, it reaches 1 at |x| ~ 4.97 so clamp after
+            const float x2 = x * x;
+            const float p = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+            const float q = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+            return std::clamp(p / q, -1.0f, 1.0f);
+        } else {
+            //tanh(9) is 1 to float precision
+            const float e = exp2<A>(std::clamp(x, -9.0f, 9.0f) * (2.0f * LOG2E));
+            const float large = (e - 1.0f) / (e + 1.0f);
+            //e - 1 cancels near 0, the Taylor series is exact to float precision there instead
+            const float x2 = x * x;
+            const float small = x * (1.0f + x2 * (-1.0f / 3.0f + x2 * (2.0f / 15.0f + x2 * (-17.0f / 315.0f +
+                                                                                          x2 * (62.0f / 2835.0f)))));
+            return std::abs(x) < 0.25f ? small : large;
+        }
+    }
+
+}
+
+namespace AAri::fast_math {
+    // Array versions, in and out may be the same array ------------------------------------------
+    // They run the kernels for the selected instruction set (see kernels/kernels.h)
+
+    template<Accuracy A = Accuracy::High>
+    void sin2pi_array(const float *in, float *out, size_t n);
+
+    template<Accuracy A = Accuracy::High>
+    void cos2pi_array(const float *in, float *out, size_t n);
+
+    template<Accuracy A = Accuracy::High>
+    void exp2_array(const float *in, float *out, size_t n);
+
+    template<Accuracy A = Accuracy::High>
+    void tanh_array(const float *in, float *out, size_t n);
+}
+
+#endif //AARI_FAST_MATH_H
@@ -0,0 +1,93 @@
+//
+//
+
+#include "fft.h"
+#include <cmath>
+#include <stdexcept>
+
+using namespace AAri;
+
+namespace {
+    // In double, the tables are computed once
+    constexpr double TWO_PI = 6.283185307179586;
+}
+
+Fft::Fft(size_t size) : _size(size) {
+    if (size < 4 || (size & (size - 1)) != 0)
+        throw std::runtime_error("Fft: the size must be a power of two of at least 4");
+    const size_t half = size / 2;
+    for (size_t k = 0; k < half / 2; k++) {
+        const double angle = -TWO_PI * double(k) / double(half);
+        _twiddles.emplace_back(float(std::cos(angle)), float(std::sin(angle)));
+    }
+    for (size_t k = 0; k <= half; k++) {
+        const double angle = -TWO_PI * double(k) / double(size);
+        _split.emplace_back(float(std::cos(angle)), float(std::sin(angle)));
+    }
+    size_t bits = 0;
+    while ((size_t(1) << bits) < half)
+        bits++;
+    _reversed.resize(half);
+    for (size_t i = 0; i < half; i++) {
+        uint32_t r = 0;
+        for (size_t b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        _reversed[i] = r;
+    }
+    _work.resize(half);
+}
+
+void Fft::transform(Complex* data) const {
+    const size_t n = _size / 2;
+    for (size_t i = 0; i < n; i++) {
+        if (i < _reversed[i])
+            std::swap(data[i], data[_reversed[i]]);
+    }
+    for (size_t length = 2; length <= n; length *= 2) {
+        const size_t half = length / 2;
+        const size_t stride = n / length;
+        for (size_t start = 0; start < n; start += length) {
+            for (size_t k = 0; k < half; k++) {
+                const Complex t = multiply(data[start + k + half], _twiddles[k * stride]);
+                const Complex u = data[start + k];
+                data[start + k] = u + t;
+                data[start + k + half] = u - t;
+            }
+        }
+    }
+}
+
+void Fft::forward(const float* in, Complex* out) {
+    const size_t half = _size / 2;
+    //Even samples as the real parts, odd ones as the imaginary parts
+    for (size_t k = 0; k < half; k++)
+        _work[k] = {in[2 * k], in[2 * k + 1]};
+    transform(_work.data());
+    //Split into the spectra of the even and odd samples and combine them
+    for (size_t k = 0; k <= half; k++) {
+        const Complex z = _work[k % half];
+        const Complex mirror = std::conj(_work[(half - k) % half]);
+        const Complex even = 0.5f * (z + mirror);
+        const Complex difference = z - mirror;
+        const Complex odd = {0.5f * difference.imag(), -0.5f * difference.real()};
+        out[k] = even + multiply(_split[k], odd);
+    }
+}
+
+void Fft::inverse(const Complex* in, float* out) {
+    const size_t half = _size / 2;
+    //Undo the split, conjugated to run the forward transform backwards
+    for (size_t k = 0; k < half; k++) {
+        const Complex x = in[k];
+        const Complex mirror = std::conj(in[half - k]);
+        const Complex even = 0.5f * (x + mirror);
+        const Complex odd = multiply(0.5f * (x - mirror), std::conj(_split[k]));
+        _work[k] = std::conj(even + Complex(-odd.imag(), odd.real()));
+    }
+    transform(_work.data());
+    const float scale = 1.0f / float(half);
+    for (size_t k = 0; k < half; k++) {
+        out[2 * k] = _work[k].real() * scale;
+        out[2 * k + 1] = -_work[k].imag() * scale;
+    }
+}
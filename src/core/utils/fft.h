@@ -0,0 +1,63 @@
+//
+//
+
+#ifndef AARI_FFT_H
+#define AARI_FFT_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AAri {
+    /**
+     * FFT of real signals of a power of two size, through a complex FFT of half the size.
+     * The spectra only hold the size / 2 + 1 bins from DC to Nyquist, the others are their conjugates.
+     * The tables are computed by the constructor, the transforms don't allocate.
+     */
+    class Fft {
+    public:
+        using Complex = std::complex<float>;
+
+        // Plain product, std::complex's checks for infinities cost a function call per product
+        static Complex multiply(Complex a, Complex b) {
+            return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+        }
+
+        explicit Fft(size_t size);
+
+        size_t size() const {
+            return _size;
+        }
+
+        size_t bins() const {
+            return _size / 2 + 1;
+        }
+
+        /**
+         * @param in size samples
+         * @param out bins() values
+         */
+        void forward(const float *in, Complex *out);
+
+        /**
+         * Inverse of forward, scaled so that inverse(forward(x)) == x
+         * @param in bins() values
+         * @param out size samples
+         */
+        void inverse(const Complex *in, float *out);
+
+    private:
+        // In place radix 2 FFT of size / 2 values
+        void transform(Complex *data) const;
+
+        size_t _size;
+        // e^(-2 pi i k / (size / 2)) for the half size FFT, then e^(-2 pi i k / size) to split the spectrum
+        std::vector<Complex> _twiddles;
+        std::vector<Complex> _split;
+        std::vector<uint32_t> _reversed;
+        std::vector<Complex> _work;
+    };
+}
+
+#endif //AARI_FFT_H
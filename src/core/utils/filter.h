@@ -0,0 +1,153 @@
+//
+//
+
+#ifndef AARI_FILTER_H
+#define AARI_FILTER_H
+
+#include <algorithm>
+#include <cmath>
+#include "fast_math.h"
+#include "../kernels/kernels.h"
+
+/**
+ * Second order filters: biquads with the RBJ cookbook coefficients, in transposed direct form II,
+ * and the trapezoidal state variable filter (Simper / Zavalishin), which stays stable and keeps
+ * its tuning when the cutoff is modulated at audio rate.
+ *
+ * Cutoff and Q are smoothed by a one-pole before the coefficients are computed, so that steps
+ * in the controls don't click. The coefficients only need sin / cos of the cutoff in cycles per
+ * sample, which fast_math computes in a few multiply-adds: they are recomputed every sample.
+ */
+namespace AAri::filter {
+    // Modes are floats so that they can be stored in inputs
+    constexpr float LOWPASS = 0.0f;
+    constexpr float HIGHPASS = 1.0f;
+    constexpr float BANDPASS = 2.0f; // 0 dB at the cutoff
+    constexpr float NOTCH = 3.0f;
+
+    // Time constant of the cutoff and Q smoothing
+    constexpr float SMOOTHING_TIME = 0.002f;
+    // The cutoff is kept under this fraction of the sample rate
+    constexpr float MAX_CUTOFF = 0.49f;
+    constexpr float MIN_CUTOFF = 1e-5f;
+    constexpr float MIN_Q = 0.05f;
+    // Below this the state of a filter with no input is flushed to 0 (-120 dB)
+    constexpr float SILENCE = 1e-6f;
+}
+
+namespace AAri::filter::inline AARI_SIMD_NAMESPACE {
+    inline float smoothing_coefficient(float sample_rate) {
+        return 1.0f - fast_math::exp(-1.0f / std::max(SMOOTHING_TIME * sample_rate, 1.0f));
+    }
+
+    inline float smooth(float value, float target, float coefficient) {
+        return value + (target - value) * coefficient;
+    }
+
+    // Cutoff in Hz to cycles per sample, clamped below Nyquist
+    inline float normalized_cutoff(float cutoff, float inv_sample_rate) {
+        return std::clamp(cutoff * inv_sample_rate, MIN_CUTOFF, MAX_CUTOFF);
+    }
+
+    /**
+     * @param f cutoff in cycles per sample, see normalized_cutoff
+     */
+    inline BiquadCoefficients biquad_coefficients(float mode, float f, float q) {
+        const float c = fast_math::cos2pi(f);
+        const float alpha = fast_math::sin2pi(f) / (2.0f * std::max(q, MIN_Q));
+        const float inv_a0 = 1.0f / (1.0f + alpha);
+        float b0, b1, b2;
+        if (mode == HIGHPASS) {
+            b0 = 0.5f * (1.0f + c);
+            b1 = -(1.0f + c);
+            b2 = b0;
+        } else if (mode == BANDPASS) {
+            b0 = alpha;
+            b1 = 0.0f;
+            b2 = -alpha;
+        } else if (mode == NOTCH) {
+            b0 = 1.0f;
+            b1 = -2.0f * c;
+            b2 = 1.0f;
+        } else {
+            b0 = 0.5f * (1.0f - c);
+            b1 = 1.0f - c;
+            b2 = b0;
+        }
+        return {b0 * inv_a0, b1 * inv_a0, b2 * inv_a0, -2.0f * c * inv_a0, (1.0f - alpha) * inv_a0};
+    }
+
+    /**
+     * One sample of a biquad, s1 and s2 are its state
+     */
+    inline float biquad_step(float x, const BiquadCoefficients&c, float&s1, float&s2) {
+        const float y = c.b0 * x + s1;
+        s1 = c.b1 * x - c.a1 * y + s2;
+        s2 = c.b2 * x - c.a2 * y;
+        return y;
+    }
+
+    /**
+     * Outputs of a state variable filter for one sample
+     */
+    struct SvfOutputs {
+        float lowpass;
+        float bandpass;
+        float highpass;
+    };
+
+    /**
+     * One sample of a state variable filter, ic1 and ic2 are its state
+     * @param f cutoff in cycles per sample, see normalized_cutoff
+     */
+    inline SvfOutputs svf_step(float x, float f, float q, float&ic1, float&ic2) {
+        //g = tan(pi f), f / 2 is already in [0, 1/4] so sin and cos skip the range reduction of sin2pi
+        const float half = 0.5f * f;
+        const float g = fast_math::detail::sin2pi_quarter<fast_math::Accuracy::High>(half) /
+                        fast_math::detail::sin2pi_quarter<fast_math::Accuracy::High>(0.25f - half);
+        const float k = 1.0f / std::max(q, MIN_Q);
+        const float a1 = 1.0f / (1.0f + g * (g + k));
+        const float a2 = g * a1;
+        const float a3 = g * a2;
+        const float v3 = x - ic2;
+        const float v1 = a1 * ic1 + a2 * v3;
+        const float v2 = ic2 + a2 * ic1 + a3 * v3;
+        ic1 = 2.0f * v1 - ic1;
+        ic2 = 2.0f * v2 - ic2;
+        //Bandpass normalised to 0 dB at the cutoff like the biquad one
+        const float bandpass = k * v1;
+        return {v2, bandpass, x - bandpass - v2};
+    }
+
+    /**
+     * Weights of the lowpass, bandpass and highpass outputs giving a mode, the notch being low + high.
+     * The Svf block computes them for every sample, the SVF bank kernel once per call.
+     * Mixing rather than selecting keeps the kernel's per sample loop branch free.
+     */
+    inline SvfOutputs svf_mix(float mode) {
+        if (mode == HIGHPASS)
+            return {0.0f, 0.0f, 1.0f};
+        if (mode == BANDPASS)
+            return {0.0f, 1.0f, 0.0f};
+        if (mode == NOTCH)
+            return {1.0f, 0.0f, 1.0f};
+        return {1.0f, 0.0f, 0.0f};
+    }
+
+    inline float svf_select(const SvfOutputs&mix, const SvfOutputs&out) {
+        return mix.lowpass * out.lowpass + mix.bandpass * out.bandpass + mix.highpass * out.highpass;
+    }
+
+    /**
+     * Flush a state to 0 once the input is 0 and it decayed under SILENCE, so that filters can sleep
+     * instead of ringing on in the denormals
+     */
+    inline void flush(float x, float&s1, float&s2) {
+        //& rather than && to keep it branch free
+        const bool quiet = (x == 0.0f) & (std::abs(s1) < SILENCE) & (std::abs(s2) < SILENCE);
+        s1 = quiet ? 0.0f : s1;
+        s2 = quiet ? 0.0f : s2;
+    }
+}
+
+#endif //AARI_FILTER_H
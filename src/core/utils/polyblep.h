@@ -0,0 +1,70 @@
+//
+//
+
+#ifndef AARI_POLYBLEP_H
+#define AARI_POLYBLEP_H
+
+#include <cmath>
+#include "fast_math.h"
+
+/**
+ * Saw, square and triangle waves with their discontinuities smoothed by polynomial band-limited
+ * steps (PolyBLEP) and ramps (PolyBLAMP), which removes most of the aliasing of the naive waves.
+ *
+ * p is the phase in cycles in [0, 1) and dt the phase increment per sample (freq / sample rate).
+ * Branch free like fast_math, the edges are selects rather than jumps.
+ */
+namespace AAri::polyblep::inline AARI_SIMD_NAMESPACE {
+    //Correction around a step of height 2 at t = 0
+    inline float blep(float t, float dt, float inv_dt) {
+        const float a = t * inv_dt;
+        const float b = (t - 1.0f) * inv_dt;
+        const float before = b * b + b + b + 1.0f;
+        const float after = a + a - a * a - 1.0f;
+        return t < dt ? after : (t > 1.0f - dt ? before : 0.0f);
+    }
+
+    //Integral of blep: correction around a change of slope at t = 0
+    inline float blamp(float t, float dt, float inv_dt) {
+        const float a = t * inv_dt - 1.0f;
+        const float b = (t - 1.0f) * inv_dt + 1.0f;
+        const float before = b * b * b * (1.0f / 3.0f);
+        const float after = a * a * a * (-1.0f / 3.0f);
+        return t < dt ? after : (t > 1.0f - dt ? before : 0.0f);
+    }
+
+    //Keep the corrections from overlapping, and away from 0 for the division
+    inline float clamp_increment(float dt) {
+        return std::clamp(std::abs(dt), 1e-7f, 0.5f);
+    }
+
+    //Rising saw from -1 to 1
+    inline float saw(float p, float dt) {
+        dt = clamp_increment(dt);
+        return 2.0f * p - 1.0f - blep(p, dt, 1.0f / dt);
+    }
+
+    inline float square(float p, float dt) {
+        dt = clamp_increment(dt);
+        const float inv_dt = 1.0f / dt;
+        const float naive = p < 0.5f ? 1.0f : -1.0f;
+        return naive + blep(p, dt, inv_dt) - blep(fast_math::fraction(p + 0.5f), dt, inv_dt);
+    }
+
+    //-1 at p = 0 and 1 at p = 0.5
+    inline float triangle(float p, float dt) {
+        dt = clamp_increment(dt);
+        const float inv_dt = 1.0f / dt;
+        const float naive = 1.0f - 4.0f * std::abs(p - 0.5f);
+        //The slope changes by 8 per cycle at the corners
+        return naive + 4.0f * dt * (blamp(p, dt, inv_dt) - blamp(fast_math::fraction(p + 0.5f), dt, inv_dt));
+    }
+
+    //Phase after one sample, wrapped into [0, 1) whatever the sign of dt
+    inline float advance(float p, float dt) {
+        const float next = fast_math::fraction(p + dt);
+        return next + float(next < 0.0f);
+    }
+}
+
+#endif //AARI_POLYBLEP_H
@@ -0,0 +1,144 @@
+//
+//
+
+#include "voice_pool.h"
+#include "blocks.h"
+#include "inputs_outputs.h"
+#include <cmath>
+
+using namespace AAri;
+
+namespace {
+    void set_input(entt::registry&registry, entt::entity input, float value) {
+        if (input == entt::null)
+            return;
+        if (auto* port = registry.try_get<Input1D>(input))
+            port->value = value;
+    }
+
+    bool asleep(entt::registry&registry, entt::entity block) {
+        auto* silence = registry.try_get<Silence>(block);
+        return silence != nullptr && silence->asleep;
+    }
+
+    //The output block of the voice was removed, it can't be heard or played anymore
+    bool removed(entt::registry&registry, entt::entity block) {
+        return !registry.valid(block) || !registry.all_of<Block>(block);
+    }
+}
+
+VoicePool::VoicePool(std::vector<Voice> voices, size_t queue_capacity)
+    : _voices(std::move(voices)), _states(_voices.size()), _notes(new std::atomic<int>[_voices.size()]),
+      _events(queue_capacity) {
+    for (size_t i = 0; i < _voices.size(); i++) {
+        if (_voices[i].output_block == entt::null)
+            throw std::runtime_error("VoicePool: every voice needs an output block");
+        _notes[i].store(-1, std::memory_order_relaxed);
+    }
+}
+
+bool VoicePool::note_on(uint8_t note, float velocity) {
+    return _events.push({NoteEvent::Type::On, note, velocity});
+}
+
+bool VoicePool::note_off(uint8_t note) {
+    return _events.push({NoteEvent::Type::Off, note, 0.0f});
+}
+
+bool VoicePool::all_notes_off() {
+    return _events.push({NoteEvent::Type::AllOff, 0, 0.0f});
+}
+
+float VoicePool::note_to_freq(uint8_t note) {
+    return 440.0f * std::exp2((float(note) - 69.0f) / 12.0f);
+}
+
+void VoicePool::process_events(entt::registry&registry) {
+    NoteEvent event;
+    while (_events.pop(event)) {
+        switch (event.type) {
+            case NoteEvent::Type::On:
+                start(registry, allocate(registry, event.note), event.note, event.velocity);
+                break;
+            case NoteEvent::Type::Off:
+                for (size_t i = 0; i < _voices.size(); i++) {
+                    if (_states[i].held && _notes[i].load(std::memory_order_relaxed) == event.note)
+                        release(registry, i);
+                }
+                break;
+            case NoteEvent::Type::AllOff:
+                for (size_t i = 0; i < _voices.size(); i++) {
+                    if (_states[i].held)
+                        release(registry, i);
+                }
+                break;
+        }
+    }
+}
+
+void VoicePool::update_voices(entt::registry&registry) {
+    //Released voices are free again once they went to sleep, and any voice once its output block is removed
+    size_t active = 0;
+    for (size_t i = 0; i < _voices.size(); i++) {
+        auto&state = _states[i];
+        const auto output_block = _voices[i].output_block;
+        if (state.playing && (removed(registry, output_block) || (!state.held && asleep(registry, output_block)))) {
+            state.playing = false;
+            state.held = false;
+            _notes[i].store(-1, std::memory_order_relaxed);
+        }
+        active += state.playing;
+    }
+    _active.store(active, std::memory_order_relaxed);
+}
+
+size_t VoicePool::allocate(entt::registry&registry, uint8_t note) {
+    //Same note again: retrigger its voice
+    for (size_t i = 0; i < _voices.size(); i++) {
+        if (_states[i].held && _notes[i].load(std::memory_order_relaxed) == note &&
+            !removed(registry, _voices[i].output_block))
+            return i;
+    }
+    size_t free = _voices.size();
+    size_t oldest_released = _voices.size();
+    size_t oldest_held = _voices.size();
+    for (size_t i = 0; i < _voices.size(); i++) {
+        const auto&state = _states[i];
+        if (removed(registry, _voices[i].output_block))
+            continue;
+        if (!state.playing || (!state.held && asleep(registry, _voices[i].output_block))) {
+            free = i;
+            break;
+        }
+        auto&oldest = state.held ? oldest_held : oldest_released;
+        if (oldest == _voices.size() || state.started < _states[oldest].started)
+            oldest = i;
+    }
+    if (free < _voices.size())
+        return free;
+    return oldest_released < _voices.size() ? oldest_released : oldest_held;
+}
+
+void VoicePool::start(entt::registry&registry, size_t voice, uint8_t note, float velocity) {
+    if (voice >= _voices.size())
+        return;
+    const auto&v = _voices[voice];
+    set_input(registry, v.freq, note_to_freq(note));
+    set_input(registry, v.velocity, velocity);
+    set_input(registry, v.retrigger, 0.0f);
+    set_input(registry, v.gate, 1.0f);
+    for (auto block: v.blocks) {
+        if (auto* silence = registry.try_get<Silence>(block))
+            silence->asleep = false;
+    }
+    if (auto* silence = registry.try_get<Silence>(v.output_block))
+        silence->asleep = false;
+
+    _states[voice] = {true, true, ++_counter};
+    _notes[voice].store(note, std::memory_order_relaxed);
+}
+
+void VoicePool::release(entt::registry&registry, size_t voice) {
+    set_input(registry, _voices[voice].gate, 0.0f);
+    _states[voice].held = false;
+}
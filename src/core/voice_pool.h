@@ -0,0 +1,118 @@
+//
+//
+
+#ifndef AARI_VOICE_POOL_H
+#define AARI_VOICE_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <entt/entt.hpp>
+#include "utils/data_structures.h"
+
+namespace AAri {
+    /**
+     * Fixed set of copies of a voice subgraph, built once, and played through note events.
+     *
+     * note_on / note_off only push to a lock free queue, so they never wait for the audio thread.
+     * The engine applies the events at the start of each rendered buffer: a voice is allocated by setting
+     * its inputs, so note on costs the same whatever the size of the graph, and nothing is created or sorted.
+     * Voices that are not playing are left to the Silence mechanism: once released their blocks sleep
+     * and are skipped by Graph::process, which is also how the pool knows the voice is free again.
+     * When all the voices are busy the oldest released one is stolen, or the oldest held one.
+     */
+    class VoicePool {
+    public:
+        /**
+         * Ports and blocks of one copy of the voice. Only output_block is mandatory.
+         */
+        struct Voice {
+            // Input1D set to 1 on note on and 0 on note off, e.g. the gate of an Adsr
+            entt::entity gate = entt::null;
+            // Input1D set to the frequency of the note in Hz
+            entt::entity freq = entt::null;
+            // Input1D set to the velocity of the note, between 0 and 1
+            entt::entity velocity = entt::null;
+            // Input1D zeroed on note on, e.g. the stage of an Adsr so that a stolen voice restarts its attack
+            entt::entity retrigger = entt::null;
+            // The voice is free once this block is asleep and its note is released. If the block is removed
+            // the voice is freed and never allocated again
+            entt::entity output_block = entt::null;
+            // Blocks woken up on note on, in case their inputs alone don't wake them
+            std::vector<entt::entity> blocks;
+        };
+
+        explicit VoicePool(std::vector<Voice> voices, size_t queue_capacity = 1024);
+
+        // Note events, they can be called from any one thread at a time (e.g. python) ------------------
+        // They return false if the queue is full
+
+        bool note_on(uint8_t note, float velocity = 1.0f);
+
+        bool note_off(uint8_t note);
+
+        bool all_notes_off();
+
+        // Inspection, from any thread ------------------------------------------------------------------
+
+        [[nodiscard]] size_t size() const {
+            return _voices.size();
+        }
+
+        // Voices playing a note or releasing it, as of the end of the last rendered buffer
+        [[nodiscard]] size_t active_voices() const {
+            return _active.load(std::memory_order_relaxed);
+        }
+
+        // Note of a voice as of the end of the last rendered buffer, -1 when the voice is free
+        [[nodiscard]] int voice_note(size_t voice) const {
+            return _notes[voice].load(std::memory_order_relaxed);
+        }
+
+        // Called by the engine from the audio thread with the registry locked ---------------------------
+
+        // Apply the pending note events, before rendering a buffer
+        void process_events(entt::registry &registry);
+
+        // Free the released voices that went to sleep, after rendering a buffer
+        void update_voices(entt::registry &registry);
+
+        static float note_to_freq(uint8_t note);
+
+    private:
+        struct NoteEvent {
+            enum class Type : uint8_t {
+                On,
+                Off,
+                AllOff,
+            };
+            Type type = Type::On;
+            uint8_t note = 0;
+            float velocity = 0.0f;
+        };
+
+        struct VoiceState {
+            bool held = false;
+            bool playing = false;
+            uint64_t started = 0;
+        };
+
+        void start(entt::registry &registry, size_t voice, uint8_t note, float velocity);
+
+        void release(entt::registry &registry, size_t voice);
+
+        size_t allocate(entt::registry &registry, uint8_t note);
+
+        std::vector<Voice> _voices;
+        // Only touched by the audio thread
+        std::vector<VoiceState> _states;
+        uint64_t _counter = 0;
+        // Published for the other threads
+        std::unique_ptr<std::atomic<int>[]> _notes;
+        std::atomic<size_t> _active{0};
+        SpscQueue<NoteEvent> _events;
+    };
+}
+
+#endif //AARI_VOICE_POOL_H
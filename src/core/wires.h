@@ -8,6 +8,7 @@
 #include "inputs_outputs.h"
 #include <string>
 #include <vector>
+#include <unordered_set>
 #include <entt/entt.hpp>
 
 namespace AAri {
@@ -26,6 +27,8 @@ namespace AAri {
         float gain = 1.0f;
         float offset = 0.0f;
         TransmitFunc transmitFunc = nullptr;
+        // Slot of the input when it is a MixerInput, 0 otherwise
+        uint32_t slot = 0;
         //-------------------------------------------------------------------------------
 
         static void transmit_1d_to_1d(entt::registry&registry, const Wire&wire);
@@ -33,16 +36,16 @@ namespace AAri {
         template<size_t N>
         static void broadcast_1d_to_Nd(entt::registry&registry, const Wire&wire);
 
-        //Templated function for mono mixers:
+        //Element wise, e.g. a stereo mixer output to the stereo input of an effect
         template<size_t N>
-        static void transmit_to_mono_mixer(entt::registry&registry, const Wire&wire);
+        static void transmit_Nd_to_Nd(entt::registry&registry, const Wire&wire);
 
-        //Similar for stereo mixers:
-        template<size_t N>
-        static void transmit_stereo_to_stereo_mixer(entt::registry&registry, const Wire&wire);
+        //Element wise, over the common part if the sizes differ
+        static void transmit_array_to_array(entt::registry&registry, const Wire&wire);
 
-        template<size_t N>
-        static void transmit_mono_to_stereo_mixer(entt::registry&registry, const Wire&wire);
+        //Wires to a MixerInput are gathered by the graph rather than transmitted (see GatherList), so this
+        //does nothing. It is the only function add_wire_to_mixer takes, and names mixer wires in snapshots
+        static void transmit_to_mixer(entt::registry&, const Wire&);
 
     private:
         // Creation and deletion are private
@@ -54,12 +57,12 @@ namespace AAri {
                                    entt::entity from_output,
                                    entt::entity to_input,
                                    TransmitFunc transmitFunc,
-                                   float gain = 1.0f, float offset = 0.0f) {
-            //First check there isn't already a wire to this same input
+                                   float gain = 1.0f, float offset = 0.0f, uint32_t slot = 0) {
+            //First check there isn't already a wire to this same input (or slot of a mixer input)
             auto view = registry.view<Wire>();
             for (auto entity: view) {
                 auto&wire = view.get<Wire>(entity);
-                if (wire.to_input == to_input) {
+                if (wire.to_input == to_input && wire.slot == slot) {
                     throw std::runtime_error("Cannot create wire, input already connected");
                 }
             }
@@ -67,10 +70,56 @@ namespace AAri {
 
             auto entity = registry.create();
             registry.emplace<Wire>(entity, from_block, to_block, from_output,
-                                   to_input, gain, offset, transmitFunc);
+                                   to_input, gain, offset, transmitFunc, slot);
             return entity;
         }
 
+        /**
+         * Bulk version of create: wire i goes from from_outputs[i] to to_inputs[i].
+         * The check for already connected inputs is done once for the whole batch
+         * instead of scanning all wires for each new one.
+         */
+        static std::vector<entt::entity> create_many(entt::registry&registry,
+                                                     const std::vector<entt::entity>&from_blocks,
+                                                     const std::vector<entt::entity>&to_blocks,
+                                                     const std::vector<entt::entity>&from_outputs,
+                                                     const std::vector<entt::entity>&to_inputs,
+                                                     const TransmitFunc&transmitFunc,
+                                                     const std::vector<float>&gains,
+                                                     const std::vector<float>&offsets,
+                                                     const std::vector<uint32_t>&slots = {}) {
+            const size_t n = from_blocks.size();
+            if (to_blocks.size() != n || from_outputs.size() != n || to_inputs.size() != n ||
+                gains.size() != n || offsets.size() != n || (!slots.empty() && slots.size() != n)) {
+                throw std::runtime_error("Cannot create wires, all arrays must have the same size");
+            }
+            auto slot = [&](size_t i) {
+                return slots.empty() ? 0u : slots[i];
+            };
+
+            auto key = [](entt::entity input, uint32_t input_slot) {
+                return (uint64_t(entt::to_integral(input)) << 32) | uint64_t(input_slot);
+            };
+            std::unordered_set<uint64_t> connected;
+            connected.reserve(n + registry.view<Wire>().size());
+            registry.view<Wire>().each([&](auto&wire) {
+                connected.insert(key(wire.to_input, wire.slot));
+            });
+            for (size_t i = 0; i < n; i++) {
+                if (!connected.insert(key(to_inputs[i], slot(i))).second) {
+                    throw std::runtime_error("Cannot create wire, input already connected");
+                }
+            }
+
+            std::vector<entt::entity> entities(n);
+            registry.create(entities.begin(), entities.end());
+            for (size_t i = 0; i < n; i++) {
+                registry.emplace<Wire>(entities[i], from_blocks[i], to_blocks[i], from_outputs[i],
+                                       to_inputs[i], gains[i], offsets[i], transmitFunc, slot(i));
+            }
+            return entities;
+        }
+
         static void destroy(entt::registry&registry, entt::entity entity) {
             registry.destroy(entity);
         }
@@ -1,6 +1,195 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
+#include "core/audio_engine.h"
+#include "core/kernels/kernels.h"
 
-int main(int argc, char *argv[]) {
-    std::cout << "Hello, World!" << std::endl;
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace AAri;
+
+namespace {
+    struct Options {
+        std::string snapshot;
+        std::string output;
+        double duration = 10.0;
+        ma_uint32 sample_rate = 48000;
+        ma_uint32 buffer_size = 512;
+        std::string simd;
+    };
+
+    void print_usage() {
+        std::cout << "Usage: AAri <snapshot> [options]\n"
+                "Render a saved patch offline.\n\n"
+                "Options:\n"
+                "  -d, --duration <seconds>     length of the render (default 10)\n"
+                "  -o, --output <file>          .wav files are written as 32 bit float WAV,\n"
+                "                               anything else as raw interleaved stereo float32.\n"
+                "                               Without an output the render is only timed.\n"
+                "  -r, --sample-rate <hz>       (default 48000)\n"
+                "  -b, --buffer-size <frames>   frames rendered per block (default 512)\n"
+                "  -s, --simd <level>           force the DSP kernels: scalar, sse2, avx2 or avx512\n"
+                "                               (default: the best the CPU supports)\n"
+                "  -h, --help\n";
+    }
+
+    bool ends_with(const std::string&str, const std::string&suffix) {
+        return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    Options parse_args(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "-h" || arg == "--help") {
+                print_usage();
+                std::exit(0);
+            } else if (arg == "-d" || arg == "--duration") {
+                options.duration = std::stod(next());
+            } else if (arg == "-o" || arg == "--output") {
+                options.output = next();
+            } else if (arg == "-r" || arg == "--sample-rate") {
+                options.sample_rate = (ma_uint32)std::stoul(next());
+            } else if (arg == "-b" || arg == "--buffer-size") {
+                options.buffer_size = (ma_uint32)std::stoul(next());
+            } else if (arg == "-s" || arg == "--simd") {
+                options.simd = next();
+            } else if (!arg.empty() && arg[0] == '-') {
+                throw std::runtime_error("Unknown option " + arg);
+            } else if (options.snapshot.empty()) {
+                options.snapshot = arg;
+            } else {
+                throw std::runtime_error("Unexpected argument " + arg);
+            }
+        }
+        if (options.snapshot.empty())
+            throw std::runtime_error("No snapshot given");
+        if (options.duration <= 0.0 || options.sample_rate == 0 || options.buffer_size == 0)
+            throw std::runtime_error("Duration, sample rate and buffer size must be positive");
+        return options;
+    }
+
+    /**
+     * @return the peak resident memory of the process in bytes
+     */
+    size_t peak_memory() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return counters.PeakWorkingSetSize;
+        return 0;
+#else
+        struct rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return (size_t)usage.ru_maxrss;
+#else
+        return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+    }
+
+    /**
+     * Where rendered audio goes: a WAV encoder, a raw float file or nowhere
+     */
+    class Sink {
+    public:
+        Sink(const std::string&path, ma_uint32 sample_rate) {
+            if (path.empty())
+                return;
+            if (ends_with(path, ".wav") || ends_with(path, ".WAV")) {
+                auto config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, 2, sample_rate);
+                if (ma_encoder_init_file(path.c_str(), &config, &_encoder) != MA_SUCCESS)
+                    throw std::runtime_error("Cannot open " + path + " for writing");
+                _wav = true;
+            } else {
+                _raw.open(path, std::ios::binary | std::ios::trunc);
+                if (!_raw)
+                    throw std::runtime_error("Cannot open " + path + " for writing");
+            }
+        }
+
+        ~Sink() {
+            if (_wav)
+                ma_encoder_uninit(&_encoder);
+        }
+
+        void write(const float* buffer, ma_uint32 frames) {
+            if (_wav) {
+                if (ma_encoder_write_pcm_frames(&_encoder, buffer, frames, nullptr) != MA_SUCCESS)
+                    throw std::runtime_error("Failed writing WAV file");
+            } else if (_raw.is_open()) {
+                _raw.write(reinterpret_cast<const char *>(buffer), (std::streamsize)(2 * frames * sizeof(float)));
+                if (!_raw)
+                    throw std::runtime_error("Failed writing raw file");
+            }
+        }
+
+    private:
+        bool _wav = false;
+        ma_encoder _encoder{};
+        std::ofstream _raw;
+    };
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        options = parse_args(argc, argv);
+    } catch (const std::exception&e) {
+        std::cerr << "Error: " << e.what() << "\n\n";
+        print_usage();
+        return 1;
+    }
+
+    try {
+        if (!options.simd.empty())
+            set_simd_level(parse_simd_level(options.simd));
+        AudioEngine engine(options.sample_rate, options.buffer_size, true);
+        std::cout << "DSP kernels: " << simd_level_name(get_simd_level()) << "\n";
+
+        auto load_start = std::chrono::steady_clock::now();
+        auto blocks = engine.load_snapshot(options.snapshot);
+        std::chrono::duration<double> load_time = std::chrono::steady_clock::now() - load_start;
+        std::cout << "Loaded " << blocks.size() << " blocks from " << options.snapshot
+                << " in " << load_time.count() * 1000.0 << " ms\n";
+
+        Sink sink(options.output, options.sample_rate);
+        std::vector<float> buffer(2 * (size_t)options.buffer_size);
+        auto total_frames = (uint64_t)(options.duration * options.sample_rate);
+
+        std::chrono::duration<double> render_time{0.0};
+        for (uint64_t done = 0; done < total_frames;) {
+            auto frames = (ma_uint32)std::min<uint64_t>(options.buffer_size, total_frames - done);
+            auto start = std::chrono::steady_clock::now();
+            engine.render(buffer.data(), frames);
+            render_time += std::chrono::steady_clock::now() - start;
+            sink.write(buffer.data(), frames);
+            done += frames;
+        }
+
+        const double rendered = (double)total_frames / options.sample_rate;
+        std::printf("Rendered %.2f s in %.3f s (%.1fx realtime)\n", rendered, render_time.count(),
+                    rendered / std::max(render_time.count(), 1e-9));
+        std::printf("Peak memory: %.1f MB\n", (double)peak_memory() / (1024.0 * 1024.0));
+    } catch (const std::exception&e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
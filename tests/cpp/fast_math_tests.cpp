@@ -0,0 +1,434 @@
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include "../../src/core/utils/fast_math.h"
+#include "../../src/core/utils/polyblep.h"
+#include "../../src/core/utils/envelope.h"
+#include "../../src/core/utils/filter.h"
+#include "../../src/core/utils/fft.h"
+#include "../../src/core/kernels/kernels.h"
+#include <catch2/catch_all.hpp>
+#include <bit>
+#include <cmath>
+#include <vector>
+
+using namespace AAri;
+using fast_math::Accuracy;
+
+namespace {
+    std::vector<float> linspace(float start, float stop, size_t n) {
+        std::vector<float> values(n);
+        for (size_t i = 0; i < n; i++)
+            values[i] = start + (stop - start) * float(i) / float(n - 1);
+        return values;
+    }
+
+    //Max absolute error of the array version of a kernel against a double precision reference
+    template<typename Kernel, typename Reference>
+    double max_error(Kernel kernel, Reference reference, const std::vector<float>&x) {
+        std::vector<float> out(x.size());
+        kernel(x.data(), out.data(), x.size());
+        double error = 0.0;
+        for (size_t i = 0; i < x.size(); i++)
+            error = std::max(error, std::abs(double(out[i]) - reference(double(x[i]))));
+        return error;
+    }
+
+    constexpr double PI_D = 3.14159265358979323846;
+}
+
+TEST_CASE("Test fast sin and cos accuracy") {
+    auto x = linspace(-8.0f, 8.0f, 100001);
+    auto sin_ref = [](double v) { return std::sin(2.0 * PI_D * v); };
+    auto cos_ref = [](double v) { return std::cos(2.0 * PI_D * v); };
+
+    SECTION("Test array kernels") {
+        REQUIRE(max_error(fast_math::sin2pi_array<Accuracy::Low>, sin_ref, x) < 1e-4);
+        REQUIRE(max_error(fast_math::sin2pi_array<Accuracy::Medium>, sin_ref, x) < 2e-6);
+        REQUIRE(max_error(fast_math::sin2pi_array<Accuracy::High>, sin_ref, x) < 5e-7);
+        REQUIRE(max_error(fast_math::cos2pi_array<Accuracy::Low>, cos_ref, x) < 1e-4);
+        REQUIRE(max_error(fast_math::cos2pi_array<Accuracy::High>, cos_ref, x) < 5e-7);
+    }
+
+    SECTION("Test scalar versions") {
+        for (float v: {-1.0f, -0.75f, -0.5f, -0.25f, 0.0f, 0.125f, 0.25f, 0.5f, 0.75f, 1.0f, 440.3f}) {
+            REQUIRE_THAT(fast_math::sin2pi(v), Catch::Matchers::WithinAbs(sin_ref(v), 5e-7));
+        }
+        //Radians are converted to turns first, which costs some precision for large arguments
+        for (float v: {-3.0f, -1.0f, 0.0f, 0.5f, 1.0f, 3.0f}) {
+            REQUIRE_THAT(fast_math::sin(v), Catch::Matchers::WithinAbs(std::sin(double(v)), 1e-6));
+            REQUIRE_THAT(fast_math::cos(v), Catch::Matchers::WithinAbs(std::cos(double(v)), 1e-6));
+        }
+        //Large phases as seen by oscillators (freq * phase)
+        REQUIRE_THAT(fast_math::sin2pi(12345.125f), Catch::Matchers::WithinAbs(sin_ref(12345.125), 5e-7));
+    }
+
+    SECTION("Test fraction matches fmodf") {
+        for (float v: {-3.75f, -0.5f, 0.0f, 0.999f, 1.0f, 1.25f, 1000.5f, 8388607.5f, 8388609.0f, 3e9f, -5e9f,
+                       1e20f})
+            REQUIRE(fast_math::fraction(v) == std::fmod(v, 1.0f));
+    }
+}
+
+TEST_CASE("Test fast exp2 and tanh accuracy") {
+    SECTION("Test exp2 relative error") {
+        auto x = linspace(-20.0f, 20.0f, 100001);
+        std::vector<float> out(x.size());
+        auto rel_error = [&](auto kernel) {
+            kernel(x.data(), out.data(), x.size());
+            double error = 0.0;
+            for (size_t i = 0; i < x.size(); i++) {
+                double ref = std::exp2(double(x[i]));
+                error = std::max(error, std::abs(double(out[i]) - ref) / ref);
+            }
+            return error;
+        };
+        REQUIRE(rel_error(fast_math::exp2_array<Accuracy::Low>) < 1e-4);
+        REQUIRE(rel_error(fast_math::exp2_array<Accuracy::Medium>) < 3e-6);
+        REQUIRE(rel_error(fast_math::exp2_array<Accuracy::High>) < 5e-7);
+    }
+
+    SECTION("Test exp2 clamps its input") {
+        REQUIRE(std::isfinite(fast_math::exp2(1000.0f)));
+        REQUIRE(fast_math::exp2(-1000.0f) > 0.0f);
+        REQUIRE(fast_math::exp2(3.0f) == Catch::Approx(8.0f));
+    }
+
+    SECTION("Test tanh") {
+        auto x = linspace(-12.0f, 12.0f, 100001);
+        auto ref = [](double v) { return std::tanh(v); };
+        REQUIRE(max_error(fast_math::tanh_array<Accuracy::Low>, ref, x) < 2e-4);
+        REQUIRE(max_error(fast_math::tanh_array<Accuracy::Medium>, ref, x) < 5e-6);
+        REQUIRE(max_error(fast_math::tanh_array<Accuracy::High>, ref, x) < 5e-7);
+        REQUIRE(fast_math::tanh(100.0f) == Catch::Approx(1.0f));
+        REQUIRE(fast_math::tanh(-100.0f) == Catch::Approx(-1.0f));
+    }
+
+    SECTION("Test tanh relative error near 0") {
+        auto rel_error = [](auto kernel) {
+            auto x = linspace(-1e-3f, 1e-3f, 10001);
+            std::vector<float> out(x.size());
+            kernel(x.data(), out.data(), x.size());
+            double error = 0.0;
+            for (size_t i = 0; i < x.size(); i++) {
+                if (x[i] != 0.0f)
+                    error = std::max(error, std::abs(double(out[i]) / std::tanh(double(x[i])) - 1.0));
+            }
+            return error;
+        };
+        REQUIRE(rel_error(fast_math::tanh_array<Accuracy::Medium>) < 1e-6);
+        REQUIRE(rel_error(fast_math::tanh_array<Accuracy::High>) < 1e-6);
+        REQUIRE(fast_math::tanh(1e-30f) == 1e-30f);
+    }
+}
+
+TEST_CASE("Test PolyBLEP waveforms") {
+    const float dt = 0.01f;
+
+    SECTION("Test they match the naive waveforms away from the discontinuities") {
+        for (float p: {0.1f, 0.3f, 0.45f, 0.55f, 0.7f, 0.9f}) {
+            REQUIRE_THAT(polyblep::saw(p, dt), Catch::Matchers::WithinAbs(2.0f * p - 1.0f, 1e-6));
+            REQUIRE(polyblep::square(p, dt) == (p < 0.5f ? 1.0f : -1.0f));
+            REQUIRE_THAT(polyblep::triangle(p, dt),
+                         Catch::Matchers::WithinAbs(1.0f - 4.0f * std::abs(p - 0.5f), 1e-6));
+        }
+    }
+
+    SECTION("Test the steps are smoothed") {
+        //Halfway through the jump on both sides of it
+        REQUIRE_THAT(polyblep::saw(0.0f, dt), Catch::Matchers::WithinAbs(0.0f, 1e-6));
+        REQUIRE_THAT(polyblep::square(0.0f, dt), Catch::Matchers::WithinAbs(0.0f, 1e-6));
+        REQUIRE_THAT(polyblep::square(0.5f, dt), Catch::Matchers::WithinAbs(0.0f, 1e-6));
+        //and continuous across it
+        REQUIRE_THAT(polyblep::saw(0.999999f, dt), Catch::Matchers::WithinAbs(0.0f, 1e-3));
+        //The triangle corners are rounded instead
+        REQUIRE(polyblep::triangle(0.0f, dt) > -1.0f);
+        REQUIRE(polyblep::triangle(0.5f, dt) < 1.0f);
+    }
+
+    SECTION("Test the phase wraps both ways") {
+        REQUIRE_THAT(polyblep::advance(0.95f, 0.1f), Catch::Matchers::WithinAbs(0.05f, 1e-6));
+        REQUIRE_THAT(polyblep::advance(0.05f, -0.1f), Catch::Matchers::WithinAbs(0.95f, 1e-6));
+        //A frozen oscillator doesn't divide by zero
+        REQUIRE(std::isfinite(polyblep::saw(0.0f, 0.0f)));
+    }
+}
+
+TEST_CASE("Test filter coefficients") {
+    SECTION("Test the biquad modes at DC and Nyquist") {
+        //H(1) = (b0 + b1 + b2) / (1 + a1 + a2), H(-1) = (b0 - b1 + b2) / (1 - a1 + a2)
+        auto dc = [](const BiquadCoefficients&c) { return (c.b0 + c.b1 + c.b2) / (1.0f + c.a1 + c.a2); };
+        auto nyquist = [](const BiquadCoefficients&c) { return (c.b0 - c.b1 + c.b2) / (1.0f - c.a1 + c.a2); };
+        auto lowpass = filter::biquad_coefficients(filter::LOWPASS, 0.01f, 0.7071f);
+        REQUIRE_THAT(dc(lowpass), Catch::Matchers::WithinAbs(1.0, 1e-4));
+        REQUIRE_THAT(nyquist(lowpass), Catch::Matchers::WithinAbs(0.0, 1e-6));
+        auto highpass = filter::biquad_coefficients(filter::HIGHPASS, 0.01f, 0.7071f);
+        REQUIRE_THAT(dc(highpass), Catch::Matchers::WithinAbs(0.0, 1e-6));
+        REQUIRE_THAT(nyquist(highpass), Catch::Matchers::WithinAbs(1.0, 1e-4));
+        auto bandpass = filter::biquad_coefficients(filter::BANDPASS, 0.01f, 2.0f);
+        REQUIRE_THAT(dc(bandpass), Catch::Matchers::WithinAbs(0.0, 1e-6));
+        auto notch = filter::biquad_coefficients(filter::NOTCH, 0.01f, 2.0f);
+        REQUIRE_THAT(dc(notch), Catch::Matchers::WithinAbs(1.0, 1e-4));
+    }
+
+    SECTION("Test the SVF settles to the input through its lowpass") {
+        float ic1 = 0.0f;
+        float ic2 = 0.0f;
+        filter::SvfOutputs outputs{};
+        for (int i = 0; i < 2000; i++)
+            outputs = filter::svf_step(1.0f, 0.01f, 0.7071f, ic1, ic2);
+        REQUIRE_THAT(outputs.lowpass, Catch::Matchers::WithinAbs(1.0, 1e-4));
+        REQUIRE_THAT(outputs.bandpass, Catch::Matchers::WithinAbs(0.0, 1e-4));
+        REQUIRE_THAT(outputs.highpass, Catch::Matchers::WithinAbs(0.0, 1e-4));
+    }
+
+    SECTION("Test flushing") {
+        float s1 = 1e-7f;
+        float s2 = -1e-7f;
+        filter::flush(0.1f, s1, s2);
+        REQUIRE(s1 != 0.0f);
+        filter::flush(0.0f, s1, s2);
+        REQUIRE(s1 == 0.0f);
+        REQUIRE(s2 == 0.0f);
+    }
+}
+
+TEST_CASE("Test FFT") {
+    const size_t size = 256;
+    Fft fft(size);
+    REQUIRE(fft.bins() == 129);
+    REQUIRE_THROWS(Fft(100));
+    std::vector<float> x(size);
+    for (size_t i = 0; i < size; i++)
+        x[i] = std::sin(0.1f * float(i * i)) + 0.25f;
+
+    //Against the definition
+    std::vector<Fft::Complex> spectrum(fft.bins());
+    fft.forward(x.data(), spectrum.data());
+    double max_error = 0.0;
+    for (size_t k = 0; k < fft.bins(); k++) {
+        std::complex<double> expected = 0.0;
+        for (size_t i = 0; i < size; i++)
+            expected += double(x[i]) * std::polar(1.0, -2.0 * M_PI * double(k * i % size) / double(size));
+        max_error = std::max(max_error, std::abs(expected - std::complex<double>(spectrum[k])));
+    }
+    REQUIRE(max_error < 1e-3);
+
+    std::vector<float> back(size);
+    fft.inverse(spectrum.data(), back.data());
+    for (size_t i = 0; i < size; i++)
+        REQUIRE_THAT(back[i], Catch::Matchers::WithinAbs(x[i], 1e-5));
+}
+
+TEST_CASE("Test SIMD kernel dispatch") {
+    const auto best = detect_simd_level();
+    const auto initial = get_simd_level();
+    auto x = linspace(-4.0f, 4.0f, 1027);
+    std::vector<float> out(x.size());
+    std::vector<float> expected(x.size());
+
+    SECTION("Test every available level gives the same results") {
+        for (int i = 0; i <= (int)best; i++) {
+            auto level = SimdLevel(i);
+            set_simd_level(level);
+            REQUIRE(get_simd_level() == level);
+            REQUIRE(kernels().level == level);
+
+            //Odd sizes to go through the remainder loops too
+            REQUIRE_THAT(kernels().sum(x.data(), 1027), Catch::Matchers::WithinAbs(0.0, 1e-3));
+            REQUIRE(kernels().sum(x.data() + 1026, 1) == 4.0f);
+
+            kernels().affine(x.data(), out.data(), x.size(), 2.0f, 1.0f);
+            for (size_t j = 0; j < x.size(); j++)
+                REQUIRE(out[j] == x[j] * 2.0f + 1.0f);
+
+            fast_math::sin2pi_array(x.data(), out.data(), x.size());
+            for (size_t j = 0; j < x.size(); j++)
+                REQUIRE_THAT(out[j], Catch::Matchers::WithinAbs(fast_math::sin2pi(x[j]), 1e-6));
+            fast_math::tanh_array<Accuracy::Low>(x.data(), out.data(), x.size());
+            for (size_t j = 0; j < x.size(); j++)
+                REQUIRE_THAT(out[j], Catch::Matchers::WithinAbs(fast_math::tanh<Accuracy::Low>(x[j]), 1e-6));
+
+            //Envelopes with half of the gates on, in every stage
+            auto coefficients = envelope::adsr_coefficients(0.001f, 0.002f, 0.5f, 0.001f, 48000.0f);
+            std::vector<float> stages(x.size(), envelope::RELEASE);
+            std::vector<float> levels(x.size(), 0.0f);
+            std::vector<float> expected_stages = stages;
+            for (int step = 0; step < 200; step++) {
+                for (size_t j = 0; j < x.size(); j++)
+                    out[j] = x[j] > 0.0f && step < 150 ? 1.0f : 0.0f;
+                kernels().adsr(out.data(), stages.data(), levels.data(), x.size(), coefficients);
+                for (size_t j = 0; j < x.size(); j++)
+                    expected[j] = envelope::step(out[j], expected_stages[j], expected[j], coefficients);
+            }
+            for (size_t j = 0; j < x.size(); j++) {
+                REQUIRE_THAT(levels[j], Catch::Matchers::WithinAbs(expected[j], 1e-5));
+                REQUIRE(stages[j] == expected_stages[j]);
+            }
+            std::fill(expected.begin(), expected.end(), 0.0f);
+
+            //Filters at every cutoff up to Nyquist, fed with x
+            const size_t n = x.size();
+            std::vector<float> cutoffs = linspace(10.0f, 24000.0f, n);
+            std::vector<float> qs = linspace(0.1f, 10.0f, n);
+            std::vector<float> svf_state(4 * n, 0.0f);
+            std::vector<float> expected_state = svf_state;
+            const float smoothing = filter::smoothing_coefficient(48000.0f);
+            for (int step = 0; step < 10; step++) {
+                kernels().svf_bank({x.data(), out.data(), cutoffs.data(), qs.data(), svf_state.data(), n,
+                                    filter::HIGHPASS, 1.0f / 48000.0f, smoothing});
+                for (size_t j = 0; j < n; j++) {
+                    float&cutoff = expected_state[2 * n + j];
+                    float&q = expected_state[3 * n + j];
+                    cutoff = filter::smooth(cutoff, cutoffs[j], smoothing);
+                    q = filter::smooth(q, qs[j], smoothing);
+                    auto outputs = filter::svf_step(x[j], filter::normalized_cutoff(cutoff, 1.0f / 48000.0f), q,
+                                                    expected_state[j], expected_state[n + j]);
+                    REQUIRE_THAT(out[j], Catch::Matchers::WithinAbs(outputs.highpass, 1e-4));
+                }
+            }
+            std::vector<float> coefficients_soa(5 * n);
+            std::vector<float> biquad_state(2 * n, 0.0f);
+            std::vector<float> s1(n, 0.0f);
+            std::vector<float> s2(n, 0.0f);
+            for (size_t j = 0; j < n; j++) {
+                auto c = filter::biquad_coefficients(filter::BANDPASS, cutoffs[j] / 48000.0f, qs[j]);
+                const float values[] = {c.b0, c.b1, c.b2, c.a1, c.a2};
+                for (size_t k = 0; k < 5; k++)
+                    coefficients_soa[k * n + j] = values[k];
+            }
+            for (int step = 0; step < 10; step++) {
+                kernels().biquad_bank({x.data(), out.data(), coefficients_soa.data(), biquad_state.data(), n});
+                for (size_t j = 0; j < n; j++) {
+                    auto c = filter::biquad_coefficients(filter::BANDPASS, cutoffs[j] / 48000.0f, qs[j]);
+                    REQUIRE_THAT(out[j], Catch::Matchers::WithinAbs(filter::biquad_step(x[j], c, s1[j], s2[j]), 1e-4));
+                }
+            }
+
+            //The FDN matrices against their definitions
+            for (size_t lines: {4, 8, 16}) {
+                for (bool householder: {false, true}) {
+                    std::vector<float> values(x.begin() + 100, x.begin() + 100 + lines);
+                    std::vector<float> filters(lines, 0.5f);
+                    std::vector<float> gains(lines, 0.9f);
+                    std::vector<float> damped(lines);
+                    for (size_t j = 0; j < lines; j++)
+                        damped[j] = 0.9f * (values[j] + (0.5f - values[j]) * 0.2f);
+                    auto lines_out = values;
+                    kernels().fdn({lines_out.data(), filters.data(), gains.data(), lines, 0.2f, 1.0f, -1.0f,
+                                   householder});
+                    for (size_t r = 0; r < lines; r++) {
+                        float expected_line = (r & 1) ? -1.0f : 1.0f;
+                        for (size_t c = 0; c < lines; c++) {
+                            const float entry = householder
+                                                    ? (r == c ? 1.0f : 0.0f) - 2.0f / float(lines)
+                                                    : (std::popcount(r & c) & 1 ? -1.0f : 1.0f) /
+                                                      std::sqrt(float(lines));
+                            expected_line += entry * damped[c];
+                        }
+                        REQUIRE_THAT(lines_out[r], Catch::Matchers::WithinAbs(expected_line, 1e-4));
+                        REQUIRE_THAT(filters[r], Catch::Matchers::WithinAbs(damped[r] / 0.9f, 1e-5));
+                    }
+                }
+            }
+
+            //Every group size of the transpose, and frames past a chunk
+            const auto planar = linspace(-1.0f, 1.0f, 15 * 101);
+            for (size_t channels: {1, 2, 6, 8, 15}) {
+                const size_t frames = 100;
+                std::vector<float> interleaved(channels * frames);
+                kernels().interleave(planar.data(), 101, channels, frames, interleaved.data());
+                size_t mismatches = 0;
+                for (size_t c = 0; c < channels; c++) {
+                    for (size_t j = 0; j < frames; j++)
+                        mismatches += interleaved[j * channels + c] != planar[c * 101 + j];
+                }
+                REQUIRE(mismatches == 0);
+            }
+
+            //Sources in a different order than their gains, over more than a chunk
+            std::vector<const float *> sources(n);
+            float expected_sum = 0.0f;
+            for (size_t i = 0; i < n; i++) {
+                sources[i] = &x[(i * 7) % n];
+                expected_sum += x[(i * 7) % n] * x[i];
+            }
+            REQUIRE_THAT(kernels().gather_sum(sources.data(), x.data(), n),
+                         Catch::Matchers::WithinRel(expected_sum, 1e-5f));
+        }
+    }
+
+    SECTION("Test unsupported levels are refused") {
+        if (best != SimdLevel::AVX512)
+            REQUIRE_THROWS(set_simd_level(SimdLevel::AVX512));
+        REQUIRE(get_simd_level() == initial);
+    }
+
+    SECTION("Test level names") {
+        REQUIRE(parse_simd_level("AVX2") == SimdLevel::AVX2);
+        REQUIRE(parse_simd_level(simd_level_name(SimdLevel::Scalar)) == SimdLevel::Scalar);
+        REQUIRE_THROWS(parse_simd_level("neon"));
+    }
+    set_simd_level(initial);
+}
+
+TEST_CASE("Benchmark fast math against libm") {
+    auto x = linspace(0.0f, 1000.0f, 4096);
+    std::vector<float> out(x.size());
+
+    BENCHMARK("libm sinf") {
+        for (size_t i = 0; i < x.size(); i++)
+            out[i] = sinf(fast_math::TWO_PI * x[i]);
+        return out[0];
+    };
+    BENCHMARK("fast sin2pi Low") {
+        fast_math::sin2pi_array<Accuracy::Low>(x.data(), out.data(), x.size());
+        return out[0];
+    };
+    BENCHMARK("fast sin2pi High") {
+        fast_math::sin2pi_array<Accuracy::High>(x.data(), out.data(), x.size());
+        return out[0];
+    };
+    for (int i = 0; i <= (int)detect_simd_level(); i++) {
+        set_simd_level(SimdLevel(i));
+        BENCHMARK(std::string("kernels sin2pi High ") + simd_level_name(SimdLevel(i))) {
+            kernels().sin2pi[(size_t)Accuracy::High](x.data(), out.data(), x.size());
+            return out[0];
+        };
+        BENCHMARK(std::string("kernels sum ") + simd_level_name(SimdLevel(i))) {
+            return kernels().sum(x.data(), x.size());
+        };
+    }
+    set_simd_level(detect_simd_level());
+
+    BENCHMARK("libm exp2f") {
+        for (size_t i = 0; i < x.size(); i++)
+            out[i] = exp2f(x[i] * 0.1f);
+        return out[0];
+    };
+    BENCHMARK("fast exp2 High") {
+        for (size_t i = 0; i < x.size(); i++)
+            out[i] = fast_math::exp2(x[i] * 0.1f);
+        return out[0];
+    };
+    BENCHMARK("libm tanhf") {
+        for (size_t i = 0; i < x.size(); i++)
+            out[i] = tanhf(x[i] * 0.01f);
+        return out[0];
+    };
+    BENCHMARK("fast tanh High") {
+        for (size_t i = 0; i < x.size(); i++)
+            out[i] = fast_math::tanh(x[i] * 0.01f);
+        return out[0];
+    };
+}
+
+int main(int argc, char *argv[]) {
+    Catch::Session session; // There must be exactly one instance
+
+    int returnCode = session.applyCommandLine(argc, argv);
+    if (returnCode != 0) // Indicates a command line error
+        return returnCode;
+
+    return session.run();
+}
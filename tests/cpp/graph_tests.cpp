@@ -6,9 +6,26 @@
 #include "../../src/core/audio_engine.h"
 #include "../../src/blocks/mixers.h"
 #include "../../src/blocks/oscillators.h"
+#include "../../src/blocks/constants.h"
+#include "../../src/blocks/additive.h"
+#include "../../src/blocks/fm.h"
+#include "../../src/blocks/envelopes.h"
+#include "../../src/blocks/filters.h"
+#include "../../src/blocks/delays.h"
+#include "../../src/blocks/reverb.h"
+#include "../../src/blocks/convolution.h"
+#include "../../src/blocks/samples.h"
+#include "../../src/blocks/audio_input.h"
+#include "../../src/blocks/aux_bus.h"
+#include "../../src/core/utils/envelope.h"
+#include "../../src/core/audio_file.h"
+#include "../../src/core/kernels/kernels.h"
 #include <entt/entt.hpp>
 #include <catch2/catch_all.hpp>
 
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <thread>
 
 using namespace AAri;
@@ -118,7 +135,7 @@ TEST_CASE("Testing audio start stop with graph callback", "[AudioEngine]") {
         engine.set_output_ref(output_id, 2);
         //Wire oscillator to output :
         engine.add_wire_to_mixer(osc, output_mixer, osc_block.outputIds[0], 0,
-                                 Wire::transmit_mono_to_stereo_mixer<2>);
+                                 Wire::transmit_to_mixer);
         //Start and stop audio:
         //Sleep for 3 seconds:
         std::this_thread::sleep_for(std::chrono::seconds(3));
@@ -390,9 +407,9 @@ TEST_CASE("Test mixers") {
     SECTION("Test mono mixer") {
         auto mixer = MonoMixer<4>::create(&engine);
         engine.add_wire_to_mixer(block1, mixer, getOutputId(registry, block1, 0), 0,
-                                 Wire::transmit_to_mono_mixer<4>);
+                                 Wire::transmit_to_mixer);
         engine.add_wire_to_mixer(block2, mixer, getOutputId(registry, block2, 0), 1,
-                                 Wire::transmit_to_mono_mixer<4>);
+                                 Wire::transmit_to_mixer);
 
         registry.get<Input1D>(registry.get<Block>(block1).inputIds[0]).value = 3.0f;
         registry.get<Input1D>(registry.get<Block>(block2).inputIds[0]).value = 2.0f;
@@ -406,8 +423,1872 @@ TEST_CASE("Test mixers") {
         REQUIRE(output2.value == 5.0f);
         REQUIRE(output3.value == 11.0f);
     }
+
+    SECTION("Test mixer of any size") {
+        //More sources than a block takes wires
+        const size_t n = 40;
+        auto mixer = Mixer::create(&engine, n, 2);
+        std::vector<entt::entity> sources, outputs;
+        std::vector<size_t> slots;
+        {
+            auto [reg, lock] = engine.get_graph_registry();
+            for (size_t i = 0; i < n; i++) {
+                sources.push_back(create_times_two(reg));
+                outputs.push_back(getOutputId(reg, sources.back(), 0));
+                reg.get<Input1D>(getInputId(reg, sources.back(), 0)).value = float(i);
+                slots.push_back(i);
+            }
+        }
+        std::vector<float> offsets(n, 0.0f);
+        offsets[3] = 1.0f;
+        engine.add_wires_to_mixer(sources, std::vector<entt::entity>(n, mixer), outputs, slots,
+                                  Wire::transmit_to_mixer, std::vector<float>(n, 0.5f), offsets);
+        graph.process(ctx);
+        auto&out = registry.get<OutputND<2>>(getOutputId(registry, mixer, 0));
+        REQUIRE(out.value[0] == 781.0f);
+        REQUIRE(out.value[1] == 781.0f);
+
+        //Slots are checked and take a single wire each
+        REQUIRE_THROWS(engine.add_wire_to_mixer(block1, mixer, getOutputId(registry, block1, 0), 3,
+                                                Wire::transmit_to_mixer));
+        REQUIRE_THROWS(engine.add_wire_to_mixer(block1, mixer, getOutputId(registry, block1, 0), n,
+                                                Wire::transmit_to_mixer));
+        REQUIRE_THROWS(engine.add_wire_to_mixer(block1, block2, getOutputId(registry, block1, 0), 0,
+                                                Wire::transmit_to_mixer));
+
+        //Only mono and stereo outputs are mixed, and only through transmit_to_mixer
+        auto other = Mixer::create(&engine, 1, 2);
+        REQUIRE_THROWS(engine.add_wire_to_mixer(block1, other, getInputId(registry, block1, 0), 0,
+                                                Wire::transmit_to_mixer));
+        REQUIRE_THROWS(engine.add_wire_to_mixer(block1, other, getOutputId(registry, block1, 0), 0,
+                                                Wire::transmit_1d_to_1d));
+        REQUIRE_THROWS(engine.add_wire(block1, other, getOutputId(registry, block1, 0),
+                                       getInputId(registry, other, 0), Wire::transmit_to_mixer));
+        engine.add_wire_to_mixer(block1, other, getOutputId(registry, block1, 0), 0, Wire::transmit_to_mixer);
+    }
+}
+
+
+TEST_CASE("Test bulk graph construction") {
+    AudioEngine engine;
+    AudioContext ctx{48000.0f, 1.0f / 48000.0f, 0.5};
+    auto&graph = engine._test_only_get_graph();
+    auto&registry = graph.registry;
+
+    SECTION("Test bulk block creation") {
+        std::vector<float> freqs = {110.0f, 220.0f, 330.0f};
+        std::vector<float> amps = {1.0f, 0.5f, 0.25f};
+        auto oscs = SineOsc::create_many(&engine, freqs, amps);
+        REQUIRE(oscs.size() == 3);
+        for (size_t i = 0; i < oscs.size(); i++) {
+            REQUIRE(registry.get<Input1D>(getInputId(registry, oscs[i], 1)).value == freqs[i]);
+            REQUIRE(registry.get<Input1D>(getInputId(registry, oscs[i], 2)).value == amps[i]);
+        }
+        auto mixers = MonoMixer<4>::create_many(&engine, 2);
+        REQUIRE(mixers.size() == 2);
+        REQUIRE(engine.get_blocks().size() == 5);
+
+        REQUIRE_THROWS(SineOsc::create_many(&engine, freqs, {1.0f}));
+    }
+
+    SECTION("Test bulk wiring") {
+        auto [reg, guard] = engine.get_graph_registry();
+        std::vector<entt::entity> sources, targets, outputs, inputs;
+        for (int i = 0; i < 4; i++) {
+            sources.push_back(create_times_two(reg));
+            targets.push_back(create_plus_three(reg));
+            outputs.push_back(getOutputId(reg, sources.back(), 0));
+            inputs.push_back(getInputId(reg, targets.back(), 0));
+            reg.get<Input1D>(getInputId(reg, sources.back(), 0)).value = float(i);
+        }
+        guard.reset();
+
+        std::vector<float> gains = {1.0f, 1.0f, 2.0f, 2.0f};
+        std::vector<float> offsets = {0.0f, 1.0f, 0.0f, 1.0f};
+        auto wires = engine.add_wires(sources, targets, outputs, inputs, Wire::transmit_1d_to_1d, gains, offsets);
+        REQUIRE(wires.size() == 4);
+        graph.process(ctx);
+        for (int i = 0; i < 4; i++) {
+            REQUIRE(engine.view_wire(wires[i]).to_input == inputs[i]);
+            auto expected = (2.0f * float(i)) * gains[i] + offsets[i] + 3.0f;
+            REQUIRE(registry.get<Output1D>(getOutputId(registry, targets[i], 0)).value == expected);
+        }
+
+        //Connecting an input twice, either within the batch or to an existing wire, must throw
+        REQUIRE_THROWS(engine.add_wires({sources[0]}, {targets[0]}, {outputs[0]}, {inputs[0]},
+            Wire::transmit_1d_to_1d, {1.0f}, {0.0f}));
+        REQUIRE_THROWS(engine.add_wires({sources[0], sources[1]}, {targets[0], targets[0]},
+            {outputs[0], outputs[1]}, {inputs[0], inputs[0]},
+            Wire::transmit_1d_to_1d, {1.0f, 1.0f}, {0.0f, 0.0f}));
+    }
+
+    SECTION("Test bulk wiring to mixers") {
+        auto oscs = SineOsc::create_many(&engine, {110.0f, 220.0f, 110.0f, 220.0f}, {1.0f, 1.0f, 1.0f, 1.0f});
+        auto mixers = MonoMixer<2>::create_many(&engine, 2);
+        std::vector<entt::entity> outputs;
+        for (auto osc: oscs)
+            outputs.push_back(getOutputId(registry, osc, 0));
+
+        //The same slot index can be used on two different mixers
+        auto wires = engine.add_wires_to_mixer(oscs, {mixers[0], mixers[0], mixers[1], mixers[1]}, outputs,
+                                               {0, 1, 0, 1}, Wire::transmit_to_mixer,
+                                               {1.0f, 1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 0.0f});
+        REQUIRE(wires.size() == 4);
+        for (int i = 0; i < 100; i++)
+            graph.process(ctx);
+        auto&out1 = registry.get<Output1D>(getOutputId(registry, mixers[0], 0));
+        auto&out2 = registry.get<Output1D>(getOutputId(registry, mixers[1], 0));
+        REQUIRE(out1.value != 0.0f);
+        REQUIRE(out1.value == out2.value);
+    }
+}
+
+TEST_CASE("Test graph snapshots") {
+    AudioContext ctx{48000.0f, 1.0f / 48000.0f, 0.5};
+    auto path = (std::filesystem::temp_directory_path() / "aari_snapshot_test.aari").string();
+
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    auto oscs = SineOsc::create_many(&engine, {110.0f, 220.0f, 5.0f}, {1.0f, 0.5f, 1.0f});
+    auto mixer = StereoMixer<4>::create(&engine);
+    auto mixer_out = getOutputId(registry, mixer, 0);
+    engine.set_output_ref(mixer_out, 2);
+    engine.add_wire_to_mixer(oscs[0], mixer, getOutputId(registry, oscs[0], 0), 0,
+                             Wire::transmit_to_mixer);
+    engine.add_wire_to_mixer(oscs[1], mixer, getOutputId(registry, oscs[1], 0), 1,
+                             Wire::transmit_to_mixer, 0.5f, 0.1f);
+    //Frequency modulation of the second oscillator by the third
+    engine.add_wire(oscs[2], oscs[1], getOutputId(registry, oscs[2], 0), getInputId(registry, oscs[1], 1),
+                    Wire::transmit_1d_to_1d, 10.0f, 220.0f);
+    for (int i = 0; i < 10; i++)
+        engine._test_only_get_graph().process(ctx);
+
+    SECTION("Test save and load") {
+        engine.save_snapshot(path);
+
+        AudioEngine loaded_engine;
+        auto&loaded_registry = loaded_engine._test_only_get_graph().registry;
+        auto blocks = loaded_engine.load_snapshot(path);
+        REQUIRE(blocks.size() == 4);
+        REQUIRE(loaded_engine.get_blocks().size() == 4);
+        REQUIRE(loaded_registry.view<Wire>().size() == 3);
+
+        auto [loaded_out, loaded_width] = loaded_engine.get_output_ref();
+        REQUIRE(loaded_width == 2);
+
+        //The loaded graph starts from the same state and must produce the same output
+        auto&out = registry.get<OutputND<2>>(mixer_out);
+        auto&loaded = loaded_registry.get<OutputND<2>>(loaded_out);
+        for (int i = 0; i < 100; i++) {
+            engine._test_only_get_graph().process(ctx);
+            loaded_engine._test_only_get_graph().process(ctx);
+            REQUIRE(out.value[0] == loaded.value[0]);
+            REQUIRE(out.value[1] == loaded.value[1]);
+        }
+    }
+
+    SECTION("Test loading into an engine that already has blocks") {
+        engine.save_snapshot(path);
+
+        //Enough entities before the loaded ones that their ids don't match the saved ones
+        AudioEngine loaded_engine;
+        auto&loaded_registry = loaded_engine._test_only_get_graph().registry;
+        auto existing = SineOsc::create_many(&loaded_engine, std::vector<float>(8, 110.0f),
+                                             std::vector<float>(8, 1.0f));
+        auto existing_mixer = MonoMixer<2>::create(&loaded_engine);
+        loaded_engine.add_wire_to_mixer(existing[0], existing_mixer, getOutputId(loaded_registry, existing[0], 0),
+                                        0, Wire::transmit_to_mixer);
+        auto blocks = loaded_engine.load_snapshot(path);
+        REQUIRE(blocks.size() == 4);
+        REQUIRE(loaded_engine.get_blocks().size() == 13);
+        REQUIRE(loaded_registry.view<Wire>().size() == 4);
+
+        auto [loaded_out, loaded_width] = loaded_engine.get_output_ref();
+        auto&out = registry.get<OutputND<2>>(mixer_out);
+        auto&loaded = loaded_registry.get<OutputND<2>>(loaded_out);
+        for (int i = 0; i < 100; i++) {
+            engine._test_only_get_graph().process(ctx);
+            loaded_engine._test_only_get_graph().process(ctx);
+            REQUIRE(out.value[0] == loaded.value[0]);
+            REQUIRE(out.value[1] == loaded.value[1]);
+        }
+    }
+
+    //Save the graph and rewrite records of the file, for files that a save doesn't make
+    auto save_patched = [&](auto patch) {
+        engine.save_snapshot(path);
+        std::vector<char> bytes(std::filesystem::file_size(path));
+        std::ifstream(path, std::ios::binary).read(bytes.data(), (std::streamsize)bytes.size());
+        auto* header = reinterpret_cast<snapshot::SnapshotHeader *>(bytes.data());
+        auto* ports = reinterpret_cast<snapshot::PortRecord *>(
+            bytes.data() + sizeof(snapshot::SnapshotHeader) +
+            (header->n_block_kinds + header->n_transmit_kinds) * sizeof(snapshot::KindName));
+        auto* blocks = reinterpret_cast<snapshot::BlockRecord *>(ports + header->n_ports);
+        auto* wires = reinterpret_cast<snapshot::WireRecord *>(blocks + header->n_blocks);
+        patch(*header, ports, blocks, wires);
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), (std::streamsize)bytes.size());
+    };
+
+    SECTION("Test invalid snapshots") {
+        REQUIRE_THROWS(engine.load_snapshot(path + ".does_not_exist"));
+
+        engine.save_snapshot(path);
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+        auto n_blocks = engine.get_blocks().size();
+        REQUIRE_THROWS(engine.load_snapshot(path));
+        REQUIRE(engine.get_blocks().size() == n_blocks);
+    }
+
+    SECTION("Test port types that don't match the blocks or the wires") {
+        auto load_patched = [&](auto patch) {
+            save_patched(patch);
+            AudioEngine loaded_engine;
+            REQUIRE_THROWS(loaded_engine.load_snapshot(path));
+            REQUIRE(loaded_engine.get_blocks().empty());
+        };
+        //An oscillator input that is an array
+        load_patched([](auto&header, auto* ports, auto*, auto*) {
+            auto* port = std::find_if(ports, ports + header.n_ports, [](const auto&port) {
+                return port.kind == snapshot::PortKind::Input1D;
+            });
+            port->kind = snapshot::PortKind::InputArray;
+        });
+        //The frequency modulation wire with the transmit function of a mixer wire
+        load_patched([](auto&header, auto* ports, auto*, auto* wires) {
+            auto* fm = std::find_if(wires, wires + header.n_wires, [&](const auto&wire) {
+                return ports[wire.to_input].kind == snapshot::PortKind::Input1D;
+            });
+            auto* mix = std::find_if(wires, wires + header.n_wires, [&](const auto&wire) {
+                return ports[wire.to_input].kind == snapshot::PortKind::MixerInput;
+            });
+            fm->transmit_kind = mix->transmit_kind;
+        });
+        //A stereo output read as a mono one
+        load_patched([](auto&header, auto*, auto*, auto*) { header.output_width = 1; });
+    }
+
+    SECTION("Test snapshots whose graph can't be sorted") {
+        //The frequency modulation wire loops back into the modulator
+        save_patched([](auto&header, auto* ports, auto* blocks, auto* wires) {
+            auto* fm = std::find_if(wires, wires + header.n_wires, [&](const auto&wire) {
+                return ports[wire.to_input].kind == snapshot::PortKind::Input1D;
+            });
+            fm->to_block = fm->from_block;
+            fm->to_input = blocks[fm->from_block].inputs[0];
+        });
+        AudioEngine loaded_engine(48000, 512, true);
+        auto&loaded_registry = loaded_engine._test_only_get_graph().registry;
+        auto constant = Constant::create(&loaded_engine, 0.5f);
+        loaded_engine.set_output_ref(getOutputId(loaded_registry, constant, 0), 1);
+        auto n_ports = [&]() {
+            return loaded_registry.view<Input1D>().size() + loaded_registry.view<Output1D>().size();
+        };
+        const auto n_constant_ports = n_ports();
+        REQUIRE_THROWS(loaded_engine.load_snapshot(path));
+        REQUIRE(loaded_engine.get_blocks().size() == 1);
+        REQUIRE(loaded_registry.view<Wire>().size() == 0);
+        REQUIRE(n_ports() == n_constant_ports);
+        REQUIRE(loaded_engine.get_output_ref() == std::make_tuple(getOutputId(loaded_registry, constant, 0), 1));
+        float buffer[2 * 4];
+        loaded_engine.render(buffer, 4);
+        REQUIRE(buffer[6] == 0.5f);
+    }
+
+    SECTION("Test every block kind") {
+        AudioEngine all_engine;
+        SineOsc::create(&all_engine);
+        WavetableOsc::create(&all_engine);
+        WavetableOsc::create(&all_engine, Wavetables::SINE, 440.0f, 1.0f, WavetableOsc::Interpolation::Cubic);
+        SawOsc::create(&all_engine);
+        SquareOsc::create(&all_engine);
+        TriOsc::create(&all_engine);
+        AdditiveBank::create(&all_engine, {100.0f, 200.0f}, {1.0f, 0.5f});
+        FmVoices::create(&all_engine, {100.0f, 200.0f});
+        Adsr::create(&all_engine);
+        Ar::create(&all_engine);
+        AdsrBank::create(&all_engine, 2);
+        Biquad::create(&all_engine);
+        Svf::create(&all_engine);
+        BiquadCascade::create(&all_engine, 2);
+        FilterBank::create(&all_engine, {200.0f, 2000.0f});
+        Delay::create(&all_engine, 0.01f, 0.005f);
+        Comb::create(&all_engine, 0.01f, 0.005f, 0.5f, 0.0f);
+        Allpass::create(&all_engine, 0.01f, 0.005f, 0.5f);
+        FdnReverb::create(&all_engine);
+        Convolution::create(&all_engine, std::vector<float>{1.0f, 0.5f});
+        AudioInput::create(&all_engine, 0, 2);
+        AuxBus::create(&all_engine, 1);
+        AuxBus::create(&all_engine, 2);
+        Constant::create(&all_engine, 0.5f);
+        MonoMixer<2>::create(&all_engine);
+        StereoMixer<2>::create(&all_engine);
+        //Samplers need a loaded sample and are left out
+        all_engine.save_snapshot(path);
+
+        AudioEngine loaded_engine;
+        REQUIRE(loaded_engine.load_snapshot(path).size() == all_engine.get_blocks().size());
+    }
+
+    SECTION("Test unserialisable blocks") {
+        auto [reg, guard] = engine.get_graph_registry();
+        create_times_two(reg);
+        guard.reset();
+        REQUIRE_THROWS(engine.save_snapshot(path));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Test headless rendering") {
+    AudioEngine engine(48000, 512, true);
+    REQUIRE(engine.is_headless());
+    REQUIRE_THROWS(engine.startAudio());
+
+    std::vector<float> buffer(2 * 256, 1.0f);
+    SECTION("Test silence without output") {
+        engine.render(buffer.data(), 256);
+        for (auto sample: buffer)
+            REQUIRE(sample == 0.0f);
+    }
+    SECTION("Test rendering a sine") {
+        auto&registry = engine._test_only_get_graph().registry;
+        auto osc = SineOsc::create(&engine, 1.0f, 0.5f);
+        engine.set_output_ref(getOutputId(registry, osc, 0), 1);
+        engine.render(buffer.data(), 256);
+        for (size_t i = 0; i < 256; i++) {
+            //Mono outputs are duplicated on both channels
+            REQUIRE(buffer[2 * i] == buffer[2 * i + 1]);
+            auto t = float(i + 1) / 48000.0f;
+            REQUIRE_THAT(buffer[2 * i], Catch::Matchers::WithinAbs(0.5f * sinf(2.0f * PI * t), 1e-4));
+        }
+    }
+}
+
+TEST_CASE("Test dead block culling") {
+    AudioEngine engine;
+    auto [registry, guard] = engine.get_graph_registry();
+    auto block1 = create_times_two(registry);
+    auto block2 = create_plus_three(registry);
+    auto block3 = create_plus_three(registry);
+    guard.reset();
+
+    AudioContext ctx{48000.0f, 1.0f / 48000.0f, 0.5};
+    auto&graph = engine._test_only_get_graph();
+    registry.get<Input1D>(getInputId(registry, block1, 0)).value = 1.0f;
+    auto&output1 = registry.get<Output1D>(getOutputId(registry, block1, 0));
+    auto&output2 = registry.get<Output1D>(getOutputId(registry, block2, 0));
+    auto&output3 = registry.get<Output1D>(getOutputId(registry, block3, 0));
+
+    //block1 -> block2 -> output, block3 is not connected to anything
+    engine.add_wire(block1, block2, getOutputId(registry, block1, 0),
+                    getInputId(registry, block2, 0), Wire::transmit_1d_to_1d);
+    engine.set_output_ref(getOutputId(registry, block2, 0), 1);
+
+    SECTION("Test unconnected blocks are skipped") {
+        graph.process(ctx);
+        REQUIRE(output1.value == 2.0f);
+        REQUIRE(output2.value == 5.0f);
+        REQUIRE(output3.value == 0.0f);
+        REQUIRE(registry.all_of<Dormant>(block3));
+        REQUIRE(!registry.all_of<Dormant>(block1));
+    }
+
+    SECTION("Test blocks are re-included when connected") {
+        auto wire = engine.add_wire(block2, block3, getOutputId(registry, block2, 0),
+                                    getInputId(registry, block3, 0), Wire::transmit_1d_to_1d);
+        engine.set_output_ref(getOutputId(registry, block3, 0), 1);
+        graph.process(ctx);
+        REQUIRE(output3.value == 8.0f);
+
+        //Now block 3 is the output and the others don't feed it anymore
+        engine.remove_wire(wire);
+        REQUIRE(registry.all_of<Dormant>(block1));
+        REQUIRE(registry.all_of<Dormant>(block2));
+        REQUIRE(!registry.all_of<Dormant>(block3));
+    }
+
+    SECTION("Test taps") {
+        engine.add_tap(getOutputId(registry, block3, 0));
+        engine.add_tap(getOutputId(registry, block3, 0));
+        graph.process(ctx);
+        REQUIRE(output3.value == 3.0f);
+
+        //Taps are counted
+        engine.remove_tap(getOutputId(registry, block3, 0));
+        REQUIRE(!registry.all_of<Dormant>(block3));
+        engine.remove_tap(getOutputId(registry, block3, 0));
+        REQUIRE(registry.all_of<Dormant>(block3));
+    }
+}
+
+TEST_CASE("Test silence detection and sleeping") {
+    AudioEngine engine;
+    AudioContext ctx{48000.0f, 1.0f / 48000.0f, 0.5};
+    auto&graph = engine._test_only_get_graph();
+    auto&registry = graph.registry;
+
+    auto oscs = SineOsc::create_many(&engine, {110.0f, 220.0f}, {0.0f, 0.0f});
+    auto mixer = MonoMixer<2>::create(&engine);
+    engine.add_wires_to_mixer(oscs, {mixer, mixer},
+                              {getOutputId(registry, oscs[0], 0), getOutputId(registry, oscs[1], 0)},
+                              {0, 1}, Wire::transmit_to_mixer, {1.0f, 1.0f}, {0.0f, 0.0f});
+    auto&out = registry.get<Output1D>(getOutputId(registry, mixer, 0));
+    auto&phase = registry.get<Input1D>(getInputId(registry, oscs[0], 0));
+
+    SECTION("Test silent blocks fall asleep") {
+        graph.process(ctx);
+        graph.process(ctx);
+        REQUIRE(registry.get<Silence>(oscs[0]).asleep);
+        REQUIRE(registry.get<Silence>(oscs[1]).asleep);
+        REQUIRE(registry.get<Silence>(mixer).asleep);
+        REQUIRE(out.value == 0.0f);
+
+        //Sleeping oscillators are not processed so their phase doesn't move
+        auto sleeping_phase = phase.value;
+        graph.process(ctx);
+        REQUIRE(phase.value == sleeping_phase);
+    }
+
+    SECTION("Test blocks wake up when an input changes") {
+        for (int i = 0; i < 4; i++)
+            graph.process(ctx);
+        engine.set_input_1d(getInputId(registry, oscs[0], 2), 1.0f);
+        graph.process(ctx);
+        REQUIRE(!registry.get<Silence>(oscs[0]).asleep);
+        REQUIRE(!registry.get<Silence>(mixer).asleep);
+        REQUIRE(out.value != 0.0f);
+        //The other oscillator is still silent and goes back to sleep
+        graph.process(ctx);
+        REQUIRE(registry.get<Silence>(oscs[1]).asleep);
+
+        //And the mixer sleeps again once the oscillator is silent
+        engine.set_input_1d(getInputId(registry, oscs[0], 2), 0.0f);
+        graph.process(ctx);
+        graph.process(ctx);
+        REQUIRE(registry.get<Silence>(mixer).asleep);
+        REQUIRE(out.value == 0.0f);
+    }
+
+    SECTION("Test blocks fed by blocks that never sleep stay awake") {
+        auto [reg, guard] = engine.get_graph_registry();
+        auto source = create_times_two(reg);
+        guard.reset();
+        engine.add_wire(source, oscs[0], getOutputId(registry, source, 0), getInputId(registry, oscs[0], 1),
+                        Wire::transmit_1d_to_1d);
+        for (int i = 0; i < 4; i++)
+            graph.process(ctx);
+        REQUIRE(!registry.get<Silence>(oscs[0]).asleep);
+        REQUIRE(!registry.get<Silence>(mixer).asleep);
+    }
+}
+
+TEST_CASE("Test constant folding and wire fusion") {
+    AudioEngine engine;
+    AudioContext ctx{48000.0f, 1.0f / 48000.0f, 0.5};
+    auto&graph = engine._test_only_get_graph();
+    auto&registry = graph.registry;
+
+    auto [reg, guard] = engine.get_graph_registry();
+    auto source = create_times_two(reg);
+    auto sink = create_plus_three(reg);
+    guard.reset();
+    auto constant = Constant::create(&engine, 0.5f);
+    auto osc = SineOsc::create(&engine, 440.0f, 1.0f);
+    auto amp = getInputId(registry, osc, 2);
+    engine.set_output_ref(getOutputId(registry, osc, 0), 1);
+
+    SECTION("Test constants are folded into the inputs they feed") {
+        auto wire = engine.add_wire(constant, osc, getOutputId(registry, constant, 0), amp,
+                                    Wire::transmit_1d_to_1d, 2.0f, 1.0f);
+        REQUIRE(registry.all_of<Folded>(wire));
+        REQUIRE(registry.get<Input1D>(amp).value == 2.0f);
+        REQUIRE(registry.get<WiresToBlock>(osc).input_wire_ids[0] == entt::null);
+        REQUIRE(registry.all_of<Dormant>(constant));
+
+        //Changing the constant or the wire updates the folded value
+        engine.set_input_1d(getInputId(registry, constant, 0), 1.0f);
+        REQUIRE(registry.get<Input1D>(amp).value == 3.0f);
+        engine.tweak_wire_offset(wire, 0.0f);
+        REQUIRE(registry.get<Input1D>(amp).value == 2.0f);
+        graph.process(ctx);
+        graph.process(ctx);
+        REQUIRE(registry.get<Input1D>(amp).value == 2.0f);
+
+        //Chains of constants are folded too
+        auto constant2 = Constant::create(&engine, 0.0f);
+        engine.remove_wire(wire);
+        engine.add_wire(constant2, constant, getOutputId(registry, constant2, 0),
+                        getInputId(registry, constant, 0), Wire::transmit_1d_to_1d, 1.0f, 0.25f);
+        engine.add_wire(constant, osc, getOutputId(registry, constant, 0), amp, Wire::transmit_1d_to_1d);
+        REQUIRE(registry.get<Input1D>(amp).value == 0.25f);
+        REQUIRE(registry.all_of<Dormant>(constant2));
+
+        //Folding is undone when the wire is removed
+        engine.remove_wire(*engine.get_wire_to_input(amp));
+        engine.set_input_1d(amp, 0.75f);
+        graph.process(ctx);
+        REQUIRE(registry.get<Input1D>(amp).value == 0.75f);
+    }
+
+    SECTION("Test wires through passthrough constants are fused") {
+        auto freq = getInputId(registry, osc, 1);
+        auto wire1 = engine.add_wire(source, constant, getOutputId(registry, source, 0),
+                                     getInputId(registry, constant, 0), Wire::transmit_1d_to_1d, 3.0f, 1.0f);
+        auto wire2 = engine.add_wire(constant, osc, getOutputId(registry, constant, 0), freq,
+                                     Wire::transmit_1d_to_1d, 2.0f, 5.0f);
+        REQUIRE(registry.all_of<Fused>(wire2));
+        REQUIRE(registry.get<Fused>(wire2).wire.from_block == source);
+        REQUIRE(registry.all_of<Dormant>(constant));
+
+        registry.get<Input1D>(getInputId(registry, source, 0)).value = 10.0f;
+        graph.process(ctx);
+        REQUIRE(registry.get<Input1D>(freq).value == 2.0f * (3.0f * 20.0f + 1.0f) + 5.0f);
+
+        engine.tweak_wire_gain(wire1, 1.0f);
+        graph.process(ctx);
+        REQUIRE(registry.get<Input1D>(freq).value == 2.0f * (20.0f + 1.0f) + 5.0f);
+
+        //A tapped passthrough is still processed
+        engine.add_tap(getOutputId(registry, constant, 0));
+        graph.process(ctx);
+        REQUIRE(registry.get<Output1D>(getOutputId(registry, constant, 0)).value == 21.0f);
+    }
+
+    SECTION("Test wires with unknown transmit functions are left alone") {
+        auto wire = engine.add_wire(constant, sink, getOutputId(registry, constant, 0),
+                                    getInputId(registry, sink, 0),
+                                    [](entt::registry&registry, const Wire&wire) {
+                                        Wire::transmit_1d_to_1d(registry, wire);
+                                    });
+        REQUIRE(!registry.all_of<Folded>(wire));
+        engine.set_output_ref(getOutputId(registry, sink, 0), 1);
+        graph.process(ctx);
+        REQUIRE(registry.get<Output1D>(getOutputId(registry, sink, 0)).value == 3.5f);
+    }
+}
+
+TEST_CASE("Test wavetable oscillator") {
+    auto&tables = Wavetables::instance();
+
+    SECTION("Test the built in tables") {
+        auto&sine = tables.get(Wavetables::SINE);
+        auto&saw = tables.get(Wavetables::SAW);
+        for (float phase: {0.0f, 0.1f, 0.25f, 0.6f, 0.999f}) {
+            REQUIRE_THAT(sine.read_linear(0, phase), Catch::Matchers::WithinAbs(sinf(2.0f * PI * phase), 1e-5));
+            REQUIRE_THAT(sine.read_cubic(Wavetable::LEVELS - 1, phase),
+                         Catch::Matchers::WithinAbs(sinf(2.0f * PI * phase), 1e-6));
+        }
+        //The full band saw is close to the naive rising 2 p - 1 of SawOsc away from its discontinuity
+        for (float phase: {0.1f, 0.25f, 0.4f, 0.6f, 0.75f, 0.9f})
+            REQUIRE_THAT(saw.read_cubic(0, phase), Catch::Matchers::WithinAbs(2.0f * phase - 1.0f, 1e-2));
+        //Unknown tables fall back to the sine
+        REQUIRE(&tables.get(Wavetables::MAX_TABLES) == &sine);
+    }
+
+    SECTION("Test the levels stay below Nyquist") {
+        for (float freq: {20.0f, 100.0f, 440.0f, 1000.0f, 5000.0f, 15000.0f}) {
+            auto level = Wavetable::level_for(freq, 48000.0f);
+            REQUIRE((Wavetable::MAX_HARMONICS >> level) * freq <= 24000.0f);
+            //and don't throw more harmonics away than needed
+            if (level > 0)
+                REQUIRE((Wavetable::MAX_HARMONICS >> (level - 1)) * freq > 24000.0f);
+        }
+        REQUIRE(Wavetable::level_for(0.0f, 48000.0f) == 0);
+        REQUIRE(Wavetable::level_for(30000.0f, 48000.0f) == Wavetable::LEVELS - 1);
+    }
+
+    SECTION("Test user tables") {
+        std::vector<float> cycle(100);
+        for (size_t i = 0; i < cycle.size(); i++)
+            cycle[i] = 0.5f * cosf(2.0f * PI * 3.0f * float(i) / 100.0f);
+        auto index = tables.add(cycle);
+        REQUIRE(index >= Wavetables::SQUARE + 1);
+        for (float phase: {0.0f, 0.05f, 0.3f})
+            REQUIRE_THAT(tables.get(index).read_cubic(0, phase),
+                         Catch::Matchers::WithinAbs(0.5f * cosf(2.0f * PI * 3.0f * phase), 1e-5));
+        REQUIRE_THROWS(tables.add({1.0f}));
+    }
+
+    SECTION("Test rendering") {
+        AudioEngine engine;
+        auto&registry = engine._test_only_get_graph().registry;
+        auto osc = WavetableOsc::create(&engine, Wavetables::SINE, 1000.0f, 0.5f,
+                                        WavetableOsc::Interpolation::Cubic);
+        engine.set_output_ref(getOutputId(registry, osc, 0), 1);
+        std::vector<float> buffer(2 * 256);
+        engine.render(buffer.data(), 256);
+        for (size_t i = 0; i < 256; i++) {
+            auto phase = float(i) * 1000.0f / 48000.0f;
+            REQUIRE_THAT(buffer[2 * i], Catch::Matchers::WithinAbs(0.5f * sinf(2.0f * PI * phase), 1e-4));
+        }
+
+        //Switching tables through the table input
+        engine.set_input_1d(getInputId(registry, osc, 3), float(Wavetables::SQUARE));
+        engine.render(buffer.data(), 256);
+        float peak = 0.0f;
+        for (auto sample: buffer)
+            peak = std::max(peak, std::abs(sample));
+        REQUIRE(peak > 0.5f);
+    }
+
+    SECTION("Test negative frequencies") {
+        AudioEngine engine;
+        auto&graph = engine._test_only_get_graph();
+        auto&registry = graph.registry;
+        AudioContext ctx{48000.0f, 1.0f / 48000.0f, 0.0};
+        auto osc = WavetableOsc::create(&engine, Wavetables::SAW, -1000.0f, 0.5f,
+                                        WavetableOsc::Interpolation::Cubic);
+        auto&phase = registry.get<Input1D>(getInputId(registry, osc, 0));
+        auto&out = registry.get<Output1D>(getOutputId(registry, osc, 0));
+        //A phase just below 0 must not wrap to 1, set from outside or after a step
+        engine.set_input_1d(getInputId(registry, osc, 0), -1e-10f);
+        graph.process(ctx);
+        REQUIRE(phase.value >= 0.0f);
+        REQUIRE(phase.value < 1.0f);
+        engine.set_input_1d(getInputId(registry, osc, 0), 1e-10f);
+        engine.set_input_1d(getInputId(registry, osc, 1), -2e-10f * 48000.0f);
+        graph.process(ctx);
+        REQUIRE(phase.value < 1.0f);
+
+        engine.set_input_1d(getInputId(registry, osc, 1), -1000.0f);
+        for (int i = 0; i < 480; i++) {
+            graph.process(ctx);
+            REQUIRE(phase.value >= 0.0f);
+            REQUIRE(phase.value < 1.0f);
+            REQUIRE(std::abs(out.value) < 0.6f);
+        }
+    }
+}
+
+TEST_CASE("Test PolyBLEP oscillators") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    std::vector<float> buffer(2 * 480);
+
+    SECTION("Test rendering a saw") {
+        auto osc = SawOsc::create(&engine, 100.0f, 0.5f);
+        REQUIRE(registry.get<Block>(osc).type == BlockType::SawOsc);
+        engine.set_output_ref(getOutputId(registry, osc, 0), 1);
+        engine.render(buffer.data(), 480);
+        //One cycle, matching the naive saw away from the wrap
+        for (size_t i = 10; i < 470; i++) {
+            auto phase = float(i) * 100.0f / 48000.0f;
+            REQUIRE_THAT(buffer[2 * i], Catch::Matchers::WithinAbs(0.5f * (2.0f * phase - 1.0f), 1e-4));
+        }
+        REQUIRE_THAT(buffer[0], Catch::Matchers::WithinAbs(0.0f, 1e-6));
+    }
+
+    SECTION("Test every shape stays in range") {
+        auto blocks = SquareOsc::create_many(&engine, {1000.0f, 5000.0f}, {1.0f, 1.0f});
+        auto tri = TriOsc::create(&engine, 3000.0f, 1.0f);
+        auto saw = SawOsc::create(&engine, 6000.0f, 1.0f);
+        for (auto block: {blocks[0], blocks[1], tri, saw}) {
+            engine.set_output_ref(getOutputId(registry, block, 0), 1);
+            engine.render(buffer.data(), 480);
+            float peak = 0.0f;
+            for (auto sample: buffer)
+                peak = std::max(peak, std::abs(sample));
+            REQUIRE(peak > 0.5f);
+            REQUIRE(peak <= 1.0f + 1e-5f);
+        }
+        REQUIRE_THROWS(TriOsc::create_many(&engine, {1.0f}, {}));
+    }
+}
+
+TEST_CASE("Test additive bank") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    std::vector<float> buffer(2 * 256);
+    auto bank = AdditiveBank::create(&engine, {100.0f, 300.0f, 500.0f, 30000.0f}, {1.0f, 0.5f, 0.25f, 1.0f}, 0.5f);
+    engine.set_output_ref(getOutputId(registry, bank, 0), 1);
+    auto expected = [](float t, float pitch) {
+        return 0.5f * (sinf(2.0f * PI * 100.0f * pitch * t) + 0.5f * sinf(2.0f * PI * 300.0f * pitch * t) +
+                       0.25f * sinf(2.0f * PI * 500.0f * pitch * t));
+    };
+
+    SECTION("Test rendering, without the partial above Nyquist") {
+        engine.render(buffer.data(), 256);
+        for (size_t i = 0; i < 256; i++)
+            REQUIRE_THAT(buffer[2 * i], Catch::Matchers::WithinAbs(expected(float(i) / 48000.0f, 1.0f), 1e-4));
+    }
+
+    SECTION("Test bulk parameter changes") {
+        engine.set_input_1d(getInputId(registry, bank, 0), 2.0f);
+        engine.set_input_array(getInputId(registry, bank, 3), {0.0f}, 3);
+        engine.render(buffer.data(), 256);
+        for (size_t i = 0; i < 256; i++)
+            REQUIRE_THAT(buffer[2 * i], Catch::Matchers::WithinAbs(expected(float(i) / 48000.0f, 2.0f), 1e-4));
+
+        REQUIRE_THROWS(engine.set_input_array(getInputId(registry, bank, 2), {1.0f, 2.0f}, 3));
+        REQUIRE_THROWS(engine.set_input_array(getInputId(registry, bank, 2), std::vector<float>(5)));
+        REQUIRE_THROWS(AdditiveBank::create(&engine, {1.0f}, {}));
+    }
+
+    SECTION("Test snapshots") {
+        engine.render(buffer.data(), 100);
+        auto path = (std::filesystem::temp_directory_path() / "aari_additive_test.aari").string();
+        engine.save_snapshot(path);
+        AudioEngine loaded_engine;
+        loaded_engine.load_snapshot(path);
+        std::filesystem::remove(path);
+        std::vector<float> loaded(buffer.size());
+        engine.render(buffer.data(), 256);
+        loaded_engine.render(loaded.data(), 256);
+        REQUIRE(buffer == loaded);
+    }
+}
+
+TEST_CASE("Test FM voices") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    std::vector<float> buffer(2 * 256);
+
+    SECTION("Test a two operator stack") {
+        auto fm = FmVoices::create(&engine, {100.0f}, 0, 0.5f);
+        engine.set_output_ref(getOutputId(registry, fm, 0), 1);
+        engine.set_input_array(getInputId(registry, fm, 3), {1.0f, 2.0f});
+        engine.set_input_array(getInputId(registry, fm, 4), {1.0f, 2.0f, 0.0f});
+        engine.render(buffer.data(), 256);
+        for (size_t i = 0; i < 256; i++) {
+            auto t = float(i) / 48000.0f;
+            auto expected = 0.5f * sinf(2.0f * PI * 100.0f * t + 2.0f * sinf(2.0f * PI * 200.0f * t));
+            REQUIRE_THAT(buffer[2 * i], Catch::Matchers::WithinAbs(expected, 1e-4));
+        }
+    }
+
+    SECTION("Test voices are independent") {
+        //All carriers: each voice is the sum of its 4 operators
+        auto fm = FmVoices::create(&engine, {100.0f, 100.0f, 250.0f}, 7);
+        engine.set_output_ref(getOutputId(registry, fm, 0), 1);
+        engine.set_input_array(getInputId(registry, fm, 3), {1.0f, 2.0f, 3.0f, 4.0f});
+        engine.set_input_array(getInputId(registry, fm, 6), {0.25f, 0.25f, 0.0f});
+        engine.render(buffer.data(), 256);
+        for (size_t i = 0; i < 256; i++) {
+            auto t = float(i) / 48000.0f;
+            float expected = 0.0f;
+            for (float ratio: {1.0f, 2.0f, 3.0f, 4.0f})
+                expected += 0.5f * sinf(2.0f * PI * 100.0f * ratio * t);
+            REQUIRE_THAT(buffer[2 * i], Catch::Matchers::WithinAbs(expected, 1e-4));
+        }
+        REQUIRE_THROWS(FmVoices::create(&engine, {100.0f}, (uint32_t)FmVoices::ALGORITHMS.size()));
+    }
+
+    SECTION("Test feedback and the SIMD levels agree") {
+        auto fm = FmVoices::create(&engine, std::vector<float>(70, 220.0f), 8);
+        engine.set_output_ref(getOutputId(registry, fm, 0), 1);
+        engine.set_input_1d(getInputId(registry, fm, 2), 1.5f);
+        const auto initial = get_simd_level();
+        std::vector<float> reference;
+        for (int level = 0; level <= (int)detect_simd_level(); level++) {
+            set_simd_level(SimdLevel(level));
+            std::vector<float> state((FM_OPERATORS + 2) * 70, 0.0f);
+            engine.set_input_array(getInputId(registry, fm, 7), state);
+            engine.render(buffer.data(), 256);
+            if (reference.empty())
+                reference = buffer;
+            for (size_t i = 0; i < buffer.size(); i++)
+                REQUIRE_THAT(buffer[i], Catch::Matchers::WithinAbs(reference[i], 1e-3));
+        }
+        set_simd_level(initial);
+
+        //Feedback changes the sound
+        engine.set_input_1d(getInputId(registry, fm, 2), 0.0f);
+        engine.set_input_array(getInputId(registry, fm, 7), std::vector<float>((FM_OPERATORS + 2) * 70, 0.0f));
+        engine.render(buffer.data(), 256);
+        REQUIRE(buffer != reference);
+    }
+}
+
+TEST_CASE("Test envelopes") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    std::vector<float> buffer(2 * 48000);
+    auto render = [&](size_t frames) {
+        engine.render(buffer.data(), (ma_uint32)frames);
+        return buffer[2 * (frames - 1)];
+    };
+
+    SECTION("Test the ADSR stages") {
+        auto adsr = Adsr::create(&engine, 0.01f, 0.1f, 0.5f, 0.05f);
+        engine.set_output_ref(getOutputId(registry, adsr, 0), 1);
+        REQUIRE(render(10) == 0.0f);
+
+        engine.set_input_1d(getInputId(registry, adsr, 0), 1.0f);
+        //The attack reaches 1 in 10 ms
+        render(470);
+        for (size_t i = 1; i < 470; i++)
+            REQUIRE(buffer[2 * i] > buffer[2 * (i - 1)]);
+        REQUIRE(buffer[2 * 469] > 0.9f);
+        REQUIRE(buffer[2 * 469] < 1.0f);
+        render(20);
+        REQUIRE(*std::max_element(buffer.begin(), buffer.begin() + 40) == 1.0f);
+        //Then decays to the sustain level and stays there
+        REQUIRE_THAT(render(24000), Catch::Matchers::WithinAbs(0.5f, 1e-6));
+
+        engine.set_input_1d(getInputId(registry, adsr, 0), 0.0f);
+        REQUIRE(render(2400) < 1e-3f);
+        REQUIRE(render(100) == 0.0f);
+        //Released envelopes sleep
+        REQUIRE(registry.get<Silence>(adsr).asleep);
+    }
+
+    SECTION("Test the AR envelope doesn't sustain") {
+        auto ar = Ar::create(&engine, 0.001f, 0.05f);
+        engine.set_output_ref(getOutputId(registry, ar, 0), 1);
+        engine.set_input_1d(getInputId(registry, ar, 0), 1.0f);
+        render(100);
+        REQUIRE(*std::max_element(buffer.begin(), buffer.begin() + 200) == 1.0f);
+        REQUIRE(render(4800) == 0.0f);
+    }
+
+    SECTION("Test the bank drives FM voices") {
+        auto bank = AdsrBank::create(&engine, 3, 0.01f, 0.1f, 0.5f, 0.05f);
+        auto fm = FmVoices::create(&engine, {100.0f, 200.0f, 300.0f}, 7);
+        engine.add_wire(bank, fm, getOutputId(registry, bank, 0), getInputId(registry, fm, 6),
+                        Wire::transmit_array_to_array);
+        engine.set_output_ref(getOutputId(registry, fm, 0), 1);
+        engine.set_input_array(getInputId(registry, bank, 4), {1.0f, 0.0f, 1.0f});
+
+        //Same as single envelopes
+        std::vector<float> stages(3, envelope::RELEASE);
+        std::vector<float> levels(3, 0.0f);
+        auto coefficients = envelope::adsr_coefficients(0.01f, 0.1f, 0.5f, 0.05f, 48000.0f);
+        const float gates[] = {1.0f, 0.0f, 1.0f};
+        for (int i = 0; i < 1000; i++) {
+            for (size_t v = 0; v < 3; v++)
+                levels[v] = envelope::step(gates[v], stages[v], levels[v], coefficients);
+        }
+        render(1000);
+        auto&bank_levels = registry.get<OutputArray>(getOutputId(registry, bank, 0)).value;
+        for (size_t v = 0; v < 3; v++)
+            REQUIRE_THAT(bank_levels[v], Catch::Matchers::WithinAbs(levels[v], 1e-6));
+        REQUIRE(registry.get<InputArray>(getInputId(registry, fm, 6)).value == bank_levels);
+
+        engine.set_input_array(getInputId(registry, bank, 4), {0.0f, 0.0f, 0.0f});
+        render(10000);
+        REQUIRE(registry.get<Silence>(bank).asleep);
+        REQUIRE(registry.get<Silence>(fm).asleep == false);
+        REQUIRE(std::abs(buffer[2 * 9999]) < 1e-6f);
+    }
+}
+
+TEST_CASE("Test filters") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    std::vector<float> buffer(2 * 9600);
+    //Peak of the output over the last 2400 samples of 9600, once the filter settled
+    auto steady_peak = [&]() {
+        engine.render(buffer.data(), 9600);
+        float peak = 0.0f;
+        for (size_t i = 7200; i < 9600; i++)
+            peak = std::max(peak, std::abs(buffer[2 * i]));
+        return peak;
+    };
+    auto osc = SineOsc::create(&engine, 100.0f, 1.0f);
+
+    SECTION("Test the biquad response") {
+        auto biquad = Biquad::create(&engine, 1000.0f, 0.7071f, filter::LOWPASS);
+        engine.add_wire(osc, biquad, getOutputId(registry, osc, 0), getInputId(registry, biquad, 0),
+                        Wire::transmit_1d_to_1d);
+        engine.set_output_ref(getOutputId(registry, biquad, 0), 1);
+        REQUIRE_THAT(steady_peak(), Catch::Matchers::WithinAbs(1.0, 0.01));
+        //-3 dB at the cutoff, -40 dB a decade above
+        engine.set_input_1d(getInputId(registry, osc, 1), 1000.0f);
+        REQUIRE_THAT(steady_peak(), Catch::Matchers::WithinAbs(0.7071, 0.01));
+        engine.set_input_1d(getInputId(registry, osc, 1), 10000.0f);
+        REQUIRE(steady_peak() < 0.012f);
+        engine.set_input_1d(getInputId(registry, biquad, 1), filter::HIGHPASS);
+        REQUIRE_THAT(steady_peak(), Catch::Matchers::WithinAbs(1.0, 0.02));
+
+        //It sleeps once the oscillator stops and it rang out
+        engine.set_input_1d(getInputId(registry, osc, 2), 0.0f);
+        engine.render(buffer.data(), 9600);
+        REQUIRE(registry.get<Silence>(biquad).asleep);
+        REQUIRE(buffer[2 * 9599] == 0.0f);
+    }
+
+    SECTION("Test the SVF outputs") {
+        auto svf = Svf::create(&engine, 1000.0f, 0.7071f, filter::BANDPASS);
+        engine.add_wire(osc, svf, getOutputId(registry, osc, 0), getInputId(registry, svf, 0),
+                        Wire::transmit_1d_to_1d);
+        engine.set_input_1d(getInputId(registry, osc, 1), 1000.0f);
+        engine.set_output_ref(getOutputId(registry, svf, 0), 1);
+        //The bandpass is 0 dB at the cutoff
+        REQUIRE_THAT(steady_peak(), Catch::Matchers::WithinAbs(1.0, 0.01));
+        engine.set_input_1d(getInputId(registry, osc, 1), 100.0f);
+        for (size_t output = 1; output < 4; output++)
+            engine.add_tap(getOutputId(registry, svf, output));
+        float lowpass = 0.0f;
+        float highpass = 0.0f;
+        for (int i = 0; i < 9600; i++) {
+            engine.render(buffer.data(), 1);
+            if (i >= 7200) {
+                lowpass = std::max(lowpass, std::abs(registry.get<Output1D>(getOutputId(registry, svf, 1)).value));
+                highpass = std::max(highpass, std::abs(registry.get<Output1D>(getOutputId(registry, svf, 3)).value));
+            }
+        }
+        REQUIRE_THAT(lowpass, Catch::Matchers::WithinAbs(1.0, 0.01));
+        REQUIRE(highpass < 0.012f);
+
+        //Sweeping the cutoff at audio rate keeps it stable
+        auto lfo = SineOsc::create(&engine, 50.0f, 1.0f);
+        engine.add_wire(lfo, svf, getOutputId(registry, lfo, 0), getInputId(registry, svf, 2),
+                        Wire::transmit_1d_to_1d, 10000.0f, 12000.0f);
+        engine.set_input_1d(getInputId(registry, svf, 3), 20.0f);
+        engine.render(buffer.data(), 9600);
+        for (size_t i = 0; i < 9600; i++)
+            REQUIRE(std::abs(buffer[2 * i]) < 2.0f);
+    }
+
+    SECTION("Test the cascade is the sections in series, delayed") {
+        constexpr size_t SECTIONS = 4;
+        auto cascade = BiquadCascade::create(&engine, SECTIONS, 2000.0f, 1.0f, filter::LOWPASS);
+        engine.add_wire(osc, cascade, getOutputId(registry, osc, 0), getInputId(registry, cascade, 0),
+                        Wire::transmit_1d_to_1d);
+        engine.set_input_1d(getInputId(registry, osc, 1), 1500.0f);
+        std::vector<entt::entity> chain;
+        for (size_t k = 0; k < SECTIONS; k++) {
+            chain.push_back(Biquad::create(&engine, 2000.0f, 1.0f, filter::LOWPASS));
+            auto from = k == 0 ? osc : chain[k - 1];
+            engine.add_wire(from, chain[k], getOutputId(registry, from, 0), getInputId(registry, chain[k], 0),
+                            Wire::transmit_1d_to_1d);
+        }
+        engine.set_output_ref(getOutputId(registry, cascade, 0), 1);
+        engine.add_tap(getOutputId(registry, chain.back(), 0));
+
+        std::vector<float> serial;
+        std::vector<float> pipelined;
+        for (int i = 0; i < 1000; i++) {
+            engine.render(buffer.data(), 1);
+            pipelined.push_back(buffer[0]);
+            serial.push_back(registry.get<Output1D>(getOutputId(registry, chain.back(), 0)).value);
+        }
+        REQUIRE(*std::max_element(serial.begin(), serial.end()) > 0.5f);
+        for (size_t i = 0; i + SECTIONS - 1 < serial.size(); i++)
+            REQUIRE_THAT(pipelined[i + SECTIONS - 1], Catch::Matchers::WithinAbs(serial[i], 1e-4));
+    }
+
+    SECTION("Test the filter bank") {
+        auto bank = FilterBank::create(&engine, {200.0f, 2000.0f, 20000.0f}, 0.7071f, filter::LOWPASS);
+        engine.set_output_ref(getOutputId(registry, bank, 1), 1);
+        engine.set_input_array(getInputId(registry, bank, 1), {1.0f, 1.0f, 1.0f});
+        //DC goes through the lowpasses
+        engine.render(buffer.data(), 9600);
+        REQUIRE_THAT(buffer[2 * 9599], Catch::Matchers::WithinAbs(3.0, 1e-3));
+        auto&outs = registry.get<OutputArray>(getOutputId(registry, bank, 0)).value;
+        for (float out: outs)
+            REQUIRE_THAT(out, Catch::Matchers::WithinAbs(1.0, 1e-3));
+        //and not the highpasses
+        engine.set_input_1d(getInputId(registry, bank, 0), filter::HIGHPASS);
+        engine.render(buffer.data(), 9600);
+        REQUIRE_THAT(buffer[2 * 9599], Catch::Matchers::WithinAbs(0.0, 1e-3));
+
+        engine.set_input_array(getInputId(registry, bank, 1), {0.0f, 0.0f, 0.0f});
+        engine.render(buffer.data(), 9600);
+        REQUIRE(registry.get<Silence>(bank).asleep);
+        REQUIRE_THROWS(engine.set_input_array(getInputId(registry, bank, 2), {1.0f, 2.0f, 3.0f, 4.0f}));
+    }
+}
+
+TEST_CASE("Test delay lines") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    const float sample_rate = float(engine.get_sample_rate());
+    std::vector<float> buffer(2 * 9600);
+    //Impulse response of a block, sample by sample
+    auto impulse_response = [&](entt::entity block, size_t n) {
+        engine.set_output_ref(getOutputId(registry, block, 0), 1);
+        std::vector<float> response;
+        for (size_t i = 0; i < n; i++) {
+            engine.set_input_1d(getInputId(registry, block, 0), i == 0 ? 1.0f : 0.0f);
+            engine.render(buffer.data(), 1);
+            response.push_back(buffer[0]);
+        }
+        return response;
+    };
+
+    SECTION("Test whole and fractional delays") {
+        auto delay = Delay::create(&engine, 0.01f, 10.0f / sample_rate);
+        auto&line = registry.get<DelayLine>(getInputId(registry, delay, 2));
+        REQUIRE(line.length() == 512);
+        auto response = impulse_response(delay, 20);
+        for (size_t i = 0; i < 20; i++)
+            REQUIRE(response[i] == (i == 10 ? 1.0f : 0.0f));
+        //Half a sample: the Catmull-Rom weights
+        engine.set_input_1d(getInputId(registry, delay, 1), 10.5f / sample_rate);
+        response = impulse_response(delay, 20);
+        REQUIRE_THAT(response[9], Catch::Matchers::WithinAbs(-0.0625, 1e-6));
+        REQUIRE_THAT(response[10], Catch::Matchers::WithinAbs(0.5625, 1e-6));
+        REQUIRE_THAT(response[11], Catch::Matchers::WithinAbs(0.5625, 1e-6));
+        REQUIRE_THAT(response[12], Catch::Matchers::WithinAbs(-0.0625, 1e-6));
+        //Delays are clamped to the ring, around the wrap too
+        engine.set_input_1d(getInputId(registry, delay, 1), 1.0f);
+        response = impulse_response(delay, 1000);
+        REQUIRE(response[line.max_delay()] == 1.0f);
+
+        engine.render(buffer.data(), 1024);
+        REQUIRE(registry.get<Silence>(delay).asleep);
+    }
+
+    SECTION("Test the comb filter") {
+        auto comb = Comb::create(&engine, 0.01f, 100.0f / sample_rate, 0.5f, 0.0f);
+        auto response = impulse_response(comb, 400);
+        REQUIRE(response[100] == 1.0f);
+        REQUIRE_THAT(response[200], Catch::Matchers::WithinAbs(0.5, 1e-6));
+        REQUIRE_THAT(response[300], Catch::Matchers::WithinAbs(0.25, 1e-6));
+        REQUIRE(response[150] == 0.0f);
+        //Damping lowers the echoes
+        engine.set_input_1d(getInputId(registry, comb, 3), 0.5f);
+        response = impulse_response(comb, 4000);
+        REQUIRE(std::abs(response[300]) < 0.25f);
+        //The feedback dies out then it sleeps
+        engine.render(buffer.data(), 4800);
+        REQUIRE(registry.get<Silence>(comb).asleep);
+        REQUIRE(buffer[2 * 4799] == 0.0f);
+    }
+
+    SECTION("Test the allpass keeps the energy") {
+        auto allpass = Allpass::create(&engine, 0.01f, 50.0f / sample_rate, 0.5f);
+        auto response = impulse_response(allpass, 4800);
+        REQUIRE(response[0] == -0.5f);
+        float energy = 0.0f;
+        for (float x: response)
+            energy += x * x;
+        REQUIRE_THAT(energy, Catch::Matchers::WithinAbs(1.0, 1e-4));
+    }
+
+    SECTION("Test modulated delays") {
+        //A chorus: the delay time swings between 5 and 15 ms at audio rate
+        auto osc = SineOsc::create(&engine, 440.0f, 1.0f);
+        auto lfo = SineOsc::create(&engine, 100.0f, 1.0f);
+        auto delay = Delay::create(&engine, 0.02f, 0.01f);
+        engine.add_wire(osc, delay, getOutputId(registry, osc, 0), getInputId(registry, delay, 0),
+                        Wire::transmit_1d_to_1d);
+        engine.add_wire(lfo, delay, getOutputId(registry, lfo, 0), getInputId(registry, delay, 1),
+                        Wire::transmit_1d_to_1d, 0.005f, 0.01f);
+        engine.set_output_ref(getOutputId(registry, delay, 0), 1);
+        engine.render(buffer.data(), 9600);
+        float peak = 0.0f;
+        for (size_t i = 960; i < 9600; i++)
+            peak = std::max(peak, std::abs(buffer[2 * i]));
+        REQUIRE(peak > 0.9f);
+        REQUIRE(peak < 1.1f);
+    }
+
+    SECTION("Test the rings come from the memory pool") {
+        auto&pool = MemoryPool::instance();
+        const size_t used = pool.used();
+        const size_t capacity = pool.capacity();
+        auto delay = Delay::create(&engine, 1.0f, 0.5f);
+        const size_t length = registry.get<DelayLine>(getInputId(registry, delay, 2)).length();
+        REQUIRE(length == 65536);
+        REQUIRE(pool.used() >= used + length);
+        //Copies get their own ring
+        auto subgraph = engine.capture_subgraph({delay}, {getInputId(registry, delay, 2)});
+        auto copies = engine.clone_subgraph(subgraph, 2);
+        auto&first = registry.get<DelayLine>(copies[0].ports[0]);
+        auto&second = registry.get<DelayLine>(copies[1].ports[0]);
+        REQUIRE(first.length() == length);
+        REQUIRE(first.memory.data() != second.memory.data());
+        REQUIRE(pool.used() >= used + 3 * length);
+        //and give it back with the block
+        engine.remove_block(delay);
+        engine.remove_block(copies[0].blocks[0]);
+        engine.remove_block(copies[1].blocks[0]);
+        REQUIRE(pool.used() == used);
+        REQUIRE(pool.capacity() == capacity);
+        REQUIRE_THROWS(Delay::create(&engine, 0.0f, 0.0f));
+    }
+}
+
+TEST_CASE("Test FDN reverb") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    const float sample_rate = float(engine.get_sample_rate());
+
+    auto delays = FdnReverb::default_delays(16, 1.0f, sample_rate);
+    REQUIRE(delays.size() == 16);
+    REQUIRE(delays.front() >= FdnReverb::MIN_DELAY_TIME * sample_rate);
+    for (size_t i = 1; i < delays.size(); i++)
+        REQUIRE(delays[i] > delays[i - 1]);
+    REQUIRE(delays.back() < 1.1f * FdnReverb::MAX_DELAY_TIME * sample_rate);
+    REQUIRE_THROWS(FdnReverb::create(&engine, 6));
+
+    //A burst of sine through a send bus into the reverb
+    auto osc = SineOsc::create(&engine, 440.0f, 1.0f);
+    auto send = StereoMixer<2>::create(&engine);
+    engine.add_wire_to_mixer(osc, send, getOutputId(registry, osc, 0), 0, Wire::transmit_to_mixer);
+    auto reverb = FdnReverb::create(&engine, 16, 1.0f, 1.0f, 0.2f);
+    engine.add_wire(send, reverb, getOutputId(registry, send, 0), getInputId(registry, reverb, 0),
+                    Wire::transmit_Nd_to_Nd<2>);
+    engine.set_output_ref(getOutputId(registry, reverb, 0), 2);
+
+    //Level of each channel over 100 ms
+    std::vector<float> buffer(2 * 4800);
+    auto rms = [&](size_t channel) {
+        engine.render(buffer.data(), 4800);
+        float total = 0.0f;
+        for (size_t i = 0; i < 4800; i++)
+            total += buffer[2 * i + channel] * buffer[2 * i + channel];
+        return std::sqrt(total / 4800.0f);
+    };
+
+    auto check_decay = [&]() {
+        rms(0);
+        engine.set_input_1d(getInputId(registry, osc, 2), 0.0f);
+        for (int i = 0; i < 4; i++)
+            rms(0);
+        const float early = rms(0);
+        for (int i = 0; i < 4; i++)
+            rms(0);
+        const float late = rms(0);
+        REQUIRE(early > 0.01f);
+        //60 dB per second with a bit more in the highs from the damping: 30 dB and a little over in 500 ms
+        const float db = 20.0f * std::log10(early / late);
+        REQUIRE(db > 27.0f);
+        REQUIRE(db < 40.0f);
+
+        //It falls silent then sleeps
+        for (int i = 0; i < 50; i++)
+            rms(0);
+        REQUIRE(registry.get<Silence>(reverb).asleep);
+        REQUIRE(buffer[2 * 4799] == 0.0f);
+    };
+
+    SECTION("Test the decay time with the Hadamard matrix") {
+        check_decay();
+    }
+
+    SECTION("Test the decay time with the Householder matrix") {
+        engine.set_input_1d(getInputId(registry, reverb, 3), FdnReverb::HOUSEHOLDER);
+        check_decay();
+    }
+
+    SECTION("Test a mono input comes out on both sides") {
+        auto&input = registry.get<InputND<2>>(getInputId(registry, reverb, 0)).value;
+        engine.remove_wire(engine.get_wires_to_block(reverb)[0]);
+        input = {0.0f, 0.0f};
+        engine.set_input_1d(getInputId(registry, osc, 2), 0.0f);
+        std::vector<float> impulse(2 * 24000);
+        input = {1.0f, 0.0f};
+        engine.render(impulse.data(), 1);
+        input = {0.0f, 0.0f};
+        engine.render(impulse.data(), 24000);
+        float left = 0.0f;
+        float right = 0.0f;
+        for (size_t i = 0; i < 24000; i++) {
+            left += impulse[2 * i] * impulse[2 * i];
+            right += impulse[2 * i + 1] * impulse[2 * i + 1];
+        }
+        REQUIRE(left > 0.01f);
+        REQUIRE(right > 0.01f);
+        REQUIRE(right / left > 0.25f);
+        REQUIRE(right / left < 4.0f);
+    }
+}
+
+TEST_CASE("Test convolution") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    REQUIRE_THROWS(Convolution::create(&engine, std::vector<float>{}));
+
+    //Long enough for the three parts of the convolver, noise decaying over the length
+    const size_t length = 5000;
+    std::vector<float> ir(length);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        ir[i] = (float(seed >> 8) / float(1 << 24) - 0.5f) * std::exp(-float(i) / 1500.0f);
+    }
+
+    auto check_response = [&](entt::entity block, const std::vector<float>&input, size_t frames) {
+        engine.set_output_ref(getOutputId(registry, block, 0), 1);
+        auto inputid = getInputId(registry, block, 0);
+        float buffer[2];
+        float max_error = 0.0f;
+        for (size_t n = 0; n < frames; n++) {
+            engine.set_input_1d(inputid, n < input.size() ? input[n] : 0.0f);
+            engine.render(buffer, 1);
+            double expected = 0.0;
+            for (size_t k = 0; k < length && k <= n; k++)
+                expected += double(ir[k]) * double(n - k < input.size() ? input[n - k] : 0.0f);
+            max_error = std::max(max_error, std::abs(buffer[0] - float(expected)));
+        }
+        REQUIRE(max_error < 1e-4f);
+        REQUIRE(registry.get<ConvolutionState>(getInputId(registry, block, 2)).convolver->late_blocks() == 0);
+    };
+
+    SECTION("Test against the direct convolution") {
+        auto block = Convolution::create(&engine, ir);
+        std::vector<float> input(3000);
+        for (size_t i = 0; i < input.size(); i++)
+            input[i] = std::sin(0.01f * float(i * i % 10007));
+        check_response(block, input, input.size() + length + 100);
+        //It sleeps once the input has been 0 for the length of the impulse response
+        float buffer[2 * 64];
+        engine.render(buffer, 64);
+        REQUIRE(registry.get<Silence>(block).asleep);
+    }
+
+    SECTION("Test loading the impulse response from a WAV file") {
+        auto path = (std::filesystem::temp_directory_path() / "aari_convolution_test.wav").string();
+        ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, 1,
+                                                          engine.get_sample_rate());
+        ma_encoder encoder;
+        REQUIRE(ma_encoder_init_file(path.c_str(), &config, &encoder) == MA_SUCCESS);
+        ma_encoder_write_pcm_frames(&encoder, ir.data(), length, nullptr);
+        ma_encoder_uninit(&encoder);
+
+        REQUIRE_THROWS(Convolution::create_from_file(&engine, path, 1));
+        REQUIRE_THROWS(Convolution::create_from_file(&engine, path + ".missing"));
+        auto block = Convolution::create_from_file(&engine, path);
+        REQUIRE(registry.get<InputArray>(getInputId(registry, block, 2)).value.size() == length);
+        check_response(block, {1.0f, -0.5f}, length + 10);
+        std::filesystem::remove(path);
+    }
+
+    SECTION("Test a worker that falls behind in real time") {
+        //A single tap at the start of the tail: the impulse of block 2 is heard at the start of block 4
+        std::vector<float> impulse(Convolver::TAIL_START + 1, 0.0f);
+        impulse.back() = 1.0f;
+        Convolver convolver(impulse);
+        auto run_block = [&](size_t block, bool realtime) {
+            std::vector<float> output(Convolver::TAIL_BLOCK);
+            for (size_t n = 0; n < Convolver::TAIL_BLOCK; n++)
+                output[n] = convolver.process(block == 2 && n == 0 ? 1.0f : 0.0f, realtime);
+            return output;
+        };
+        for (size_t block = 0; block < 4; block++)
+            run_block(block, false);
+        REQUIRE(run_block(4, false)[0] == Catch::Approx(1.0f));
+
+        convolver._test_only_hold_worker(true);
+        for (size_t block = 5; block < 8; block++)
+            run_block(block, true);
+        convolver._test_only_hold_worker(false);
+        //Block 6 is skipped, its slot is the one block 2 was in
+        auto output = run_block(8, false);
+        REQUIRE(std::all_of(output.begin(), output.end(), [](float y) { return y == 0.0f; }));
+        REQUIRE(convolver.late_blocks() > 0);
+    }
+}
+
+TEST_CASE("Test sampler") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    const auto sample_rate = engine.get_sample_rate();
+
+    //Longer than the attack and the ring together, so that the ring wraps around
+    const size_t frames = 3 * SampleStream::RING_FRAMES + 1234;
+    std::vector<float> data(2 * frames);
+    for (size_t i = 0; i < frames; i++) {
+        data[2 * i] = std::sin(0.001f * float(i));
+        data[2 * i + 1] = float(i % 1000) / 1000.0f;
+    }
+    auto path = (std::filesystem::temp_directory_path() / "aari_sampler_test.wav").string();
+    ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, 2, sample_rate);
+    ma_encoder encoder;
+    REQUIRE(ma_encoder_init_file(path.c_str(), &config, &encoder) == MA_SUCCESS);
+    ma_encoder_write_pcm_frames(&encoder, data.data(), frames, nullptr);
+    ma_encoder_uninit(&encoder);
+
+    REQUIRE_THROWS(Samples::instance().load(path + ".missing", sample_rate));
+    const auto streamed = Samples::instance().load(path, sample_rate, 1000);
+    const auto* file = Samples::instance().get(streamed);
+    REQUIRE(file->attack_frames() == 1000);
+    REQUIRE(file->length() == frames);
+    REQUIRE_FALSE(file->complete());
+    const auto whole = Samples::instance().load(path, sample_rate, 2 * frames);
+    REQUIRE(Samples::instance().get(whole)->complete());
+    REQUIRE(Samples::instance().get(whole)->attack_frames() == frames);
+    REQUIRE(Samples::instance().get(uint32_t(Samples::instance().size())) == nullptr);
+
+    auto sampler = Sampler::create(&engine, streamed, 0.5f);
+    engine.set_output_ref(getOutputId(registry, sampler, 0), 2);
+    auto gate = getInputId(registry, sampler, 0);
+    std::vector<float> buffer(2 * 4096);
+
+    auto check_playback = [&]() {
+        engine.set_input_1d(gate, 1.0f);
+        size_t mismatches = 0;
+        for (size_t start = 0; start < frames; start += 4096) {
+            engine.render(buffer.data(), 4096);
+            for (size_t i = 0; i < 4096 && start + i < frames; i++) {
+                mismatches += buffer[2 * i] != 0.5f * data[2 * (start + i)];
+                mismatches += buffer[2 * i + 1] != 0.5f * data[2 * (start + i) + 1];
+            }
+        }
+        REQUIRE(mismatches == 0);
+        engine.render(buffer.data(), 64);
+        REQUIRE(buffer[2 * 63] == 0.0f);
+        REQUIRE(registry.get<Silence>(sampler).asleep);
+        engine.set_input_1d(gate, 0.0f);
+        engine.render(buffer.data(), 1);
+    };
+
+    SECTION("Test streaming from disk") {
+        check_playback();
+        //Again from the start, through the same stream
+        check_playback();
+        REQUIRE(registry.get<SamplerState>(gate).stream->underruns() == 0);
+    }
+
+    SECTION("Test a sample held in memory") {
+        engine.set_input_1d(getInputId(registry, sampler, 1), float(whole));
+        check_playback();
+    }
+
+    SECTION("Test restarting in the middle of the sample") {
+        engine.set_input_1d(gate, 1.0f);
+        engine.render(buffer.data(), 4096);
+        engine.render(buffer.data(), 4096);
+        engine.set_input_1d(gate, 0.0f);
+        engine.render(buffer.data(), 1);
+        check_playback();
+    }
+
+    SECTION("Test an unknown sample is silent") {
+        engine.set_input_1d(getInputId(registry, sampler, 1), 1e6f);
+        engine.set_input_1d(gate, 1.0f);
+        engine.render(buffer.data(), 64);
+        REQUIRE(buffer[2 * 63] == 0.0f);
+        REQUIRE(registry.get<Silence>(sampler).asleep);
+    }
+
+    SECTION("Test removing a sampler while its stream is refilled") {
+        //Owned by the streaming thread too, the stream outlives the block until the thread is done with it
+        std::weak_ptr<SampleStream> stream = registry.get<SamplerState>(gate).stream;
+        engine.set_input_1d(gate, 1.0f);
+        engine.render(buffer.data(), 64);
+        engine.remove_block(sampler);
+        for (int i = 0; i < 1000 && !stream.expired(); i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        REQUIRE(stream.expired());
+
+        sampler = Sampler::create(&engine, streamed, 0.5f);
+        engine.set_output_ref(getOutputId(registry, sampler, 0), 2);
+        gate = getInputId(registry, sampler, 0);
+        check_playback();
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Test recording") {
+    SECTION("Test recording the output and a tapped output") {
+        AudioEngine engine;
+        auto&registry = engine._test_only_get_graph().registry;
+        auto osc = SineOsc::create(&engine, 440.0f, 0.5f);
+        auto pan = StereoMixer<2>::create(&engine);
+        engine.add_wire_to_mixer(osc, pan, getOutputId(registry, osc, 0), 0, Wire::transmit_to_mixer);
+        engine.set_output_ref(getOutputId(registry, osc, 0), 1);
+
+        auto master_path = (std::filesystem::temp_directory_path() / "aari_master_test.wav").string();
+        auto tap_path = (std::filesystem::temp_directory_path() / "aari_tap_test.wav").string();
+        REQUIRE_THROWS(engine.start_recording(tap_path, getInputId(registry, osc, 1)));
+        REQUIRE_THROWS(engine.start_recording(tap_path, entt::entity{12345}));
+        auto&master = engine.start_recording(master_path);
+        //The mixer doesn't feed the output, recording it keeps it running
+        auto&tap = engine.start_recording(tap_path, getOutputId(registry, pan, 0));
+        REQUIRE(tap.channels() == 2);
+
+        std::vector<float> rendered;
+        std::vector<float> buffer(2 * 1000);
+        for (int i = 0; i < 30; i++) {
+            engine.render(buffer.data(), 1000);
+            rendered.insert(rendered.end(), buffer.begin(), buffer.end());
+        }
+        engine.stop_recording(master);
+        engine.stop_recording(tap);
+        REQUIRE_THROWS(engine.stop_recording(tap));
+        //Not recorded any more
+        engine.render(buffer.data(), 1000);
+
+        auto master_channels = read_audio_file(master_path, engine.get_sample_rate());
+        auto tap_channels = read_audio_file(tap_path, engine.get_sample_rate());
+        REQUIRE(master_channels[0].size() == 30000);
+        REQUIRE(tap_channels[0].size() == 30000);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < 30000; i++) {
+            mismatches += master_channels[0][i] != rendered[2 * i] || master_channels[1][i] != rendered[2 * i + 1];
+            //Panned to the center of the stereo mixer
+            mismatches += std::abs(tap_channels[0][i] - tap_channels[1][i]) > 1e-6f;
+        }
+        REQUIRE(mismatches == 0);
+        float peak = 0.0f;
+        for (float x: tap_channels[0])
+            peak = std::max(peak, std::abs(x));
+        REQUIRE(peak > 0.1f);
+        std::filesystem::remove(master_path);
+        std::filesystem::remove(tap_path);
+    }
+
+    SECTION("Test recording a tapped output without a main output") {
+        AudioEngine engine(48000, 512, true);
+        auto&registry = engine._test_only_get_graph().registry;
+        auto constant = Constant::create(&engine, 0.25f);
+        engine.set_output_ref(getOutputId(registry, constant, 0), 0);
+
+        auto path = (std::filesystem::temp_directory_path() / "aari_stem_test.wav").string();
+        auto&stem = engine.start_recording(path, getOutputId(registry, constant, 0));
+        std::vector<float> buffer(2 * 1000);
+        for (int i = 0; i < 3; i++)
+            engine.render(buffer.data(), 1000);
+        engine.stop_recording(stem);
+        //Nothing is played
+        REQUIRE(std::all_of(buffer.begin(), buffer.end(), [](float x) { return x == 0.0f; }));
+
+        auto channels = read_audio_file(path, engine.get_sample_rate());
+        REQUIRE(channels[0].size() == 3000);
+        size_t mismatches = 0;
+        for (float x: channels[0])
+            mismatches += std::abs(x - 0.25f) > 1e-4f;
+        REQUIRE(mismatches == 0);
+        std::filesystem::remove(path);
+    }
+}
+
+TEST_CASE("Test audio input") {
+    SECTION("Test offline input through an effect") {
+        AudioEngine engine(48000, 512, true, 3);
+        auto&registry = engine._test_only_get_graph().registry;
+        REQUIRE(engine.get_input_channels() == 3);
+        REQUIRE_THROWS(AudioInput::create(&engine, 0, 5));
+        //Channels 1 to 3 of a device with 3, the last one doesn't exist
+        auto input = AudioInput::create(&engine, 1, 3, 0.5f);
+        REQUIRE(engine.view_block(input).outputIds[3] == entt::null);
+        auto delay = Delay::create(&engine, 0.01f, 10.0f / 48000.0f);
+        engine.add_wire(input, delay, getOutputId(registry, input, 0), getInputId(registry, delay, 0),
+                        Wire::transmit_1d_to_1d);
+        engine.add_tap(getOutputId(registry, input, 1));
+        engine.add_tap(getOutputId(registry, input, 2));
+        engine.set_output_ref(getOutputId(registry, delay, 0), 1);
+
+        std::vector<float> captured(3 * 256);
+        for (size_t i = 0; i < 256; i++) {
+            captured[3 * i] = 1.0f;
+            captured[3 * i + 1] = std::sin(0.05f * float(i));
+            captured[3 * i + 2] = i % 2 == 0 ? 1.0f : -1.0f;
+        }
+        std::vector<float> buffer(2 * 256);
+        engine.render(buffer.data(), 256, captured.data());
+        for (size_t i = 0; i < 256; i++) {
+            const float expected = i >= 10 ? 0.5f * captured[3 * (i - 10) + 1] : 0.0f;
+            REQUIRE_THAT(buffer[2 * i], Catch::Matchers::WithinAbs(expected, 1e-5));
+        }
+        auto value = [&](size_t output) {
+            auto io = engine.view_block_io(input);
+            return dynamic_cast<Output1D *>(io[getOutputId(registry, input, output)].get())->value;
+        };
+        REQUIRE(value(1) == -0.5f);
+        REQUIRE(value(2) == 0.0f);
+
+        //Without input the block outputs 0
+        engine.render(buffer.data(), 16);
+        REQUIRE(value(0) == 0.0f);
+        REQUIRE(value(1) == 0.0f);
+    }
+
+    SECTION("Test an engine without input channels") {
+        AudioEngine engine(48000, 512, true);
+        std::vector<float> captured(2 * 16, 1.0f);
+        std::vector<float> buffer(2 * 16);
+        REQUIRE_THROWS(engine.render(buffer.data(), 16, captured.data()));
+    }
+
+    SECTION("Test full duplex on the null backend") {
+        AudioEngine engine(48000, 256, false, 2, true);
+        auto&registry = engine._test_only_get_graph().registry;
+        REQUIRE(engine.get_input_channels() == 2);
+        auto input = AudioInput::create(&engine, 0, 2);
+        engine.set_output_ref(getOutputId(registry, input, 0), 1);
+        auto path = (std::filesystem::temp_directory_path() / "aari_duplex_test.wav").string();
+        auto&recorder = engine.start_recording(path);
+        engine.startAudio();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        engine.stopAudio();
+        engine.stop_recording(recorder);
+        //The callback ran with the captured buffer, silence on the null device
+        auto recorded = read_audio_file(path, 48000);
+        REQUIRE(recorded[0].size() > 0);
+        for (float x: recorded[0])
+            REQUIRE(x == 0.0f);
+        std::filesystem::remove(path);
+    }
+}
+
+TEST_CASE("Test output buses") {
+    AudioEngine engine(48000, 512, true, 0, false, 8);
+    REQUIRE(engine.get_output_channels() == 8);
+    auto main = Constant::create(&engine, 0.125f);
+    auto front = Constant::create(&engine, 0.25f);
+    auto rear = Constant::create(&engine, 0.5f);
+    auto out = [&](entt::entity block) { return engine.view_block(block).outputIds[0]; };
+    //A mono main output goes to the first two channels, buses sharing a channel are summed
+    engine.set_output_ref(out(main), 1);
+    engine.set_output_bus("front", out(front), 1);
+    engine.set_output_bus("rear", out(rear), 7);
+    REQUIRE_THROWS(engine.set_output_bus("outside", out(rear), 8));
+    REQUIRE_THROWS(engine.set_output_bus("not an output", rear, 0));
+
+    //Over more than one planar segment
+    const size_t frames = 600;
+    std::vector<float> buffer(8 * frames, -1.0f);
+    auto check = [&](const std::array<float, 8>&expected) {
+        engine.render(buffer.data(), frames);
+        for (size_t i = 0; i < frames; i++)
+            for (size_t c = 0; c < 8; c++)
+                REQUIRE(buffer[8 * i + c] == expected[c]);
+    };
+    check({0.125f, 0.375f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f});
+
+    engine.set_output_bus("rear", out(rear), 5);
+    engine.remove_output_bus("front");
+    REQUIRE_THROWS(engine.remove_output_bus("front"));
+    check({0.125f, 0.125f, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f});
+
+    //Buses play without a main output, and a removed block is silent
+    engine.set_output_ref(entt::null, 0);
+    engine.remove_block(rear);
+    check({0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f});
 }
 
+TEST_CASE("Test aux buses") {
+    AudioEngine engine(48000, 512, true, 1);
+    auto&registry = engine._test_only_get_graph().registry;
+    //Two sources share one effect through a mono bus: the input only runs because it is sent to the bus
+    auto input = AudioInput::create(&engine, 0, 1);
+    auto constant = Constant::create(&engine, 0.25f);
+    auto bus = engine.add_aux_bus("fx", 1);
+    REQUIRE(engine.get_aux_bus("fx") == bus);
+    REQUIRE_THROWS(engine.add_aux_bus("fx"));
+    auto delay = Delay::create(&engine, 0.01f, 10.0f / 48000.0f);
+    engine.add_wire(bus, delay, getOutputId(registry, bus, 0), getInputId(registry, delay, 0),
+                    Wire::transmit_1d_to_1d);
+    engine.set_output_ref(getOutputId(registry, delay, 0), 1);
+    auto input_send = engine.add_send(input, getOutputId(registry, input, 0), "fx", 0.5f);
+    engine.add_send(constant, getOutputId(registry, constant, 0), "fx");
+    REQUIRE_THROWS(engine.add_send(constant, getOutputId(registry, constant, 0), "nowhere"));
+    REQUIRE_THROWS(engine.add_send(constant, getOutputId(registry, input, 0), "fx"));
+    REQUIRE_THROWS(engine.add_send(entt::entity{12345}, getOutputId(registry, constant, 0), "fx"));
+    //The effect chain of the bus sent back into it
+    REQUIRE_THROWS(engine.add_send(delay, getOutputId(registry, delay, 0), "fx"));
+    REQUIRE(registry.view<Send>().size() == 2);
+
+    std::vector<float> captured(256);
+    for (size_t i = 0; i < captured.size(); i++)
+        captured[i] = std::sin(0.05f * float(i));
+    std::vector<float> buffer(2 * 256);
+    auto render_and_check = [&](float input_gain, float constant_gain) {
+        engine.render(buffer.data(), 256, captured.data());
+        for (size_t i = 10; i < 256; i++) {
+            const float expected = input_gain * captured[i - 10] + constant_gain * 0.25f;
+            REQUIRE_THAT(buffer[2 * i], Catch::Matchers::WithinAbs(expected, 1e-5));
+        }
+    };
+    render_and_check(0.5f, 1.0f);
+    engine.tweak_send_gain(input_send, 2.0f);
+    render_and_check(2.0f, 1.0f);
+    engine.remove_send(input_send);
+    render_and_check(0.0f, 1.0f);
+
+    //A stereo bus takes mono sources on both channels
+    auto stereo_bus = engine.add_aux_bus("stereo");
+    engine.add_send(constant, getOutputId(registry, constant, 0), "stereo", 2.0f);
+    engine.set_output_ref(getOutputId(registry, stereo_bus, 0), 2);
+    engine.render(buffer.data(), 16);
+    REQUIRE(buffer[30] == 0.5f);
+    REQUIRE(buffer[31] == 0.5f);
+
+    //Removing the source removes its sends, removing the bus leaves the effect
+    engine.remove_block(constant);
+    engine.render(buffer.data(), 16);
+    REQUIRE(buffer[30] == 0.0f);
+    engine.remove_aux_bus("fx");
+    REQUIRE_THROWS(engine.get_aux_bus("fx"));
+    REQUIRE(registry.valid(delay));
+    REQUIRE(engine.get_wires_to_block(delay).empty());
+}
+
+TEST_CASE("Benchmark additive bank against separate oscillators") {
+    std::vector<float> freqs(1024);
+    std::vector<float> amps(1024, 1.0f / 1024.0f);
+    for (size_t i = 0; i < freqs.size(); i++)
+        freqs[i] = 20.0f * float(i + 1);
+    std::vector<float> buffer(2 * 512);
+
+    AudioEngine bank_engine;
+    auto&bank_registry = bank_engine._test_only_get_graph().registry;
+    auto bank = AdditiveBank::create(&bank_engine, freqs, amps);
+    bank_engine.set_output_ref(getOutputId(bank_registry, bank, 0), 1);
+    BENCHMARK("AdditiveBank with 1024 partials") {
+        bank_engine.render(buffer.data(), 512);
+        return buffer[0];
+    };
+
+    AudioEngine osc_engine;
+    auto&osc_registry = osc_engine._test_only_get_graph().registry;
+    auto oscs = SineOsc::create_many(&osc_engine, freqs, amps);
+    for (auto osc: oscs)
+        osc_engine.add_tap(getOutputId(osc_registry, osc, 0));
+    osc_engine.set_output_ref(getOutputId(osc_registry, oscs[0], 0), 1);
+    BENCHMARK("1024 SineOsc blocks") {
+        osc_engine.render(buffer.data(), 512);
+        return buffer[0];
+    };
+
+    AudioEngine fm_engine;
+    auto&fm_registry = fm_engine._test_only_get_graph().registry;
+    auto fm = FmVoices::create(&fm_engine, std::vector<float>(freqs.begin(), freqs.begin() + 64), 8, 1.0f / 64.0f);
+    fm_engine.set_output_ref(getOutputId(fm_registry, fm, 0), 1);
+    fm_engine.set_input_1d(getInputId(fm_registry, fm, 2), 0.5f);
+    BENCHMARK("FmVoices with 64 voices of 6 operators") {
+        fm_engine.render(buffer.data(), 512);
+        return buffer[0];
+    };
+
+    AudioEngine filter_engine;
+    auto&filter_registry = filter_engine._test_only_get_graph().registry;
+    auto filters = FilterBank::create(&filter_engine, std::vector<float>(freqs.begin(), freqs.begin() + 64));
+    filter_engine.set_output_ref(getOutputId(filter_registry, filters, 1), 1);
+    filter_engine.set_input_array(getInputId(filter_registry, filters, 1), std::vector<float>(64, 1.0f));
+    BENCHMARK("FilterBank with 64 state variable filters") {
+        filter_engine.render(buffer.data(), 512);
+        return buffer[0];
+    };
+
+    //Several reverbs on one core, e.g. one per bus
+    AudioEngine reverb_engine;
+    auto&reverb_registry = reverb_engine._test_only_get_graph().registry;
+    auto source = SineOsc::create(&reverb_engine, 440.0f, 1.0f);
+    auto send = StereoMixer<2>::create(&reverb_engine);
+    reverb_engine.add_wire_to_mixer(source, send, getOutputId(reverb_registry, source, 0), 0,
+                                    Wire::transmit_to_mixer);
+    auto returns = StereoMixer<4>::create(&reverb_engine);
+    for (size_t i = 0; i < 4; i++) {
+        auto reverb = FdnReverb::create(&reverb_engine, 16, 1.0f + 0.1f * float(i));
+        reverb_engine.add_wire(send, reverb, getOutputId(reverb_registry, send, 0),
+                               getInputId(reverb_registry, reverb, 0), Wire::transmit_Nd_to_Nd<2>);
+        reverb_engine.add_wire_to_mixer(reverb, returns, getOutputId(reverb_registry, reverb, 0), i,
+                                        Wire::transmit_to_mixer);
+    }
+    reverb_engine.set_output_ref(getOutputId(reverb_registry, returns, 0), 2);
+    BENCHMARK("4 FdnReverb with 16 lines") {
+        reverb_engine.render(buffer.data(), 256);
+        return buffer[0];
+    };
+
+    //2 s impulse response, the tail on the worker thread
+    AudioEngine convolution_engine;
+    auto&convolution_registry = convolution_engine._test_only_get_graph().registry;
+    auto convolution_osc = SineOsc::create(&convolution_engine, 220.0f, 1.0f);
+    std::vector<float> impulse_response(96000);
+    for (size_t i = 0; i < impulse_response.size(); i++)
+        impulse_response[i] = std::sin(0.37f * float(i)) * std::exp(-float(i) / 20000.0f);
+    auto convolution = Convolution::create(&convolution_engine, impulse_response);
+    convolution_engine.add_wire(convolution_osc, convolution, getOutputId(convolution_registry, convolution_osc, 0),
+                                getInputId(convolution_registry, convolution, 0), Wire::transmit_1d_to_1d);
+    convolution_engine.set_output_ref(getOutputId(convolution_registry, convolution, 0), 1);
+    BENCHMARK("Convolution with a 2 s impulse response") {
+        convolution_engine.render(buffer.data(), 256);
+        return buffer[0];
+    };
+}
+
+TEST_CASE("Test voice pool") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    auto mixer = MonoMixer<4>::create(&engine);
+    engine.set_output_ref(getOutputId(registry, mixer, 0), 1);
+    std::vector<entt::entity> adsrs;
+    std::vector<entt::entity> oscs;
+    auto&pool = engine.add_voice_pool(4, [&]() {
+        auto adsr = Adsr::create(&engine, 0.001f, 0.01f, 0.5f, 0.01f);
+        auto osc = SineOsc::create(&engine, 440.0f, 0.0f);
+        engine.add_wire(adsr, osc, getOutputId(registry, adsr, 0), getInputId(registry, osc, 2),
+                        Wire::transmit_1d_to_1d);
+        engine.add_wire_to_mixer(osc, mixer, getOutputId(registry, osc, 0), oscs.size(),
+                                 Wire::transmit_to_mixer);
+        adsrs.push_back(adsr);
+        oscs.push_back(osc);
+        VoicePool::Voice voice;
+        voice.gate = getInputId(registry, adsr, 0);
+        voice.retrigger = getInputId(registry, adsr, 5);
+        voice.freq = getInputId(registry, osc, 1);
+        voice.output_block = osc;
+        voice.blocks = {adsr, osc};
+        return voice;
+    });
+    std::vector<float> buffer(2 * 4800);
+    auto render = [&](size_t frames) {
+        engine.render(buffer.data(), (ma_uint32)frames);
+    };
+    auto asleep = [&](size_t voice) {
+        return registry.get<Silence>(adsrs[voice]).asleep && registry.get<Silence>(oscs[voice]).asleep;
+    };
+    auto gate = [&](size_t voice) {
+        return registry.get<Input1D>(getInputId(registry, adsrs[voice], 0)).value;
+    };
+
+    REQUIRE(pool.size() == 4);
+    render(10);
+    for (size_t v = 0; v < 4; v++)
+        REQUIRE(asleep(v));
+    REQUIRE(pool.active_voices() == 0);
+
+    SECTION("Test notes are allocated, stolen and freed") {
+        for (uint8_t note = 60; note < 64; note++)
+            REQUIRE(pool.note_on(note, 0.5f));
+        render(100);
+        REQUIRE(pool.active_voices() == 4);
+        for (size_t v = 0; v < 4; v++) {
+            REQUIRE(pool.voice_note(v) == 60 + (int)v);
+            REQUIRE(gate(v) == 1.0f);
+            REQUIRE_FALSE(asleep(v));
+            REQUIRE_THAT(registry.get<Input1D>(getInputId(registry, oscs[v], 1)).value,
+                         Catch::Matchers::WithinRel(VoicePool::note_to_freq(60 + v), 1e-6));
+        }
+        REQUIRE_THAT(VoicePool::note_to_freq(69), Catch::Matchers::WithinRel(440.0f, 1e-6));
+
+        //A released voice is stolen before the held ones
+        pool.note_off(62);
+        pool.note_on(70);
+        render(10);
+        REQUIRE(pool.voice_note(2) == 70);
+        REQUIRE(gate(2) == 1.0f);
+        //Then the oldest held one
+        pool.note_on(71);
+        render(10);
+        REQUIRE(pool.voice_note(0) == 71);
+
+        //Released voices go back to sleep and are free again
+        pool.note_off(61);
+        render(4800);
+        REQUIRE(asleep(1));
+        REQUIRE(pool.voice_note(1) == -1);
+        REQUIRE(pool.active_voices() == 3);
+        pool.note_on(72);
+        render(10);
+        REQUIRE(pool.voice_note(1) == 72);
+
+        pool.all_notes_off();
+        render(4800);
+        for (size_t v = 0; v < 4; v++)
+            REQUIRE(asleep(v));
+        REQUIRE(pool.active_voices() == 0);
+        REQUIRE(buffer[2 * 4799] == 0.0f);
+    }
+
+    SECTION("Test a repeated note reuses its voice") {
+        pool.note_on(60);
+        render(10);
+        pool.note_on(60);
+        render(10);
+        REQUIRE(pool.active_voices() == 1);
+        REQUIRE(pool.voice_note(0) == 60);
+    }
+
+    SECTION("Test voices whose block was removed are freed") {
+        pool.note_on(60);
+        pool.note_on(61);
+        render(10);
+        REQUIRE(pool.active_voices() == 2);
+        //Held, but its output block is gone
+        engine.remove_block(oscs[1]);
+        render(10);
+        REQUIRE(pool.active_voices() == 1);
+        REQUIRE(pool.voice_note(1) == -1);
+        //and it is not given new notes
+        pool.note_on(61);
+        render(10);
+        REQUIRE(pool.voice_note(1) == -1);
+        REQUIRE(pool.voice_note(2) == 61);
+
+        //Also without an output to render
+        engine.remove_block(oscs[0]);
+        engine.set_output_ref(entt::null, 0);
+        render(10);
+        REQUIRE(pool.active_voices() == 1);
+        REQUIRE(pool.voice_note(0) == -1);
+    }
+}
+
+TEST_CASE("Test subgraph templates") {
+    AudioEngine engine;
+    auto&registry = engine._test_only_get_graph().registry;
+    //A voice: an envelope on an oscillator frequency modulated by a second one
+    auto adsr = Adsr::create(&engine, 0.001f, 0.01f, 0.5f, 0.01f);
+    auto osc = SineOsc::create(&engine, 220.0f, 0.0f);
+    auto lfo = SineOsc::create(&engine, 5.0f, 1.0f);
+    engine.add_wire(adsr, osc, getOutputId(registry, adsr, 0), getInputId(registry, osc, 2), Wire::transmit_1d_to_1d);
+    engine.add_wire(lfo, osc, getOutputId(registry, lfo, 0), getInputId(registry, osc, 1), Wire::transmit_1d_to_1d,
+                    10.0f, 220.0f);
+    auto mixer = MonoMixer<4>::create(&engine);
+    engine.add_wire_to_mixer(osc, mixer, getOutputId(registry, osc, 0), 0, Wire::transmit_to_mixer);
+    engine.set_output_ref(getOutputId(registry, mixer, 0), 1);
+
+    auto voice = engine.capture_subgraph({adsr, osc, lfo},
+                                         {getInputId(registry, adsr, 0), getOutputId(registry, osc, 0)});
+    //The wire to the mixer crosses the boundary
+    REQUIRE(voice.blocks.size() == 3);
+    REQUIRE(voice.wires.size() == 2);
+    REQUIRE_THROWS(engine.capture_subgraph({adsr}, {getInputId(registry, osc, 0)}));
+
+    SECTION("Test copies are independent and play like the original") {
+        auto copies = engine.clone_subgraph(voice, 3);
+        REQUIRE(copies.size() == 3);
+        REQUIRE(engine.get_blocks().size() == 4 + 3 * 3);
+        REQUIRE(registry.view<Wire>().size() == 3 + 3 * 2);
+        for (size_t c = 0; c < 3; c++) {
+            REQUIRE(copies[c].blocks.size() == 3);
+            REQUIRE(copies[c].wires.size() == 2);
+            REQUIRE(copies[c].ports.size() == 2);
+            REQUIRE(registry.get<Block>(copies[c].blocks[0]).type == BlockType::Adsr);
+            REQUIRE(registry.get<Block>(copies[c].blocks[0]).inputIds[0] == copies[c].ports[0]);
+            REQUIRE(registry.get<Input1D>(getInputId(registry, copies[c].blocks[1], 1)).value == 220.0f);
+            REQUIRE(registry.all_of<Silence>(copies[c].blocks[0]));
+            engine.add_wire_to_mixer(copies[c].blocks[1], mixer, copies[c].ports[1], c + 1,
+                                     Wire::transmit_to_mixer);
+        }
+
+        engine.set_input_1d(getInputId(registry, adsr, 0), 1.0f);
+        engine.set_input_1d(copies[1].ports[0], 1.0f);
+        std::vector<float> buffer(2 * 1000);
+        engine.render(buffer.data(), 1000);
+        auto&original = registry.get<Output1D>(getOutputId(registry, osc, 0)).value;
+        REQUIRE(original != 0.0f);
+        REQUIRE(registry.get<Output1D>(copies[1].ports[1]).value == original);
+        REQUIRE(registry.get<Output1D>(copies[0].ports[1]).value == 0.0f);
+        REQUIRE(registry.get<Output1D>(copies[2].ports[1]).value == 0.0f);
+    }
+
+    SECTION("Test cloning many voices") {
+        //20 blocks: the voice above and a chain of oscillators summed in a mixer
+        std::vector<entt::entity> blocks = {adsr, osc, lfo};
+        auto voice_mixer = MonoMixer<16>::create(&engine);
+        blocks.push_back(voice_mixer);
+        auto partials = SineOsc::create_many(&engine, std::vector<float>(16, 440.0f), std::vector<float>(16, 0.1f));
+        for (size_t i = 0; i < partials.size(); i++) {
+            engine.add_wire_to_mixer(partials[i], voice_mixer, getOutputId(registry, partials[i], 0), i,
+                                     Wire::transmit_to_mixer);
+            blocks.push_back(partials[i]);
+        }
+        REQUIRE(blocks.size() == 20);
+        auto big_voice = engine.capture_subgraph(blocks, {getOutputId(registry, voice_mixer, 0)});
+        REQUIRE(big_voice.wires.size() == 18);
+
+        auto copies = engine.clone_subgraph(big_voice, 256);
+        REQUIRE(copies.size() == 256);
+        REQUIRE(engine.get_blocks().size() == 21 + 256 * 20);
+        REQUIRE(registry.view<Wire>().size() == 19 + 256 * 18);
+        //Each copy is wired to its own blocks
+        for (auto&copy: copies) {
+            for (auto wire_id: copy.wires) {
+                auto&wire = registry.get<Wire>(wire_id);
+                REQUIRE(std::find(copy.blocks.begin(), copy.blocks.end(), wire.from_block) != copy.blocks.end());
+                REQUIRE(std::find(copy.blocks.begin(), copy.blocks.end(), wire.to_block) != copy.blocks.end());
+            }
+        }
+    }
+}
 
 int main(int argc, char* argv[]) {
     Catch::Session session; // There must be exactly one instance
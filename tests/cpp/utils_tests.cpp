@@ -5,9 +5,16 @@
 #include "../../src/core/graph.h"
 #include "../../src/core/audio_engine.h"
 #include "../../src/blocks/mixers.h"
+#include "../../src/core/utils/data_structures.h"
+#include "../../src/core/memory_pool.h"
+#include "../../src/core/recorder.h"
+#include "../../src/core/audio_file.h"
 #include <entt/entt.hpp>
 #include <catch2/catch_all.hpp>
 
+#include <filesystem>
+#include <thread>
+
 TEST_CASE("Test fill with nulls")
 {
     SECTION("Test correct size and actually null")
@@ -20,6 +27,143 @@ TEST_CASE("Test fill with nulls")
     std::array<entt::entity, 10> arr = fill_with_null<10>();
 }
 
+TEST_CASE("Test SPSC queue")
+{
+    SECTION("Test capacity and full queue")
+    {
+        SpscQueue<int> queue(5);
+        REQUIRE(queue.capacity() == 8);
+        for (int i = 0; i < 8; i++)
+            REQUIRE(queue.push(i));
+        REQUIRE_FALSE(queue.push(8));
+        REQUIRE(queue.size() == 8);
+        int value = -1;
+        REQUIRE(queue.pop(value));
+        REQUIRE(value == 0);
+        REQUIRE(queue.push(8));
+        for (int i = 1; i < 9; i++) {
+            REQUIRE(queue.pop(value));
+            REQUIRE(value == i);
+        }
+        REQUIRE_FALSE(queue.pop(value));
+    }
+    SECTION("Test values arrive in order across threads")
+    {
+        SpscQueue<int> queue(64);
+        constexpr int COUNT = 100000;
+        std::thread producer([&]() {
+            for (int i = 0; i < COUNT; i++) {
+                while (!queue.push(i))
+                    std::this_thread::yield();
+            }
+        });
+        int expected = 0;
+        int value;
+        while (expected < COUNT) {
+            if (queue.pop(value)) {
+                REQUIRE(value == expected);
+                expected++;
+            }
+        }
+        producer.join();
+        REQUIRE(queue.size() == 0);
+    }
+}
+
+TEST_CASE("Test memory pool")
+{
+    auto &pool = AAri::MemoryPool::instance();
+    const size_t used = pool.used();
+    SECTION("Test buffers are zeroed, aligned and given back")
+    {
+        {
+            auto buffer = pool.allocate(100);
+            REQUIRE(buffer.size() == 112);
+            REQUIRE(reinterpret_cast<uintptr_t>(buffer.data()) % 64 == 0);
+            REQUIRE(pool.used() == used + 112);
+            for (size_t i = 0; i < buffer.size(); i++)
+                REQUIRE(buffer.data()[i] == 0.0f);
+            std::fill(buffer.data(), buffer.data() + buffer.size(), 1.0f);
+            //Moved, the memory is only given back once
+            AAri::MemoryPool::Buffer moved = std::move(buffer);
+            REQUIRE(buffer.data() == nullptr);
+            REQUIRE(moved.size() == 112);
+        }
+        REQUIRE(pool.used() == used);
+        auto buffer = pool.allocate(100);
+        REQUIRE(buffer.data()[0] == 0.0f);
+    }
+    SECTION("Test free ranges are merged")
+    {
+        auto a = pool.allocate(1024);
+        auto b = pool.allocate(1024);
+        auto c = pool.allocate(1024);
+        float *start = a.data();
+        a = {};
+        b = {};
+        //a and b merged back into one range
+        auto d = pool.allocate(2048);
+        REQUIRE(d.data() == start);
+    }
+    SECTION("Test large buffers add arenas")
+    {
+        const size_t capacity = pool.capacity();
+        auto buffer = pool.allocate(capacity + 1);
+        REQUIRE(pool.capacity() > capacity);
+        buffer = {};
+        pool.reserve(capacity);
+        REQUIRE(pool.capacity() > capacity);
+    }
+    REQUIRE(pool.used() == used);
+}
+
+TEST_CASE("Test recorder")
+{
+    REQUIRE(AAri::Recorder::file_path("take.wav", 1) == "take.wav");
+    REQUIRE(AAri::Recorder::file_path("take.wav", 3) == "take_3.wav");
+    REQUIRE(AAri::Recorder::file_path("dir.d/take", 2) == "dir.d/take_2");
+    REQUIRE_THROWS(AAri::Recorder("/nonexistent/dir/take.wav", 2, 48000));
+
+    //More than the ring, pushed by blocks and frame by frame, over files of 50000 frames
+    auto path = (std::filesystem::temp_directory_path() / "aari_recorder_test.wav").string();
+    const size_t frames = AAri::Recorder::RING_FRAMES + 12345;
+    std::vector<float> data(2 * frames);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = float(i % 4099) / 4099.0f - 0.5f;
+    {
+        AAri::Recorder recorder(path, 2, 48000, 50000);
+        for (size_t start = 0; start < frames; start += 1000) {
+            const size_t count = std::min<size_t>(1000, frames - start);
+            if (start % 2000 == 0) {
+                recorder.push(data.data() + 2 * start, count, false);
+            } else {
+                for (size_t i = 0; i < count; i++)
+                    recorder.push_frame(data.data() + 2 * (start + i), false);
+                recorder.publish();
+            }
+        }
+        REQUIRE(recorder.dropped_frames() == 0);
+    }
+
+    std::vector<float> left;
+    std::vector<float> right;
+    size_t files = 0;
+    while (std::filesystem::exists(AAri::Recorder::file_path(path, files + 1))) {
+        auto channels = AAri::read_audio_file(AAri::Recorder::file_path(path, ++files), 48000);
+        REQUIRE(channels.size() == 2);
+        REQUIRE(channels[0].size() <= 50000);
+        left.insert(left.end(), channels[0].begin(), channels[0].end());
+        right.insert(right.end(), channels[1].begin(), channels[1].end());
+        std::filesystem::remove(AAri::Recorder::file_path(path, files));
+    }
+    REQUIRE(files == (frames + 49999) / 50000);
+    REQUIRE(left.size() == frames);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < frames; i++)
+        mismatches += left[i] != data[2 * i] || right[i] != data[2 * i + 1];
+    REQUIRE(mismatches == 0);
+}
+
 int main(int argc, char *argv[]) {
     Catch::Session session; // There must be exactly one instance
 
@@ -29,7 +29,7 @@ class TestEngine(unittest.TestCase):
             audio_engine.output_mixer.entity,
             sine_block.output_ids[0],
             0,
-            AAri_cpp.Wire.transmit_mono_to_stereo_mixer_4,
+            AAri_cpp.Wire.transmit_to_mixer,
         )
         sleep(3)
         ios = []
@@ -1,11 +1,42 @@
-import unittest
+import os
+import struct
 import sys
+import tempfile
+import unittest
+
+import numpy as np
 
 sys.path.append(r"../../AAri")
 
 import AAri_cpp
 
 
+def input_id(engine, block, index=0):
+    return engine.view_block(int(block)).inputIds[index]
+
+
+def output_id(engine, block, index=0):
+    return engine.view_block(int(block)).outputIds[index]
+
+
+def ids(entities) -> np.ndarray:
+    return np.array([int(e) for e in entities], dtype=np.uint32)
+
+
+def read_wav(path: str, channels: int) -> np.ndarray:
+    """Samples of a 32 bit float WAV file, frames x channels"""
+    with open(path, "rb") as f:
+        data = f.read()
+    position = 12
+    while position < len(data):
+        chunk, size = struct.unpack_from("<4sI", data, position)
+        if chunk == b"data":
+            samples = np.frombuffer(data, np.float32, size // 4, position + 8)
+            return samples.reshape(-1, channels)
+        position += 8 + size + (size & 1)
+    raise ValueError(f"No data in {path}")
+
+
 class TestAAriPythonBindings(unittest.TestCase):
     def test_audio_engine(self):
         audio_engine = AAri_cpp.AudioEngine()
@@ -20,5 +51,195 @@ class TestAAriPythonBindings(unittest.TestCase):
         self.assertIsNotNone(sine_osc)
 
 
+class TestEngineBindings(unittest.TestCase):
+    def setUp(self):
+        self.engine = AAri_cpp.AudioEngine(headless=True)
+        self.directory = tempfile.TemporaryDirectory()
+
+    def tearDown(self):
+        self.directory.cleanup()
+
+    def sines(self):
+        """Two sines in a stereo mixer played by the engine, the second one frequency modulated"""
+        oscs = AAri_cpp.SineOsc.create_many(
+            self.engine, np.array([110.0, 220.0]), np.array([0.5, 0.25])
+        )
+        modulator = AAri_cpp.SineOsc.create(self.engine, 5.0, 1.0)
+        self.engine.add_wire(
+            modulator,
+            int(oscs[1]),
+            output_id(self.engine, modulator),
+            input_id(self.engine, oscs[1], 1),
+            AAri_cpp.Wire.transmit_1d_to_1d,
+            gain=10.0,
+            offset=220.0,
+        )
+        mixer = AAri_cpp.Mixer.create(self.engine, 2, 2)
+        self.engine.add_wires_to_mixer(
+            oscs,
+            np.full(2, int(mixer), dtype=np.uint32),
+            ids(output_id(self.engine, osc) for osc in oscs),
+            np.arange(2, dtype=np.uint32),
+            AAri_cpp.Wire.transmit_to_mixer,
+            np.ones(2),
+            np.zeros(2),
+        )
+        self.engine.set_output_ref(output_id(self.engine, mixer), 2)
+        return oscs, mixer
+
+    def test_bulk_wires_and_render(self):
+        sources = AAri_cpp.Constant.create_many(self.engine, np.array([0.25, 0.5]))
+        targets = AAri_cpp.Constant.create_many(self.engine, np.zeros(2))
+        wires = self.engine.add_wires(
+            sources,
+            targets,
+            ids(output_id(self.engine, b) for b in sources),
+            ids(input_id(self.engine, b) for b in targets),
+            AAri_cpp.Wire.transmit_1d_to_1d,
+            np.array([1.0, 2.0]),
+            np.array([0.0, 0.1]),
+        )
+        self.assertEqual(len(wires), 2)
+        mixer = AAri_cpp.Mixer.create(self.engine, 2)
+        self.engine.add_wires_to_mixer(
+            targets,
+            np.full(2, int(mixer), dtype=np.uint32),
+            ids(output_id(self.engine, b) for b in targets),
+            np.arange(2, dtype=np.uint32),
+            AAri_cpp.Wire.transmit_to_mixer,
+            np.ones(2),
+            np.zeros(2),
+        )
+        self.engine.set_output_ref(output_id(self.engine, mixer), 1)
+
+        rendered = self.engine.render(16)
+        self.assertEqual(rendered.shape, (16, 2))
+        np.testing.assert_allclose(rendered[-1], [1.35, 1.35], atol=1e-6)
+
+    def test_set_input_array(self):
+        bank = AAri_cpp.AdditiveBank.create(
+            self.engine, np.array([100.0, 200.0, 300.0]), np.zeros(3)
+        )
+        amps = input_id(self.engine, bank, 3)
+        self.engine.set_input_array(amps, np.array([0.5, 0.25]), offset=1)
+        np.testing.assert_array_equal(
+            self.engine.view_block_io(bank)[amps].value, [0.0, 0.5, 0.25]
+        )
+        with self.assertRaises(RuntimeError):
+            self.engine.set_input_array(amps, np.ones(3), offset=1)
+
+    def test_snapshot_round_trip(self):
+        self.sines()
+        path = os.path.join(self.directory.name, "patch.aari")
+        self.engine.save_snapshot(path)
+
+        loaded = AAri_cpp.AudioEngine(headless=True)
+        blocks = loaded.load_snapshot(path)
+        self.assertEqual(len(blocks), len(self.engine.get_blocks()))
+        self.assertEqual(loaded.get_output_ref()[1], 2)
+        np.testing.assert_allclose(
+            loaded.render(256), self.engine.render(256), atol=1e-6
+        )
+        with self.assertRaises(RuntimeError):
+            loaded.load_snapshot(path + ".missing")
+
+    def test_subgraph_clones(self):
+        oscs, _ = self.sines()
+        modulator = self.engine.get_wires_to_block(int(oscs[1]))[0]
+        modulator = self.engine.view_wire(modulator).from_block
+        carrier = output_id(self.engine, oscs[1])
+        subgraph = self.engine.capture_subgraph(ids([modulator, oscs[1]]), ids([carrier]))
+        self.assertEqual(subgraph.n_blocks, 2)
+        # The wire to the mixer is outside of the subgraph
+        self.assertEqual(subgraph.n_wires, 1)
+        self.assertEqual(subgraph.n_exposed_ports, 1)
+
+        n_blocks = len(self.engine.get_blocks())
+        copies = self.engine.clone_subgraph(subgraph, 3)
+        self.assertEqual(len(copies), 3)
+        self.assertEqual(len(self.engine.get_blocks()), n_blocks + 6)
+        for copy in copies:
+            self.assertEqual((len(copy.blocks), len(copy.wires), len(copy.ports)), (2, 1, 1))
+
+        # The copies play the same, one is played and the other one tapped
+        self.engine.set_output_ref(int(copies[0].ports[0]), 1)
+        self.engine.add_tap(int(copies[1].ports[0]))
+        rendered = self.engine.render(64)
+        values = {}
+        for block in copies[1].blocks:
+            values.update(self.engine.view_block_io(int(block)))
+        self.assertGreater(np.abs(rendered).max(), 0.01)
+        tapped = values[AAri_cpp.Entity(int(copies[1].ports[0]))]
+        self.assertAlmostEqual(tapped.value, rendered[-1, 0], places=6)
+
+    def test_voice_pool(self):
+        mixer = AAri_cpp.Mixer.create(self.engine, 2)
+        self.engine.set_output_ref(output_id(self.engine, mixer), 1)
+        oscs = []
+
+        def make_voice():
+            adsr = AAri_cpp.Adsr.create(self.engine, 0.001, 0.01, 0.5, 0.01)
+            osc = AAri_cpp.SineOsc.create(self.engine, 440.0, 0.0)
+            self.engine.add_wire(
+                adsr,
+                osc,
+                output_id(self.engine, adsr),
+                input_id(self.engine, osc, 2),
+                AAri_cpp.Wire.transmit_1d_to_1d,
+            )
+            self.engine.add_wire_to_mixer(
+                osc,
+                mixer,
+                output_id(self.engine, osc),
+                len(oscs),
+                AAri_cpp.Wire.transmit_to_mixer,
+            )
+            oscs.append(osc)
+            voice = AAri_cpp.VoicePool.Voice()
+            voice.gate = input_id(self.engine, adsr, 0)
+            voice.retrigger = input_id(self.engine, adsr, 5)
+            voice.freq = input_id(self.engine, osc, 1)
+            voice.output_block = osc
+            voice.blocks = [adsr, osc]
+            return voice
+
+        pool = self.engine.add_voice_pool(2, make_voice)
+        self.assertEqual(pool.size, 2)
+        self.assertTrue(pool.note_on(69, 0.5))
+        rendered = self.engine.render(480)
+        self.assertEqual(pool.active_voices, 1)
+        self.assertEqual(pool.voice_note(0), 69)
+        self.assertEqual(pool.voice_note(1), -1)
+        freq = self.engine.view_block_io(oscs[0])[input_id(self.engine, oscs[0], 1)]
+        self.assertAlmostEqual(freq.value, AAri_cpp.VoicePool.note_to_freq(69), places=3)
+        self.assertGreater(np.abs(rendered).max(), 0.1)
+
+        # Released voices go back to sleep and are free again
+        pool.all_notes_off()
+        rendered = self.engine.render(4800)
+        self.assertEqual(pool.active_voices, 0)
+        self.assertEqual(rendered[-1, 0], 0.0)
+
+    def test_recording(self):
+        oscs, _ = self.sines()
+        master_path = os.path.join(self.directory.name, "master.wav")
+        tap_path = os.path.join(self.directory.name, "tap.wav")
+        master = self.engine.start_recording(master_path)
+        tap = self.engine.start_recording(tap_path, output_id(self.engine, oscs[0]))
+        self.assertEqual(master.channels, 2)
+        self.assertEqual(tap.channels, 1)
+        with self.assertRaises(RuntimeError):
+            self.engine.start_recording(tap_path, input_id(self.engine, oscs[0]))
+
+        rendered = np.concatenate([self.engine.render(1000) for _ in range(3)])
+        self.engine.stop_recording(master)
+        self.engine.stop_recording(tap)
+
+        np.testing.assert_array_equal(read_wav(master_path, 2), rendered)
+        tapped = read_wav(tap_path, 1)
+        self.assertEqual(tapped.shape, (3000, 1))
+        self.assertGreater(np.abs(tapped).max(), 0.4)
+
+
 if __name__ == "__main__":
     unittest.main()
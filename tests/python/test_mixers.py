@@ -0,0 +1,61 @@
+import sys
+import unittest
+
+import numpy as np
+
+import AAri_cpp  # Import the Pybind11 module
+from AAri.audio_engine import AudioEngine
+from block import Block, MonoMixer, ParamDef, StereoMixer
+
+sys.path.append(r"../../AAri")
+
+
+class Constant(Block):
+    OUTPUTS = [ParamDef("out", AAri_cpp.Output1D)]
+
+    def __init__(self, value: float):
+        super().__init__(AAri_cpp.Constant.create(AudioEngine().engine, value))
+
+
+class TestMixers(unittest.TestCase):
+    def setUp(self):
+        self.audio_engine = AudioEngine()
+        self.default_output = self.audio_engine.output_ref
+
+    def tearDown(self):
+        self.audio_engine.set_output_ref(*self.default_output)
+
+    def render(self, mixer, width: int) -> np.ndarray:
+        self.audio_engine.set_output_ref(mixer.output_ids[0], width)
+        return self.audio_engine.engine.render(64)
+
+    def test_mono_mixer(self):
+        sources = [Constant(0.25), Constant(0.5)]
+        mixer = MonoMixer(2)
+        self.audio_engine.add_wire(sources[0].out, mixer)
+        self.audio_engine.add_wire(sources[1].out, mixer, gain=2.0)
+        self.assertEqual(
+            [w.slot for w in self.audio_engine.get_wires_to_block(mixer)], [0, 1]
+        )
+        with self.assertRaises(RuntimeError):
+            self.audio_engine.add_wire(Constant(1.0).out, mixer)
+
+        # Mono outputs are played on both channels
+        rendered = self.render(mixer, 1)
+        np.testing.assert_allclose(rendered[-1], [1.25, 1.25], atol=1e-6)
+
+    def test_stereo_mixer(self):
+        sources = [Constant(0.25), Constant(0.5)]
+        mono = MonoMixer(1)
+        self.audio_engine.add_wire(sources[0].out, mono)
+        # A mixer of mono and stereo sources, the mono ones are summed into both channels
+        mixer = StereoMixer(2)
+        self.audio_engine.add_wire(mono.out, mixer)
+        self.audio_engine.add_wire(sources[1].out, mixer, gain=0.5, offset=0.1)
+
+        rendered = self.render(mixer, 2)
+        np.testing.assert_allclose(rendered[-1], [0.6, 0.6], atol=1e-6)
+
+
+if __name__ == "__main__":
+    unittest.main()